@@ -0,0 +1,273 @@
+#include "Aoi.h"
+#include "CThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <sched.h>       // sched_yield
+
+CAoiGrid::CAoiGrid()
+{
+    m_width = 0;
+    m_height = 0;
+    m_cellSize = 0;
+    m_radius2 = 0;
+    m_cols = 0;
+    m_rows = 0;
+    m_count = 0;
+}
+
+int CAoiGrid::Init(float width, float height, float radius, uint32_t capacity)
+{
+    if (!m_cells.empty()) return -1;
+    if (width <= 0 || height <= 0 || radius <= 0 || capacity == 0) return -2;
+
+    m_width = width;
+    m_height = height;
+    m_cellSize = radius;
+    m_radius2 = radius * radius;
+    m_cols = (uint32_t)(width / radius) + 1;
+    m_rows = (uint32_t)(height / radius) + 1;
+    m_cells.resize((size_t)m_cols * m_rows);
+
+    m_entities.resize(capacity);
+    for (auto& e : m_entities) {
+        e.alive = false;
+        e.dirty = false;
+        e.removed = false;
+    }
+    return 0;
+}
+
+// ==================== 网格 ====================
+void CAoiGrid::Clamp(float& x, float& y) const
+{
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x > m_width) x = m_width;
+    if (y > m_height) y = m_height;
+}
+
+uint32_t CAoiGrid::CellOf(float x, float y) const
+{
+    uint32_t cx = (uint32_t)(x / m_cellSize);
+    uint32_t cy = (uint32_t)(y / m_cellSize);
+    return cy * m_cols + cx;
+}
+
+void CAoiGrid::CellInsert(uint32_t id)
+{
+    Entity& e = m_entities[id];
+    std::vector<Entry>& cell = m_cells[e.cell];
+    e.slot = (uint32_t)cell.size();
+    Entry entry = { id, e.x, e.y };
+    cell.push_back(entry);
+}
+
+// 和最后一项交换后删除（O(1)），被换过来的实体更新自己的下标
+void CAoiGrid::CellErase(uint32_t id)
+{
+    Entity& e = m_entities[id];
+    std::vector<Entry>& cell = m_cells[e.cell];
+    Entry& last = cell.back();
+    cell[e.slot] = last;
+    m_entities[last.id].slot = e.slot;
+    cell.pop_back();
+}
+
+// ==================== 实体 ====================
+int CAoiGrid::Add(uint32_t id, float x, float y)
+{
+    if (id >= m_entities.size()) return -1;
+    Entity& e = m_entities[id];
+    if (e.alive || e.removed) return -2;
+
+    Clamp(x, y);
+    e.x = x;
+    e.y = y;
+    e.cell = CellOf(x, y);
+    e.alive = true;
+    e.view.clear();
+    CellInsert(id);
+    if (!e.dirty) {
+        e.dirty = true;
+        m_dirty.push_back(id);
+    }
+    m_count++;
+    return 0;
+}
+
+int CAoiGrid::Move(uint32_t id, float x, float y)
+{
+    if (id >= m_entities.size() || !m_entities[id].alive) return -1;
+    Entity& e = m_entities[id];
+
+    Clamp(x, y);
+    e.x = x;
+    e.y = y;
+    uint32_t cell = CellOf(x, y);
+    if (cell != e.cell) {
+        CellErase(id);
+        e.cell = cell;
+        CellInsert(id);
+    }
+    else {
+        Entry& entry = m_cells[cell][e.slot];  // 同一格子：只改坐标
+        entry.x = x;
+        entry.y = y;
+    }
+    if (!e.dirty) {
+        e.dirty = true;
+        m_dirty.push_back(id);
+    }
+    return 0;
+}
+
+int CAoiGrid::Remove(uint32_t id)
+{
+    if (id >= m_entities.size() || !m_entities[id].alive) return -1;
+    Entity& e = m_entities[id];
+    CellErase(id);
+    e.alive = false;
+    e.removed = true;
+    m_removed.push_back(id);
+    m_count--;
+    return 0;
+}
+
+// ==================== 更新 ====================
+void CAoiGrid::Compute(const std::vector<uint32_t>& ids)
+{
+    for (size_t k = 0; k < ids.size(); k++) {
+        Entity& e = m_entities[ids[k]];
+        e.next.clear();
+        uint32_t cx = e.cell % m_cols;
+        uint32_t cy = e.cell / m_cols;
+        uint32_t x0 = cx > 0 ? cx - 1 : 0, x1 = cx + 1 < m_cols ? cx + 1 : cx;
+        uint32_t y0 = cy > 0 ? cy - 1 : 0, y1 = cy + 1 < m_rows ? cy + 1 : cy;
+
+        // 周围3×3个格子，每个格子顺序扫
+        for (uint32_t y = y0; y <= y1; y++) {
+            for (uint32_t x = x0; x <= x1; x++) {
+                const std::vector<Entry>& cell = m_cells[y * m_cols + x];
+                for (size_t i = 0; i < cell.size(); i++) {
+                    float dx = cell[i].x - e.x, dy = cell[i].y - e.y;
+                    if (dx * dx + dy * dy <= m_radius2 && cell[i].id != ids[k]) {
+                        e.next.push_back(cell[i].id);
+                    }
+                }
+            }
+        }
+        std::sort(e.next.begin(), e.next.end());
+    }
+}
+
+// 新旧视野都是排序的：一次归并求差
+void CAoiGrid::Apply(uint32_t id)
+{
+    Entity& e = m_entities[id];
+    const std::vector<uint32_t>& old = e.view;
+    const std::vector<uint32_t>& now = e.next;
+    size_t i = 0, j = 0;
+    while (i < old.size() || j < now.size()) {
+        if (j == now.size() || (i < old.size() && old[i] < now[j])) {
+            // 离开
+            uint32_t other = old[i++];
+            AoiEvent ev = { id, other, AOI_LEAVE };
+            m_events.push_back(ev);
+            Entity& o = m_entities[other];
+            if (o.alive && !o.dirty) {   // 对方没动：它的视野由这里修正（动过的自己会算）
+                SortedErase(o.view, id);
+                AoiEvent back = { other, id, AOI_LEAVE };
+                m_events.push_back(back);
+            }
+        }
+        else if (i == old.size() || now[j] < old[i]) {
+            // 进入
+            uint32_t other = now[j++];
+            AoiEvent ev = { id, other, AOI_ENTER };
+            m_events.push_back(ev);
+            Entity& o = m_entities[other];
+            if (!o.dirty) {
+                SortedInsert(o.view, id);
+                AoiEvent back = { other, id, AOI_ENTER };
+                m_events.push_back(back);
+            }
+        }
+        else {
+            i++;
+            j++;
+        }
+    }
+    e.view.swap(e.next);
+    e.next.clear();
+}
+
+void CAoiGrid::Update(CThreadPool* pool, unsigned regions)
+{
+    m_events.clear();
+    m_moved.clear();
+
+    // 第1步：移除的实体，从没动过的实体的视野里删掉（动过的重算时自然就看不见了）
+    for (size_t k = 0; k < m_removed.size(); k++) {
+        uint32_t id = m_removed[k];
+        Entity& e = m_entities[id];
+        for (size_t i = 0; i < e.view.size(); i++) {
+            Entity& o = m_entities[e.view[i]];
+            if (!o.alive || o.dirty) continue;
+            SortedErase(o.view, id);
+            AoiEvent ev = { e.view[i], id, AOI_LEAVE };
+            m_events.push_back(ev);
+        }
+        e.view.clear();
+        e.removed = false;
+    }
+    m_removed.clear();
+
+    // 第2步：动过的实体按格子行分区域
+    if (pool == NULL) regions = 1;
+    else if (regions == 0) regions = AOI_REGIONS;
+    m_regions.resize(regions);
+    for (auto& r : m_regions) r.clear();
+    for (size_t k = 0; k < m_dirty.size(); k++) {
+        uint32_t id = m_dirty[k];
+        Entity& e = m_entities[id];
+        if (!e.alive) {
+            e.dirty = false;  // 动过之后又被移除了
+            continue;
+        }
+        uint32_t row = e.cell / m_cols;
+        m_regions[(size_t)row * regions / m_rows].push_back(id);
+        m_moved.push_back(id);
+    }
+    m_dirty.clear();
+
+    // 第3步：重算视野（其他区域交给线程池，调用线程算最后一个，然后等全部完成）
+    // 工作线程取走一个任务就重新打开连接，同一个线程投递的几个区域会分到不同的工作线程上
+    std::atomic<unsigned> remaining(regions - 1);
+    for (unsigned r = 0; r + 1 < regions; r++) {
+        const std::vector<uint32_t>* ids = &m_regions[r];
+        std::atomic<unsigned>* counter = &remaining;
+        auto task = [this, ids, counter]() {
+            Compute(*ids);
+            counter->fetch_sub(1, std::memory_order_release);
+        };
+        if (ids->empty() || pool->AddTask(task) != 0) task();  // 投递失败就自己算
+    }
+    Compute(m_regions[regions - 1]);
+    while (remaining.load(std::memory_order_acquire) > 0) sched_yield();
+
+    // 第4步：求差、产生事件（串行：要修改别的实体的视野）
+    for (size_t k = 0; k < m_moved.size(); k++) Apply(m_moved[k]);
+    for (size_t k = 0; k < m_moved.size(); k++) m_entities[m_moved[k]].dirty = false;
+}
+
+void CAoiGrid::SortedInsert(std::vector<uint32_t>& v, uint32_t id)
+{
+    auto it = std::lower_bound(v.begin(), v.end(), id);
+    if (it == v.end() || *it != id) v.insert(it, id);
+}
+
+void CAoiGrid::SortedErase(std::vector<uint32_t>& v, uint32_t id)
+{
+    auto it = std::lower_bound(v.begin(), v.end(), id);
+    if (it != v.end() && *it == id) v.erase(it);
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class CThreadPool;
+
+// 视野事件类型
+enum AoiEventType {
+    AOI_ENTER = 0,    // target进入watcher的视野
+    AOI_LEAVE = 1,    // target离开watcher的视野（走远了或被移除）
+};
+
+// 视野事件：watcher需要收到（或不再收到）target的数据
+struct AoiEvent {
+    uint32_t watcher;
+    uint32_t target;
+    int type;
+};
+
+// 并行更新时默认的区域数
+#define AOI_REGIONS 4
+
+// ============================================
+// CAoiGrid类：均匀网格的视野管理（Area Of Interest）
+//
+// 问题：CSocketBase之上只能"发给所有人"；位置同步的流量是 N×N，
+//      只发给附近的玩家是最大的一项带宽优化
+//
+// 做法：
+//   1. 地图按视野半径切成格子，每个实体只在一个格子里；
+//      视野内的实体一定在周围3×3个格子里，不用看全图
+//   2. 格子里连续存放 {id, x, y}（查邻居时顺序扫内存，不跳指针），
+//      删除用"和最后一个交换"，O(1)
+//   3. 增量更新：Move()只改格子和坐标、记下"本轮动过"；
+//      Update()只重算动过的实体的视野，和旧视野求差 → 进入/离开事件
+//      视野是对称的（距离相同），没动的实体的视野按动过的实体的结果顺带修正
+//   4. 重算视野（第1阶段，只读网格）按格子行分成几个区域，
+//      可以放到CThreadPool上并行；求差和修正（第2阶段）在调用线程串行
+//   5. 广播：动过的实体（Moved()）把位置发给View(id)里的实体即可，
+//      View(id)既是"它看得见谁"，也是"谁看得见它"
+//
+// 用法：
+//   CAoiGrid aoi;
+//   aoi.Init(1000, 1000, 30, 65536);       // 地图1000×1000，视野半径30，id < 65536
+//   aoi.Add(id, x, y);  aoi.Move(id, x, y);  aoi.Remove(id);
+//   aoi.Update(&pool);                     // 每个逻辑帧一次
+//   for (auto& ev : aoi.Events()) ...      // 进入：发完整状态；离开：通知销毁
+//   for (auto id : aoi.Moved()) broadcast(位置(id), aoi.View(id));
+// ============================================
+class CAoiGrid
+{
+public:
+    CAoiGrid();
+    ~CAoiGrid() {}
+    CAoiGrid(const CAoiGrid&) = delete;
+    CAoiGrid& operator=(const CAoiGrid&) = delete;
+
+    // width/height：地图大小；radius：视野半径；capacity：实体id的上限（id < capacity）
+    // 返回值：0成功，-1已初始化，-2参数错误
+    int Init(float width, float height, float radius, uint32_t capacity);
+
+    // 添加实体（本轮Update时产生进入事件）
+    // 返回值：0成功，-1 id超出范围，-2 id已存在（包括刚Remove、还没Update的）
+    int Add(uint32_t id, float x, float y);
+
+    // 移动实体（坐标超出地图时按边界截断）
+    // 返回值：0成功，-1实体不存在
+    int Move(uint32_t id, float x, float y);
+
+    // 移除实体（立即从网格中去掉，本轮Update时对看得见它的实体产生离开事件）
+    // 返回值：0成功，-1实体不存在
+    int Remove(uint32_t id);
+
+    // 重算本轮动过的实体的视野，产生事件
+    // pool不为NULL时第1阶段按区域并行（regions个区域，0=AOI_REGIONS），调用线程也处理一个区域
+    void Update(CThreadPool* pool = NULL, unsigned regions = 0);
+
+    // 上一次Update产生的事件 / 动过（含新加入）的实体
+    const std::vector<AoiEvent>& Events() const { return m_events; }
+    const std::vector<uint32_t>& Moved() const { return m_moved; }
+
+    // 视野（按id排序）：看得见的实体 = 看得见它的实体
+    const std::vector<uint32_t>& View(uint32_t id) const { return m_entities[id].view; }
+
+    size_t Count() const { return m_count; }
+
+private:
+    // 格子里的一项（连续存放）
+    struct Entry {
+        uint32_t id;
+        float x;
+        float y;
+    };
+
+    struct Entity {
+        float x;
+        float y;
+        uint32_t cell;       // 所在格子
+        uint32_t slot;       // 在格子里的下标
+        bool alive;
+        bool dirty;          // 本轮动过
+        bool removed;        // 已Remove，等Update处理
+        std::vector<uint32_t> view;   // 当前视野（排序）
+        std::vector<uint32_t> next;   // 第1阶段算出的新视野
+    };
+
+    uint32_t CellOf(float x, float y) const;
+    void CellInsert(uint32_t id);
+    void CellErase(uint32_t id);
+    void Clamp(float& x, float& y) const;
+
+    // 第1阶段：算出ids里每个实体的新视野（只读网格，可以并行）
+    void Compute(const std::vector<uint32_t>& ids);
+    // 第2阶段：新旧视野求差，产生事件，修正没动的实体的视野
+    void Apply(uint32_t id);
+
+    static void SortedInsert(std::vector<uint32_t>& v, uint32_t id);
+    static void SortedErase(std::vector<uint32_t>& v, uint32_t id);
+
+private:
+    float m_width;
+    float m_height;
+    float m_cellSize;    // = 视野半径
+    float m_radius2;     // 半径的平方
+    uint32_t m_cols;
+    uint32_t m_rows;
+    std::vector<std::vector<Entry>> m_cells;
+    std::vector<Entity> m_entities;
+    size_t m_count;
+
+    std::vector<uint32_t> m_dirty;     // 本轮动过的（Add/Move）
+    std::vector<uint32_t> m_removed;   // 本轮移除的
+    std::vector<std::vector<uint32_t>> m_regions;  // 按区域分组的m_dirty
+    std::vector<uint32_t> m_moved;
+    std::vector<AoiEvent> m_events;
+};
@@ -0,0 +1,70 @@
+#include "Broadcast.h"
+#include <string.h>
+
+int CBroadcast::Set(const CIOBuf& body, const char* header, size_t headerSize)
+{
+    if (headerSize > BROADCAST_HEADER_MAX) return -1;
+    m_body = body;  // 共享，不拷贝
+    m_headerSize = headerSize;
+    if (headerSize > 0) memcpy(m_header, header, headerSize);
+    return 0;
+}
+
+int CBroadcast::Send(CSocketBase* const* targets, size_t count, std::vector<CSocketBase*>* flush)
+{
+    char header[BROADCAST_HEADER_MAX];
+    int sent = 0;
+    for (size_t i = 0; i < count; i++) {
+        CSocketBase* target = targets[i];
+        if (target == NULL) continue;
+
+        // 第1步：头部（有补丁就按接收者改一份，否则直接用模板）
+        const char* h = m_header;
+        if (Patch && m_headerSize > 0) {
+            memcpy(header, m_header, m_headerSize);
+            Patch(i, target, header, m_headerSize);
+            h = header;
+        }
+
+        // 第2步：头部拷进队尾，消息体挂引用
+        int ret = target->SendAsync(h, m_headerSize, m_body);
+        if (ret < 0) continue;
+        sent++;
+        if (ret == 1) {
+            if (flush != NULL) flush->push_back(target);
+            else target->Flush();
+        }
+    }
+    return sent;
+}
+
+int CBroadcast::Send(CRudpSession* const* targets, size_t count, int channel)
+{
+    char header[BROADCAST_HEADER_MAX];
+    int sent = 0;
+    for (size_t i = 0; i < count; i++) {
+        CRudpSession* target = targets[i];
+        if (target == NULL) continue;
+
+        const char* h = m_header;
+        if (Patch && m_headerSize > 0) {
+            memcpy(header, m_header, m_headerSize);
+            Patch(i, NULL, header, m_headerSize);
+            h = header;
+        }
+        CIOBuf message;
+        if (m_headerSize > 0) {
+            message = CIOBuf(m_headerSize, 0);  // 头部单独一个小块（按大小分级，不占整页）
+            message.Append(h, m_headerSize);
+        }
+        message.Append(m_body);
+        if (target->Send(message, channel) == 0) sent++;
+    }
+    return sent;
+}
+
+void CBroadcast::FlushAll(std::vector<CSocketBase*>& list)
+{
+    for (size_t i = 0; i < list.size(); i++) list[i]->Flush();
+    list.clear();
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "Socket.h"
+#include "IOBuf.h"
+#include "ReliableUdp.h"
+#include <vector>
+#include <functional>
+
+// 每个接收者的头部最大长度
+#define BROADCAST_HEADER_MAX 64
+
+// ============================================
+// CBroadcast类：编码一次，发给很多连接
+//
+// 问题：房间里500个玩家，广播一次状态就要构造500个Buffer、拷贝500次、
+//      分配500次；世界BOSS、攻城时带宽和CPU的峰值都在这里
+//
+// 做法：
+//   1. 消息体只序列化一次，放进CIOBuf（引用计数的共享块）
+//   2. 每个接收者的发送队列里只挂消息体的引用（+1引用计数），不拷贝
+//      （消息体小于OUTPUT_COALESCE_SIZE时队列会直接拷进队尾：
+//       几十字节的memcpy比多一个iovec便宜，见OutputQueue.h）
+//   3. 头部可以按接收者修改（比如每个连接自己的序号）：
+//      头部模板很小，拷到栈上、回调修改、再拷进队尾，消息体不动
+//   4. Send()只入队；由空变非空的连接收集到flush列表，
+//      本轮事件循环末尾统一Flush（每个连接一次writev）
+//
+// 用法：
+//   CIOBuf body = EncodeBossState(...);           // 只编码一次
+//   CBroadcast msg(body, header, sizeof(header));
+//   msg.Patch = [](size_t i, CSocketBase* to, char* h, size_t n) { ... };
+//   std::vector<CSocketBase*> dirty;
+//   msg.Send(players, &dirty);
+//   CBroadcast::FlushAll(dirty);
+// ============================================
+class CBroadcast
+{
+public:
+    // 头部补丁：index是接收者在列表中的下标，header可写（size字节）
+    // 发给可靠UDP会话时target为NULL，用index区分
+    using PatchFunc = std::function<void(size_t index, CSocketBase* target, char* header, size_t size)>;
+
+    CBroadcast() { m_headerSize = 0; }
+    CBroadcast(const CIOBuf& body, const char* header = NULL, size_t headerSize = 0) {
+        m_headerSize = 0;
+        Set(body, header, headerSize);
+    }
+
+    // 设置消息体和头部模板
+    // 返回值：0成功，-1头部超过BROADCAST_HEADER_MAX
+    int Set(const CIOBuf& body, const char* header = NULL, size_t headerSize = 0);
+
+    // 发给一组连接（只入队），未连接的跳过
+    // flush：由空变非空的连接追加到这里（NULL则立即Flush每个连接）
+    // 返回值：入队的连接数
+    int Send(CSocketBase* const* targets, size_t count, std::vector<CSocketBase*>* flush = NULL);
+    int Send(const std::vector<CSocketBase*>& targets, std::vector<CSocketBase*>* flush = NULL) {
+        return Send(targets.data(), targets.size(), flush);
+    }
+
+    // 发给一组可靠UDP会话：头部 + 消息体拼成切片链（消息体共享），分片也是切片
+    // 返回值：成功入队的会话数
+    int Send(CRudpSession* const* targets, size_t count, int channel = RUDP_RELIABLE);
+
+    // 本轮入队过的连接统一发出，然后清空列表
+    static void FlushAll(std::vector<CSocketBase*>& list);
+
+    const CIOBuf& Body() const { return m_body; }
+    size_t HeaderSize() const { return m_headerSize; }
+
+    PatchFunc Patch;   // 为空则所有接收者用同一个头部
+
+private:
+    CIOBuf m_body;
+    char m_header[BROADCAST_HEADER_MAX];
+    size_t m_headerSize;
+};
@@ -0,0 +1,247 @@
+#include "BufferPool.h"
+#include <stdlib.h>      // aligned_alloc, malloc, free
+#include <string.h>      // memset
+#include <sys/mman.h>    // mmap, madvise
+
+// 大页大小（x86_64：2MB）
+#define POOL_HUGE_PAGE (2 * 1024 * 1024)
+
+// 每线程缓存（线程退出时全部还给全局空闲表）
+struct CBufferPool::Cache {
+    void* items[POOL_CLASS_COUNT][POOL_CACHE_MAX];
+    unsigned count[POOL_CLASS_COUNT];
+    uint64_t hits[POOL_CLASS_COUNT];    // 还没汇总到全局的命中数
+    uint64_t frees[POOL_CLASS_COUNT];
+
+    Cache() {
+        memset(count, 0, sizeof(count));
+        memset(hits, 0, sizeof(hits));
+        memset(frees, 0, sizeof(frees));
+    }
+    ~Cache();
+};
+
+// 线程缓存状态：0未创建，1可用，2已析构（线程退出中还有CIOBuf在释放，走全局表）
+static thread_local int t_cacheState = 0;
+
+CBufferPool::Cache::~Cache() {
+    CBufferPool& pool = CBufferPool::Instance();
+    for (int cls = 0; cls < POOL_CLASS_COUNT; cls++) {
+        pool.Spill(this, cls, 0);
+        pool.FlushStats(this, cls);
+    }
+    t_cacheState = 2;
+}
+
+CBufferPool& CBufferPool::Instance() {
+    static CBufferPool* pool = new CBufferPool();  // 不析构
+    return *pool;
+}
+
+CBufferPool::CBufferPool() {
+    for (int cls = 0; cls < POOL_CLASS_COUNT; cls++) {
+        m_classes[cls].hits = 0;
+        m_classes[cls].refills = 0;
+        m_classes[cls].misses = 0;
+        m_classes[cls].frees = 0;
+    }
+    m_oversize = 0;
+    m_region = NULL;
+    m_regionSize = 0;
+    m_regionUsed = 0;
+}
+
+CBufferPool::Cache* CBufferPool::LocalCache() {
+    if (t_cacheState == 2) return NULL;
+    static thread_local Cache cache;
+    t_cacheState = 1;
+    return &cache;
+}
+
+// 每级缓存个数：按字节数折算，大级别少缓存几个
+unsigned CBufferPool::CacheLimit(int cls) {
+    size_t limit = POOL_CACHE_BYTES / ClassSize(cls);
+    if (limit < POOL_CACHE_MIN) limit = POOL_CACHE_MIN;
+    if (limit > POOL_CACHE_MAX) limit = POOL_CACHE_MAX;
+    return (unsigned)limit;
+}
+
+int CBufferPool::ClassOf(size_t size) {
+    if (size > ((size_t)1 << POOL_MAX_SHIFT)) return -1;
+    if (size <= ((size_t)1 << POOL_MIN_SHIFT)) return 0;
+    // 向上取整到2的幂：size-1 的最高位 + 1
+    int bits = 64 - __builtin_clzll((unsigned long long)(size - 1));
+    return bits - POOL_MIN_SHIFT;
+}
+
+// ==================== 分配/归还 ====================
+void* CBufferPool::Alloc(size_t size, size_t* capacity) {
+    int cls = ClassOf(size);
+    if (cls < 0) {
+        // 超大块：不进池
+        m_oversize.fetch_add(1, std::memory_order_relaxed);
+        if (capacity != NULL) *capacity = size;
+        return malloc(size);
+    }
+    if (capacity != NULL) *capacity = ClassSize(cls);
+
+    Cache* cache = LocalCache();
+    if (cache == NULL) {
+        // 线程退出阶段：直接用全局表
+        Class& c = m_classes[cls];
+        {
+            std::lock_guard<std::mutex> lock(c.mutex);
+            if (!c.free.empty()) {
+                void* p = c.free.back();
+                c.free.pop_back();
+                c.refills.fetch_add(1, std::memory_order_relaxed);
+                return p;
+            }
+        }
+        return NewChunk(cls);
+    }
+
+    // 第1步：本线程缓存（不加锁）
+    if (cache->count[cls] > 0) {
+        if ((++cache->hits[cls] & 1023) == 0) FlushStats(cache, cls);
+        return cache->items[cls][--cache->count[cls]];
+    }
+
+    // 第2步：从全局空闲表批量取
+    Refill(cache, cls);
+    if (cache->count[cls] > 0) {
+        m_classes[cls].refills.fetch_add(1, std::memory_order_relaxed);
+        return cache->items[cls][--cache->count[cls]];
+    }
+
+    // 第3步：新分配
+    return NewChunk(cls);
+}
+
+void CBufferPool::Free(void* p, size_t size) {
+    if (p == NULL) return;
+    int cls = ClassOf(size);
+    if (cls < 0) {
+        free(p);
+        return;
+    }
+
+    Cache* cache = LocalCache();
+    if (cache == NULL) {
+        Class& c = m_classes[cls];
+        std::lock_guard<std::mutex> lock(c.mutex);
+        c.free.push_back(p);
+        c.frees.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // 缓存满了：还一半给全局（别的线程可以用）
+    unsigned limit = CacheLimit(cls);
+    if (cache->count[cls] >= limit) Spill(cache, cls, limit / 2);
+    cache->items[cls][cache->count[cls]++] = p;
+    if ((++cache->frees[cls] & 1023) == 0) FlushStats(cache, cls);
+}
+
+// ==================== 全局空闲表 ====================
+void CBufferPool::Refill(Cache* cache, int cls) {
+    unsigned want = CacheLimit(cls) / 2;
+    if (want == 0) want = 1;
+
+    Class& c = m_classes[cls];
+    std::lock_guard<std::mutex> lock(c.mutex);
+    while (cache->count[cls] < want && !c.free.empty()) {
+        cache->items[cls][cache->count[cls]++] = c.free.back();
+        c.free.pop_back();
+    }
+}
+
+void CBufferPool::Spill(Cache* cache, int cls, unsigned keep) {
+    if (cache->count[cls] <= keep) return;
+
+    Class& c = m_classes[cls];
+    std::lock_guard<std::mutex> lock(c.mutex);
+    c.free.insert(c.free.end(), &cache->items[cls][keep], &cache->items[cls][cache->count[cls]]);
+    cache->count[cls] = keep;
+}
+
+void CBufferPool::FlushStats(Cache* cache, int cls) {
+    Class& c = m_classes[cls];
+    c.hits.fetch_add(cache->hits[cls], std::memory_order_relaxed);
+    c.frees.fetch_add(cache->frees[cls], std::memory_order_relaxed);
+    cache->hits[cls] = 0;
+    cache->frees[cls] = 0;
+}
+
+// ==================== 新块 ====================
+void* CBufferPool::NewChunk(int cls) {
+    size_t size = ClassSize(cls);
+    m_classes[cls].misses.fetch_add(1, std::memory_order_relaxed);
+
+    // 优先从大页区域切（对象都是64的倍数，区域按页对齐，所以切出来的都是缓存行对齐的）
+    if (m_region != NULL) {
+        size_t used = m_regionUsed.load(std::memory_order_relaxed);
+        while (used + size <= m_regionSize) {
+            if (m_regionUsed.compare_exchange_weak(used, used + size,
+                std::memory_order_relaxed)) {
+                return m_region + used;
+            }
+        }
+    }
+    return aligned_alloc(POOL_ALIGN, size);
+}
+
+bool CBufferPool::InRegion(void* p) const {
+    return m_region != NULL && (char*)p >= m_region && (char*)p < m_region + m_regionSize;
+}
+
+int CBufferPool::EnableHugePages(size_t bytes) {
+    if (m_region != NULL) return -1;
+
+    // 按大页大小取整
+    size_t size = (bytes + POOL_HUGE_PAGE - 1) / POOL_HUGE_PAGE * POOL_HUGE_PAGE;
+
+    // 第1步：显式大页（需要 /proc/sys/vm/nr_hugepages 预留）
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p == MAP_FAILED) {
+        // 第2步：普通映射 + 透明大页提示
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return -2;
+        madvise(p, size, MADV_HUGEPAGE);
+    }
+
+    m_regionUsed = 0;
+    m_regionSize = size;
+    m_region = (char*)p;
+    return 0;
+}
+
+void CBufferPool::Trim() {
+    for (int cls = 0; cls < POOL_CLASS_COUNT; cls++) {
+        Class& c = m_classes[cls];
+        std::lock_guard<std::mutex> lock(c.mutex);
+        size_t keep = 0;
+        for (size_t i = 0; i < c.free.size(); i++) {
+            if (InRegion(c.free[i])) c.free[keep++] = c.free[i];  // 大页区域的块留着
+            else free(c.free[i]);
+        }
+        c.free.resize(keep);
+    }
+}
+
+PoolStats CBufferPool::Stats(int cls) const {
+    PoolStats stats;
+    memset(&stats, 0, sizeof(stats));
+    int begin = (cls < 0) ? 0 : cls;
+    int end = (cls < 0) ? POOL_CLASS_COUNT : cls + 1;
+    for (int i = begin; i < end && i < POOL_CLASS_COUNT; i++) {
+        stats.hits += m_classes[i].hits.load(std::memory_order_relaxed);
+        stats.refills += m_classes[i].refills.load(std::memory_order_relaxed);
+        stats.misses += m_classes[i].misses.load(std::memory_order_relaxed);
+        stats.frees += m_classes[i].frees.load(std::memory_order_relaxed);
+    }
+    stats.oversize = m_oversize.load(std::memory_order_relaxed);
+    stats.hugeSize = m_regionSize;
+    stats.hugeUsed = m_regionUsed.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// 最小级别 2^6 = 64字节，最大级别 2^20 = 1MB（更大的直接malloc）
+#define POOL_MIN_SHIFT 6
+#define POOL_MAX_SHIFT 20
+#define POOL_CLASS_COUNT (POOL_MAX_SHIFT - POOL_MIN_SHIFT + 1)
+// 每线程每个级别最多缓存多少字节（小级别再受POOL_CACHE_MAX个数限制）
+#define POOL_CACHE_BYTES (256 * 1024)
+#define POOL_CACHE_MIN 2
+#define POOL_CACHE_MAX 64
+// 每个对象按缓存行对齐
+#define POOL_ALIGN 64
+
+// 统计（各线程的命中数是定期汇总的，是近似值）
+struct PoolStats {
+    uint64_t hits;       // 本线程缓存命中（不加锁）
+    uint64_t refills;    // 从全局空闲表批量取回
+    uint64_t misses;     // 空闲表也没有，新分配
+    uint64_t frees;      // 归还次数
+    uint64_t oversize;   // 超过最大级别，直接malloc
+    size_t hugeSize;     // 大页区域大小（0=未启用）
+    size_t hugeUsed;     // 大页区域已切出去的字节数
+};
+
+// ============================================
+// CBufferPool类：按2的幂分级的缓冲区池
+//
+// 问题：Buffer(size_t)每次都std::string::resize（malloc + 清零），
+//      热点循环里每个包、每条日志都新分配一次，分配器常年在profile前5
+//
+// 做法：
+//   1. 大小向上取整到2的幂（64B ~ 1MB，共15级），同级别的块可以互相复用
+//   2. 每线程每级一个小缓存：Alloc/Free大多数情况不加锁，O(1)
+//      缓存空了从全局空闲表取半个缓存；满了还一半回去
+//   3. 全局空闲表也空了才真正分配：优先从大页区域切（见EnableHugePages），
+//      区域用完或未启用时用aligned_alloc
+//   4. 块只在池内循环，不还给系统（Trim()可以把全局空闲表里的还回去）
+//
+// 用法：
+//   size_t cap = 0;
+//   char* p = (char*)CBufferPool::Instance().Alloc(1500, &cap);  // cap = 2048
+//   ...
+//   CBufferPool::Instance().Free(p, cap);   // size传Alloc时的size或cap都可以
+// ============================================
+class CBufferPool
+{
+public:
+    // 全局唯一（故意不析构：静态对象析构之后仍可能有CIOBuf在释放）
+    static CBufferPool& Instance();
+
+    // 分配至少size字节，capacity返回实际可用大小（所在级别的大小）
+    // 返回值：内存地址，失败返回NULL
+    void* Alloc(size_t size, size_t* capacity = NULL);
+
+    // 归还（size必须落在Alloc时的同一级别）
+    void Free(void* p, size_t size);
+
+    // 启用大页区域（只能调用一次，在服务启动时）
+    // 先尝试MAP_HUGETLB（需要预留大页），失败再用普通映射 + MADV_HUGEPAGE（透明大页）
+    // 返回值：0成功，-1已启用，-2映射失败
+    int EnableHugePages(size_t bytes);
+
+    // 把全局空闲表里不在大页区域的块还给系统
+    void Trim();
+
+    // 统计：cls为级别下标（0 = 64B），-1 表示全部级别
+    PoolStats Stats(int cls = -1) const;
+
+    // 级别下标 / 级别大小
+    static int ClassOf(size_t size);
+    static size_t ClassSize(int cls) { return (size_t)1 << (cls + POOL_MIN_SHIFT); }
+
+    CBufferPool(const CBufferPool&) = delete;
+    CBufferPool& operator=(const CBufferPool&) = delete;
+
+private:
+    CBufferPool();
+    ~CBufferPool() {}
+
+    struct Cache;
+    static Cache* LocalCache();
+    static unsigned CacheLimit(int cls);
+
+    void* NewChunk(int cls);
+    bool InRegion(void* p) const;
+    void Refill(Cache* cache, int cls);
+    void Spill(Cache* cache, int cls, unsigned keep);
+    void FlushStats(Cache* cache, int cls);
+
+    // 每个级别的全局空闲表和计数器
+    struct Class {
+        std::mutex mutex;
+        std::vector<void*> free;
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> refills;
+        std::atomic<uint64_t> misses;
+        std::atomic<uint64_t> frees;
+    };
+
+private:
+    Class m_classes[POOL_CLASS_COUNT];
+    std::atomic<uint64_t> m_oversize;
+
+    // 大页区域（只增不减的切分指针）
+    char* m_region;
+    size_t m_regionSize;
+    std::atomic<size_t> m_regionUsed;
+};
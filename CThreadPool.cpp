@@ -83,7 +83,7 @@ void CThreadPool::Close() {
     if (m_server) {
         CSocketBase* p = m_server;
         m_server = nullptr;  // 立即设置为NULL
-        delete p;            // 慢慢删除
+        CSocketBase::Free(p);  // 慢慢删除（不是slab分配的，Free里delete）
     }
 
     // 步骤3：停止所有工作线程
@@ -102,9 +102,13 @@ void CThreadPool::Close() {
 // TaskDispatch：任务分发函数（工作线程执行）
 // ============================================
 int CThreadPool::TaskDispatch() {
+    // 事件数组和接收缓冲区在循环外只分配一次，每个任务都复用
+    EPEvents events;
+    std::function<int()>* base = nullptr;
+    Buffer data(sizeof(base));
+
     // 主循环：持续监听任务
     while (m_epoll != -1) {
-        EPEvents events;
         int ret = 0;
 
         // 等待事件（阻塞）
@@ -114,8 +118,21 @@ int CThreadPool::TaskDispatch() {
             // 遍历所有就绪事件
             for (ssize_t i = 0; i < esize; i++) {
 
-                // 检查是否可读事件
-                if (events[i].events & EPOLLIN) {
+                // 只有出错/挂断没有可读：客户端连接直接删除（不删会一直占着句柄，ONESHOT也不会再来事件）
+                if (!(events[i].events & EPOLLIN)) {
+                    if (!(events[i].events & (EPOLLERR | EPOLLHUP))) continue;
+                    CSocketBase* server = m_server;
+                    if (server && events[i].data.ptr == server) continue;
+                    CSocketBase* pClient = CSocketBase::FromHandle(events[i].data.u64);
+                    if (pClient) {
+                        if (m_epoll != -1) m_epoll.Del(*pClient);
+                        CSocketBase::Free(pClient);
+                    }
+                    continue;
+                }
+
+                // 可读事件
+                {
                     CSocketBase* pClient = nullptr;
 
                     // 判断事件类型（通过指针区分）
@@ -132,15 +149,18 @@ int CThreadPool::TaskDispatch() {
                         if (ret != 0) continue;
 
                         // 注册客户端Socket到Epoll（检查 epoll 是否有效）
+                        // 存句柄而不是指针：连接释放后残留的事件不会访问野指针
+                        // EPOLLONESHOT：一个事件只交给一个工作线程，处理完之前别的线程拿不到这个连接
+                        // （FromHandle只保证查的那一刻对象还在，释放只能由拿到事件的线程做）
                         if (m_epoll != -1) {
-                            ret = m_epoll.Add(*pClient, EpollData((void*)pClient));
+                            ret = m_epoll.Add(*pClient, EpollData(pClient->Handle()), EPOLLIN | EPOLLONESHOT);
                             if (ret != 0) {
-                                delete pClient;
+                                CSocketBase::Free(pClient);
                                 continue;
                             }
                         } else {
                             // epoll 已关闭，放弃此连接
-                            delete pClient;
+                            CSocketBase::Free(pClient);
                             continue;
                         }
 
@@ -149,26 +169,31 @@ int CThreadPool::TaskDispatch() {
                         // 场景2：客户端发来任务数据
                         //──────────────────────────────
 
-                        pClient = (CSocketBase*)events[i].data.ptr;
+                        pClient = CSocketBase::FromHandle(events[i].data.u64);
 
                         if (pClient) {
                             // 接收任务指针
-                            std::function<int()>* base = nullptr;
-                            Buffer data(sizeof(base));
-
+                            base = nullptr;
                             ret = pClient->Recv(data);
                             if (ret <= 0) {
                                 // 接收失败或连接断开，删除连接
                                 if (m_epoll != -1) {
                                     m_epoll.Del(*pClient);
                                 }
-                                delete pClient;
+                                CSocketBase::Free(pClient);
                                 continue;
                             }
 
                             // 解析指针
                             memcpy(&base, (char*)data, sizeof(base));
 
+                            // 只取一个任务，先重新打开事件再执行：同一个生产者排着的下一个任务
+                            // 马上交给别的工作线程，不用等这个任务跑完（之后pClient不再属于本线程，不能再碰）
+                            if (m_epoll.Modify(*pClient, EPOLLIN | EPOLLONESHOT, EpollData(pClient->Handle())) != 0) {
+                                m_epoll.Del(*pClient);
+                                CSocketBase::Free(pClient);
+                            }
+
                             if (base != nullptr) {
                                 // 执行任务
                                 (*base)();
@@ -176,8 +201,6 @@ int CThreadPool::TaskDispatch() {
                                 // 释放任务对象
                                 delete base;
                             }
-                            // ✅ 任务完成，保持连接（不删除 pClient）
-                            // 客户端可以继续发送下一个任务
                         }
                     }
                 }
@@ -4,7 +4,7 @@
 #include "Socket.h"
 #include <vector>
 #include <functional>  // std::function
-#include <tuple>       // std::tuple
+#include <tuple>       // std::tuple, std::apply
 #include <utility>     // std::forward
 #include <time.h>
 
@@ -64,17 +64,19 @@ int CThreadPool::AddTask(_FUNCTION_ func, _ARGS_... args) {
     }
 
     // 封装任务：使用lambda捕获函数和参数
+    // 参数移进lambda（不再多拷贝一次）；Buffer参数仍会整块拷贝，
+    // 包数据建议用CIOBuf传：跨线程只增加引用计数，不拷贝负载
     std::function<int()>* base = new std::function<int()>(
-        [func, args...]() -> int {
-            func(args...);  // 调用函数
+        [func, params = std::make_tuple(std::move(args)...)]() mutable -> int {
+            std::apply(func, params);  // 调用函数（C++17没有包展开的初始化捕获，先装进tuple）
             return 0;
         }
     );
 
     if (base == NULL) return -3;
 
-    // 准备数据：只发送指针（8字节）
-    Buffer data(sizeof(base));
+    // 准备数据：只发送指针（8字节；缓冲区每个线程只分配一次）
+    static thread_local Buffer data(sizeof(base));
     memcpy(data, &base, sizeof(base));
 
     // 通过Socket发送指针
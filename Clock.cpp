@@ -0,0 +1,42 @@
+#include "Clock.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CLOCK_MINUTE_PREFIX 17   // "2025-01-15 14-30-"
+
+size_t CClock::Format(uint64_t realtimeNs, char* out)
+{
+    static thread_local time_t minute = -1;    // 缓存的这一分钟的起点（秒）
+    static thread_local char prefix[CLOCK_MINUTE_PREFIX + 1];
+
+    time_t sec = (time_t)(realtimeNs / 1000000000ull);
+    unsigned ms = (unsigned)(realtimeNs / 1000000ull % 1000);
+
+    // 第1步：跨分钟（或第一次）才查一次本地时间
+    if (minute == -1 || sec < minute || sec - minute >= 60) {
+        tm local_tm;
+        localtime_r(&sec, &local_tm);
+        // 按int的全部范围留足空间（编译器不知道这些字段都在正常范围内），
+        // 正常时间正好CLOCK_MINUTE_PREFIX个字符，只取这么多
+        char text[64];
+        snprintf(text, sizeof(text), "%04d-%02d-%02d %02d-%02d-",
+            local_tm.tm_year + 1900, local_tm.tm_mon + 1, local_tm.tm_mday,
+            local_tm.tm_hour, local_tm.tm_min);
+        memcpy(prefix, text, CLOCK_MINUTE_PREFIX);
+        prefix[CLOCK_MINUTE_PREFIX] = 0;
+        minute = sec - local_tm.tm_sec;
+    }
+
+    // 第2步：拷前缀，改写秒和毫秒
+    unsigned s = (unsigned)(sec - minute);
+    memcpy(out, prefix, CLOCK_MINUTE_PREFIX);
+    char* p = out + CLOCK_MINUTE_PREFIX;
+    p[0] = (char)('0' + s / 10);
+    p[1] = (char)('0' + s % 10);
+    p[2] = ' ';
+    p[3] = (char)('0' + ms / 100);
+    p[4] = (char)('0' + ms / 10 % 10);
+    p[5] = (char)('0' + ms % 10);
+    p[6] = 0;
+    return CLOCK_MINUTE_PREFIX + 6;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+// 时间字符串的缓冲区大小："2025-01-15 14-30-25 123" + '\0'
+#define CLOCK_TIME_STR_SIZE 24
+
+// ============================================
+// CClock：日志（以及其他需要墙上时间的模块）共用的时钟
+//
+// 问题：GetTimeStr每一行都 ftime + localtime_r + snprintf，还返回一个新分配的Buffer；
+//      localtime_r每次都要查时区（glibc里有一把全局锁），多个线程一起写日志时互相等
+//
+// 做法：
+//   1. 取时间用CLOCK_REALTIME_COARSE（vDSO，不进内核，精度是一个时钟节拍，几毫秒）
+//   2. 每个线程缓存 "YYYY-MM-DD HH-MM-" 这一段（同一分钟内不变），
+//      每次只改写秒和毫秒的几个数字；跨分钟才调用一次localtime_r
+//      （夏令时、时区只在整点/整分切换，按分钟缓存不会错）
+//   3. 缓存是thread_local的：不加锁，日志线程和业务线程互不影响
+//
+// 用法：
+//   char time[CLOCK_TIME_STR_SIZE];
+//   CClock::Format(time);                     // 当前时间
+//   CClock::Format(CClock::NowPrecise(), time); // 指定时间（纳秒）
+// ============================================
+class CClock
+{
+public:
+    // 当前墙上时间（纳秒），粗精度（vDSO，约几毫秒的精度）
+    static uint64_t Now() { return Read(CLOCK_REALTIME_COARSE); }
+    // 当前墙上时间（纳秒），精确
+    static uint64_t NowPrecise() { return Read(CLOCK_REALTIME); }
+
+    // 格式化成 "2025-01-15 14-30-25 123"（out至少CLOCK_TIME_STR_SIZE字节，以0结尾）
+    // 返回值：字符串长度
+    static size_t Format(uint64_t realtimeNs, char* out);
+    static size_t Format(char* out) { return Format(Now(), out); }
+
+private:
+    static uint64_t Read(clockid_t id) {
+        timespec ts;
+        clock_gettime(id, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+};
@@ -0,0 +1,424 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <netinet/in.h>  // sockaddr_in
+#include <sched.h>       // sched_yield
+#include <atomic>
+#include <vector>
+
+// 初始容量（槽位数，2的幂）
+#define CONN_TABLE_INIT 1024
+// 已用槽位（含删除标记）超过 3/4 就重建
+#define CONN_TABLE_LOAD(cap) ((cap) / 4 * 3)
+// 同时持有CConnGuard的读线程上限（每个线程第一次进入时占一个槽位，线程退出时归还）
+#define CONN_EPOCH_READERS 128
+
+// 空槽 / 删除标记（连接ID 0 保留不用；地址键第48位固定为1，所以都不会和这两个值冲突）
+#define CONN_KEY_EMPTY 0ull
+#define CONN_KEY_DELETED (~0ull)
+
+// ============================================
+// CConnEpoch：纪元回收（读线程宣告自己在读，写线程据此决定何时释放）
+//
+// 问题：读线程不加锁地拿到指针（旧数组、被删除的会话），写线程什么时候能释放它？
+//      固定等一段时间只是赌读线程够快，被调度出去的读线程照样会用到已释放的内存
+//
+// 做法：
+//   1. 全局纪元号 + 每个读线程一个槽位（独占一条缓存行）
+//      读：进入时把当前纪元写进自己的槽位，离开时清0（CConnGuard）
+//   2. 写线程退休一个对象时纪元号+1，记下退休时的纪元
+//   3. Reclaim：所有槽位里最小的纪元比退休纪元大（或者没有读线程），
+//      说明可能看到过这个对象的读线程都已经离开，可以释放
+//   4. 读线程之间互不影响；写线程只在Reclaim时扫一遍槽位
+//
+// 用法：
+//   { CConnGuard guard; T* p = table.Find(conv); ... }   // 读线程：guard期间p不会被释放
+//   table.Retire(p, Deleter);                             // 写线程：删除后退休
+//   table.Reclaim();                                      // 写线程：定期回收
+// ============================================
+class CConnEpoch
+{
+public:
+    CConnEpoch() {}
+    ~CConnEpoch() { Clear(); }
+    CConnEpoch(const CConnEpoch&) = delete;
+    CConnEpoch& operator=(const CConnEpoch&) = delete;
+
+    // ==================== 读线程（可以嵌套） ====================
+    static void Enter() {
+        Reader& r = Local();
+        if (r.depth++ > 0) return;
+        if (r.slot == NULL) r.slot = Acquire();
+        r.slot->epoch.store(Global().load(std::memory_order_acquire), std::memory_order_relaxed);
+        // 先宣告再读指针：写线程扫描槽位前也有一道屏障，两边至少有一边能看到对方
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    static void Leave() {
+        Reader& r = Local();
+        if (--r.depth > 0) return;
+        r.slot->epoch.store(0, std::memory_order_release);
+    }
+
+    // ==================== 写线程 ====================
+    // 退休：对象已经从表里摘掉（新的读线程不会再看到它），等旧的读线程离开后调用deleter
+    void Retire(void* p, void (*deleter)(void*)) {
+        Retired r = { p, deleter, Global().fetch_add(1, std::memory_order_seq_cst) };
+        m_retired.push_back(r);
+    }
+
+    // 释放已经安全的对象，返回还在等的个数
+    size_t Reclaim() {
+        if (m_retired.empty()) return 0;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t oldest = ~0ull;
+        Slot* slots = Slots();
+        for (int i = 0; i < CONN_EPOCH_READERS; i++) {
+            uint64_t e = slots[i].epoch.load(std::memory_order_acquire);
+            if (e != 0 && e < oldest) oldest = e;
+        }
+        size_t keep = 0;
+        for (size_t i = 0; i < m_retired.size(); i++) {
+            if (m_retired[i].epoch < oldest) m_retired[i].deleter(m_retired[i].p);
+            else m_retired[keep++] = m_retired[i];
+        }
+        m_retired.resize(keep);
+        return keep;
+    }
+
+    size_t Pending() const { return m_retired.size(); }
+
+    // 全部释放（调用时不能有读线程）
+    void Clear() {
+        for (size_t i = 0; i < m_retired.size(); i++) m_retired[i].deleter(m_retired[i].p);
+        m_retired.clear();
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch;   // 0 = 不在读
+        std::atomic<bool> owner;       // 槽位已被某个线程占用
+    };
+    struct Reader {
+        Slot* slot = NULL;
+        unsigned depth = 0;
+        ~Reader() { if (slot != NULL) slot->owner.store(false, std::memory_order_release); }
+    };
+    struct Retired {
+        void* p;
+        void (*deleter)(void*);
+        uint64_t epoch;   // 退休时的纪元
+    };
+
+    static std::atomic<uint64_t>& Global() {
+        static std::atomic<uint64_t> epoch(1);   // 从1开始：槽位里的0表示不在读
+        return epoch;
+    }
+    static Slot* Slots() {
+        static Slot slots[CONN_EPOCH_READERS];   // 静态存储，初始全0
+        return slots;
+    }
+    static Reader& Local() {
+        static thread_local Reader reader;
+        return reader;
+    }
+
+    // 占一个空闲槽位（读线程太多时等别的线程退出）
+    static Slot* Acquire() {
+        Slot* slots = Slots();
+        while (true) {
+            for (int i = 0; i < CONN_EPOCH_READERS; i++) {
+                bool expected = false;
+                if (!slots[i].owner.load(std::memory_order_relaxed) &&
+                    slots[i].owner.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return &slots[i];
+                }
+            }
+            sched_yield();
+        }
+    }
+
+private:
+    std::vector<Retired> m_retired;   // 只有写线程访问
+};
+
+// 读线程的作用域守卫：构造时进入，析构时离开
+class CConnGuard
+{
+public:
+    CConnGuard() { CConnEpoch::Enter(); }
+    ~CConnGuard() { CConnEpoch::Leave(); }
+    CConnGuard(const CConnGuard&) = delete;
+    CConnGuard& operator=(const CConnGuard&) = delete;
+};
+
+// ============================================
+// CConnTable模板：UDP会话的分派表（开放寻址，读不加锁）
+//
+// 问题：一个UDP端口上几千个玩家，每个数据报都要找到它的会话；
+//      CUdpSocket只有m_param里的一个对端地址，std::unordered_map
+//      每个节点单独分配、链表跳转，每包查找成了热点，而且不能被别的线程并发读
+//
+// 做法：
+//   1. 两张线性探测表：连接ID → 会话，地址(IP+端口) → 会话
+//      先按连接ID查；ID查不到时可以按来源地址兜底
+//   2. NAT重绑定：Rebind()只改地址表，会话和连接ID不变
+//   3. 单写多读：写（Insert/Erase/Rebind）只在一个线程（网络线程）；
+//      读（Find/FindAddr）可以在任意线程并发，不加锁：
+//      - 写入顺序：先写值再写键（release），读的时候先读键再读值（acquire）
+//      - 读到值后再确认一次键没变（槽位可能刚被删掉又复用给别的键）
+//      - 扩容时建新数组再原子替换指针；旧数组不立即释放（读线程可能还在上面探测），
+//        交给CConnEpoch退休，所有可能看到它的读线程离开后才释放
+//   4. 删除只打标记；标记太多时原地重建（同样走新数组 + 退休）
+//   5. 被删除的值同样可以Retire，读线程在CConnGuard期间拿到的指针一直有效
+//
+// 注意：其他线程读必须持有CConnGuard；写线程自己读不需要
+//
+// 用法：
+//   CConnTable<CRudpSession> table;
+//   table.Insert(conv, addr, session);
+//   CConnGuard guard;                            // 其他线程：先宣告
+//   CRudpSession* s = table.Find(conv);          // 任意线程
+//   if (s == NULL) s = table.FindAddr(from);     // 兜底
+//   table.Rebind(conv, oldAddr, newAddr);        // 地址变了
+//   table.Erase(conv, addr);
+//   table.Retire(s, Deleter);                    // 读线程离开后才释放
+// ============================================
+template<typename T>
+class CConnTable
+{
+public:
+    CConnTable() : m_ids(&m_epoch), m_addrs(&m_epoch) {}
+    ~CConnTable() { Clear(); }
+    CConnTable(const CConnTable&) = delete;
+    CConnTable& operator=(const CConnTable&) = delete;
+
+    // 地址 → 键（IPv4 32位 + 端口16位，第48位置1保证非0）
+    static uint64_t AddrKey(const sockaddr_in& addr) {
+        return (1ull << 48) | ((uint64_t)addr.sin_addr.s_addr << 16) | addr.sin_port;
+    }
+
+    // ==================== 读（任意线程，不加锁；其他线程要持有CConnGuard） ====================
+    T* Find(uint32_t conv) const { return m_ids.Find(conv); }
+    T* FindAddr(const sockaddr_in& addr) const { return m_addrs.Find(AddrKey(addr)); }
+
+    size_t Count() const { return m_ids.Count(); }
+    size_t Capacity() const { return m_ids.Capacity(); }
+
+    // ==================== 写（只在一个线程） ====================
+    // 插入（连接ID已存在则覆盖）；同一地址只保留最新的会话
+    void Insert(uint32_t conv, const sockaddr_in& addr, T* value) {
+        m_ids.Insert(conv, value);
+        m_addrs.Insert(AddrKey(addr), value);
+    }
+
+    // 地址变了（NAT重绑定）：连接ID表不动，地址表换键
+    void Rebind(uint32_t conv, const sockaddr_in& from, const sockaddr_in& to) {
+        T* value = m_ids.Find(conv);
+        if (value == NULL) return;
+        if (m_addrs.Find(AddrKey(from)) == value) m_addrs.Erase(AddrKey(from));
+        m_addrs.Insert(AddrKey(to), value);
+    }
+
+    // 删除（地址表里只有还指向这个会话时才删：地址可能已经被新会话占用）
+    void Erase(uint32_t conv, const sockaddr_in& addr) {
+        T* value = m_ids.Find(conv);
+        if (value == NULL) return;
+        m_ids.Erase(conv);
+        if (m_addrs.Find(AddrKey(addr)) == value) m_addrs.Erase(AddrKey(addr));
+    }
+
+    // 遍历（写线程）：func(conv, value)
+    template<typename Func>
+    void ForEach(Func func) const { m_ids.ForEach(func); }
+
+    // 退休一个已经Erase的值：持有CConnGuard的读线程都离开后调用deleter
+    void Retire(T* value, void (*deleter)(void*)) { m_epoch.Retire(value, deleter); }
+
+    // 释放已经安全的旧数组和值（写线程定期调用；Rebuild时也会顺便调用）
+    // 返回值：还在等读线程离开的个数
+    size_t Reclaim() { return m_epoch.Reclaim(); }
+
+    // 清空并释放所有退休的数组和值（调用时不能有读线程）
+    void Clear() {
+        m_ids.Clear();
+        m_addrs.Clear();
+        m_epoch.Clear();
+    }
+
+private:
+    // 一张开放寻址表：64位键 → 指针
+    class Index
+    {
+    public:
+        explicit Index(CConnEpoch* epoch) {
+            m_epoch = epoch;
+            m_array.store(NULL, std::memory_order_relaxed);
+            m_count = 0;
+            m_filled = 0;
+        }
+        ~Index() { Clear(); }
+
+        T* Find(uint64_t key) const {
+            Array* a = m_array.load(std::memory_order_acquire);
+            if (a == NULL) return NULL;
+            size_t i = Hash(key) & a->mask;
+            for (size_t n = 0; n <= a->mask; n++, i = (i + 1) & a->mask) {
+                Slot& s = a->slots[i];
+                uint64_t k = s.key.load(std::memory_order_acquire);
+                if (k == CONN_KEY_EMPTY) return NULL;
+                if (k != key) continue;
+                T* value = s.value.load(std::memory_order_acquire);
+                if (s.key.load(std::memory_order_acquire) == key) return value;
+                return Find(key);  // 读的过程中槽位被删除/复用了，重新查
+            }
+            return NULL;
+        }
+
+        void Insert(uint64_t key, T* value) {
+            Array* a = m_array.load(std::memory_order_relaxed);
+            if (a == NULL || m_filled + 1 > CONN_TABLE_LOAD(a->mask + 1)) {
+                a = Rebuild();
+            }
+
+            // 探测：已存在就覆盖；否则放到第一个删除标记或空槽
+            Slot* target = NULL;
+            size_t i = Hash(key) & a->mask;
+            for (size_t n = 0; n <= a->mask; n++, i = (i + 1) & a->mask) {
+                Slot& s = a->slots[i];
+                uint64_t k = s.key.load(std::memory_order_relaxed);
+                if (k == key) {
+                    s.value.store(value, std::memory_order_release);
+                    return;
+                }
+                if (k == CONN_KEY_DELETED && target == NULL) target = &s;
+                if (k == CONN_KEY_EMPTY) {
+                    if (target == NULL) {
+                        target = &s;
+                        m_filled++;
+                    }
+                    break;
+                }
+            }
+            target->value.store(value, std::memory_order_release);
+            target->key.store(key, std::memory_order_release);  // 键最后写：读线程看到键时值已就绪
+            m_count++;
+        }
+
+        void Erase(uint64_t key) {
+            Array* a = m_array.load(std::memory_order_relaxed);
+            if (a == NULL) return;
+            size_t i = Hash(key) & a->mask;
+            for (size_t n = 0; n <= a->mask; n++, i = (i + 1) & a->mask) {
+                Slot& s = a->slots[i];
+                uint64_t k = s.key.load(std::memory_order_relaxed);
+                if (k == CONN_KEY_EMPTY) return;
+                if (k != key) continue;
+                s.value.store(NULL, std::memory_order_release);
+                s.key.store(CONN_KEY_DELETED, std::memory_order_release);
+                m_count--;
+                return;
+            }
+        }
+
+        template<typename Func>
+        void ForEach(Func& func) const {
+            Array* a = m_array.load(std::memory_order_relaxed);
+            if (a == NULL) return;
+            for (size_t i = 0; i <= a->mask; i++) {
+                uint64_t k = a->slots[i].key.load(std::memory_order_relaxed);
+                if (k == CONN_KEY_EMPTY || k == CONN_KEY_DELETED) continue;
+                func((uint32_t)k, a->slots[i].value.load(std::memory_order_relaxed));
+            }
+        }
+
+        size_t Count() const { return m_count; }
+        size_t Capacity() const {
+            Array* a = m_array.load(std::memory_order_relaxed);
+            return a == NULL ? 0 : a->mask + 1;
+        }
+
+        void Clear() {
+            Free(m_array.exchange(NULL));
+            m_count = 0;
+            m_filled = 0;
+        }
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> key;
+            std::atomic<T*> value;
+        };
+        struct Array {
+            size_t mask;     // 容量 - 1
+            Slot* slots;
+        };
+
+        // 斐波那契散列：乘黄金比例常数取高位，连续的连接ID/端口也能散开
+        static size_t Hash(uint64_t key) {
+            key ^= key >> 32;
+            return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32);
+        }
+
+        static Array* Alloc(size_t capacity) {
+            Array* a = new Array;
+            a->mask = capacity - 1;
+            a->slots = new Slot[capacity];
+            for (size_t i = 0; i < capacity; i++) {
+                a->slots[i].key.store(CONN_KEY_EMPTY, std::memory_order_relaxed);
+                a->slots[i].value.store(NULL, std::memory_order_relaxed);
+            }
+            return a;
+        }
+
+        static void Free(Array* a) {
+            if (a == NULL) return;
+            delete[] a->slots;
+            delete a;
+        }
+        static void FreeArray(void* p) { Free((Array*)p); }
+
+        // 建新数组（活跃的超过一半就扩容，否则只是清掉删除标记），原子替换，旧的退休
+        Array* Rebuild() {
+            Array* old = m_array.load(std::memory_order_relaxed);
+            size_t capacity = CONN_TABLE_INIT;
+            if (old != NULL) {
+                capacity = old->mask + 1;
+                while ((m_count + 1) * 2 > capacity) capacity *= 2;
+            }
+
+            Array* a = Alloc(capacity);
+            if (old != NULL) {
+                for (size_t j = 0; j <= old->mask; j++) {
+                    uint64_t k = old->slots[j].key.load(std::memory_order_relaxed);
+                    if (k == CONN_KEY_EMPTY || k == CONN_KEY_DELETED) continue;
+                    size_t i = Hash(k) & a->mask;
+                    while (a->slots[i].key.load(std::memory_order_relaxed) != CONN_KEY_EMPTY) {
+                        i = (i + 1) & a->mask;
+                    }
+                    a->slots[i].value.store(old->slots[j].value.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+                    a->slots[i].key.store(k, std::memory_order_relaxed);
+                }
+            }
+            m_filled = m_count;
+            m_array.store(a, std::memory_order_release);  // 发布：之后的读都走新数组
+
+            // 刚替换下来的退休（读线程可能还在上面探测），之前退休的顺便回收
+            if (old != NULL) m_epoch->Retire(old, FreeArray);
+            m_epoch->Reclaim();
+            return a;
+        }
+
+    private:
+        std::atomic<Array*> m_array;
+        CConnEpoch* m_epoch;             // 被替换的旧数组交给它退休（两张表共用一个）
+        size_t m_count;                  // 有效条目（只有写线程改）
+        size_t m_filled;                 // 有效条目 + 删除标记
+    };
+
+private:
+    CConnEpoch m_epoch;   // 旧数组和被删除的值的回收（先声明：两张表构造时要用它的地址）
+    Index m_ids;          // 连接ID → 会话
+    Index m_addrs;        // 地址 → 会话
+};
@@ -339,15 +339,18 @@ public:
         // 1. 检查是否已创建
         if (m_epoll == -1) return -1;
 
-        // 2. 创建临时数组（固定128个）
-        EPEvents evs(EVENT_SIZE);
+        // 2. 直接用调用者的数组（第一次调用时扩到EVENT_SIZE，之后不再分配）
+        //    调用者应在循环外定义events并反复使用
+        if (events.size() < EVENT_SIZE) {
+            events.resize(EVENT_SIZE);
+        }
 
-        // 3. 调用系统函数等待
-        int ret = epoll_wait(m_epoll, evs.data(), (int)evs.size(), timeout);
+        // 3. 调用系统函数等待（结果直接写进events，不再经过临时数组拷贝）
+        int ret = epoll_wait(m_epoll, events.data(), (int)events.size(), timeout);
         /*
         *   int ret = epoll_wait(m_epoll,      // 参数1: 哪个epoll
-                       evs.data(),   // 参数2: 结果存哪里
-                       evs.size(),   // 参数3: 最多几个 (128)
+                       events.data(), // 参数2: 结果存哪里
+                       events.size(), // 参数3: 最多几个 (>=128)
                        10);          // 参数4: 超时10ms
                           数组指针      最大容量
         * 
@@ -362,14 +365,6 @@ public:
             return -2;  // 真的出错
         }
 
-        // 5. 调整用户数组大小
-        if (ret > (int)events.size()) {
-            events.resize(ret);
-        }
-
-        // 6. 拷贝到用户数组
-        memcpy(events.data(), evs.data(), sizeof(epoll_event) * ret);
-
         return ret;
     }
     int Add(int fd, const EpollData& data ,
@@ -0,0 +1,393 @@
+#include "IOBuf.h"
+#include "BufferPool.h"
+#include <string.h>      // memcpy
+#include <new>           // placement new, std::bad_alloc
+
+// 块头大小（按16字节对齐，数据紧跟在后面）
+#define IOBUF_BLOCK_HEADER ((sizeof(Block) + 15) & ~(size_t)15)
+// Reserve的默认新块数据区大小：块头 + 数据区正好是IOBUF_BLOCK_SIZE（一个池级别）
+// 只给流式累积用（接收缓冲、发送队列合并）；Append按请求大小分配
+#define IOBUF_BLOCK_DATA (IOBUF_BLOCK_SIZE - IOBUF_BLOCK_HEADER)
+
+// ==================== 块管理 ====================
+// 块从CBufferPool分配：数据区大小取整到级别大小，多出来的部分就是尾部空间
+CIOBuf::Block* CIOBuf::NewBlock(size_t capacity)
+{
+    size_t size = 0;
+    void* p = CBufferPool::Instance().Alloc(IOBUF_BLOCK_HEADER + capacity, &size);
+    if (p == NULL) throw std::bad_alloc();  // 和std::string一样，分配失败抛异常
+    Block* block = new (p) Block();
+    block->ref.store(1, std::memory_order_relaxed);
+    block->capacity = size - IOBUF_BLOCK_HEADER;
+    block->data = (char*)p + IOBUF_BLOCK_HEADER;
+    return block;
+}
+
+CIOBuf::Block* CIOBuf::AdoptBlock(std::string&& data)
+{
+    void* p = CBufferPool::Instance().Alloc(sizeof(Block));
+    if (p == NULL) throw std::bad_alloc();
+    Block* block = new (p) Block();
+    block->ref.store(1, std::memory_order_relaxed);
+    block->owned = std::move(data);
+    block->capacity = block->owned.size();  // 没有尾部空间：追加时另起新块
+    block->data = &block->owned[0];
+    return block;
+}
+
+void CIOBuf::Unref(Block* block)
+{
+    // 最后一个引用者负责释放（acq_rel：保证其他线程对块的读写都已完成）
+    if (block->ref.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // 普通块：数据紧跟块头；接管的string：只有块头
+        bool bInline = (block->data == (char*)block + IOBUF_BLOCK_HEADER);
+        size_t size = bInline ? IOBUF_BLOCK_HEADER + block->capacity : sizeof(Block);
+        block->~Block();
+        CBufferPool::Instance().Free(block, size);
+    }
+}
+
+// ==================== 构造/析构 ====================
+CIOBuf::CIOBuf()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+CIOBuf::~CIOBuf()
+{
+    Clear();
+}
+
+CIOBuf::CIOBuf(size_t capacity, size_t headroom)
+{
+    m_head = 0;
+    m_size = 0;
+    PushSlice(NewBlock(headroom + capacity), headroom, 0);
+}
+
+CIOBuf::CIOBuf(const char* data, size_t size)
+{
+    m_head = 0;
+    m_size = 0;
+    Append(data, size);
+}
+
+CIOBuf::CIOBuf(std::string&& data)
+{
+    m_head = 0;
+    m_size = 0;
+    Append(std::move(data));
+}
+
+CIOBuf::CIOBuf(const CIOBuf& buf)
+{
+    m_head = 0;
+    m_size = 0;
+    Append(buf);
+}
+
+CIOBuf& CIOBuf::operator=(const CIOBuf& buf)
+{
+    if (this != &buf) {
+        CIOBuf tmp(buf);   // 先加引用再释放旧的（buf可能是自己的切片）
+        *this = std::move(tmp);
+    }
+    return *this;
+}
+
+CIOBuf::CIOBuf(CIOBuf&& buf) noexcept
+{
+    m_slices.swap(buf.m_slices);
+    m_head = buf.m_head;
+    m_size = buf.m_size;
+    buf.m_head = 0;
+    buf.m_size = 0;
+}
+
+CIOBuf& CIOBuf::operator=(CIOBuf&& buf) noexcept
+{
+    if (this != &buf) {
+        Clear();
+        m_slices.swap(buf.m_slices);
+        m_head = buf.m_head;
+        m_size = buf.m_size;
+        buf.m_head = 0;
+        buf.m_size = 0;
+    }
+    return *this;
+}
+
+// ==================== 查询 ====================
+bool CIOBuf::IsShared() const
+{
+    for (size_t i = m_head; i < m_slices.size(); i++) {
+        if (!Unique(m_slices[i])) return true;
+    }
+    return false;
+}
+
+void CIOBuf::Clear()
+{
+    for (size_t i = m_head; i < m_slices.size(); i++) {
+        Unref(m_slices[i].block);
+    }
+    m_slices.clear();
+    m_head = 0;
+    m_size = 0;
+}
+
+void CIOBuf::PushSlice(Block* block, size_t offset, size_t length)
+{
+    Segment s = { block, offset, length };
+    m_slices.push_back(s);
+    m_size += length;
+}
+
+void CIOBuf::PopFront()
+{
+    Unref(Front().block);
+    m_head++;
+    if (m_head == m_slices.size()) {
+        m_slices.clear();
+        m_head = 0;
+    }
+    else if (m_head >= 32 && m_head * 2 >= m_slices.size()) {
+        // 前面空出来的太多：整体前移一次（均摊O(1)）
+        m_slices.erase(m_slices.begin(), m_slices.begin() + m_head);
+        m_head = 0;
+    }
+}
+
+// ==================== 写入 ====================
+void CIOBuf::Append(const char* data, size_t size)
+{
+    if (size == 0) return;
+
+    // 第1步：填最后一块的尾部空间（块没有被共享时）
+    if (Count() > 0 && Unique(Back())) {
+        Segment& s = Back();
+        size_t end = s.offset + s.length;
+        size_t room = s.block->capacity - end;
+        size_t len = room < size ? room : size;
+        if (len > 0) {
+            memcpy(s.block->data + end, data, len);
+            s.length += len;
+            m_size += len;
+            data += len;
+            size -= len;
+        }
+    }
+
+    // 第2步：剩下的放进新块（按剩余大小分配，池取整到级别大小，多出来的就是尾部空间）
+    // 小消息只占一个小级别，不占整页；要反复追加的场景用Reserve/Commit
+    if (size > 0) {
+        Block* block = NewBlock(size);
+        memcpy(block->data, data, size);
+        PushSlice(block, 0, size);
+    }
+}
+
+void CIOBuf::Append(const CIOBuf& buf)
+{
+    // 先记下范围：buf可能就是*this（push_back会让迭代器失效，所以按下标取）
+    size_t begin = buf.m_head, end = buf.m_slices.size();
+    for (size_t i = begin; i < end; i++) {
+        Segment s = buf.m_slices[i];
+        if (s.length == 0) continue;
+        Ref(s.block);
+        PushSlice(s.block, s.offset, s.length);
+    }
+}
+
+void CIOBuf::Append(CIOBuf&& buf)
+{
+    if (Empty() && Count() == 0) {
+        *this = std::move(buf);
+        return;
+    }
+    // 引用直接转移过来，不用加减计数
+    for (size_t i = buf.m_head; i < buf.m_slices.size(); i++) {
+        const Segment& s = buf.m_slices[i];
+        if (s.length == 0) {
+            Unref(s.block);
+            continue;
+        }
+        PushSlice(s.block, s.offset, s.length);
+    }
+    buf.m_slices.clear();
+    buf.m_head = 0;
+    buf.m_size = 0;
+}
+
+void CIOBuf::Append(std::string&& data)
+{
+    if (data.empty()) return;
+    size_t size = data.size();
+    PushSlice(AdoptBlock(std::move(data)), 0, size);
+}
+
+char* CIOBuf::Reserve(size_t n)
+{
+    if (Count() > 0 && Unique(Back())) {
+        Segment& s = Back();
+        size_t end = s.offset + s.length;
+        if (s.block->capacity - end >= n) return s.block->data + end;
+    }
+    Block* block = NewBlock(n > IOBUF_BLOCK_DATA ? n : IOBUF_BLOCK_DATA);
+    PushSlice(block, 0, 0);
+    return block->data;
+}
+
+void CIOBuf::Commit(size_t n)
+{
+    if (Count() == 0) return;
+    Back().length += n;
+    m_size += n;
+}
+
+void CIOBuf::Prepend(const char* data, size_t size)
+{
+    if (size == 0) return;
+
+    // 第1步：第一块的头部空间够 → 原地写
+    if (Count() > 0 && Unique(Front()) && Front().offset >= size) {
+        Segment& s = Front();
+        s.offset -= size;
+        s.length += size;
+        memcpy(s.block->data + s.offset, data, size);
+        m_size += size;
+        return;
+    }
+
+    // 第2步：前面插一个新块（数据放在块尾，前面再留出头部空间）
+    Block* block = NewBlock(IOBUF_HEADROOM + size);
+    memcpy(block->data + IOBUF_HEADROOM, data, size);
+    Segment s = { block, IOBUF_HEADROOM, size };
+    if (m_head > 0) {
+        m_slices[--m_head] = s;
+    }
+    else {
+        m_slices.insert(m_slices.begin(), s);
+    }
+    m_size += size;
+}
+
+// ==================== 切片 ====================
+CIOBuf CIOBuf::Slice(size_t offset, size_t length) const
+{
+    CIOBuf result;
+    for (size_t i = m_head; i < m_slices.size() && length > 0; i++) {
+        const Segment& s = m_slices[i];
+        if (offset >= s.length) {
+            offset -= s.length;
+            continue;
+        }
+        size_t len = s.length - offset;
+        if (len > length) len = length;
+        Ref(s.block);
+        result.PushSlice(s.block, s.offset + offset, len);
+        length -= len;
+        offset = 0;
+    }
+    return result;
+}
+
+void CIOBuf::TrimStart(size_t n)
+{
+    while (n > 0 && Count() > 0) {
+        Segment& s = Front();
+        if (n < s.length) {
+            s.offset += n;
+            s.length -= n;
+            m_size -= n;
+            return;
+        }
+        n -= s.length;
+        m_size -= s.length;
+        PopFront();
+    }
+}
+
+void CIOBuf::TrimEnd(size_t n)
+{
+    while (n > 0 && Count() > 0) {
+        Segment& s = Back();
+        if (n < s.length) {
+            s.length -= n;
+            m_size -= n;
+            return;
+        }
+        n -= s.length;
+        m_size -= s.length;
+        Unref(s.block);
+        m_slices.pop_back();
+    }
+    if (Count() == 0) {
+        m_slices.clear();
+        m_head = 0;
+    }
+}
+
+// ==================== 读取 ====================
+int CIOBuf::Gather(iovec* iov, int max) const
+{
+    int count = 0;
+    for (size_t i = m_head; i < m_slices.size() && count < max; i++) {
+        const Segment& s = m_slices[i];
+        if (s.length == 0) continue;
+        iov[count].iov_base = s.block->data + s.offset;
+        iov[count].iov_len = s.length;
+        count++;
+    }
+    return count;
+}
+
+const char* CIOBuf::Coalesce()
+{
+    if (m_size == 0) return "";
+
+    // 跳过空切片后只剩一段：已经连续
+    unsigned nonEmpty = 0;
+    const Segment* last = NULL;
+    for (size_t i = m_head; i < m_slices.size(); i++) {
+        if (m_slices[i].length > 0) {
+            nonEmpty++;
+            last = &m_slices[i];
+        }
+    }
+    if (nonEmpty == 1) return last->block->data + last->offset;
+
+    Block* block = NewBlock(m_size);
+    size_t size = CopyTo(block->data, 0, m_size);
+    Clear();
+    PushSlice(block, 0, size);
+    return block->data;
+}
+
+size_t CIOBuf::CopyTo(void* dst, size_t offset, size_t n) const
+{
+    char* out = (char*)dst;
+    size_t copied = 0;
+    for (size_t i = m_head; i < m_slices.size() && copied < n; i++) {
+        const Segment& s = m_slices[i];
+        if (offset >= s.length) {
+            offset -= s.length;
+            continue;
+        }
+        size_t len = s.length - offset;
+        if (len > n - copied) len = n - copied;
+        memcpy(out + copied, s.block->data + s.offset + offset, len);
+        copied += len;
+        offset = 0;
+    }
+    return copied;
+}
+
+std::string CIOBuf::ToString() const
+{
+    std::string result;
+    result.resize(m_size);
+    if (m_size > 0) CopyTo(&result[0], 0, m_size);
+    return result;
+}
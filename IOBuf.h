@@ -0,0 +1,147 @@
+#pragma once
+#include <sys/uio.h>     // iovec, readv, writev
+#include <stddef.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+// 新分配的块默认多大（小消息会拼进同一块的尾部）
+#define IOBUF_BLOCK_SIZE 4096
+// 新块前面预留多少字节给协议头（Prepend不用搬移负载）
+#define IOBUF_HEADROOM 64
+// 一次writev最多带多少段
+#define IOBUF_IOV_MAX 64
+
+// ============================================
+// CIOBuf类：引用计数的零拷贝缓冲区链
+//
+// 问题：Buffer就是std::string
+//   - 按值传递、LogInfo转Buffer、交给线程池任务，每次都整块拷贝
+//   - 加协议头要在前面insert（负载整体后移）
+//   - 一个包从recv到业务处理要被拷贝3~4次
+//
+// 做法：数据放在带引用计数的块（Block）里，CIOBuf只是一串切片
+//   ┌────────── Block A ──────────┐   ┌──── Block B ────┐
+//   │ 头部空间 │ 切片0 │ 尾部空间 │   │     切片1       │
+//   └─────────────────────────────┘   └─────────────────┘
+//   1. 拷贝CIOBuf = 共享块，只把引用计数+1（线程安全，可以交给别的线程）
+//   2. Slice()/TrimStart()/TrimEnd()只改切片的偏移和长度
+//   3. Prepend()优先写进第一块的头部空间，负载不动
+//   4. Gather()把所有切片转成iovec，交给writev一次发出
+//
+// 写入规则：块只被一个切片引用时（引用计数=1）才允许往它的头部/尾部空间写，
+//          共享的块只读，写入时自动另起新块（不会改到别人看到的数据）
+//
+// 用法：
+//   CIOBuf pkt(IOBUF_BLOCK_SIZE);           // 预留头部空间
+//   char* p = pkt.Reserve(n);               // 直接recv进来
+//   pkt.Commit(ret);
+//   CIOBuf body = pkt.Slice(4, len);        // 去掉包头，不拷贝
+//   body.Prepend((char*)&head, sizeof(head));  // 加新包头，不搬移负载
+//   client->Send(body);                     // writev
+// ============================================
+class CIOBuf
+{
+public:
+    CIOBuf();
+    ~CIOBuf();
+
+    // 预分配一块：capacity字节可写，前面留headroom字节给Prepend
+    explicit CIOBuf(size_t capacity, size_t headroom = IOBUF_HEADROOM);
+
+    // 拷贝一次数据进新块（之后的传递都不再拷贝）
+    CIOBuf(const char* data, size_t size);
+
+    // 接管std::string（Buffer）的内存，不拷贝
+    explicit CIOBuf(std::string&& data);
+
+    // 拷贝 = 共享块（引用计数+1）
+    CIOBuf(const CIOBuf& buf);
+    CIOBuf& operator=(const CIOBuf& buf);
+    CIOBuf(CIOBuf&& buf) noexcept;
+    CIOBuf& operator=(CIOBuf&& buf) noexcept;
+
+    // -------------------- 查询 --------------------
+    size_t Size() const { return m_size; }
+    bool Empty() const { return m_size == 0; }
+    unsigned Count() const { return (unsigned)(m_slices.size() - m_head); }  // 切片数
+    bool IsShared() const;   // 是否有块被别的CIOBuf共享
+
+    void Clear();
+
+    // -------------------- 写入 --------------------
+
+    // 追加（拷贝）：先填满最后一块的尾部空间，不够再按剩余大小分配新块（小消息不占整页）
+    void Append(const char* data, size_t size);
+
+    // 追加另一个链（共享块，不拷贝）
+    void Append(const CIOBuf& buf);
+    void Append(CIOBuf&& buf);
+
+    // 追加std::string（接管内存，不拷贝）
+    void Append(std::string&& data);
+
+    // 取得至少n字节的连续尾部空间（不够就追加一个整页新块），写完后Commit
+    // 流式累积（接收缓冲、发送队列合并）用这个，后续小块接着写进同一页
+    char* Reserve(size_t n);
+    void Commit(size_t n);
+
+    // 在最前面加数据：第一块头部空间够就原地写，否则在前面插入新块
+    void Prepend(const char* data, size_t size);
+
+    // -------------------- 切片 --------------------
+
+    // 取[offset, offset+length)，共享块（越界部分截掉）
+    CIOBuf Slice(size_t offset, size_t length) const;
+
+    // 去掉前n字节 / 后n字节（已经完全不用的块会被释放）
+    void TrimStart(size_t n);
+    void TrimEnd(size_t n);
+
+    // -------------------- 读取 --------------------
+
+    // 切片 → iovec，最多max段，返回段数
+    int Gather(iovec* iov, int max) const;
+
+    // 合并成一段连续内存（多于一个切片时拷贝一次），返回数据指针
+    const char* Coalesce();
+
+    // 从offset开始拷贝最多n字节到dst，返回实际拷贝的字节数
+    size_t CopyTo(void* dst, size_t offset, size_t n) const;
+
+    // 拷贝成std::string（兼容只接受Buffer的旧接口）
+    std::string ToString() const;
+
+private:
+    // 引用计数的数据块
+    struct Block {
+        std::atomic<int> ref;
+        size_t capacity;
+        char* data;
+        std::string owned;   // 接管的std::string（普通块为空，数据紧跟在Block后面）
+    };
+
+    struct Segment {
+        Block* block;
+        size_t offset;   // 在block->data中的起始位置
+        size_t length;
+    };
+
+    static Block* NewBlock(size_t capacity);
+    static Block* AdoptBlock(std::string&& data);
+    static void Ref(Block* block) { block->ref.fetch_add(1, std::memory_order_relaxed); }
+    static void Unref(Block* block);
+
+    // 块只被这一个切片引用 → 头部/尾部空间可写
+    static bool Unique(const Segment& s) { return s.block->ref.load(std::memory_order_acquire) == 1; }
+
+    Segment& Front() { return m_slices[m_head]; }
+    Segment& Back() { return m_slices.back(); }
+    void PushSlice(Block* block, size_t offset, size_t length);  // 接管一个引用
+    void PopFront();
+
+private:
+    std::vector<Segment> m_slices; // 切片（[m_head, end)有效，头部弹出时不搬移）
+    size_t m_head;                 // 第一个有效切片的下标
+    size_t m_size;                 // 总字节数
+};
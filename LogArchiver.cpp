@@ -0,0 +1,157 @@
+#include "LogArchiver.h"
+#include <algorithm>
+#include <spawn.h>          // posix_spawnp
+#include <sys/wait.h>       // waitpid
+#include <sys/resource.h>   // setpriority
+#include <sys/syscall.h>    // SYS_gettid
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+
+extern char** environ;
+
+CLogArchiver::CLogArchiver()
+{
+    m_stop = false;
+    m_busy = false;
+    m_running = false;
+    m_keep = 0;
+    m_compress = false;
+}
+
+int CLogArchiver::Start(const std::string& dir, unsigned keep, bool compress)
+{
+    if (m_running) return -1;
+    m_dir = dir;
+    m_keep = keep;
+    m_compress = compress;
+    m_stop = false;
+    try {
+        m_thread = std::thread(&CLogArchiver::ThreadFunc, this);
+    }
+    catch (...) {
+        return -2;
+    }
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_running = true;
+    return 0;
+}
+
+void CLogArchiver::Stop()
+{
+    if (!m_running) return;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();   // 后台线程处理完队列才退出
+
+    // 加锁改，再唤醒：Wait()的条件里读m_running，不唤醒的话它可能一直睡着
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_running = false;
+    }
+    m_cond.notify_all();
+}
+
+void CLogArchiver::Submit(const std::string& path, const std::string& active)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_queue.push_back(path);
+        m_active = active;
+    }
+    m_cond.notify_one();
+}
+
+void CLogArchiver::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_cond.wait(lock, [this]() { return (m_queue.empty() && !m_busy) || !m_running; });
+}
+
+bool CLogArchiver::IsLogName(const std::string& name)
+{
+    // "2025-01-15 14-30-25 123" 开头（数字和分隔符的位置都要对），".log"/".blog"（二进制格式）结尾，可以再加".gz"
+    static const char pattern[] = "0000-00-00 00-00-00 000";
+    size_t n = sizeof(pattern) - 1;
+    if (name.size() < n + 4) return false;
+    for (size_t i = 0; i < n; i++) {
+        bool digit = name[i] >= '0' && name[i] <= '9';
+        if (pattern[i] == '0' ? !digit : name[i] != pattern[i]) return false;
+    }
+    size_t len = name.size();
+    if (len >= n + 7 && name.compare(len - 3, 3, ".gz") == 0) len -= 3;
+    if (name.compare(len - 4, 4, ".log") == 0) return true;
+    return len >= n + 5 && name.compare(len - 5, 5, ".blog") == 0;
+}
+
+int CLogArchiver::Compress(const std::string& path)
+{
+    // gzip -f：原文件换成 .gz（gzip自己先写完再删原文件，中途失败原文件还在）
+    char arg0[] = "gzip";
+    char arg1[] = "-f";
+    char arg2[] = "--";
+    std::string file = path;
+    char* argv[] = { arg0, arg1, arg2, &file[0], NULL };
+    pid_t pid;
+    if (posix_spawnp(&pid, "gzip", NULL, NULL, argv, environ) != 0) return -1;
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return 0;   // 别人回收了（比如SIGCHLD被忽略），当作完成
+    }
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -2;
+}
+
+void CLogArchiver::Retain()
+{
+    if (m_keep == 0) return;
+    std::string active;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        active = m_active;   // 压缩期间日志线程可能又轮转了：用最新的
+    }
+    DIR* dir = opendir(m_dir.c_str());
+    if (dir == NULL) return;
+    std::vector<std::string> names;
+    dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        std::string name = entry->d_name;
+        if (name != active && IsLogName(name)) names.push_back(name);
+    }
+    closedir(dir);
+
+    // 名字就是时间：排序后前面的最旧
+    if (names.size() <= m_keep) return;
+    std::sort(names.begin(), names.end());
+    for (size_t i = 0; i + m_keep < names.size(); i++) {
+        unlink((m_dir + "/" + names[i]).c_str());
+    }
+}
+
+void CLogArchiver::ThreadFunc()
+{
+    // 最低优先级（gzip子进程继承）
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+
+    std::unique_lock<std::mutex> lock(m_lock);
+    while (true) {
+        m_cond.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty()) break;   // 只有m_stop：队列已经处理完了才退出
+
+        std::string path = m_queue.front();
+        m_queue.pop_front();
+        m_busy = true;
+        lock.unlock();
+
+        if (m_compress && access(path.c_str(), F_OK) == 0) Compress(path);   // 可能已经被清理掉了
+        Retain();
+
+        lock.lock();
+        m_busy = false;
+        m_cond.notify_all();   // Wait()
+    }
+}
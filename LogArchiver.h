@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// ============================================
+// CLogArchiver类：轮转下来的日志文件的后台处理（压缩 + 保留数量）
+//
+// 问题：压缩一个几百MB的日志要好几秒，放在日志线程里做，这几秒所有生产者的环都没人读
+//
+// 做法：
+//   1. 日志线程轮转后只把旧文件名交给Submit（加锁入队，立即返回）
+//   2. 后台线程把自己的nice值调到19（Linux上nice是按线程的，启动的gzip进程继承），
+//      逐个调用gzip压缩：和游戏线程、日志线程抢CPU时总是让路
+//   3. 每处理完一个文件按名字（就是时间）排序，只保留最近keep个归档文件，
+//      正在写的文件永远不删；只认 "时间.log" / "时间.log.gz"（二进制格式是.blog）这种名字，目录里别的文件不动
+//   4. Stop先把队列里已经交来的文件都处理完再退出（退出时最后一次轮转的文件也会被压缩）
+//
+// 用法：
+//   CLogArchiver archiver;
+//   archiver.Start("./log", 30, true);
+//   archiver.Submit("./log/2025-01-15 14-30-25 123.log", "2025-01-15 15-30-25 456.log");
+//   archiver.Stop();
+// ============================================
+class CLogArchiver
+{
+public:
+    CLogArchiver();
+    ~CLogArchiver() { Stop(); }
+    CLogArchiver(const CLogArchiver&) = delete;
+    CLogArchiver& operator=(const CLogArchiver&) = delete;
+
+    // dir：日志目录；keep：保留的归档文件数（0不限）；compress：是否gzip
+    // 返回值：0成功，-1已启动，-2创建线程失败
+    int Start(const std::string& dir, unsigned keep, bool compress);
+    void Stop();
+    bool IsRunning() const { return m_running; }
+
+    // 交来一个刚轮转下来的文件；active是现在正在写的文件名（不带目录，清理时跳过）
+    void Submit(const std::string& path, const std::string& active);
+
+    // 等队列处理完（测试用）
+    void Wait();
+
+    // 日志目录里这个名字是不是日志文件（"时间.log" / "时间-N.log" / 二进制的".blog" / 加 ".gz"）
+    static bool IsLogName(const std::string& name);
+
+private:
+    void ThreadFunc();
+    static int Compress(const std::string& path);
+    void Retain();
+
+private:
+    std::thread m_thread;
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    std::deque<std::string> m_queue;
+    std::string m_active;
+    bool m_stop;
+    bool m_busy;          // 后台线程正在处理一个文件
+    bool m_running;
+
+    std::string m_dir;
+    unsigned m_keep;
+    bool m_compress;
+};
@@ -0,0 +1,469 @@
+#include "LogBinary.h"
+#include "LogWriter.h"
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/wait.h>   // waitpid
+#include <spawn.h>      // posix_spawnp
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+extern char** environ;
+
+static uint64_t BinaryNowMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// 时间差可能是负的（不同线程的环是一个一个读的）：zigzag，小的负数也只占1、2个字节
+static uint64_t ZigZag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+static int64_t UnZigZag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+// ==================== CLogBinaryWriter ====================
+CLogBinaryWriter::CLogBinaryWriter()
+{
+    m_out = NULL;
+    m_count = 0;
+    m_first = 0;
+    m_last = 0;
+    m_mark = 0;
+    m_prev = 0;
+    m_opened = 0;
+    m_level = 0;
+    m_blockSeq = 1;
+    m_block.reserve(LOG_BLOCK_SIZE + 4096);
+}
+
+void CLogBinaryWriter::PutVarint(uint64_t value)
+{
+    char buf[10];
+    int n = 0;
+    while (value >= 0x80) {
+        buf[n++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = (char)value;
+    m_block.append(buf, n);
+}
+
+void CLogBinaryWriter::Strings(const LogSiteInfo& site, uint32_t ids[3])
+{
+    const char* strings[3] = { site.file, site.func, site.fmt != NULL ? site.fmt : "" };
+    for (int i = 0; i < 3; i++) {
+        auto it = m_ids.find(strings[i]);
+        if (it == m_ids.end()) {
+            uint32_t id = (uint32_t)m_strings.size();
+            m_strings.push_back(strings[i]);
+            m_defined.push_back(0);
+            it = m_ids.emplace(strings[i], id).first;
+        }
+        ids[i] = it->second;
+    }
+}
+
+// 这个字符串在本块里还没定义过：先写一条STRING记录
+void CLogBinaryWriter::Define(uint32_t id)
+{
+    if (m_defined[id] == m_blockSeq) return;
+    m_defined[id] = m_blockSeq;
+    const std::string& s = m_strings[id];
+    m_block += (char)LOG_BIN_STRING;
+    PutVarint(id);
+    PutVarint(s.size());
+    m_block += s;
+}
+
+void CLogBinaryWriter::Begin(int type, int level, pid_t pid, pid_t tid, uint64_t ns)
+{
+    // 块头的位置先留着，交出去的时候再填
+    if (m_block.empty()) m_block.assign(LOG_BLOCK_HEADER, '\0');
+    if (m_count == 0) {
+        m_first = m_last = ns;
+        m_prev = 0;
+        m_opened = BinaryNowMs();
+        m_level = 0;
+    }
+    if (ns < m_first) m_first = ns;
+    if (ns > m_last) m_last = ns;
+    if (level > m_level) m_level = level;
+
+    m_block += (char)type;
+    PutVarint((uint64_t)level);
+    PutVarint((uint64_t)(uint32_t)pid);
+    PutVarint((uint64_t)(uint32_t)tid);
+    PutVarint(ZigZag((int64_t)(ns - m_prev)));
+    m_prev = ns;
+    m_count++;
+}
+
+void CLogBinaryWriter::Event(int level, pid_t pid, pid_t tid, uint64_t ns, const LogSiteInfo& site,
+    const char* args, size_t size)
+{
+    uint32_t ids[3];
+    Strings(site, ids);
+    EventIds(level, pid, tid, ns, ids, site.line, site.kind, args, size);
+}
+
+void CLogBinaryWriter::EventIds(int level, pid_t pid, pid_t tid, uint64_t ns, const uint32_t ids[3], int line,
+    int kind, const char* args, size_t size)
+{
+    if (m_out == NULL) return;
+    if (m_block.size() >= LOG_BLOCK_SIZE) Flush();   // 在两条记录之间换块
+
+    // 第1步：本块里还没定义的字符串先定义（新块先留好块头）
+    if (m_block.empty()) m_block.assign(LOG_BLOCK_HEADER, '\0');
+    for (int i = 0; i < 3; i++) Define(ids[i]);
+
+    // 第2步：记录
+    Begin(LOG_BIN_EVENT, level, pid, tid, ns);
+    PutVarint(ids[0]);
+    PutVarint((uint64_t)(uint32_t)line);
+    PutVarint(ids[1]);
+    PutVarint((uint64_t)kind);
+    PutVarint(ids[2]);
+    PutVarint(size);
+    m_block.append(args, size);
+}
+
+void CLogBinaryWriter::Text(int level, pid_t pid, pid_t tid, uint64_t ns, const char* data, size_t size)
+{
+    if (m_out == NULL) return;
+    if (m_block.size() >= LOG_BLOCK_SIZE) Flush();
+    Begin(LOG_BIN_TEXT, level, pid, tid, ns);
+    PutVarint(size);
+    m_block.append(data, size);
+}
+
+int CLogBinaryWriter::Poll()
+{
+    if (m_count == 0) return 0;
+    if (m_block.size() >= LOG_BLOCK_SIZE || m_level >= 3 || BinaryNowMs() - m_opened >= LOG_BLOCK_MS) {
+        Flush();
+        return 1;
+    }
+    return 0;
+}
+
+void CLogBinaryWriter::Flush()
+{
+    if (m_count == 0 || m_out == NULL) return;
+
+    // 第1步：填块头
+    char* p = &m_block[0];
+    uint32_t length = (uint32_t)(m_block.size() - LOG_BLOCK_HEADER);
+    memcpy(p, LOG_BLOCK_SYNC, LOG_BLOCK_SYNC_SIZE);
+    memcpy(p + 8, &length, 4);
+    memcpy(p + 12, &m_count, 4);
+    // 块头的最晚时间不小于前面的块：不同线程的记录时间会交错、飞行记录转储的时间更早，
+    // 抬高到前面所有块的最晚时间，文件里块头的最晚时间单调不减，Seek才能二分
+    if (m_last < m_mark) m_last = m_mark;
+    m_mark = m_last;
+    memcpy(p + 16, &m_first, 8);
+    memcpy(p + 24, &m_last, 8);
+    uint32_t sum = CLogBinaryReader::Checksum(p, 32);
+    memcpy(p + 32, &sum, 4);
+
+    // 第2步：整块交给writer（按块里最高的级别决定要不要这一轮就写）
+    m_out->Append(m_block.data(), m_block.size(), m_level);
+    m_block.clear();
+    m_count = 0;
+    m_blockSeq++;   // 下一块的字符串重新定义
+}
+
+// ==================== CLogBinaryReader ====================
+CLogBinaryReader::CLogBinaryReader()
+{
+    m_file = NULL;
+    m_pipe = false;
+    m_child = -1;
+    m_size = 0;
+    m_offset = 0;
+    m_pos = NULL;
+    m_prev = 0;
+    m_blocks = 0;
+    m_bytesRead = 0;
+    m_corrupt = 0;
+}
+
+uint32_t CLogBinaryReader::Checksum(const char* data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int CLogBinaryReader::Open(const char* path)
+{
+    Close();
+    size_t len = strlen(path);
+    if (len > 3 && strcmp(path + len - 3, ".gz") == 0) {
+        // 压缩过的归档：只能顺序读。先确认文件在（gzip找不到文件时管道只是空的，分不出来）
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return -1;
+
+        // 不经过shell：路径原样作为参数，子进程的标准输出接到管道
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0) return -1;
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+        char arg0[] = "gzip";
+        char arg1[] = "-dc";
+        char arg2[] = "--";
+        std::string file = path;
+        char* argv[] = { arg0, arg1, arg2, &file[0], NULL };
+        pid_t pid;
+        int ret = posix_spawnp(&pid, "gzip", &actions, NULL, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(fds[1]);
+        if (ret != 0) {
+            close(fds[0]);
+            return -1;
+        }
+        m_file = fdopen(fds[0], "rb");
+        if (m_file == NULL) {
+            close(fds[0]);
+            waitpid(pid, NULL, 0);
+            return -1;
+        }
+        m_child = pid;
+        m_pipe = true;
+    }
+    else {
+        m_file = fopen(path, "rb");
+        struct stat st;
+        if (m_file != NULL && fstat(fileno(m_file), &st) == 0) m_size = (uint64_t)st.st_size;
+    }
+    return m_file != NULL ? 0 : -1;
+}
+
+void CLogBinaryReader::Close()
+{
+    if (m_file != NULL) fclose(m_file);
+    if (m_child > 0) {
+        // 没读完就关：gzip写管道会收到SIGPIPE退出
+        while (waitpid(m_child, NULL, 0) < 0 && errno == EINTR) {}
+    }
+    m_file = NULL;
+    m_pipe = false;
+    m_child = -1;
+    m_size = 0;
+    m_offset = 0;
+    m_data.clear();
+    m_pos = NULL;
+    m_strings.clear();
+}
+
+bool CLogBinaryReader::ParseHeader(const char* p, Header& header)
+{
+    if (memcmp(p, LOG_BLOCK_SYNC, LOG_BLOCK_SYNC_SIZE) != 0) return false;
+    uint32_t sum;
+    memcpy(&sum, p + 32, 4);
+    if (sum != Checksum(p, 32)) return false;
+    memcpy(&header.length, p + 8, 4);
+    memcpy(&header.count, p + 12, 4);
+    memcpy(&header.first, p + 16, 8);
+    memcpy(&header.last, p + 24, 8);
+    return header.length <= LOG_BLOCK_MAX;
+}
+
+int CLogBinaryReader::ReadAt(uint64_t offset, char* buf, size_t size)
+{
+    if (fseeko(m_file, (off_t)offset, SEEK_SET) != 0) return -1;
+    size_t n = fread(buf, 1, size, m_file);
+    m_bytesRead += n;
+    return (int)n;
+}
+
+int CLogBinaryReader::FindBlock(uint64_t& offset, uint64_t limit, Header& header)
+{
+    // 一次读一小段往后找同步标记（段之间重叠一个块头，标记跨段也能找到）
+    // 二分时平均要跨过半个块才碰到下一个块头，段小一点少读些没用的数据
+    std::vector<char> buf(8 * 1024);
+    while (offset < limit && offset + LOG_BLOCK_HEADER <= m_size) {
+        size_t want = buf.size();
+        if (limit - offset + LOG_BLOCK_HEADER < want) want = (size_t)(limit - offset + LOG_BLOCK_HEADER);
+        int n = ReadAt(offset, &buf[0], want);
+        if (n < LOG_BLOCK_HEADER) return -1;
+        for (int i = 0; i + LOG_BLOCK_HEADER <= n && offset + i < limit; i++) {
+            if (buf[i] != LOG_BLOCK_SYNC[0] || !ParseHeader(&buf[i], header)) continue;
+            if (offset + i + LOG_BLOCK_HEADER + header.length > m_size) continue;   // 写了一半的块
+            offset += i;
+            return 0;
+        }
+        offset += (uint64_t)(n - LOG_BLOCK_HEADER + 1);
+    }
+    return -1;
+}
+
+int CLogBinaryReader::Seek(uint64_t ns)
+{
+    if (m_file == NULL) return -1;
+    m_data.clear();
+    m_pos = NULL;
+
+    if (m_pipe) {
+        // 顺序读：跳过整块都早于ns的块
+        while (ReadBlock() == 1) {
+            Header header;
+            ParseHeader(m_data.data(), header);
+            if (header.last >= ns) return 0;
+        }
+        return -1;
+    }
+
+    // 二分：[lo, hi]之间有第一个 最晚时间 >= ns 的块
+    uint64_t lo = 0, hi = m_size;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        uint64_t offset = mid;
+        Header header;
+        if (FindBlock(offset, hi, header) != 0) {
+            hi = mid;   // [mid, hi)里没有块
+            continue;
+        }
+        if (header.last < ns) lo = offset + LOG_BLOCK_HEADER + header.length;
+        else hi = offset;
+    }
+    m_offset = lo;
+    return m_offset < m_size ? 0 : -1;
+}
+
+int CLogBinaryReader::ReadBlock()
+{
+    // 整块读进m_data（开头保留块头，Seek顺序读时要看时间）
+    m_pos = NULL;
+    Header header;
+    if (m_pipe) {
+        // 管道：逐字节对齐到同步标记
+        char head[LOG_BLOCK_HEADER];
+        if (fread(head, 1, LOG_BLOCK_HEADER, m_file) != LOG_BLOCK_HEADER) return 0;
+        m_bytesRead += LOG_BLOCK_HEADER;
+        while (!ParseHeader(head, header)) {
+            memmove(head, head + 1, LOG_BLOCK_HEADER - 1);
+            int c = fgetc(m_file);
+            if (c == EOF) return 0;
+            head[LOG_BLOCK_HEADER - 1] = (char)c;
+            m_bytesRead++;
+        }
+        m_data.assign(head, LOG_BLOCK_HEADER);
+        m_data.resize(LOG_BLOCK_HEADER + header.length);
+        if (fread(&m_data[LOG_BLOCK_HEADER], 1, header.length, m_file) != header.length) return 0;
+        m_bytesRead += header.length;
+    }
+    else {
+        // 通常下一块就紧挨着；对不上（坏块、写了一半）才往后找
+        uint64_t offset = m_offset;
+        char head[LOG_BLOCK_HEADER];
+        if (ReadAt(offset, head, LOG_BLOCK_HEADER) != LOG_BLOCK_HEADER) return 0;
+        if (!ParseHeader(head, header) || offset + LOG_BLOCK_HEADER + header.length > m_size) {
+            if (FindBlock(offset, m_size, header) != 0) {
+                m_offset = m_size;
+                return 0;
+            }
+            m_corrupt++;
+        }
+        m_data.resize(LOG_BLOCK_HEADER + header.length);
+        if (ReadAt(offset, &m_data[0], m_data.size()) != (int)m_data.size()) return 0;
+        m_offset = offset + m_data.size();
+    }
+    m_blocks++;
+    m_pos = m_data.data() + LOG_BLOCK_HEADER;
+    m_prev = 0;
+    return 1;
+}
+
+static bool GetVarint(const char*& p, const char* end, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char c = (unsigned char)*p++;
+        value |= (uint64_t)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+int CLogBinaryReader::Next(LogBinaryRecord& record)
+{
+    while (true) {
+        if (m_pos == NULL || m_pos >= m_data.data() + m_data.size()) {
+            if (ReadBlock() != 1) return 0;
+        }
+        const char* end = m_data.data() + m_data.size();
+        const char* p = m_pos;
+        int type = (unsigned char)*p++;
+        uint64_t v[6];
+        bool ok = true;
+
+        if (type == LOG_BIN_STRING) {
+            ok = GetVarint(p, end, v[0]) && GetVarint(p, end, v[1]) && v[1] <= (uint64_t)(end - p) && v[0] < LOG_SITE_MAX;
+            if (ok) {
+                if (m_strings.size() <= v[0]) m_strings.resize(v[0] + 1);
+                m_strings[v[0]].assign(p, (size_t)v[1]);
+                m_pos = p + v[1];
+                continue;
+            }
+        }
+        else if (type == LOG_BIN_EVENT || type == LOG_BIN_TEXT) {
+            // 公共部分：级别 pid tid 时间差
+            ok = GetVarint(p, end, v[0]) && GetVarint(p, end, v[1]) && GetVarint(p, end, v[2]) && GetVarint(p, end, v[3]);
+            if (ok) {
+                record.type = type;
+                record.level = (int)v[0];
+                record.pid = (pid_t)v[1];
+                record.tid = (pid_t)v[2];
+                record.ns = m_prev + (uint64_t)UnZigZag(v[3]);
+                m_prev = record.ns;
+            }
+            if (ok && type == LOG_BIN_EVENT) {
+                // 文件 行号 函数 种类 格式串 参数
+                ok = GetVarint(p, end, v[0]) && GetVarint(p, end, v[1]) && GetVarint(p, end, v[2]) &&
+                    GetVarint(p, end, v[3]) && GetVarint(p, end, v[4]) && GetVarint(p, end, v[5]) &&
+                    v[0] < m_strings.size() && v[2] < m_strings.size() && v[4] < m_strings.size() &&
+                    v[5] <= (uint64_t)(end - p);
+                if (ok) {
+                    record.site.file = m_strings[v[0]].c_str();
+                    record.site.line = (int)v[1];
+                    record.site.func = m_strings[v[2]].c_str();
+                    record.site.kind = (int)v[3];
+                    record.site.fmt = m_strings[v[4]].c_str();
+                    record.data = p;
+                    record.size = (size_t)v[5];
+                }
+            }
+            else if (ok) {
+                ok = GetVarint(p, end, v[0]) && v[0] <= (uint64_t)(end - p);
+                if (ok) {
+                    record.data = p;
+                    record.size = (size_t)v[0];
+                }
+            }
+            if (ok) {
+                m_pos = record.data + record.size;
+                return 1;
+            }
+        }
+
+        // 坏数据（或者不认识的类型）：这一块剩下的丢掉
+        m_corrupt++;
+        m_pos = NULL;
+        m_data.clear();
+    }
+}
+
+int CLogBinaryReader::Format(const LogBinaryRecord& record, std::string& out)
+{
+    if (record.type == LOG_BIN_TEXT) {
+        out.append(record.data, record.size);
+        return 0;
+    }
+    return CLogFormatter::FormatLine(record.site, record.level, record.ns, record.pid, record.tid,
+        record.data, record.size, out);
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "LogFormat.h"
+
+class CLogWriter;
+
+// 块的同步标记（每个块的开头；解码器从任意位置往后找它来定位块）
+#define LOG_BLOCK_SYNC "\xF7GLOGBLK"
+#define LOG_BLOCK_SYNC_SIZE 8
+// 块头：同步标记(8) + 负载长度(4) + 记录数(4) + 最早时间(8) + 最晚时间(8，不小于前面的块) + 校验(4)
+#define LOG_BLOCK_HEADER 36
+// 块攒到这么大就写出（一个块是解码器定位的最小单位）
+#define LOG_BLOCK_SIZE (64 * 1024)
+// 块最多攒这么久（毫秒，和CLogWriter的默认刷盘间隔一致）
+#define LOG_BLOCK_MS 50
+// 解码器认为合法的块负载上限（超过就当成是误认的同步标记）
+#define LOG_BLOCK_MAX (64 * 1024 * 1024)
+
+// 块里的记录类型（每条记录第1个字节）
+enum LogBinaryType {
+    LOG_BIN_STRING = 1,   // 字符串表：id、长度、字节
+    LOG_BIN_EVENT = 2,    // 延迟格式化的一条：级别、pid、tid、时间差、文件/行号/函数/种类/格式串、参数区
+    LOG_BIN_TEXT = 3,     // 已经是文本的一行（TRACEI/LOGI等、socket兜底）：级别、pid、tid、时间差、文本
+};
+
+// 解码出来的一条记录（指针指向读取器的缓冲，读下一块之前有效）
+struct LogBinaryRecord
+{
+    int type;             // LOG_BIN_EVENT / LOG_BIN_TEXT
+    int level;
+    pid_t pid;
+    pid_t tid;
+    uint64_t ns;          // 墙上时间（纳秒）
+    LogSiteInfo site;     // LOG_BIN_EVENT
+    const char* data;     // EVENT：参数区（CLogArgs编码）；TEXT：一行文本（含换行）
+    size_t size;
+};
+
+// ============================================
+// CLogBinaryWriter：结构化的二进制日志（CLoggerServer::SetFileFormat(LOG_FILE_BINARY)）
+//
+// 问题：CLoggerServer写的都是自由格式的文本：日志线程要把每条延迟格式化的记录还原成文本，
+//      查问题时只能grep整天的日志，几十GB要好几分钟
+//
+// 做法：
+//   1. 延迟格式化的记录不再格式化：格式点ID换成字符串表里的ID，参数区原样写
+//      （整数字段都是varint，时间是和上一条的差，zigzag编码）
+//   2. 文件、函数、格式串进字符串表：ID全文件唯一，但每个块里第一次用到时都重新定义一次
+//      → 每个块都能单独解码
+//   3. 记录攒成块（64KB或50ms），块头带同步标记、这一块的最早/最晚时间和校验，
+//      整块交给CLogWriter：轮转只发生在两批之间，文件里总是完整的块
+//   4. 块头就是稀疏的时间索引：解码器按文件偏移二分，每次从中间往后找下一个同步标记、
+//      读块头的时间，log(n)次读就定位到时间范围的开头，不用扫整个文件
+//
+// 块格式：
+//   sync(8) 负载长度(4) 记录数(4) 最早ns(8) 最晚ns(8) 校验(4，前32字节的FNV-1a)，后面是记录
+// 记录：
+//   STRING  1 | id | 长度 | 字节
+//   EVENT   2 | 级别 | pid | tid | 时间差 | 文件id | 行号 | 函数id | 种类 | 格式串id | 参数长度 | 参数
+//   TEXT    3 | 级别 | pid | tid | 时间差 | 长度 | 文本
+//
+// 用法：
+//   CLogBinaryWriter binary;
+//   binary.Open(&writer);
+//   binary.Event(level, pid, tid, ns, site, args, size);   // 日志线程里
+//   binary.Poll();                                          // 每轮一次，到时候了整块交给writer
+//   binary.Flush();                                         // 退出前
+// ============================================
+class CLogBinaryWriter
+{
+public:
+    CLogBinaryWriter();
+    CLogBinaryWriter(const CLogBinaryWriter&) = delete;
+    CLogBinaryWriter& operator=(const CLogBinaryWriter&) = delete;
+
+    void Open(CLogWriter* out) { m_out = out; }
+    bool IsOpen() const { return m_out != NULL; }
+
+    // 文件/函数/格式串 → 字符串表ID（ids[0..2]）；调用者按格式点缓存，之后直接用EventIds
+    void Strings(const LogSiteInfo& site, uint32_t ids[3]);
+
+    void Event(int level, pid_t pid, pid_t tid, uint64_t ns, const LogSiteInfo& site,
+        const char* args, size_t size);
+    void EventIds(int level, pid_t pid, pid_t tid, uint64_t ns, const uint32_t ids[3], int line, int kind,
+        const char* args, size_t size);
+    void Text(int level, pid_t pid, pid_t tid, uint64_t ns, const char* data, size_t size);
+
+    // 块够大、或者攒够了LOG_BLOCK_MS、或者里面有ERROR以上：整块交给CLogWriter
+    // 返回值：1交出了一块，0没到时候
+    int Poll();
+    // 立即交出当前块（没有记录就什么都不做）
+    void Flush();
+
+private:
+    void Begin(int type, int level, pid_t pid, pid_t tid, uint64_t ns);
+    void Define(uint32_t id);
+    void PutVarint(uint64_t value);
+
+private:
+    CLogWriter* m_out;
+    std::string m_block;                                // 当前块（开头留好块头的位置）
+    uint32_t m_count;                                   // 块里的记录数
+    uint64_t m_first;                                   // 块里最早/最晚的时间
+    uint64_t m_last;
+    uint64_t m_mark;                                    // 已交出的块里最晚的时间（块头的最晚时间单调不减）
+    uint64_t m_prev;                                    // 上一条记录的时间（算时间差）
+    uint64_t m_opened;                                  // 块里第一条记录进来的时间（毫秒，单调时钟）
+    int m_level;                                        // 块里最高的级别（交给writer决定是否立即写）
+    uint32_t m_blockSeq;                                // 块序号（字符串是否已在本块定义）
+    std::unordered_map<std::string, uint32_t> m_ids;    // 字符串 → ID
+    std::vector<std::string> m_strings;                 // ID → 字符串
+    std::vector<uint32_t> m_defined;                    // ID → 最近一次定义它的块序号
+};
+
+// ============================================
+// CLogBinaryReader：二进制日志的读取（离线解码工具tools/LogDecoder、测试）
+// 普通文件可以Seek（按块头二分）；.gz通过gzip -dc顺序读（Seek退化为往后跳块）
+// ============================================
+class CLogBinaryReader
+{
+public:
+    CLogBinaryReader();
+    ~CLogBinaryReader() { Close(); }
+    CLogBinaryReader(const CLogBinaryReader&) = delete;
+    CLogBinaryReader& operator=(const CLogBinaryReader&) = delete;
+
+    // 返回值：0成功，-1打开失败（.gz文件不存在也是-1）
+    int Open(const char* path);
+    void Close();
+
+    // 定位到第一个最晚时间 >= ns 的块（之后Next从这一块开始）
+    // 写的时候块头的最晚时间单调不减，所以前面的块里没有 >= ns 的记录
+    // 返回值：0成功，-1没有这样的块（已到结尾）
+    int Seek(uint64_t ns);
+
+    // 下一条记录
+    // 返回值：1有记录，0读完了
+    int Next(LogBinaryRecord& record);
+
+    // 记录还原成文本（和文本格式的日志文件里的一行完全一样）
+    // 返回值：0成功，-1参数数据错误
+    static int Format(const LogBinaryRecord& record, std::string& out);
+
+    // 统计（测试、工具的输出用）
+    uint64_t Blocks() const { return m_blocks; }          // 读过的块数
+    uint64_t BytesRead() const { return m_bytesRead; }    // 从文件里读的字节数（定位 + 解码）
+    uint64_t Corrupt() const { return m_corrupt; }        // 跳过的坏块
+
+    // 块头的校验（FNV-1a）
+    static uint32_t Checksum(const char* data, size_t size);
+
+private:
+    struct Header {
+        uint32_t length;
+        uint32_t count;
+        uint64_t first;
+        uint64_t last;
+    };
+    // 从offset往后找下一个合法的块头，块头要在limit之前（只用于可以随机读的文件）
+    // 返回值：0找到（offset改成块的位置），-1没找到
+    int FindBlock(uint64_t& offset, uint64_t limit, Header& header);
+    int ReadAt(uint64_t offset, char* buf, size_t size);
+    static bool ParseHeader(const char* p, Header& header);
+    // 顺序读下一块进m_data
+    // 返回值：1读到，0结尾
+    int ReadBlock();
+
+private:
+    FILE* m_file;
+    bool m_pipe;                  // gzip -dc（不能随机读）
+    pid_t m_child;                // gzip子进程（Close时回收）
+    uint64_t m_size;              // 文件大小（pipe为0）
+    uint64_t m_offset;            // 下一块从哪里开始找
+    std::string m_data;           // 当前块的负载
+    const char* m_pos;            // 当前块里读到哪里
+    uint64_t m_prev;              // 上一条记录的时间
+    std::vector<std::string> m_strings;   // 字符串表（ID全文件唯一）
+    uint64_t m_blocks;
+    uint64_t m_bytesRead;
+    uint64_t m_corrupt;
+};
@@ -0,0 +1,188 @@
+#include "LogFilter.h"
+#include "Socket.h"
+#include <sys/mman.h>    // mmap
+#include <sys/stat.h>    // fstat
+#include <sys/time.h>    // timeval（SO_RCVTIMEO）
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <mutex>
+
+LogFilterTable CLogFilter::s_local;
+std::atomic<LogFilterTable*> CLogFilter::s_table(&CLogFilter::s_local);
+
+static const char* s_severity[] = { "debug", "info", "warning", "error", "fatal", "off" };
+
+int CLogFilter::Attach(const char* path)
+{
+    static std::mutex lock;
+    std::lock_guard<std::mutex> guard(lock);
+    if (IsAttached()) return 0;
+
+    // 第1步：打开（没有就创建）级别表文件，不够大就补0（补出来的模块是DEBUG）
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1) return -1;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (st.st_size < (off_t)sizeof(LogFilterTable) &&
+        ftruncate(fd, (off_t)sizeof(LogFilterTable)) == -1)) {
+        close(fd);
+        return -2;
+    }
+
+    // 第2步：映射；之后所有的Enabled都读共享的表（映射不会撤销，fd可以关）
+    void* p = mmap(NULL, sizeof(LogFilterTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return -3;
+    s_table.store((LogFilterTable*)p, std::memory_order_release);
+    return 0;
+}
+
+void CLogFilter::SetLevel(int module, int severity)
+{
+    if (severity < 0) severity = 0;
+    if (severity > LOG_SEVERITY_OFF) severity = LOG_SEVERITY_OFF;
+    LogFilterTable* table = s_table.load(std::memory_order_acquire);
+    for (int i = 0; i < LOG_MODULE_MAX; i++) {
+        if (module == -1 || module == i) table->level[i].store(severity, std::memory_order_relaxed);
+    }
+}
+
+int CLogFilter::Level(int module)
+{
+    if (module < 0 || module >= LOG_MODULE_MAX) return -1;
+    return s_table.load(std::memory_order_acquire)->level[module].load(std::memory_order_relaxed);
+}
+
+void CLogFilter::SetFlight(int module, int severity)
+{
+    if (severity < 0) severity = 0;
+    if (severity > LOG_SEVERITY_OFF) severity = LOG_SEVERITY_OFF;
+    int value = severity == LOG_SEVERITY_OFF ? 0 : severity + 1;
+    LogFilterTable* table = s_table.load(std::memory_order_acquire);
+    for (int i = 0; i < LOG_MODULE_MAX; i++) {
+        if (module == -1 || module == i) table->flight[i].store(value, std::memory_order_relaxed);
+    }
+}
+
+int CLogFilter::Flight(int module)
+{
+    if (module < 0 || module >= LOG_MODULE_MAX) return -1;
+    int value = s_table.load(std::memory_order_acquire)->flight[module].load(std::memory_order_relaxed);
+    return value == 0 ? LOG_SEVERITY_OFF : value - 1;
+}
+
+int CLogFilter::SetName(int module, const char* name)
+{
+    if (module < 0 || module >= LOG_MODULE_MAX) return -1;
+    size_t n = name == NULL ? 0 : strlen(name);
+    if (n == 0 || n >= LOG_MODULE_NAME) return -2;
+    // 名字只在启动时登记，控制命令偶尔读：不加锁
+    char* p = s_table.load(std::memory_order_acquire)->name[module];
+    memcpy(p, name, n);
+    p[n] = 0;
+    return 0;
+}
+
+int CLogFilter::Find(const char* name)
+{
+    if (name == NULL || *name == 0) return -1;
+    char* end = NULL;
+    long id = strtol(name, &end, 10);
+    if (*end == 0) return (id >= 0 && id < LOG_MODULE_MAX) ? (int)id : -1;
+
+    LogFilterTable* table = s_table.load(std::memory_order_acquire);
+    if (strcmp(name, "default") == 0 && table->name[0][0] == 0) return 0;
+    for (int i = 0; i < LOG_MODULE_MAX; i++) {
+        if (strncmp(table->name[i], name, LOG_MODULE_NAME) == 0) return i;
+    }
+    return -1;
+}
+
+int CLogFilter::Command(const char* line, std::string& reply)
+{
+    // 第1步：拆成最多3个词
+    char words[3][LOG_MODULE_NAME] = { {0}, {0}, {0} };
+    int count = 0;
+    const char* p = line;
+    while (*p != 0 && count < 3) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (*p == 0) break;
+        size_t n = 0;
+        while (p[n] != 0 && p[n] != ' ' && p[n] != '\t' && p[n] != '\r' && p[n] != '\n') n++;
+        if (n >= LOG_MODULE_NAME) {
+            reply = "ERR 参数太长\n";
+            return -2;
+        }
+        memcpy(words[count++], p, n);
+        p += n;
+    }
+
+    // 第2步：get → 列出有名字的、或者不是DEBUG的、或者打开了飞行记录的模块
+    LogFilterTable* table = s_table.load(std::memory_order_acquire);
+    if (count == 1 && strcmp(words[0], "get") == 0) {
+        reply = "OK";
+        for (int i = 0; i < LOG_MODULE_MAX; i++) {
+            int level = table->level[i].load(std::memory_order_relaxed);
+            int flight = Flight(i);
+            if (i != 0 && table->name[i][0] == 0 && level == 0 && flight == LOG_SEVERITY_OFF) continue;
+            char item[96];
+            snprintf(item, sizeof(item), " %d:%.*s=%s", i, LOG_MODULE_NAME,
+                table->name[i][0] != 0 ? table->name[i] : (i == 0 ? "default" : ""),
+                s_severity[level >= 0 && level <= LOG_SEVERITY_OFF ? level : 0]);
+            reply += item;
+            if (flight != LOG_SEVERITY_OFF) {
+                reply += "/flight=";
+                reply += s_severity[flight];
+            }
+        }
+        reply += "\n";
+        return 0;
+    }
+
+    // 第3步：level|flight <模块> <级别>
+    bool flight = strcmp(words[0], "flight") == 0;
+    if (count == 3 && (strcmp(words[0], "level") == 0 || flight)) {
+        int module = strcmp(words[1], "*") == 0 ? -1 : Find(words[1]);
+        int severity = -1;
+        for (int i = 0; i <= LOG_SEVERITY_OFF; i++) {
+            if (strcasecmp(words[2], s_severity[i]) == 0) severity = i;
+        }
+        if ((module == -1 && strcmp(words[1], "*") != 0) || severity == -1) {
+            reply = "ERR 模块或级别不存在\n";
+            return -2;
+        }
+        if (flight) SetFlight(module, severity);
+        else SetLevel(module, severity);
+        reply = "OK\n";
+        return 0;
+    }
+
+    reply = "ERR 命令不认识\n";
+    return -1;
+}
+
+int CLogFilter::Control(const char* command, std::string& reply)
+{
+    // 第1步：连接（阻塞socket，最多等1秒回复）
+    CLocalSocket client;
+    if (client.Init(CSockParam(LOG_CONTROL_PATH, 0)) != 0 || client.Link() != 0) return -1;
+    timeval tv = { 1, 0 };
+    setsockopt((int)client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    // 第2步：发一行
+    Buffer line(command);
+    line += "\n";
+    if (client.Send(line) != (int)line.size()) return -2;
+
+    // 第3步：收到换行为止
+    reply.clear();
+    while (reply.empty() || reply.back() != '\n') {
+        Buffer data(256);
+        int n = client.Recv(data);
+        if (n <= 0) return -3;
+        reply.append(data.c_str(), (size_t)n);
+    }
+    return 0;
+}
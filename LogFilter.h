@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <string>
+
+// 模块数（模块号 0 ~ LOG_MODULE_MAX-1，0是默认模块）
+#define LOG_MODULE_MAX 64
+// 模块名最长字节数（含结尾的0）
+#define LOG_MODULE_NAME 24
+// 级别表所在的文件：每个进程映射同一个文件 → 改一次所有进程立即生效
+#define LOG_FILTER_PATH "./log/levels.shm"
+// 日志服务器的控制socket（改级别、查级别）
+#define LOG_CONTROL_PATH "./log/control.sock"
+
+// 严重度：过滤按严重度比较，不直接比较LogLevel
+// LogLevel的取值是历史顺序（INFO=0，DEBUG=1），DEBUG比INFO数值大但更不重要，
+// 这里把两者对调：DEBUG=0 < INFO=1 < WARNING=2 < ERROR=3 < FATAL=4
+// 常量参数在编译期就算完
+#define LOG_SEVERITY(level) ((level) == 0 ? 1 : (level) == 1 ? 0 : (level))
+// 关闭一个模块的全部日志
+#define LOG_SEVERITY_OFF 5
+
+// 共享内存里的级别表（文件全0 = 所有模块都从DEBUG开始输出）
+struct LogFilterTable
+{
+    std::atomic<int> level[LOG_MODULE_MAX];        // 每个模块输出的最低严重度
+    char name[LOG_MODULE_MAX][LOG_MODULE_NAME];    // 模块名（控制命令里用，启动时登记）
+    std::atomic<int> flight[LOG_MODULE_MAX];       // 没打开的级别里写进飞行记录器的最低严重度 + 1（0 = 不记录）
+};
+
+// ============================================
+// CLogFilter类：日志的运行时级别过滤（每个模块一个级别）
+//
+// 问题：TRACE*/LOG*/DUMP*不管级别要不要，都先构造完整的LogInfo（取时间、asprintf、
+//      dump的十六进制循环都做完）才交给日志服务器；热循环里的DEBUG日志关不掉
+//
+// 做法：
+//   1. 编译期：LOG_MIN_LEVEL以下的调用点，宏展开成常量false的分支，整个调用被编译器删掉
+//   2. 运行期：宏先检查本模块的级别（一次原子读 + 一次比较，一个可预测的分支），
+//      通过了才求值参数、构造LogInfo；没通过的调用点参数一个都不求值
+//   3. 级别表在共享内存里（映射LOG_FILTER_PATH，所有进程同一份），
+//      日志服务器的控制socket收到命令只改一个原子变量，不通知任何人
+//   4. 没映射之前用进程内的默认表（全部输出）；第一次写日志时自动映射
+//   5. 飞行记录器（LogFlight.h）按模块打开：没打开的级别只有打开了飞行记录的模块才求值参数，
+//      其余模块和以前一样一个参数都不求值（默认都不记录）
+//
+// 模块：在 #include "Logger.h" 之前 #define LOG_MODULE 3，这个文件里的日志就属于3号模块
+//
+// 控制命令（每行一条，回复一行）：
+//   level <模块名|模块号|*> <debug|info|warning|error|fatal|off>   → "OK"
+//   flight <模块名|模块号|*> <debug|info|warning|error|fatal|off>  → "OK"（没打开的级别从这一级起写进飞行记录器）
+//   get                                                           → "OK 0:default=debug 3:db=warning/flight=debug ..."
+//
+// 用法：
+//   CLogFilter::Attach();                         // 可选，第一次写日志时也会映射
+//   CLogFilter::SetName(3, "db");
+//   CLogFilter::Control("level db warning", reply);   // 别的进程里，通过日志服务器改
+// ============================================
+class CLogFilter
+{
+public:
+    // 这个模块的这个严重度要不要输出（热路径：宏里调用）
+    static bool Enabled(int module, int severity) {
+        return severity >= s_table.load(std::memory_order_relaxed)->level[module].load(std::memory_order_relaxed);
+    }
+
+    // 级别没打开时：要不要写进飞行记录器（只在Enabled不成立的分支里调用）
+    static bool Recorded(int module, int severity) {
+        int flight = s_table.load(std::memory_order_relaxed)->flight[module].load(std::memory_order_relaxed);
+        return flight != 0 && severity >= flight - 1;
+    }
+
+    // 映射共享的级别表（一个进程只映射一次，之后直接返回0）
+    // 返回值：0成功，-1打开文件失败，-2设置大小失败，-3映射失败
+    static int Attach(const char* path = LOG_FILTER_PATH);
+    static bool IsAttached() { return s_table.load(std::memory_order_relaxed) != &s_local; }
+
+    // module=-1：所有模块
+    static void SetLevel(int module, int severity);
+    static int Level(int module);
+    // 飞行记录的最低严重度（LOG_SEVERITY_OFF = 不记录）；module=-1：所有模块
+    static void SetFlight(int module, int severity);
+    static int Flight(int module);
+
+    // 登记模块名
+    // 返回值：0成功，-1模块号越界，-2名字为空或太长
+    static int SetName(int module, const char* name);
+    // 模块名或模块号 → 模块号
+    // 返回值：模块号，-1找不到
+    static int Find(const char* name);
+
+    // 执行一条控制命令（日志线程里调用），reply是回复的一行（含换行）
+    // 返回值：0成功，-1命令不认识，-2参数错误
+    static int Command(const char* line, std::string& reply);
+
+    // 客户端：连接日志服务器的控制socket，发一条命令，等回复
+    // 返回值：0成功（reply是回复），-1连接失败，-2发送失败，-3没收到回复
+    static int Control(const char* command, std::string& reply);
+
+private:
+    static std::atomic<LogFilterTable*> s_table;
+    static LogFilterTable s_local;        // 映射之前用的进程内默认表
+};
@@ -0,0 +1,185 @@
+#include "LogFlight.h"
+#include "LogFormat.h"   // CLogTsc
+#include <sys/mman.h>    // mmap, munmap, memfd_create
+#include <sys/stat.h>    // fstat
+#include <sys/syscall.h> // SYS_gettid
+#include <unistd.h>
+#include <fcntl.h>
+#include <new>
+#include <algorithm>
+
+// 本进程的飞行记录器（信号处理函数遍历；槽位用CAS占，线程退出时还回去）
+static std::atomic<std::atomic<int>*> g_flights[LOG_FLIGHT_THREADS];
+
+CLogFlight::CLogFlight()
+{
+    m_header = NULL;
+    m_data = NULL;
+    m_capacity = 0;
+    m_page = (size_t)sysconf(_SC_PAGESIZE);
+    m_fd = -1;
+    m_head = 0;
+    m_slot = -1;
+}
+
+// 第一页是头部，后面capacity字节是数据区；数据区镜像映射两次（和CLogRing一样）
+int CLogFlight::Map(int fd, size_t capacity)
+{
+    void* header = mmap(NULL, m_page, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (header == MAP_FAILED) return -3;
+
+    void* base = mmap(NULL, capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        munmap(header, m_page);
+        return -3;
+    }
+    void* lo = mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, (off_t)m_page);
+    void* hi = mmap((char*)base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, (off_t)m_page);
+    if (lo != base || hi != (char*)base + capacity) {
+        munmap(base, capacity * 2);
+        munmap(header, m_page);
+        return -3;
+    }
+    m_header = (Shared*)header;
+    m_data = (char*)base;
+    m_capacity = capacity;
+    return 0;
+}
+
+int CLogFlight::Create(size_t capacity)
+{
+    if (m_header != NULL) return -1;
+
+    size_t cap = m_page;
+    while (cap < capacity) cap <<= 1;
+
+    int fd = memfd_create("logflight", MFD_CLOEXEC);
+    if (fd == -1) return -2;
+    if (ftruncate(fd, (off_t)(m_page + cap)) == -1) {
+        close(fd);
+        return -2;
+    }
+    int ret = Map(fd, cap);
+    if (ret != 0) {
+        close(fd);
+        return ret;
+    }
+
+    Shared* shared = new (m_header) Shared;   // memfd是全0的，这里只是构造atomic
+    shared->capacity = (uint32_t)cap;
+    shared->pid = getpid();
+    shared->tid = (pid_t)syscall(SYS_gettid);
+    shared->head.store(0, std::memory_order_relaxed);
+    shared->signal.store(0, std::memory_order_relaxed);
+    shared->tick.store(CLogTsc::Now(), std::memory_order_relaxed);   // 日志服务器接手之前的记录用创建的时间
+    shared->magic = LOG_FLIGHT_MAGIC;
+    m_fd = fd;
+    m_head = 0;
+
+    // 登记（满了只是收不到信号标记，记录照常）
+    for (int i = 0; i < LOG_FLIGHT_THREADS; i++) {
+        std::atomic<int>* empty = NULL;
+        if (g_flights[i].compare_exchange_strong(empty, &shared->signal)) {
+            m_slot = i;
+            break;
+        }
+    }
+    return 0;
+}
+
+int CLogFlight::Attach(int fd)
+{
+    if (m_header != NULL) return -1;
+
+    // 第1步：大小必须是 一页 + 2的幂
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size <= m_page) return -2;
+    size_t cap = (size_t)st.st_size - m_page;
+    if ((cap & (cap - 1)) != 0) return -2;
+
+    // 第2步：映射并校验头部
+    int ret = Map(fd, cap);
+    if (ret != 0) return ret;
+    if (m_header->magic != LOG_FLIGHT_MAGIC || m_header->capacity != cap) {
+        Close();
+        return -4;
+    }
+    return 0;
+}
+
+void CLogFlight::Close()
+{
+    if (m_slot != -1) {
+        g_flights[m_slot].store(NULL);
+        m_slot = -1;
+    }
+    if (m_header != NULL) {
+        munmap(m_data, m_capacity * 2);
+        munmap(m_header, m_page);
+        m_header = NULL;
+        m_data = NULL;
+    }
+    if (m_fd != -1) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_capacity = 0;
+    m_head = 0;
+}
+
+pid_t CLogFlight::Pid() const { return m_header != NULL ? m_header->pid : 0; }
+pid_t CLogFlight::Tid() const { return m_header != NULL ? m_header->tid : 0; }
+
+void CLogFlight::Signal(int signo)
+{
+    for (int i = 0; i < LOG_FLIGHT_THREADS; i++) {
+        std::atomic<int>* signal = g_flights[i].load();
+        if (signal != NULL) signal->store(signo);
+    }
+}
+
+uint64_t CLogFlight::Head() const
+{
+    return m_header != NULL ? m_header->head.load(std::memory_order_acquire) : 0;
+}
+
+int CLogFlight::TakeSignal()
+{
+    if (m_header == NULL || m_header->signal.load(std::memory_order_relaxed) == 0) return 0;
+    return m_header->signal.exchange(0);
+}
+
+int CLogFlight::Snapshot(std::string& buf, std::vector<size_t>& offsets, uint64_t after)
+{
+    buf.clear();
+    offsets.clear();
+    if (m_header == NULL) return 0;
+
+    // 第1步：整个环拷出来（[head - capacity, head)），拷完再读一次写位置：
+    // 这期间生产者写过的、以及正在写的下一条（最长capacity/4 + 16）可能已经把拷出来的最早那段覆盖了
+    uint64_t head = m_header->head.load(std::memory_order_acquire);
+    uint64_t begin = head > m_capacity ? head - m_capacity : 0;
+    buf.assign(m_data + (begin & (m_capacity - 1)), (size_t)(head - begin));
+    uint64_t reach = m_header->head.load(std::memory_order_acquire) + m_capacity / 4 + 16;
+    uint64_t valid = reach > m_capacity ? reach - m_capacity : 0;
+    if (valid < after) valid = after;
+
+    // 第2步：从写位置往回走（记录由生产者写，长度都要校验）
+    uint64_t pos = head;
+    while (pos > valid && pos - begin >= 8) {
+        uint64_t trailer;
+        memcpy(&trailer, buf.data() + (pos - begin) - 8, 8);
+        uint32_t total = (uint32_t)trailer;
+        if ((uint32_t)(trailer >> 32) != ~total || total < sizeof(LogRecord) + 8 || (total & 7) != 0 ||
+            total > pos - begin || pos - total < valid) break;
+        pos -= total;
+        LogRecord record;
+        memcpy(&record, buf.data() + (pos - begin), sizeof(record));
+        if (Total(record.size) != total) break;
+        offsets.push_back((size_t)(pos - begin));
+    }
+
+    // 第3步：最早的在前
+    std::reverse(offsets.begin(), offsets.end());
+    return (int)offsets.size();
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "LogRing.h"     // LogRecord（记录头部和共享内存环一样）
+
+// 每个线程的飞行记录器大小（2的幂，向上取整到页）
+#define LOG_FLIGHT_SIZE (1024 * 1024)
+// 共享内存头部的标识（对端映射后校验）
+#define LOG_FLIGHT_MAGIC 0x54484C46   // "FLHT"
+// 一个进程里最多登记这么多个飞行记录器（信号处理函数里只能遍历固定的数组）
+#define LOG_FLIGHT_THREADS 1024
+// 客户端交出飞行记录器时随fd一起发送的握手数据（紧跟在LOG_RING_HELLO之后）
+#define LOG_FLIGHT_HELLO "\x01LOGFLHT\n"
+#define LOG_FLIGHT_HELLO_SIZE 9
+
+// ============================================
+// CLogFlight类：每个线程的飞行记录器（共享内存里的覆盖写环）
+//
+// 问题：线上DEBUG日志写不起（级别是INFO），出了FATAL想看之前几秒的DEBUG上下文，
+//      却什么都没有；进程崩溃时，还没写出去的上下文跟着进程一起没了
+//
+// 做法：
+//   1. 打开了飞行记录的模块（CLogFilter，控制命令 "flight <模块> <级别>"），运行期没打开的级别
+//      不再直接丢掉：宏把参数按延迟格式化的方式编码（格式点ID + 时间 + 参数，不格式化），
+//      写进本线程的飞行记录器。只有一次memcpy + 一次release store，
+//      满了覆盖最早的记录，从不阻塞、从不失败；没打开飞行记录的模块参数照样不求值
+//   2. 时间不读TSC：日志服务器每轮（约1毫秒）把当前TSC写进记录器头部，生产者读这个粗粒度的值
+//      （一次普通的读）。dump出来的时间精度是毫秒级，线程之间按它合并，同一线程里的顺序不变
+//   3. 记录器在memfd里，和共享内存环一起交给日志服务器映射：写日志的进程崩溃了，
+//      内存还在日志服务器那里，最后几条记录不会丢
+//   4. 每条记录尾部再写一遍长度，读的时候从写位置往回走（覆盖写的环找不到"最早的一条"从哪开始）
+//   5. 日志服务器在这些时候把记录器还原成文本，写进单独的文件（./log/flight-时间.log）：
+//      a. 收到FATAL（TRACEF/LOGF等）：这个进程所有线程的记录器
+//      b. 进程收到信号（CLoggerServer::InstallFlightSignals）：崩溃信号先标记再按默认处理，
+//         LOG_FLIGHT_SIGNAL只标记（不退出）
+//      c. 控制命令 "dump [pid]"（CLogFilter::Control，或CLoggerServer::FlightDump）
+//   6. 格式点登记照常走共享内存环（只登记一次），格式化用日志服务器里这个线程的CLogFormatter
+//
+// 用法（生产者，Logger.cpp里，业务代码只用宏）：
+//   CLogFlight flight;  flight.Create(LOG_FLIGHT_SIZE);  → 把flight.Fd()发给日志服务器
+//   char* p = flight.Reserve(n);  编码（时间用flight.Tick()）;  flight.Commit(level, LOG_RECORD_BINARY, n);
+// 用法（日志线程）：
+//   flight.Attach(fd);
+//   flight.SetTick(CLogTsc::Now());          // 每轮
+//   flight.Snapshot(buf, offsets, after);   // 最早的在前
+// ============================================
+class CLogFlight
+{
+public:
+    CLogFlight();
+    ~CLogFlight() { Close(); }
+    CLogFlight(const CLogFlight&) = delete;
+    CLogFlight& operator=(const CLogFlight&) = delete;
+
+    // 生产者：创建并登记（信号处理函数要能找到它）
+    // 返回值：0成功，-1已创建，-2 memfd失败，-3映射失败
+    int Create(size_t capacity);
+
+    // 日志线程：映射对方传来的fd（不接管fd，调用者自己关闭）
+    // 返回值：0成功，-1已创建，-2大小不对，-3映射失败，-4不是飞行记录器
+    int Attach(int fd);
+
+    void Close();
+
+    bool IsValid() const { return m_header != NULL; }
+    int Fd() const { return m_fd; }
+    pid_t Pid() const;
+    pid_t Tid() const;
+
+    // -------------------- 生产者 --------------------
+
+    // 取得size字节的负载空间（总是成功，覆盖最早的记录）；单条超过1/4容量返回NULL
+    char* Reserve(size_t size) {
+        if (size > m_capacity / 4) return NULL;
+        return m_data + (m_head & (m_capacity - 1)) + sizeof(LogRecord);
+    }
+    // 发布Reserve到的记录（size ≤ Reserve时的大小）：头部、尾部的长度，一次release store
+    void Commit(int level, int type, size_t size) {
+        char* p = m_data + (m_head & (m_capacity - 1));
+        size_t total = Total(size);
+        LogRecord* record = (LogRecord*)p;
+        record->size = (uint32_t)size;
+        record->level = (uint8_t)level;
+        record->type = (uint8_t)type;
+        record->reserved = 0;
+        uint64_t trailer = ((uint64_t)~(uint32_t)total << 32) | total;
+        memcpy(p + total - 8, &trailer, 8);
+        m_head += total;
+        m_header->head.store(m_head, std::memory_order_release);
+    }
+
+    // 粗粒度的时间（日志服务器最近一次SetTick的TSC；刚创建时是创建的时间）
+    uint64_t Tick() const { return m_header->tick.load(std::memory_order_relaxed); }
+
+    // 信号处理函数里调用：本进程所有记录器标记上这个信号（只有原子写，异步信号安全）
+    static void Signal(int signo);
+
+    // -------------------- 日志线程 --------------------
+
+    // 写位置（下一条记录的开始）
+    uint64_t Head() const;
+    // 更新生产者读的时间（每轮一次）
+    void SetTick(uint64_t tick) { if (m_header != NULL) m_header->tick.store(tick, std::memory_order_relaxed); }
+    // 取出并清掉信号标记（0 = 没有）
+    int TakeSignal();
+
+    // 取出写位置之前还在环里、并且开始位置 >= after的全部记录，最早的在前
+    // buf是拷出来的数据（生产者还在写也没关系：拷完再确认哪些没被覆盖），
+    // offsets是每条记录（LogRecord头部）在buf里的偏移
+    // 返回值：记录数
+    int Snapshot(std::string& buf, std::vector<size_t>& offsets, uint64_t after = 0);
+
+private:
+    // 共享内存第一页
+    struct Shared {
+        uint32_t magic;
+        uint32_t capacity;
+        pid_t pid;
+        pid_t tid;
+        alignas(64) std::atomic<uint64_t> head;     // 写位置（生产者）
+        alignas(64) std::atomic<int> signal;        // 生产者进程收到的信号（日志线程取走）
+        alignas(64) std::atomic<uint64_t> tick;     // 粗粒度的时间（日志线程写，生产者读）
+    };
+
+    int Map(int fd, size_t capacity);
+
+    // 记录总长：头部 + 负载，8字节对齐，再加8字节尾部（长度 + 长度取反，往回走时校验）
+    static size_t Total(size_t size) { return ((sizeof(LogRecord) + size + 7) & ~(size_t)7) + 8; }
+
+private:
+    Shared* m_header;
+    char* m_data;            // 镜像映射的数据区（2 × capacity 的地址空间）
+    size_t m_capacity;
+    size_t m_page;
+    int m_fd;
+    uint64_t m_head;         // 生产者：本地的写位置
+    int m_slot;              // 生产者：在进程登记表里的位置（-1没登记）
+};
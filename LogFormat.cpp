@@ -0,0 +1,437 @@
+#include "LogFormat.h"
+#include "LogRing.h"
+#include "Clock.h"
+#include "LogHex.h"
+#include <stdio.h>
+#include <stdarg.h>
+
+static const char g_levelName[][8] = {
+    "INFO","DEBUG","WARNING","ERROR","FATAL"
+};
+
+// ==================== CLogSite ====================
+uint32_t CLogSite::Assign()
+{
+    static std::atomic<uint32_t> next(1);   // 0表示未分配
+    uint32_t value = next.fetch_add(1, std::memory_order_relaxed);
+    uint32_t expected = 0;
+    if (!id.compare_exchange_strong(expected, value, std::memory_order_relaxed)) {
+        return expected;   // 别的线程先分配了（浪费一个编号，没关系）
+    }
+    return value;
+}
+
+// ==================== CLogTsc ====================
+CLogTsc::CLogTsc()
+{
+    m_baseTsc = m_baseMono = 0;
+    m_anchorTsc = m_anchorMono = m_anchorReal = 0;
+    m_nsPerTick = 0;
+}
+
+static uint64_t ClockNs(clockid_t id)
+{
+    timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t CLogTsc::RealtimeNs()
+{
+    return ClockNs(CLOCK_REALTIME);
+}
+
+void CLogTsc::Sample(uint64_t& tsc, uint64_t& mono, uint64_t& real)
+{
+    // 时钟读数夹在两次TSC中间，取中点
+    uint64_t t0 = Now();
+    mono = ClockNs(CLOCK_MONOTONIC);
+    real = ClockNs(CLOCK_REALTIME);
+    uint64_t t1 = Now();
+    tsc = t0 + (t1 - t0) / 2;
+}
+
+void CLogTsc::Calibrate()
+{
+    uint64_t tsc, mono, real;
+    if (m_nsPerTick == 0) {
+        // 第1步：初始校准，忙等10ms
+        Sample(m_baseTsc, m_baseMono, real);
+        while (ClockNs(CLOCK_MONOTONIC) - m_baseMono < 10000000ull) {}
+        Sample(tsc, mono, real);
+    }
+    else {
+        // 第2步：每秒一次，用从起点开始的整个跨度修正频率
+        if (ClockNs(CLOCK_MONOTONIC) - m_anchorMono < 1000000000ull) return;
+        Sample(tsc, mono, real);
+    }
+    if (tsc > m_baseTsc) m_nsPerTick = (double)(mono - m_baseMono) / (double)(tsc - m_baseTsc);
+    if (m_nsPerTick <= 0) m_nsPerTick = 1;
+    m_anchorTsc = tsc;
+    m_anchorMono = mono;
+    m_anchorReal = real;
+}
+
+uint64_t CLogTsc::ToRealtime(uint64_t tsc) const
+{
+    if (m_nsPerTick == 0) return RealtimeNs();
+    // 记录可能早于对齐点（有符号差值）
+    double delta = (double)(int64_t)(tsc - m_anchorTsc) * m_nsPerTick;
+    return m_anchorReal + (int64_t)delta;
+}
+
+// ==================== 参数解码 ====================
+struct LogArgValue
+{
+    int type;
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char* s;   // STRING / BLOB（不以0结尾）
+    size_t n;
+};
+
+// 读出下一个参数
+// 返回值：1读到，0没有了，-1数据错误
+static int NextArg(const char*& p, const char* end, LogArgValue& v)
+{
+    if (p >= end) return 0;
+    v.type = (unsigned char)*p++;
+    v.i = 0;
+    v.u = 0;
+    v.d = 0;
+    v.s = NULL;
+    v.n = 0;
+    switch (v.type) {
+    case LOG_ARG_INT:
+    case LOG_ARG_UINT:
+    case LOG_ARG_DOUBLE:
+    case LOG_ARG_POINTER:
+        if (end - p < 8) return -1;
+        memcpy(&v.u, p, 8);
+        memcpy(&v.i, p, 8);
+        memcpy(&v.d, p, 8);
+        p += 8;
+        return 1;
+    case LOG_ARG_INT32:
+    case LOG_ARG_UINT32: {
+        uint32_t n;
+        if (end - p < 4) return -1;
+        memcpy(&n, p, 4);
+        v.i = v.type == LOG_ARG_INT32 ? (int64_t)(int32_t)n : (int64_t)n;
+        v.u = v.type == LOG_ARG_INT32 ? (uint64_t)(uint32_t)n : (uint64_t)n;   // %x输出32位，和printf一致
+        v.d = (double)v.i;
+        p += 4;
+        v.type = v.type == LOG_ARG_INT32 ? LOG_ARG_INT : LOG_ARG_UINT;
+        return 1;
+    }
+    case LOG_ARG_CHAR:
+    case LOG_ARG_UCHAR:
+        if (end - p < 1) return -1;
+        v.i = v.type == LOG_ARG_CHAR ? (int64_t)(signed char)*p : (int64_t)(unsigned char)*p;
+        v.u = (uint64_t)v.i;
+        v.d = (double)v.i;
+        p++;
+        return 1;
+    case LOG_ARG_STRING:
+    case LOG_ARG_BLOB: {
+        uint32_t n;
+        if (end - p < 4) return -1;
+        memcpy(&n, p, 4);
+        p += 4;
+        if ((size_t)(end - p) < n) return -1;
+        v.s = p;
+        v.n = n;
+        p += n;
+        return 1;
+    }
+    default:
+        return -1;
+    }
+}
+
+static int64_t ArgInt(const LogArgValue& v)
+{
+    return v.type == LOG_ARG_DOUBLE ? (int64_t)v.d : v.i;
+}
+
+static double ArgDouble(const LogArgValue& v)
+{
+    if (v.type == LOG_ARG_DOUBLE) return v.d;
+    if (v.type == LOG_ARG_UINT || v.type == LOG_ARG_POINTER) return (double)v.u;
+    return (double)v.i;
+}
+
+// 格式化追加（短的直接在栈上，长的第二次直接写进out）
+static void AppendF(std::string& out, const char* spec, ...)
+{
+    char buf[256];
+    va_list ap;
+    va_start(ap, spec);
+    int n = vsnprintf(buf, sizeof(buf), spec, ap);
+    va_end(ap);
+    if (n <= 0) return;
+    if ((size_t)n < sizeof(buf)) {
+        out.append(buf, (size_t)n);
+        return;
+    }
+    size_t old = out.size();
+    out.resize(old + (size_t)n + 1);
+    va_start(ap, spec);
+    vsnprintf(&out[old], (size_t)n + 1, spec, ap);
+    va_end(ap);
+    out.resize(old + (size_t)n);
+}
+
+// 流式风格：和 std::stringstream << value 的输出一致
+static void AppendValue(std::string& out, const LogArgValue& v)
+{
+    switch (v.type) {
+    case LOG_ARG_INT: AppendF(out, "%lld", (long long)v.i); break;
+    case LOG_ARG_UINT: AppendF(out, "%llu", (unsigned long long)v.u); break;
+    case LOG_ARG_DOUBLE: AppendF(out, "%g", v.d); break;
+    case LOG_ARG_CHAR:
+    case LOG_ARG_UCHAR: out += (char)v.i; break;
+    case LOG_ARG_STRING: out.append(v.s, v.n); break;
+    case LOG_ARG_POINTER: {
+        std::stringstream stream;
+        stream << (const void*)(uintptr_t)v.u;
+        out += stream.str();
+        break;
+    }
+    case LOG_ARG_BLOB: CLogFormatter::HexDump(v.s, v.n, out); break;
+    }
+}
+
+// printf风格：逐个转换说明符，用调用方写的标志/宽度/精度，长度修饰按参数的实际类型重写
+// 返回值：0成功，-1参数数据错误
+static int FormatPrintf(const char* fmt, const char* p, const char* end, std::string& out)
+{
+    LogArgValue v;
+    while (*fmt != 0) {
+        // 第1步：普通文本整段拷贝
+        const char* percent = strchr(fmt, '%');
+        if (percent == NULL) {
+            out += fmt;
+            break;
+        }
+        out.append(fmt, (size_t)(percent - fmt));
+        fmt = percent + 1;
+        if (*fmt == '%') {
+            out += '%';
+            fmt++;
+            continue;
+        }
+
+        // 第2步：解析 标志 宽度 精度 长度
+        char spec[64] = "%";
+        size_t len = 1;
+        bool plain = true;   // 没有标志/宽度/精度（%s可以直接追加）
+        while (*fmt != 0 && strchr("-+ #0'", *fmt) != NULL && len < 16) {
+            spec[len++] = *fmt++;
+            plain = false;
+        }
+        for (int part = 0; part < 2; part++) {
+            if (part == 1) {
+                if (*fmt != '.') break;
+                spec[len++] = *fmt++;
+                plain = false;
+            }
+            if (*fmt == '*') {
+                fmt++;
+                int r = NextArg(p, end, v);
+                if (r < 0) return -1;
+                len += (size_t)snprintf(spec + len, 16, "%d", r == 1 ? (int)ArgInt(v) : 0);
+                plain = false;
+                continue;
+            }
+            for (int k = 0; *fmt >= '0' && *fmt <= '9'; k++, fmt++) {
+                if (k < 10) spec[len++] = *fmt;
+                plain = false;
+            }
+        }
+        while (*fmt != 0 && strchr("hlLqjzt", *fmt) != NULL) fmt++;
+        char conv = *fmt;
+        if (conv == 0) break;
+        fmt++;
+        if (conv == '%') {
+            out += '%';
+            continue;
+        }
+        if (strchr("diouxXcfFeEgGaAspn", conv) == NULL) {   // 不认识：原样输出
+            out.append(percent, (size_t)(fmt - percent));
+            continue;
+        }
+
+        // 第3步：取参数（缺参数时什么也不输出）
+        int r = NextArg(p, end, v);
+        if (r < 0) return -1;
+        if (r == 0) continue;
+
+        switch (conv) {
+        case 'd':
+        case 'i':
+            memcpy(spec + len, "lld", 4);
+            AppendF(out, spec, (long long)ArgInt(v));
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            spec[len] = 'l';
+            spec[len + 1] = 'l';
+            spec[len + 2] = conv;
+            spec[len + 3] = 0;
+            AppendF(out, spec, (unsigned long long)(v.type == LOG_ARG_DOUBLE ? (uint64_t)v.d : v.u));
+            break;
+        case 'c':
+            memcpy(spec + len, "c", 2);
+            AppendF(out, spec, (int)ArgInt(v));
+            break;
+        case 'p':
+            memcpy(spec + len, "p", 2);
+            AppendF(out, spec, (void*)(uintptr_t)v.u);
+            break;
+        case 's':
+            if (plain && v.type == LOG_ARG_STRING) {
+                out.append(v.s, v.n);
+            }
+            else {
+                std::string text;
+                AppendValue(text, v);
+                memcpy(spec + len, "s", 2);
+                AppendF(out, spec, text.c_str());
+            }
+            break;
+        case 'n':
+            break;
+        default:   // 浮点
+            spec[len] = conv;
+            spec[len + 1] = 0;
+            AppendF(out, spec, ArgDouble(v));
+            break;
+        }
+    }
+    return 0;
+}
+
+// ==================== CLogFormatter ====================
+void CLogFormatter::HexDump(const char* data, size_t size, std::string& out)
+{
+    // 一次留好确切的长度，CLogHex一遍写完
+    size_t used = out.size();
+    out.resize(used + CLogHex::Size(size));
+    if (size > 0) CLogHex::Dump(data, size, &out[used]);
+}
+
+int CLogFormatter::FormatLine(const LogSiteInfo& site, int level, uint64_t realtimeNs, pid_t pid, pid_t tid,
+    const char* args, size_t size, std::string& out)
+{
+    // 第1步：头部（和LogInfo一样；dump风格头部后面换行）
+    char time[CLOCK_TIME_STR_SIZE];
+    CClock::Format(realtimeNs, time);
+    if (level < 0 || level >= (int)(sizeof(g_levelName) / sizeof(g_levelName[0]))) level = 0;
+    AppendF(out, site.kind == LOG_SITE_DUMP ? "%s(%d):[%s][%s]<%d-%d>(%s)\n" : "%s(%d):[%s][%s]<%d-%d>(%s) ",
+        site.file, site.line, g_levelName[level], time, (int)pid, (int)tid, site.func);
+
+    // 第2步：消息
+    const char* end = args + size;
+    if (site.kind == LOG_SITE_PRINTF) {
+        if (FormatPrintf(site.fmt, args, end, out) != 0) return -1;
+    }
+    else {
+        LogArgValue v;
+        int r;
+        while ((r = NextArg(args, end, v)) == 1) AppendValue(out, v);
+        if (r < 0) return -1;
+    }
+    if (site.kind != LOG_SITE_DUMP) out += "\n";
+    return 0;
+}
+
+size_t CLogFormatter::SiteSize(const CLogSite& site, const char* func)
+{
+    return 9 + strlen(site.file) + 1 + strlen(func) + 1 + strlen(site.fmt) + 1;
+}
+
+void CLogFormatter::PutSite(char* p, CLogSite& site, const char* func)
+{
+    uint32_t id = site.Id();
+    int32_t line = site.line;
+    memcpy(p, &id, 4);
+    memcpy(p + 4, &line, 4);
+    p[8] = (char)site.kind;
+    p += 9;
+    const char* strings[3] = { site.file, func, site.fmt };
+    for (int i = 0; i < 3; i++) {
+        size_t n = strlen(strings[i]) + 1;
+        memcpy(p, strings[i], n);
+        p += n;
+    }
+}
+
+int CLogFormatter::Format(int type, int level, const char* data, size_t size, pid_t pid, pid_t tid,
+    const CLogTsc& clock, std::string& out)
+{
+    uint32_t id;
+    LogSiteInfo info;
+    uint64_t realtimeNs;
+    const char* args;
+    size_t argSize;
+    int ret = Decode(type, data, size, clock, id, info, realtimeNs, args, argSize);
+    if (ret <= 0) return ret;
+
+    size_t old = out.size();
+    if (FormatLine(info, level, realtimeNs, pid, tid, args, argSize, out) != 0) {
+        out.resize(old);
+        return -1;
+    }
+    return 1;
+}
+
+int CLogFormatter::Decode(int type, const char* data, size_t size, const CLogTsc& clock,
+    uint32_t& id, LogSiteInfo& info, uint64_t& realtimeNs, const char*& args, size_t& argSize)
+{
+    if (type == LOG_RECORD_SITE) {
+        // 登记：id line kind file\0 func\0 fmt\0（数据来自别的进程，逐项校验）
+        if (size < 12 || data[size - 1] != 0) return -1;
+        int32_t line;
+        memcpy(&id, data, 4);
+        memcpy(&line, data + 4, 4);
+        int kind = (unsigned char)data[8];
+        if (id == 0 || id > LOG_SITE_MAX || kind > LOG_SITE_DUMP) return -1;
+        const char* p = data + 9;
+        const char* end = data + size;
+        const char* strings[3];
+        for (int i = 0; i < 3; i++) {
+            if (p >= end) return -1;
+            strings[i] = p;
+            p += strlen(p) + 1;   // 最后一个字节是0，不会越界
+        }
+        if (m_sites.size() <= id) m_sites.resize(id + 1);
+        Site& site = m_sites[id];
+        site.file = strings[0];
+        site.func = strings[1];
+        site.fmt = strings[2];
+        site.line = line;
+        site.kind = kind;
+        site.valid = true;
+        return 0;
+    }
+    if (type != LOG_RECORD_BINARY || size < LOG_BINARY_HEADER) return -1;
+
+    uint64_t tsc;
+    memcpy(&id, data, 4);
+    memcpy(&tsc, data + 4, 8);
+    if (id >= m_sites.size() || !m_sites[id].valid) return -2;
+    const Site& site = m_sites[id];
+    info.file = site.file.c_str();
+    info.line = site.line;
+    info.func = site.func.c_str();
+    info.kind = site.kind;
+    info.fmt = site.fmt.c_str();
+    realtimeNs = clock.ToRealtime(tsc);
+    args = data + LOG_BINARY_HEADER;
+    argSize = size - LOG_BINARY_HEADER;
+    return 1;
+}
@@ -0,0 +1,276 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <type_traits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>   // __rdtsc
+#endif
+
+// 延迟格式化记录的固定头部：格式点ID(4) + 时间戳(8)
+#define LOG_BINARY_HEADER 12
+// 格式点ID的上限（日志线程校验对方发来的ID，防止按垃圾ID分配登记表）
+#define LOG_SITE_MAX (1 << 20)
+
+// 格式点的种类（决定日志线程怎么把参数还原成文本）
+enum LogSiteKind {
+    LOG_SITE_PRINTF = 0,    // TRACE*：按fmt格式化
+    LOG_SITE_STREAM = 1,    // LOG*：参数依次拼接（和operator<<的输出一致）
+    LOG_SITE_DUMP = 2,      // DUMP*：一个二进制块，十六进制 + ASCII
+};
+
+// 参数的类型标签（每个参数：1字节标签 + 值）
+enum LogArgType {
+    LOG_ARG_INT = 1,        // int64
+    LOG_ARG_UINT = 2,       // uint64
+    LOG_ARG_DOUBLE = 3,     // double
+    LOG_ARG_CHAR = 4,       // 1字节
+    LOG_ARG_STRING = 5,     // uint32长度 + 字节
+    LOG_ARG_POINTER = 6,    // uint64
+    LOG_ARG_BLOB = 7,       // uint32长度 + 字节（DUMP*）
+    LOG_ARG_UCHAR = 8,      // 1字节（unsigned char：%d按无符号，流式按字符）
+    LOG_ARG_INT32 = 9,      // int32（不超过4字节的有符号整数，%x等按32位输出，和printf一致）
+    LOG_ARG_UINT32 = 10,    // uint32
+};
+
+// ============================================
+// CLogSite：一个日志调用点（宏里的static对象，常量初始化，没有构造开销）
+// 第一次使用时分配一个进程内唯一的ID；文件、函数、格式串只在每个线程第一次
+// 用到这个调用点时随LOG_RECORD_SITE记录发一次，之后每条记录只带ID
+// ============================================
+struct CLogSite
+{
+    const char* file;
+    int line;
+    int level;
+    int kind;               // LogSiteKind
+    const char* fmt;        // 只有LOG_SITE_PRINTF有
+    std::atomic<uint32_t> id;
+
+    constexpr CLogSite(const char* f, int l, int lv, int k, const char* fm)
+        : file(f), line(l), level(lv), kind(k), fmt(fm), id(0) {}
+
+    uint32_t Id() {
+        uint32_t value = id.load(std::memory_order_relaxed);
+        return value != 0 ? value : Assign();
+    }
+
+private:
+    uint32_t Assign();
+};
+
+// 日志线程（或兜底路径）格式化时需要的格式点信息
+struct LogSiteInfo
+{
+    const char* file;
+    int line;
+    const char* func;
+    int kind;
+    const char* fmt;
+};
+
+// ============================================
+// CLogArgs：参数按类型编码成字节（只拷贝值，不格式化）
+//   整数 → INT32/UINT32/INT/UINT（保留宽度），char → CHAR，浮点 → DOUBLE，字符串 → STRING（拷贝内容），
+//   其他指针 → POINTER；业务类型（只在流式里出现）先用operator<<转成字符串
+// ============================================
+class CLogArgs
+{
+public:
+    // 可以直接编码的类型（其余类型只能在流式里用，先转成字符串）
+    template<typename T>
+    struct Native {
+        typedef typename std::decay<T>::type D;
+        enum { value = std::is_arithmetic<D>::value || std::is_enum<D>::value || std::is_pointer<D>::value ||
+            std::is_base_of<std::string, D>::value };
+    };
+
+    static size_t Size() { return 0; }
+    template<typename T, typename... R>
+    static size_t Size(const T& value, const R&... rest) { return One(value) + Size(rest...); }
+
+    static char* Put(char* p) { return p; }
+    template<typename T, typename... R>
+    static char* Put(char* p, const T& value, const R&... rest) { return Put(PutOne(p, value), rest...); }
+
+    // 二进制块（DUMP*）
+    static size_t BlobSize(size_t size) { return 5 + size; }
+    static char* PutBlob(char* p, const void* data, size_t size) {
+        uint32_t n = (uint32_t)size;
+        *p = (char)LOG_ARG_BLOB;
+        memcpy(p + 1, &n, 4);
+        memcpy(p + 5, data, size);
+        return p + 5 + size;
+    }
+
+    // 单个值的编码长度 / 编码
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, size_t>::type
+        One(const T&) { return sizeof(T) == 1 && !std::is_same<T, bool>::value ? 2 : sizeof(T) <= 4 ? 5 : 9; }
+    template<typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value, size_t>::type
+        One(const T&) { return 9; }
+    static size_t One(const char* s) { return 5 + (s != NULL ? strlen(s) : 6); }
+    static size_t One(char* s) { return One((const char*)s); }
+    template<size_t N>
+    static size_t One(const char(&s)[N]) { return One((const char*)s); }
+    template<size_t N>
+    static size_t One(char(&s)[N]) { return One((const char*)s); }
+    static size_t One(const std::string& s) { return 5 + s.size(); }
+    template<typename T>
+    static size_t One(T* const&) { return 9; }
+
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, char*>::type
+        PutOne(char* p, const T& value) {
+        if (sizeof(T) == 1 && !std::is_same<T, bool>::value) {   // char / signed char / unsigned char
+            p[0] = (char)(std::is_same<T, unsigned char>::value ? LOG_ARG_UCHAR : LOG_ARG_CHAR);
+            p[1] = (char)value;
+            return p + 2;
+        }
+        if (sizeof(T) <= 4) {
+            if (std::is_signed<T>::value || std::is_enum<T>::value) {
+                int32_t v = (int32_t)value;
+                return PutRaw(p, LOG_ARG_INT32, &v, 4);
+            }
+            uint32_t v = (uint32_t)value;
+            return PutRaw(p, LOG_ARG_UINT32, &v, 4);
+        }
+        if (std::is_signed<T>::value || std::is_enum<T>::value) {
+            int64_t v = (int64_t)value;
+            return PutRaw(p, LOG_ARG_INT, &v, 8);
+        }
+        uint64_t v = (uint64_t)value;
+        return PutRaw(p, LOG_ARG_UINT, &v, 8);
+    }
+    template<typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value, char*>::type
+        PutOne(char* p, const T& value) {
+        double v = (double)value;
+        return PutRaw(p, LOG_ARG_DOUBLE, &v, 8);
+    }
+    static char* PutOne(char* p, const char* s) {
+        if (s == NULL) s = "(null)";
+        return PutString(p, s, strlen(s));
+    }
+    static char* PutOne(char* p, char* s) { return PutOne(p, (const char*)s); }
+    template<size_t N>
+    static char* PutOne(char* p, const char(&s)[N]) { return PutOne(p, (const char*)s); }
+    template<size_t N>
+    static char* PutOne(char* p, char(&s)[N]) { return PutOne(p, (const char*)s); }
+    static char* PutOne(char* p, const std::string& s) { return PutString(p, s.data(), s.size()); }
+    template<typename T>
+    static char* PutOne(char* p, T* const& ptr) {
+        uint64_t v = (uint64_t)(uintptr_t)ptr;
+        return PutRaw(p, LOG_ARG_POINTER, &v, 8);
+    }
+
+    static char* PutString(char* p, const char* s, size_t size) {
+        uint32_t n = (uint32_t)size;
+        *p = (char)LOG_ARG_STRING;
+        memcpy(p + 1, &n, 4);
+        memcpy(p + 5, s, size);
+        return p + 5 + size;
+    }
+
+private:
+    static char* PutRaw(char* p, int type, const void* value, size_t size) {
+        *p = (char)type;
+        memcpy(p + 1, value, size);
+        return p + 1 + size;
+    }
+};
+
+// ============================================
+// CLogTsc：时间戳计数器（调用方只读一次TSC），日志线程换算成墙上时间
+// x86用rdtsc，其他平台退化为CLOCK_MONOTONIC（纳秒）
+// 校准：启动时忙等10ms求频率，之后每秒用更长的跨度修正，并重新对齐墙上时间
+// ============================================
+class CLogTsc
+{
+public:
+    CLogTsc();
+
+    static uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+    }
+
+    // 第一次调用做初始校准，之后每秒修正一次（日志线程每轮调用，开销很小）
+    void Calibrate();
+
+    // TSC → 墙上时间（纳秒，CLOCK_REALTIME）
+    uint64_t ToRealtime(uint64_t tsc) const;
+
+    // 当前墙上时间（纳秒）
+    static uint64_t RealtimeNs();
+
+private:
+    // 同一时刻的 TSC / 单调时钟 / 墙上时间
+    static void Sample(uint64_t& tsc, uint64_t& mono, uint64_t& real);
+
+private:
+    uint64_t m_baseTsc;      // 校准起点（求频率用单调时钟，跨度越长越准）
+    uint64_t m_baseMono;
+    uint64_t m_anchorTsc;    // 最近一次对齐墙上时间（墙上时间可能被调整）
+    uint64_t m_anchorMono;
+    uint64_t m_anchorReal;
+    double m_nsPerTick;      // 0 = 还没校准
+};
+
+// ============================================
+// CLogFormatter类：把延迟格式化的记录还原成文本（在日志线程里，或离线工具里）
+//
+// 每个生产者线程一个（格式点是按线程登记的）：
+//   LOG_RECORD_SITE → 记下ID对应的文件/函数/格式串
+//   LOG_RECORD_BINARY → 找到格式点，按种类格式化，输出和LogInfo完全一样的一行
+// ============================================
+class CLogFormatter
+{
+public:
+    // 处理一条记录（type为LOG_RECORD_SITE或LOG_RECORD_BINARY），文本追加到out
+    // pid/tid是生产者的进程ID和内核线程ID（来自共享内存环的头部）
+    // 返回值：1追加了一行，0登记了格式点，-1数据错误，-2未知的格式点
+    int Format(int type, int level, const char* data, size_t size, pid_t pid, pid_t tid,
+        const CLogTsc& clock, std::string& out);
+
+    // 只解码不格式化（二进制日志文件用，见LogBinary.h）：SITE记录登记格式点；
+    // BINARY记录给出格式点ID、格式点信息（指向登记表，下一次登记之前有效）、墙上时间和参数区
+    // 返回值：1是一条记录，0登记了格式点，-1数据错误，-2未知的格式点
+    int Decode(int type, const char* data, size_t size, const CLogTsc& clock,
+        uint32_t& id, LogSiteInfo& site, uint64_t& realtimeNs, const char*& args, size_t& argSize);
+
+    // 格式化一行（和LogInfo的格式一致）：头部 + 消息 + 换行
+    // 返回值：0成功，-1参数数据错误
+    static int FormatLine(const LogSiteInfo& site, int level, uint64_t realtimeNs, pid_t pid, pid_t tid,
+        const char* args, size_t size, std::string& out);
+
+    // 格式点登记记录的负载：id(4) line(4) kind(1) file\0 func\0 fmt\0
+    static size_t SiteSize(const CLogSite& site, const char* func);
+    static void PutSite(char* p, CLogSite& site, const char* func);
+
+    // 十六进制 + ASCII（和DUMP*的格式一致），追加到out（CLogHex，见LogHex.h）
+    static void HexDump(const char* data, size_t size, std::string& out);
+
+private:
+    struct Site {
+        std::string file;
+        std::string func;
+        std::string fmt;
+        int line;
+        int kind;
+        bool valid;
+    };
+    std::vector<Site> m_sites;   // 下标 = 格式点ID
+};
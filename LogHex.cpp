@@ -0,0 +1,178 @@
+#include "LogHex.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LOG_HEX_X86 1
+#endif
+
+static const char g_hex[] = "0123456789ABCDEF";
+
+// 逐字节的一行（n <= 16，不满的十六进制部分补空格）
+static char* RowScalar(const unsigned char* p, size_t n, char* out)
+{
+    for (size_t j = 0; j < n; j++) {
+        out[j * 3] = g_hex[p[j] >> 4];
+        out[j * 3 + 1] = g_hex[p[j] & 0xF];
+        out[j * 3 + 2] = ' ';
+    }
+    memset(out + n * 3, ' ', (16 - n) * 3);
+    memcpy(out + 48, "\t; ", 3);
+    for (size_t j = 0; j < n; j++) out[51 + j] = (p[j] > 31 && p[j] < 0x7F) ? (char)p[j] : '.';
+    out[51 + n] = '\n';
+    return out + 52 + n;
+}
+
+#ifdef LOG_HEX_X86
+// 32个十六进制字符（a：第0~7字节的"HL"对，b：第8~15字节）摊成48字节的3个16字节块
+// 空格位置的下标是-128（pshufb得0），再OR上' '
+#define Z (char)-128
+static const char g_spread[4][16] = {
+    { 0, 1, Z, 2, 3, Z, 4, 5, Z, 6, 7, Z, 8, 9, Z, 10 },     // 块0 ← a
+    { 11, Z, 12, 13, Z, 14, 15, Z, Z, Z, Z, Z, Z, Z, Z, Z },  // 块1 ← a
+    { Z, Z, Z, Z, Z, Z, Z, Z, 0, 1, Z, 2, 3, Z, 4, 5 },       // 块1 ← b
+    { Z, 6, 7, Z, 8, 9, Z, 10, 11, Z, 12, 13, Z, 14, 15, Z }, // 块2 ← b
+};
+static const char g_space[3][16] = {
+    { 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0 },
+    { 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0 },
+    { ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ' },
+};
+#undef Z
+
+__attribute__((target("ssse3")))
+static char* RowsSsse3(const unsigned char* p, size_t rows, char* out)
+{
+    const __m128i table = _mm_loadu_si128((const __m128i*)g_hex);
+    const __m128i low = _mm_set1_epi8(0x0F);
+    const __m128i s0 = _mm_loadu_si128((const __m128i*)g_spread[0]);
+    const __m128i s1a = _mm_loadu_si128((const __m128i*)g_spread[1]);
+    const __m128i s1b = _mm_loadu_si128((const __m128i*)g_spread[2]);
+    const __m128i s2 = _mm_loadu_si128((const __m128i*)g_spread[3]);
+    const __m128i sp0 = _mm_loadu_si128((const __m128i*)g_space[0]);
+    const __m128i sp1 = _mm_loadu_si128((const __m128i*)g_space[1]);
+    const __m128i sp2 = _mm_loadu_si128((const __m128i*)g_space[2]);
+    const __m128i c31 = _mm_set1_epi8(31);
+    const __m128i c127 = _mm_set1_epi8(127);
+    const __m128i dot = _mm_set1_epi8('.');
+
+    for (size_t i = 0; i < rows; i++, p += 16, out += LOG_HEX_ROW) {
+        // 第1步：高低半字节查表，交错成"HL"对
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(v, 4), low));
+        __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(v, low));
+        __m128i a = _mm_unpacklo_epi8(hi, lo);
+        __m128i b = _mm_unpackhi_epi8(hi, lo);
+
+        // 第2步：摊成 "HL " × 16
+        _mm_storeu_si128((__m128i*)out, _mm_or_si128(_mm_shuffle_epi8(a, s0), sp0));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_or_si128(_mm_or_si128(
+            _mm_shuffle_epi8(a, s1a), _mm_shuffle_epi8(b, s1b)), sp1));
+        _mm_storeu_si128((__m128i*)(out + 32), _mm_or_si128(_mm_shuffle_epi8(b, s2), sp2));
+
+        // 第3步：ASCII列（有符号比较：>=0x80的是负数，自然不可见）
+        __m128i show = _mm_and_si128(_mm_cmpgt_epi8(v, c31), _mm_cmplt_epi8(v, c127));
+        memcpy(out + 48, "\t; ", 3);
+        _mm_storeu_si128((__m128i*)(out + 51), _mm_or_si128(_mm_and_si128(show, v), _mm_andnot_si128(show, dot)));
+        out[67] = '\n';
+    }
+    return out;
+}
+
+__attribute__((target("avx2")))
+static char* RowsAvx2(const unsigned char* p, size_t rows, char* out)
+{
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)g_hex));
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    const __m256i s0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)g_spread[0]));
+    const __m256i s1a = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)g_spread[1]));
+    const __m256i s1b = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)g_spread[2]));
+    const __m256i s2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)g_spread[3]));
+    const __m256i sp0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)g_space[0]));
+    const __m256i sp1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)g_space[1]));
+    const __m256i sp2 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)g_space[2]));
+    const __m256i c31 = _mm256_set1_epi8(31);
+    const __m256i c127 = _mm256_set1_epi8(127);
+    const __m256i dot = _mm256_set1_epi8('.');
+
+    // 两行一组：pshufb、unpack都在各自的128位通道里做，通道0是第一行、通道1是第二行
+    size_t i = 0;
+    for (; i + 2 <= rows; i += 2, p += 32, out += LOG_HEX_ROW * 2) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+        __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+        __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        __m256i o0 = _mm256_or_si256(_mm256_shuffle_epi8(a, s0), sp0);
+        __m256i o1 = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, s1a), _mm256_shuffle_epi8(b, s1b)), sp1);
+        __m256i o2 = _mm256_or_si256(_mm256_shuffle_epi8(b, s2), sp2);
+        __m256i show = _mm256_and_si256(_mm256_cmpgt_epi8(v, c31), _mm256_cmpgt_epi8(c127, v));
+        __m256i text = _mm256_or_si256(_mm256_and_si256(show, v), _mm256_andnot_si256(show, dot));
+
+        char* second = out + LOG_HEX_ROW;
+        _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(o0));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm256_castsi256_si128(o1));
+        _mm_storeu_si128((__m128i*)(out + 32), _mm256_castsi256_si128(o2));
+        memcpy(out + 48, "\t; ", 3);
+        _mm_storeu_si128((__m128i*)(out + 51), _mm256_castsi256_si128(text));
+        out[67] = '\n';
+        _mm_storeu_si128((__m128i*)second, _mm256_extracti128_si256(o0, 1));
+        _mm_storeu_si128((__m128i*)(second + 16), _mm256_extracti128_si256(o1, 1));
+        _mm_storeu_si128((__m128i*)(second + 32), _mm256_extracti128_si256(o2, 1));
+        memcpy(second + 48, "\t; ", 3);
+        _mm_storeu_si128((__m128i*)(second + 51), _mm256_extracti128_si256(text, 1));
+        second[67] = '\n';
+    }
+    if (i < rows) out = RowsSsse3(p, 1, out);   // 单数行剩下的一行
+    return out;
+}
+#endif
+
+bool CLogHex::Supported(int kernel)
+{
+    switch (kernel) {
+    case LOG_HEX_AUTO:
+    case LOG_HEX_SCALAR:
+        return true;
+#ifdef LOG_HEX_X86
+    case LOG_HEX_SSSE3:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+    case LOG_HEX_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("ssse3");
+#endif
+    default:
+        return false;
+    }
+}
+
+int CLogHex::Best()
+{
+    static const int best = Supported(LOG_HEX_AVX2) ? LOG_HEX_AVX2 :
+        Supported(LOG_HEX_SSSE3) ? LOG_HEX_SSSE3 : LOG_HEX_SCALAR;
+    return best;
+}
+
+size_t CLogHex::Dump(const char* data, size_t size, char* out, int kernel)
+{
+    if (kernel == LOG_HEX_AUTO) kernel = Best();
+    else if (!Supported(kernel)) return 0;
+
+    // 第1步：整行
+    const unsigned char* p = (const unsigned char*)data;
+    size_t rows = size / 16;
+    char* end = out;
+#ifdef LOG_HEX_X86
+    if (kernel == LOG_HEX_AVX2) end = RowsAvx2(p, rows, end);
+    else if (kernel == LOG_HEX_SSSE3) end = RowsSsse3(p, rows, end);
+    else
+#endif
+    {
+        for (size_t i = 0; i < rows; i++) end = RowScalar(p + i * 16, 16, end);
+    }
+
+    // 第2步：不满16字节的最后一行
+    if (size % 16 != 0) end = RowScalar(p + rows * 16, size % 16, end);
+    return (size_t)(end - out);
+}
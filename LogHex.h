@@ -0,0 +1,56 @@
+#pragma once
+#include <stddef.h>
+
+// 十六进制dump的实现（Dump的kernel参数；压测和核对用，平时用LOG_HEX_AUTO）
+enum LogHexKernel {
+    LOG_HEX_AUTO = 0,    // 启动时按CPU选最快的
+    LOG_HEX_SCALAR,      // 逐字节查表（任何平台）
+    LOG_HEX_SSSE3,       // 一次一行（16字节）：pshufb查表 + 插空格
+    LOG_HEX_AVX2,        // 一次两行（每个128位通道一行）
+};
+
+// 一行16字节：48字节十六进制（"XX "） + "\t; " + 16字节ASCII + "\n"
+#define LOG_HEX_ROW 68
+
+// ============================================
+// CLogHex类：DUMP*的十六进制 + ASCII格式化
+//
+// 问题：dump是逐字节处理的（每个字节查表后append 3个字符，ASCII列一个字符一个字符地+=），
+//      std::string边写边扩容；线上查协议问题时要dump包，1KB的包在游戏线程上要几十微秒
+//
+// 做法：
+//   1. Size先算出输出的确切长度，调用方一次留好空间，Dump一遍写完，不再扩容
+//   2. 整行（16字节）用SIMD：
+//      - 高低半字节用pshufb查"0123456789ABCDEF"，交错成"HL"对，
+//        再用3次pshufb把32个字符摊成48字节、空格位置OR上' '
+//      - ASCII列：两次比较得出可见字符的掩码，不可见的换成'.'
+//      AVX2一次处理两行（每个128位通道正好一行）
+//   3. 最后不满16字节的一行、不是x86的平台：逐字节查表（输出完全一样）
+//   4. 用哪个实现启动时按CPU选一次（__builtin_cpu_supports）
+//   pshufb是SSSE3的指令（纯SSE2没有字节查表），x86-64的CPU基本都支持
+//
+// 格式（和以前的DUMP*逐字节一致）：
+//   "41 42 43 ... 50 \t; ABC...P\n"，不满16字节的行十六进制部分用空格补齐到48字节
+//
+// 用法：
+//   std::string out(CLogHex::Size(n), '\0');
+//   CLogHex::Dump(data, n, &out[0]);
+// ============================================
+class CLogHex
+{
+public:
+    // size字节dump出来的字节数
+    static size_t Size(size_t size) {
+        size_t rows = size / 16, left = size % 16;
+        return rows * LOG_HEX_ROW + (left > 0 ? 48 + 3 + left + 1 : 0);
+    }
+
+    // 写到out（至少Size(size)字节，不写结尾的0）
+    // 返回值：写出的字节数；kernel在这台机器上不支持返回0（size为0也是0）
+    static size_t Dump(const char* data, size_t size, char* out, int kernel = LOG_HEX_AUTO);
+
+    // 这台机器能不能用这个实现
+    static bool Supported(int kernel);
+    // LOG_HEX_AUTO选中的实现
+    static int Best();
+};
@@ -0,0 +1,106 @@
+#include "LogLine.h"
+#include <charconv>    // std::to_chars
+#include <streambuf>
+#include <stdio.h>
+
+int CLogLine::Printf(const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = VPrintf(fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+int CLogLine::VPrintf(const char* fmt, va_list ap)
+{
+    // 第1步：先直接写进剩下的内联空间（大多数行到这里就结束了）
+    size_t room = m_spill ? 0 : LOG_LINE_INLINE - m_size;
+    va_list copy;
+    va_copy(copy, ap);
+    int n = vsnprintf(room > 0 ? m_inline + m_size : NULL, room, fmt, copy);
+    va_end(copy);
+    if (n < 0) return -1;
+    if ((size_t)n < room) {
+        m_size += (size_t)n;
+        return n;
+    }
+
+    // 第2步：放不下：按需要的长度在堆上留好空间再写一次（vsnprintf要多写一个'\0'）
+    char* p = Reserve((size_t)n + 1);
+    va_copy(copy, ap);
+    vsnprintf(p, (size_t)n + 1, fmt, copy);
+    va_end(copy);
+    Commit((size_t)n);
+    return n;
+}
+
+CLogLine& CLogLine::Integer(long long value)
+{
+    char* p = Reserve(24);
+    Commit((size_t)(std::to_chars(p, p + 24, value).ptr - p));
+    return *this;
+}
+
+CLogLine& CLogLine::Unsigned(unsigned long long value)
+{
+    char* p = Reserve(24);
+    Commit((size_t)(std::to_chars(p, p + 24, value).ptr - p));
+    return *this;
+}
+
+CLogLine& CLogLine::Double(double value)
+{
+    // 流的默认格式就是 %g、6位有效数字；to_chars指定精度时按printf的规则输出
+    char* p = Reserve(32);
+    Commit((size_t)(std::to_chars(p, p + 32, value, std::chars_format::general, 6).ptr - p));
+    return *this;
+}
+
+// 直接追加进CLogLine的流缓冲（不经过stringstream的中间缓冲，也不用再拷一次）
+class CLogLineBuf : public std::streambuf
+{
+public:
+    CLogLine* m_line = NULL;
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) m_line->Append((char)c);
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        m_line->Append(s, (size_t)n);
+        return n;
+    }
+};
+
+class CLogLineStream : public std::ostream
+{
+public:
+    CLogLineStream() : std::ostream(NULL) { rdbuf(&m_buf); }
+    CLogLineBuf m_buf;
+};
+
+// 每个线程一个流，一直复用；嵌套（业务类型的operator<<里又写日志）时临时构造
+static thread_local CLogLineStream s_stream;
+static thread_local bool s_streamBusy = false;
+
+std::ostream& CLogLine::BeginStream()
+{
+    CLogLineStream* stream = s_streamBusy ? new CLogLineStream() : &s_stream;
+    if (stream == &s_stream) s_streamBusy = true;
+    stream->m_buf.m_line = this;
+
+    // 每个值都从默认格式开始（和以前每次新建一个stringstream一样，std::hex之类不会延续）
+    stream->clear();
+    stream->flags(std::ios_base::dec | std::ios_base::skipws);
+    stream->precision(6);
+    stream->width(0);
+    stream->fill(' ');
+    return *stream;
+}
+
+void CLogLine::EndStream(std::ostream& stream)
+{
+    if (&stream == &s_stream) s_streamBusy = false;
+    else delete (CLogLineStream*)&stream;
+}
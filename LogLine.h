@@ -0,0 +1,129 @@
+#pragma once
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <string>
+#include <ostream>
+
+// 内联缓冲大小：一行日志（头部 + 内容）一般在这以内，超过才用堆
+#define LOG_LINE_INLINE 512
+
+// ============================================
+// CLogLine类：一行日志的格式化缓冲（LogInfo用）
+//
+// 问题：LogInfo::operator<< 每插入一个值就构造一个std::stringstream（带locale），
+//      再 str() 拷一份追加到m_buf：LOGE << a << b << c 一行好几次构造 + 好几次分配；
+//      头部的asprintf、内容的vasprintf也各分配一次
+//
+// 做法：
+//   1. 栈上的内联缓冲（LOG_LINE_INLINE字节），整行写在里面；超长才搬到堆上（spill）
+//   2. 内置类型直接转换，不经过流：
+//      整数 → std::to_chars；浮点 → std::to_chars(general, 6)（和流默认的%g一样）；
+//      bool输出1/0、char输出字符、字符串直接拷贝 —— 结果和stringstream逐字节一致
+//   3. 其他类型（业务类型自己的operator<<、enum class、指针……）走流：
+//      每个线程复用一个ostream（每次重置格式），它的streambuf直接追加进本行，不再拷一份；
+//      业务类型的operator<<里又写日志（嵌套）时临时构造一个
+//   4. printf风格：vsnprintf直接写进内联缓冲，放不下才按需要的长度扩到堆上再写一次
+//
+// 用法：
+//   CLogLine line;
+//   line.Printf("%s(%d) ", file, lineNo);
+//   line << "hp=" << 87.5 << ' ' << player;   // player有operator<<
+//   send(fd, line.Data(), line.Size(), 0);
+// ============================================
+class CLogLine
+{
+public:
+    CLogLine() : m_size(0), m_reserved(0), m_spill(false) {}
+    CLogLine(const CLogLine&) = delete;
+    CLogLine& operator=(const CLogLine&) = delete;
+
+    const char* Data() const { return m_spill ? m_heap.data() : m_inline; }
+    size_t Size() const { return m_spill ? m_heap.size() : m_size; }
+    bool Spilled() const { return m_spill; }
+
+    // 末尾取n字节可写的空间，写完用Commit交回实际写了多少（<= n）
+    char* Reserve(size_t n) {
+        if (!m_spill) {
+            if (m_size + n <= LOG_LINE_INLINE) return m_inline + m_size;
+            Spill();
+        }
+        size_t size = m_heap.size();
+        m_heap.resize(size + n);
+        m_reserved = n;
+        return &m_heap[size];
+    }
+    void Commit(size_t n) {
+        if (m_spill) m_heap.resize(m_heap.size() - m_reserved + n);
+        else m_size += n;
+        m_reserved = 0;
+    }
+
+    void Append(const char* data, size_t size) {
+        memcpy(Reserve(size), data, size);
+        Commit(size);
+    }
+    void Append(char c) {
+        *Reserve(1) = c;
+        Commit(1);
+    }
+
+    // printf风格追加
+    // 返回值：追加的字节数，-1格式错误
+    int Printf(const char* fmt, ...);
+    int VPrintf(const char* fmt, va_list ap);
+
+    // 搬到堆上，返回堆上的字符串（直接往里追加也可以，比如HexDump）
+    std::string& Spill() {
+        if (!m_spill) {
+            m_heap.assign(m_inline, m_size);
+            m_spill = true;
+        }
+        return m_heap;
+    }
+
+    // 内置类型：直接转换
+    CLogLine& operator<<(bool value) { Append(value ? '1' : '0'); return *this; }
+    CLogLine& operator<<(char value) { Append(value); return *this; }
+    CLogLine& operator<<(signed char value) { Append((char)value); return *this; }
+    CLogLine& operator<<(unsigned char value) { Append((char)value); return *this; }
+    CLogLine& operator<<(short value) { return Integer((long long)value); }
+    CLogLine& operator<<(unsigned short value) { return Unsigned((unsigned long long)value); }
+    CLogLine& operator<<(int value) { return Integer((long long)value); }
+    CLogLine& operator<<(unsigned int value) { return Unsigned((unsigned long long)value); }
+    CLogLine& operator<<(long value) { return Integer((long long)value); }
+    CLogLine& operator<<(unsigned long value) { return Unsigned((unsigned long long)value); }
+    CLogLine& operator<<(long long value) { return Integer(value); }
+    CLogLine& operator<<(unsigned long long value) { return Unsigned(value); }
+    CLogLine& operator<<(float value) { return Double((double)value); }
+    CLogLine& operator<<(double value) { return Double(value); }
+    CLogLine& operator<<(const char* value) {
+        if (value != NULL) Append(value, strlen(value));   // 流遇到NULL什么都不输出
+        return *this;
+    }
+    CLogLine& operator<<(char* value) { return *this << (const char*)value; }
+    CLogLine& operator<<(const std::string& value) { Append(value.data(), value.size()); return *this; }
+
+    // 其他类型：走（复用的）流，保持和以前一样的输出
+    template<typename T>
+    CLogLine& operator<<(const T& value) {
+        std::ostream& stream = BeginStream();
+        stream << value;
+        EndStream(stream);
+        return *this;
+    }
+
+private:
+    CLogLine& Integer(long long value);
+    CLogLine& Unsigned(unsigned long long value);
+    CLogLine& Double(double value);
+    std::ostream& BeginStream();
+    void EndStream(std::ostream& stream);
+
+private:
+    size_t m_size;                    // 内联缓冲已用的字节数
+    size_t m_reserved;                // 堆上：最近一次Reserve的字节数
+    bool m_spill;                     // 已经搬到m_heap
+    char m_inline[LOG_LINE_INLINE];
+    std::string m_heap;
+};
@@ -0,0 +1,155 @@
+#include "LogRing.h"
+#include <sys/mman.h>    // mmap, munmap, memfd_create
+#include <sys/stat.h>    // fstat
+#include <sys/syscall.h> // SYS_gettid
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <new>
+
+CLogRing::CLogRing()
+{
+    m_header = NULL;
+    m_data = NULL;
+    m_capacity = 0;
+    m_page = (size_t)sysconf(_SC_PAGESIZE);
+    m_fd = -1;
+    m_head = 0;
+    m_tailCache = 0;
+    m_tail = 0;
+}
+
+// 第一页是头部，后面capacity字节是数据区；数据区镜像映射两次
+int CLogRing::Map(int fd, size_t capacity)
+{
+    void* header = mmap(NULL, m_page, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (header == MAP_FAILED) return -3;
+
+    void* base = mmap(NULL, capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        munmap(header, m_page);
+        return -3;
+    }
+    void* lo = mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, (off_t)m_page);
+    void* hi = mmap((char*)base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, (off_t)m_page);
+    if (lo != base || hi != (char*)base + capacity) {
+        munmap(base, capacity * 2);
+        munmap(header, m_page);
+        return -3;
+    }
+    m_header = (Shared*)header;
+    m_data = (char*)base;
+    m_capacity = capacity;
+    return 0;
+}
+
+int CLogRing::Create(size_t capacity)
+{
+    if (m_header != NULL) return -1;
+
+    size_t cap = m_page;
+    while (cap < capacity) cap <<= 1;
+
+    int fd = memfd_create("logring", MFD_CLOEXEC);
+    if (fd == -1) return -2;
+    if (ftruncate(fd, (off_t)(m_page + cap)) == -1) {
+        close(fd);
+        return -2;
+    }
+    int ret = Map(fd, cap);
+    if (ret != 0) {
+        close(fd);
+        return ret;
+    }
+
+    Shared* shared = new (m_header) Shared;   // memfd是全0的，这里只是构造atomic
+    shared->capacity = (uint32_t)cap;
+    shared->pid = getpid();
+    shared->tid = (pid_t)syscall(SYS_gettid);
+    shared->head.store(0, std::memory_order_relaxed);
+    shared->tail.store(0, std::memory_order_relaxed);
+    shared->dropped.store(0, std::memory_order_relaxed);
+    shared->magic = LOG_RING_MAGIC;
+    m_fd = fd;
+    m_head = m_tailCache = 0;
+    return 0;
+}
+
+int CLogRing::Attach(int fd)
+{
+    if (m_header != NULL) return -1;
+
+    // 第1步：大小必须是 一页 + 2的幂
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size <= m_page) return -2;
+    size_t cap = (size_t)st.st_size - m_page;
+    if ((cap & (cap - 1)) != 0) return -2;
+
+    // 第2步：映射并校验头部
+    int ret = Map(fd, cap);
+    if (ret != 0) return ret;
+    if (m_header->magic != LOG_RING_MAGIC || m_header->capacity != cap) {
+        Close();
+        return -4;
+    }
+    m_tail = m_header->tail.load(std::memory_order_acquire);
+    return 0;
+}
+
+void CLogRing::Close()
+{
+    if (m_header != NULL) {
+        munmap(m_data, m_capacity * 2);
+        munmap(m_header, m_page);
+        m_header = NULL;
+        m_data = NULL;
+    }
+    if (m_fd != -1) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_capacity = 0;
+    m_head = m_tailCache = m_tail = 0;
+}
+
+pid_t CLogRing::Pid() const { return m_header != NULL ? m_header->pid : 0; }
+pid_t CLogRing::Tid() const { return m_header != NULL ? m_header->tid : 0; }
+
+bool CLogRing::Empty() const
+{
+    return m_header == NULL || m_header->head.load(std::memory_order_acquire) == m_tail;
+}
+
+// ==================== 生产者 ====================
+char* CLogRing::Reserve(size_t size)
+{
+    if (m_header == NULL) return NULL;
+    size_t need = Align(sizeof(LogRecord) + size);
+    if (need > m_capacity / 2) return NULL;   // 单条记录不超过半个环
+
+    if (m_head + need - m_tailCache > m_capacity) {
+        m_tailCache = m_header->tail.load(std::memory_order_acquire);   // 快满了才读对方的位置
+        if (m_head + need - m_tailCache > m_capacity) return NULL;
+    }
+    return m_data + (m_head & (m_capacity - 1)) + sizeof(LogRecord);
+}
+
+void CLogRing::Commit(int level, int type, size_t size)
+{
+    LogRecord* record = (LogRecord*)(m_data + (m_head & (m_capacity - 1)));
+    record->size = (uint32_t)size;
+    record->level = (uint8_t)level;
+    record->type = (uint8_t)type;
+    record->reserved = 0;
+    m_head += Align(sizeof(LogRecord) + size);
+    m_header->head.store(m_head, std::memory_order_release);
+}
+
+int CLogRing::Publish(int level, int type, const char* data, size_t size)
+{
+    char* p = Reserve(size);
+    if (p == NULL) return -1;
+    memcpy(p, data, size);
+    Commit(level, type, size);
+    return 0;
+}
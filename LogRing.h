@@ -0,0 +1,154 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <sys/types.h>
+
+// 每个日志线程的共享内存环大小（2的幂，向上取整到页）
+#define LOG_SHM_RING_SIZE (1024 * 1024)
+// 共享内存头部的标识（对端映射后校验）
+#define LOG_RING_MAGIC 0x474E524C   // "LRNG"
+
+// 记录类型
+enum LogRecordType {
+    LOG_RECORD_TEXT = 0,     // 已格式化好的一行文本（含换行）
+    LOG_RECORD_BINARY = 1,   // 延迟格式化：格式点ID + TSC + 编码后的参数（见LogFormat.h）
+    LOG_RECORD_SITE = 2,     // 延迟格式化：登记一个格式点（文件、行号、函数、格式串）
+};
+
+// 环里每条记录的头部（8字节对齐，后面紧跟size字节的负载）
+struct LogRecord
+{
+    uint32_t size;       // 负载字节数
+    uint8_t level;       // LogLevel
+    uint8_t type;        // LogRecordType
+    uint16_t reserved;
+};
+
+// ============================================
+// CLogRing类：单生产者单消费者的共享内存日志环
+//
+// 问题：CLoggerServer::Trace每一行都是一次阻塞的send()，
+//      日志线程那边还要epoll_wait + recv：一行日志几微秒，大半花在系统调用上
+//
+// 做法：
+//   1. 每个写日志的线程有一个自己的环（SPSC：只有它写、只有日志线程读，不加锁）
+//   2. 环在memfd里：第一次写日志时创建，fd通过已有的Unix socket连接（SCM_RIGHTS）
+//      交给日志服务器，对方映射同一段物理内存 → 跨CProcess的进程边界也能用
+//   3. 数据区和CRingBuffer一样镜像映射两次：记录永远是连续的，不用处理回绕
+//   4. 写入 = memcpy + 一次release store；日志线程每轮循环把所有环批量读完
+//   5. 读写位置各占一个缓存行；生产者缓存读位置，只有快满时才去读对方的缓存行
+//   6. 生产者崩溃或线程退出：连接断开，日志线程把环里已发布的记录读完再释放
+//      （记录由生产者写，日志线程读取时要校验长度，不能信任）
+//
+// 用法（生产者）：
+//   CLogRing ring;  ring.Create(LOG_SHM_RING_SIZE);  → 把ring.Fd()发给日志服务器
+//   char* p = ring.Reserve(n);  memcpy(p, line, n);  ring.Commit(LOG_INFO, LOG_RECORD_TEXT, n);
+// 用法（日志线程）：
+//   ring.Attach(fd);
+//   ring.Drain([](const LogRecord& r, const char* data) { ... });
+// ============================================
+class CLogRing
+{
+public:
+    CLogRing();
+    ~CLogRing() { Close(); }
+    CLogRing(const CLogRing&) = delete;
+    CLogRing& operator=(const CLogRing&) = delete;
+
+    // 生产者：创建共享内存环
+    // 返回值：0成功，-1已创建，-2 memfd失败，-3映射失败
+    int Create(size_t capacity);
+
+    // 日志线程：映射对方传来的fd（不接管fd，调用者自己关闭）
+    // 返回值：0成功，-1已创建，-2大小不对，-3映射失败，-4不是日志环
+    int Attach(int fd);
+
+    void Close();
+
+    bool IsValid() const { return m_header != NULL; }
+    int Fd() const { return m_fd; }           // 生产者的memfd（发给日志服务器）
+    size_t Capacity() const { return m_capacity; }
+    pid_t Pid() const;                        // 生产者的进程/线程ID
+    pid_t Tid() const;
+
+    // -------------------- 生产者 --------------------
+
+    // 取得size字节的负载空间，空间不够返回NULL（不阻塞）
+    char* Reserve(size_t size);
+    // 发布Reserve到的记录（size ≤ Reserve时的大小）
+    void Commit(int level, int type, size_t size);
+    // Reserve + memcpy + Commit；返回值：0成功，-1空间不够
+    int Publish(int level, int type, const char* data, size_t size);
+
+    // 环满了丢掉的记录数（生产者累加，日志线程读取并报告）
+    void AddDropped() { Header()->dropped.fetch_add(1, std::memory_order_relaxed); }
+    uint64_t TakeDropped() { return Header()->dropped.exchange(0, std::memory_order_relaxed); }
+
+    // -------------------- 日志线程 --------------------
+
+    // 读出当前已发布的全部记录，func(const LogRecord&, const char* data)
+    // 返回值：读出的记录数；-1数据损坏（已跳过剩余部分）
+    template<typename FUNC>
+    int Drain(FUNC func);
+
+    bool Empty() const;
+
+private:
+    // 共享内存第一页：读写位置各占一个缓存行
+    struct Shared {
+        uint32_t magic;
+        uint32_t capacity;
+        pid_t pid;
+        pid_t tid;
+        alignas(64) std::atomic<uint64_t> head;     // 写位置（生产者）
+        alignas(64) std::atomic<uint64_t> tail;     // 读位置（日志线程）
+        alignas(64) std::atomic<uint64_t> dropped;
+    };
+
+    Shared* Header() const { return m_header; }
+    int Map(int fd, size_t capacity);
+
+    static size_t Align(size_t size) { return (size + 7) & ~(size_t)7; }
+
+private:
+    Shared* m_header;
+    char* m_data;            // 镜像映射的数据区（2 × capacity 的地址空间）
+    size_t m_capacity;
+    size_t m_page;
+    int m_fd;
+    uint64_t m_head;         // 生产者：本地的写位置
+    uint64_t m_tailCache;    // 生产者：上次看到的读位置
+    uint64_t m_tail;         // 日志线程：本地的读位置
+};
+
+template<typename FUNC>
+int CLogRing::Drain(FUNC func)
+{
+    if (m_header == NULL) return 0;
+    uint64_t head = m_header->head.load(std::memory_order_acquire);
+    if (head - m_tail > m_capacity) {   // 写位置不可信：整个跳过
+        m_tail = head;
+        m_header->tail.store(m_tail, std::memory_order_release);
+        return -1;
+    }
+
+    int count = 0;
+    while (m_tail < head) {
+        const char* p = m_data + (m_tail & (m_capacity - 1));
+        LogRecord record;
+        memcpy(&record, p, sizeof(record));   // 头部先拷出来，校验之后对方再改也没关系
+        size_t size = Align(sizeof(LogRecord) + record.size);
+        if (record.size > m_capacity || size > head - m_tail) {
+            m_tail = head;
+            count = -1;
+            break;
+        }
+        func(record, p + sizeof(LogRecord));
+        m_tail += size;
+        count++;
+    }
+    m_header->tail.store(m_tail, std::memory_order_release);   // 一批只写一次对方的缓存行
+    return count;
+}
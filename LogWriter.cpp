@@ -0,0 +1,234 @@
+#include "LogWriter.h"
+#include "Clock.h"
+#include <sys/uio.h>     // writev
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>      // IOV_MAX
+#include <string.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+CLogWriter::CLogWriter()
+{
+    m_fd = -1;
+    m_used = 0;
+    m_last = 0;
+    m_pending = 0;
+    m_first = 0;
+    m_urgent = false;
+    m_flushBytes = LOG_FLUSH_BYTES;
+    m_flushMs = LOG_FLUSH_MS;
+    m_sync = false;
+    m_urgentLevel = 3;   // LOG_ERROR
+    m_written = 0;
+    m_writes = 0;
+    m_size = 0;
+    m_dir = "./log";
+    m_rotateBytes = LOG_ROTATE_BYTES;
+    m_interval = 0;
+    m_boundary = 0;
+    m_keep = 0;
+    m_compress = true;
+}
+
+CLogWriter::~CLogWriter()
+{
+    Close();
+    for (size_t i = 0; i < m_blocks.size(); i++) free(m_blocks[i]);
+    m_blocks.clear();
+}
+
+uint64_t CLogWriter::NowMs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+int CLogWriter::Open(const char* path)
+{
+    if (m_fd != -1) return -1;
+    m_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd == -1) return -2;
+    m_path = path;
+    m_size = 0;
+    // 轮转出来的新文件沿用这个扩展名（文本.log，二进制.blog）
+    const char* dot = strrchr(path, '.');
+    const char* slash = strrchr(path, '/');
+    m_suffix = (dot != NULL && (slash == NULL || dot > slash)) ? dot : ".log";
+    NextBoundary();
+    return 0;
+}
+
+void CLogWriter::Close()
+{
+    if (m_fd == -1) return;
+    Flush();
+    close(m_fd);
+    m_fd = -1;
+    m_archiver.Stop();   // 只等正在压缩的那个文件
+}
+
+void CLogWriter::SetPolicy(size_t bytes, unsigned ms, bool sync, int urgentLevel)
+{
+    m_flushBytes = bytes;
+    m_flushMs = ms;
+    m_sync = sync;
+    m_urgentLevel = urgentLevel;
+}
+
+void CLogWriter::SetRotation(const char* dir, size_t maxBytes, unsigned interval, unsigned keep, bool compress)
+{
+    m_dir = dir;
+    m_rotateBytes = maxBytes;
+    m_interval = interval;
+    m_keep = keep;
+    m_compress = compress;
+}
+
+// 下一个按本地时间对齐的边界（interval=3600就是每个整点）
+void CLogWriter::NextBoundary()
+{
+    if (m_interval == 0) {
+        m_boundary = 0;
+        return;
+    }
+    time_t now = time(NULL);
+    tm local_tm;
+    localtime_r(&now, &local_tm);
+    time_t local = now + local_tm.tm_gmtoff;
+    m_boundary = (local / m_interval + 1) * m_interval - local_tm.tm_gmtoff;
+}
+
+bool CLogWriter::NeedRotate() const
+{
+    if (m_size == 0) return false;   // 空文件不轮转
+    if (m_rotateBytes != 0 && m_size + m_pending > m_rotateBytes) return true;
+    return m_boundary != 0 && time(NULL) >= m_boundary;
+}
+
+int CLogWriter::Rotate()
+{
+    if (m_fd == -1) return -1;
+
+    // 第1步：先打开新文件（同一毫秒里重名就加后缀）
+    char time[CLOCK_TIME_STR_SIZE];
+    CClock::Format(CClock::NowPrecise(), time);
+    std::string name, path;
+    int fd = -1;
+    for (int i = 0; i < 10 && fd == -1; i++) {
+        name = std::string(time) + (i == 0 ? "" : "-" + std::to_string(i)) + m_suffix;
+        path = m_dir + "/" + name;
+        fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd == -1 && errno != EEXIST) break;
+    }
+    if (fd == -1) {
+        NextBoundary();   // 不要每一批都重试
+        return -2;
+    }
+
+    // 第2步：换fd（批缓冲里的数据还没写，整批进新文件），旧文件落盘后关闭
+    int old = m_fd;
+    std::string oldPath = m_path;
+    m_fd = fd;
+    m_path = path;
+    m_size = 0;
+    NextBoundary();
+    if (m_sync) fdatasync(old);
+    close(old);
+
+    // 第3步：后台压缩、清理（第一次轮转时才启动后台线程）
+    if ((m_compress || m_keep > 0) && !m_archiver.IsRunning()) m_archiver.Start(m_dir, m_keep, m_compress);
+    if (m_archiver.IsRunning()) m_archiver.Submit(oldPath, name);
+    return 0;
+}
+
+void CLogWriter::Append(const char* data, size_t size, int level)
+{
+    if (m_fd == -1 || size == 0) return;
+    if (m_pending == 0) m_first = NowMs();
+    if (level >= m_urgentLevel) m_urgent = true;
+
+    while (size > 0) {
+        // 第1步：当前块满了（或还没有块）→ 下一块（分配过的块直接复用）
+        if (m_used == 0 || m_last == LOG_WRITER_BLOCK) {
+            if (m_used == m_blocks.size()) {
+                char* block = (char*)malloc(LOG_WRITER_BLOCK);
+                if (block == NULL) return;
+                m_blocks.push_back(block);
+            }
+            m_used++;
+            m_last = 0;
+        }
+        // 第2步：拷进去
+        size_t n = LOG_WRITER_BLOCK - m_last;
+        if (n > size) n = size;
+        memcpy(m_blocks[m_used - 1] + m_last, data, n);
+        m_last += n;
+        m_pending += n;
+        data += n;
+        size -= n;
+    }
+    if (m_pending >= LOG_WRITER_MAX) Flush();
+}
+
+ssize_t CLogWriter::Poll()
+{
+    if (m_pending == 0) return 0;
+    if (m_urgent || m_pending >= m_flushBytes || NowMs() - m_first >= m_flushMs) return Flush();
+    return 0;
+}
+
+ssize_t CLogWriter::Flush()
+{
+    if (m_pending == 0 || m_fd == -1) return 0;
+    if (NeedRotate()) Rotate();
+
+    // 第1步：整批一次writev（写不完的部分接着写）
+    ssize_t total = 0;
+    size_t block = 0;     // 从哪一块开始
+    size_t offset = 0;    // 这一块里已写出的字节数
+    while (block < m_used) {
+        iovec iov[64];
+        int count = 0;
+        for (size_t i = block; i < m_used && count < 64 && count < IOV_MAX; i++, count++) {
+            size_t size = (i + 1 == m_used) ? m_last : LOG_WRITER_BLOCK;
+            size_t skip = (i == block) ? offset : 0;
+            iov[count].iov_base = m_blocks[i] + skip;
+            iov[count].iov_len = size - skip;
+        }
+        ssize_t n = writev(m_fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            total = -1;   // 磁盘满之类：这一批丢掉，不阻塞日志线程
+            break;
+        }
+        m_writes++;
+        m_written += (uint64_t)n;
+        m_size += (uint64_t)n;
+        total += n;
+        // 第2步：按写出的字节数前进
+        size_t left = (size_t)n;
+        while (left > 0 && block < m_used) {
+            size_t size = ((block + 1 == m_used) ? m_last : LOG_WRITER_BLOCK) - offset;
+            if (left < size) {
+                offset += left;
+                left = 0;
+            }
+            else {
+                left -= size;
+                block++;
+                offset = 0;
+            }
+        }
+    }
+
+    // 第3步：按需落盘；批缓冲清空（块留着复用）
+    if (m_sync && total > 0) fdatasync(m_fd);
+    m_used = 0;
+    m_last = 0;
+    m_pending = 0;
+    m_urgent = false;
+    return total;
+}
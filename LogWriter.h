@@ -0,0 +1,122 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <vector>
+#include <string>
+#include "LogArchiver.h"
+
+// 批缓冲的块大小（写出时一块一个iovec）
+#define LOG_WRITER_BLOCK (64 * 1024)
+// 默认刷盘策略：攒够64KB或者最早的数据等了50ms
+#define LOG_FLUSH_BYTES (64 * 1024)
+#define LOG_FLUSH_MS 50
+// 批缓冲的上限：超过时Append里直接写出（日志线程一轮读了很多环，也不会无限攒）
+#define LOG_WRITER_MAX (4 * 1024 * 1024)
+// 默认轮转：单个文件256MB；按时间轮转、保留数量默认关闭
+#define LOG_ROTATE_BYTES (256 * 1024 * 1024)
+
+// ============================================
+// CLogWriter类：日志文件的批量写（group commit）
+//
+// 问题：WriteLog每收到一段数据就 fwrite + fflush，一行日志一次write()；
+//      DEBUG级别下日志线程的时间全花在write系统调用上，读环跟不上，生产者开始丢日志
+//
+// 做法：
+//   1. Append只把数据拷进批缓冲（64KB的块，只在第一次用到时分配，之后复用）
+//   2. 日志线程每轮循环末尾调用Poll：满足刷盘条件才一次writev写出整批
+//      - 攒够 flushBytes 字节
+//      - 最早的一条等了 flushMs 毫秒
+//      - 批里有ERROR/FATAL（Append时level >= urgentLevel）→ 这一轮立即写
+//   3. 只有setSync=true时，每次写出后再fdatasync（默认只进页缓存，进程崩溃不丢，掉电可能丢）
+//   4. 直接用fd，不经过FILE*的缓冲（少一次拷贝，写出时机完全由策略决定）
+//   5. 轮转（SetRotation）：文件超过maxBytes，或跨过了按本地时间对齐的interval秒边界，
+//      在两批之间换文件：先打开新文件，再换fd、关旧fd → 一批只会完整地落在一个文件里，
+//      不丢不重；新文件打不开就继续写旧文件。旧文件交给CLogArchiver在后台压缩和清理
+//
+// 用法：
+//   CLogWriter writer;
+//   writer.SetPolicy(64 * 1024, 50, false);
+//   writer.Open("./log/xxx.log");
+//   writer.Append(line, n, LOG_INFO);   // 日志线程里，任意多次
+//   writer.Poll();                      // 每轮循环一次
+//   writer.Close();                     // 写出剩余的数据
+// ============================================
+class CLogWriter
+{
+public:
+    CLogWriter();
+    ~CLogWriter();
+    CLogWriter(const CLogWriter&) = delete;
+    CLogWriter& operator=(const CLogWriter&) = delete;
+
+    // 打开（截断）日志文件
+    // 返回值：0成功，-1已打开，-2打开失败
+    int Open(const char* path);
+    // 写出剩余数据并关闭
+    void Close();
+    bool IsOpen() const { return m_fd != -1; }
+    int Fd() const { return m_fd; }
+
+    // 刷盘策略：bytes字节 / ms毫秒 / level >= urgentLevel立即；sync=true每次写出后fdatasync
+    void SetPolicy(size_t bytes, unsigned ms, bool sync, int urgentLevel = 3);
+
+    // 轮转策略（Open之前设置）：新文件建在dir下，名字是当时的时间（和启动时的文件名一样）
+    // maxBytes=0不按大小，interval=0不按时间；keep：保留的旧文件数（0不限）；compress：gzip旧文件
+    void SetRotation(const char* dir, size_t maxBytes, unsigned interval, unsigned keep, bool compress);
+
+    // 立即换一个新文件（两批之间）
+    // 返回值：0成功，-1没打开，-2新文件打不开（继续写旧文件）
+    int Rotate();
+
+    const std::string& Path() const { return m_path; }
+    CLogArchiver& Archiver() { return m_archiver; }
+
+    // 追加数据到批缓冲（不写文件）
+    void Append(const char* data, size_t size, int level);
+
+    // 按策略决定是否写出
+    // 返回值：写出的字节数，0没到时候（或没有数据），-1写失败
+    ssize_t Poll();
+
+    // 立即写出整批（一次writev）
+    // 返回值：写出的字节数，-1写失败（数据丢弃，不会无限重试）
+    ssize_t Flush();
+
+    size_t Pending() const { return m_pending; }
+    uint64_t Written() const { return m_written; }      // 累计写出的字节数
+    uint64_t Writes() const { return m_writes; }        // 累计writev次数
+
+private:
+    static uint64_t NowMs();
+    bool NeedRotate() const;
+    void NextBoundary();
+
+private:
+    int m_fd;
+    std::vector<char*> m_blocks;   // 批缓冲（块复用，不释放）
+    size_t m_used;                 // 已用的块数（最后一块可能没满）
+    size_t m_last;                 // 最后一块已用的字节数
+    size_t m_pending;              // 批里的总字节数
+    uint64_t m_first;              // 批里最早一段数据的时间（毫秒）
+    bool m_urgent;                 // 批里有ERROR/FATAL
+
+    size_t m_flushBytes;
+    unsigned m_flushMs;
+    bool m_sync;
+    int m_urgentLevel;
+
+    uint64_t m_written;
+    uint64_t m_writes;
+
+    std::string m_path;            // 当前文件
+    std::string m_suffix;          // 扩展名（Open时的文件名决定，轮转沿用）
+    uint64_t m_size;               // 当前文件已写的字节数
+    std::string m_dir;             // 轮转：新文件的目录
+    size_t m_rotateBytes;
+    unsigned m_interval;
+    time_t m_boundary;             // 下一个按时间轮转的时刻（0 = 不按时间）
+    unsigned m_keep;
+    bool m_compress;
+    CLogArchiver m_archiver;
+};
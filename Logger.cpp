@@ -1,5 +1,10 @@
 // Logger.cpp - 日志模块实现
 #include "Logger.h"
+#include <sys/syscall.h>  // SYS_gettid
+#include <signal.h>       // sigaction（飞行记录器的信号）
+#include <fcntl.h>
+#include <vector>
+#include <algorithm>
 
 // ==================== CLoggerServer::Start ====================
 int CLoggerServer::Start() {
@@ -13,9 +18,9 @@ int CLoggerServer::Start() {
         mkdir("log", 0755);
     }
 
-    // 第3步：打开日志文件
-    m_file = fopen(m_path, "w+");
-    if (m_file == NULL) return -2;
+    // 第3步：打开日志文件（二进制格式的块也是交给m_writer写）
+    if (m_writer.Open(m_path) != 0) return -2;
+    if (m_format == LOG_FILE_BINARY) m_binary.Open(&m_writer);
 
     // 第4步：创建epoll实例
     int ret = m_epoll.Create(1);
@@ -42,7 +47,16 @@ int CLoggerServer::Start() {
         return -6;
     }
 
-    // 第8步：启动日志线程
+    // 第8步：控制Socket（改日志级别用，失败了只是不能远程改级别）
+    CLogFilter::Attach();
+    m_control = new CLocalSocket();
+    if (m_control->Init(CSockParam(LOG_CONTROL_PATH, (int)SOCK_ISSERVER)) != 0 ||
+        m_epoll.Add(*m_control, EpollData((void*)m_control), EPOLLIN | EPOLLERR) != 0) {
+        CSocketBase::Free(m_control);
+        m_control = NULL;
+    }
+
+    // 第9步：启动日志线程
     ret = m_thread.Start();
     if (ret != 0) {
         Close();
@@ -54,15 +68,192 @@ int CLoggerServer::Start() {
 
 // ==================== CLoggerServer::WriteLog ====================
 void CLoggerServer::WriteLog(const Buffer& data) {
-    if (m_file != NULL) {
-        fwrite((char*)data, 1, data.size(), m_file);
-        fflush(m_file);
+    if (m_binary.IsOpen()) {
+        m_binary.Text(LOG_INFO, 0, 0, CLogTsc::RealtimeNs(), data, data.size());
+        m_binary.Flush();
+        m_writer.Flush();
+    }
+    else if (m_writer.IsOpen()) {
+        m_writer.Append(data, data.size(), LOG_INFO);
+        m_writer.Flush();
 #ifdef _DEBUG
         printf("%s", (char*)data);
 #endif
     }
 }
 
+// 兜底文本里的FATAL行："file(line):[FATAL][时间]<pid-tid>"，找到就请求转储
+// 返回值：0没有；>0行里的pid；-1有FATAL但pid解析不出来（转储全部进程）
+static pid_t FindFallbackFatal(const char* data, size_t len) {
+    static const char marker[] = ":[FATAL][";
+    const char* p = (const char*)memmem(data, len, marker, sizeof(marker) - 1);
+    if (p == NULL) return 0;
+    const char* end = data + len;
+    const char* lt = (const char*)memchr(p, '<', end - p);
+    if (lt == NULL || lt + 1 >= end) return -1;
+    pid_t pid = 0;
+    for (const char* q = lt + 1; q < end && *q >= '0' && *q <= '9'; q++) pid = pid * 10 + (*q - '0');
+    return pid > 0 ? pid : -1;
+}
+
+// ==================== CLoggerServer::WriteLog（环形缓冲区） ====================
+void CLoggerServer::WriteLog(CRingBuffer& ring, bool bAll) {
+    iovec iov[2];
+    int count = ring.ReadableVec(iov);
+    if (count == 0) return;
+
+    // 找最后一个换行符：从后一段往前找
+    size_t size = ring.Size();
+    if (!bAll && ring.Free() > 0) {
+        size = 0;
+        for (int i = count - 1; i >= 0; i--) {
+            const char* p = (const char*)memrchr(iov[i].iov_base, '\n', iov[i].iov_len);
+            if (p != NULL) {
+                size = (p - (const char*)iov[i].iov_base) + 1;
+                if (i == 1) size += iov[0].iov_len;
+                break;
+            }
+        }
+        if (size == 0) return;  // 还没有完整的一行
+    }
+    // 环满了还没有换行（超长行），只能整体写出
+
+    // 兜底路径上的FATAL也要转储飞行记录（跨环尾的一行把接缝两边拼起来再找一次）
+    size_t rest = size;
+    for (int i = 0; i < count && rest > 0; i++) {
+        size_t len = iov[i].iov_len < rest ? iov[i].iov_len : rest;
+        pid_t pid = FindFallbackFatal((const char*)iov[i].iov_base, len);
+        if (pid != 0) RequestFlight(pid > 0 ? pid : 0, "FATAL");
+        rest -= len;
+    }
+    if (count == 2 && size > iov[0].iov_len) {
+        char seam[128];
+        size_t head = iov[0].iov_len < 64 ? iov[0].iov_len : 64;
+        size_t tail = size - iov[0].iov_len < 64 ? size - iov[0].iov_len : 64;
+        memcpy(seam, (const char*)iov[0].iov_base + iov[0].iov_len - head, head);
+        memcpy(seam + head, iov[1].iov_base, tail);
+        pid_t pid = FindFallbackFatal(seam, head + tail);
+        if (pid != 0) RequestFlight(pid > 0 ? pid : 0, "FATAL");
+    }
+
+    if (m_writer.IsOpen()) {
+        size_t left = size;
+        for (int i = 0; i < count && left > 0; i++) {
+            size_t len = iov[i].iov_len < left ? iov[i].iov_len : left;
+            if (m_binary.IsOpen()) {
+                // 已经是文本（pid/tid在行里），跨环尾的两段各一条记录，解码后拼起来一样
+                m_binary.Text(LOG_ERROR, 0, 0, CLogTsc::RealtimeNs(), (const char*)iov[i].iov_base, len);
+            }
+            else m_writer.Append((const char*)iov[i].iov_base, len, LOG_ERROR);   // 兜底数据：这一轮就写出
+#ifdef _DEBUG
+            printf("%.*s", (int)len, (char*)iov[i].iov_base);
+#endif
+            left -= len;
+        }
+    }
+    ring.Consume(size);
+}
+
+// ==================== CLoggerServer::WriteLog（共享内存环） ====================
+int CLoggerServer::WriteLog(CLogPeer& peer) {
+    CLogRing& ring = peer.ring;
+    int count = ring.Drain([this, &peer, &ring](const LogRecord& record, const char* data) {
+        if (record.level == LOG_FATAL && record.type != LOG_RECORD_SITE) RequestFlight(ring.Pid(), "FATAL");
+        if (!m_writer.IsOpen()) return;
+        if (m_binary.IsOpen()) {
+            WriteBinary(peer, record, data);
+            return;
+        }
+        if (record.type == LOG_RECORD_TEXT) {
+            m_writer.Append(data, record.size, record.level);
+#ifdef _DEBUG
+            printf("%.*s", (int)record.size, data);
+#endif
+            return;
+        }
+        // 延迟格式化：登记格式点，或者在这里格式化（调用方只拷贝了参数）
+        m_line.clear();
+        if (peer.formatter.Format(record.type, record.level, data, record.size,
+            ring.Pid(), ring.Tid(), m_clock, m_line) > 0) {
+            m_writer.Append(m_line.data(), m_line.size(), record.level);
+#ifdef _DEBUG
+            printf("%s", m_line.c_str());
+#endif
+        }
+    });
+
+    // 环满时生产者丢掉的记录（只丢INFO/DEBUG/WARNING，ERROR以上走socket兜底）
+    uint64_t dropped = ring.TakeDropped();
+    if (dropped > 0 && m_writer.IsOpen()) {
+        char time[CLOCK_TIME_STR_SIZE];
+        CClock::Format(time);
+        char line[256];
+        int n = snprintf(line, sizeof(line), "[%s]<%d-%d> 日志环已满，丢弃%llu条记录\n", time,
+            (int)ring.Pid(), (int)ring.Tid(), (unsigned long long)dropped);
+        if (n <= 0) return count > 0 ? count : 0;
+        if (m_binary.IsOpen()) m_binary.Text(LOG_WARNING, ring.Pid(), ring.Tid(), CLogTsc::RealtimeNs(), line, (size_t)n);
+        else m_writer.Append(line, (size_t)n, LOG_WARNING);
+    }
+    return count > 0 ? count : 0;
+}
+
+// ==================== CLoggerServer::WriteBinary ====================
+void CLoggerServer::WriteBinary(CLogPeer& peer, const LogRecord& record, const char* data) {
+    CLogRing& ring = peer.ring;
+    if (record.type == LOG_RECORD_TEXT) {
+        // 已经格式化好的一行：时间取日志线程读到它的时刻（块的时间索引用，行里有调用方的时间）
+        m_binary.Text(record.level, ring.Pid(), ring.Tid(), CLogTsc::RealtimeNs(), data, record.size);
+        return;
+    }
+
+    // 第1步：解码（SITE只登记，它的字符串表ID要重新查）
+    uint32_t id;
+    LogSiteInfo site;
+    uint64_t realtimeNs;
+    const char* args;
+    size_t argSize;
+    int ret = peer.formatter.Decode(record.type, data, record.size, m_clock, id, site, realtimeNs, args, argSize);
+    if (ret < 0) return;
+    if (peer.strings.size() < (size_t)(id + 1) * 3) peer.strings.resize((size_t)(id + 1) * 3, UINT32_MAX);
+    uint32_t* ids = &peer.strings[(size_t)id * 3];
+    if (ret == 0) {
+        ids[0] = UINT32_MAX;
+        return;
+    }
+
+    // 第2步：格式点 → 字符串表ID（每个线程的每个格式点只查一次哈希表）
+    if (ids[0] == UINT32_MAX) m_binary.Strings(site, ids);
+    m_binary.EventIds(record.level, ring.Pid(), ring.Tid(), realtimeNs, ids, site.line, site.kind, args, argSize);
+}
+
+// ==================== CLoggerServer::Control ====================
+int CLoggerServer::Control(CSocketBase* client, std::string& pending) {
+    // 第1步：收数据（一行命令很短，半行留着等下次）
+    Buffer data(256);
+    int r = client->Recv(data);
+    if (r <= 0) return r;
+    pending.append(data.c_str(), (size_t)r);
+    if (pending.size() > 4096) return 0;   // 一直没有换行：不是控制命令，断开
+
+    // 第2步：每个完整的行执行一次，回复一行
+    size_t start = 0, end;
+    while ((end = pending.find('\n', start)) != std::string::npos) {
+        std::string reply;
+        std::string line = pending.substr(start, end - start);
+        int pid = 0;
+        if (line == "dump" || sscanf(line.c_str(), "dump %d", &pid) == 1) {
+            // dump [pid]：这一轮结束时dump飞行记录器（0或不写 = 所有进程）
+            RequestFlight(pid > 0 ? pid : 0, "dump命令");
+            reply = "OK\n";
+        }
+        else CLogFilter::Command(line.c_str(), reply);
+        if (client->Send(Buffer(reply)) != (int)reply.size()) return 0;
+        start = end + 1;
+    }
+    pending.erase(0, start);
+    return r;
+}
+
 // ==================== LogInfo构造函数1：printf风格 ====================
 LogInfo::LogInfo(
     const char* file, int line, const char* func,
@@ -74,32 +265,25 @@ LogInfo::LogInfo(
         "INFO","DEBUG","WARNING","ERROR","FATAL"
     };
 
-    char* buf = NULL;
+    char time[CLOCK_TIME_STR_SIZE];
+    CClock::Format(time);
     bAuto = false;  // printf风格需要手动调用Trace()
+    m_level = level;
 
-    // 格式化日志头
-    int count = asprintf(&buf, "%s(%d):[%s][%s]<%d-%d>(%s) ",
+    // 格式化日志头（直接写进内联缓冲，不分配）
+    int count = m_line.Printf("%s(%d):[%s][%s]<%d-%d>(%s) ",
         file, line, sLevel[level],
-        (char*)CLoggerServer::GetTimeStr(), pid, tid, func);
-
-    if (count > 0) {
-        m_buf = buf;
-        free(buf);
-    }
-    else return;
+        time, pid, tid, func);
+    if (count <= 0) return;
 
     // 格式化用户消息
     va_list ap;
     va_start(ap, fmt);
-    count = vasprintf(&buf, fmt, ap);
-    if (count > 0) {
-        m_buf += buf;
-        free(buf);
-    }
+    m_line.VPrintf(fmt, ap);
     va_end(ap);
 
     // ⚡ 添加换行符（重要！）
-    m_buf += "\n";
+    m_line.Append('\n');
 }
 
 // ==================== LogInfo构造函数2：流式输出风格 ====================
@@ -109,20 +293,17 @@ LogInfo::LogInfo(
 )
 {
     bAuto = true;  // 流式输出需要析构时调用Trace()
+    m_level = level;
 
     const char sLevel[][8] = {
         "INFO","DEBUG","WARNING","ERROR","FATAL"
     };
 
-    char* buf = NULL;
-    int count = asprintf(&buf, "%s(%d):[%s][%s]<%d-%d>(%s) ",
+    char time[CLOCK_TIME_STR_SIZE];
+    CClock::Format(time);
+    m_line.Printf("%s(%d):[%s][%s]<%d-%d>(%s) ",
         file, line, sLevel[level],
-        (char*)CLoggerServer::GetTimeStr(), pid, tid, func);
-
-    if (count > 0) {
-        m_buf = buf;
-        free(buf);
-    }
+        time, pid, tid, func);
 }
 
 // ==================== LogInfo构造函数3：dump风格 ====================
@@ -133,59 +314,24 @@ LogInfo::LogInfo(
 )
 {
     bAuto = false;  // dump风格需要手动调用Trace()
+    m_level = level;
 
     const char sLevel[][8] = {
         "INFO","DEBUG","WARNING","ERROR","FATAL"
     };
 
-    char* buf = NULL;
-    int count = asprintf(&buf, "%s(%d):[%s][%s]<%d-%d>(%s)\n",
+    char time[CLOCK_TIME_STR_SIZE];
+    CClock::Format(time);
+    int count = m_line.Printf("%s(%d):[%s][%s]<%d-%d>(%s)\n",
         file, line, sLevel[level],
-        (char*)CLoggerServer::GetTimeStr(), pid, tid, func);
-
-    if (count > 0) {
-        m_buf = buf;
-        free(buf);
-    }
-    else return;
-
-    // 转换二进制数据为十六进制
-    char* Data = (char*)pData;
-    for (size_t i = 0; i < nSize; i++) {
-        char buf[16] = "";
-        snprintf(buf, sizeof(buf), "%02X ", Data[i] & 0xFF);
-        m_buf += buf;
-
-        if (0 == ((i + 1) % 16)) {
-            m_buf += "\t; ";
-            for (size_t j = i - 15; j <= i; j++) {
-                if ((Data[j] & 0xFF) > 31 && (Data[j] & 0xFF) < 0x7F) {
-                    m_buf += Data[j];
-                }
-                else {
-                    m_buf += '.';
-                }
-            }
-            m_buf += "\n";
-        }
-    }
-
-    // 处理末尾不足16字节
-    size_t k = nSize % 16;
-    if (k != 0) {
-        for (size_t j = 0; j < 16 - k; j++)
-            m_buf += "   ";
-        m_buf += "\t; ";
-        for (size_t j = nSize - k; j < nSize; j++) {
-            if ((Data[j] & 0xFF) > 31 && (Data[j] & 0xFF) < 0x7F) {
-                m_buf += Data[j];
-            }
-            else {
-                m_buf += '.';
-            }
-        }
-        m_buf += "\n";
-    }
+        time, pid, tid, func);
+    if (count <= 0) return;
+
+    // 转换二进制数据为十六进制（和日志线程格式化DUMP记录用同一个实现）
+    // 先按确切的长度留好空间，CLogHex一遍写完（SIMD，见LogHex.h）
+    size_t size = CLogHex::Size(nSize);
+    char* p = m_line.Reserve(size);
+    m_line.Commit(nSize > 0 ? CLogHex::Dump((const char*)pData, nSize, p) : 0);
 }
 
 // ==================== LogInfo析构函数 ====================
@@ -193,13 +339,15 @@ LogInfo::~LogInfo()
 {
     if (bAuto) {
         // ⚡ 流式输出：添加换行符（重要！）
-        m_buf += "\n";
+        m_line.Append('\n');
         CLoggerServer::Trace(*this);
     }
 }
 
-// ==================== CLoggerServer::Trace实现 ====================
-void CLoggerServer::Trace(const LogInfo& info) {
+// ==================== 每线程的日志客户端 ====================
+// 第一次调用时连接日志服务器，之后一直复用（thread_local，无需加锁）
+// 返回值：已连接的客户端，失败返回NULL
+static CLocalSocket* LogClient() {
     static thread_local CLocalSocket client;
 
     if (client == -1) {
@@ -210,7 +358,7 @@ void CLoggerServer::Trace(const LogInfo& info) {
             printf("%s(%d):[%s]初始化socket失败 ret=%d\n",
                 __FILE__, __LINE__, __FUNCTION__, ret);
 #endif
-            return;
+            return NULL;
         }
 #ifdef _DEBUG
         printf("%s(%d):[%s]初始化成功 client=%d\n",
@@ -224,18 +372,315 @@ void CLoggerServer::Trace(const LogInfo& info) {
             printf("%s(%d):[%s]连接日志服务器失败 ret=%d\n",
                 __FILE__, __LINE__, __FUNCTION__, ret);
 #endif
-            return;
+            return NULL;
         }
 #ifdef _DEBUG
         printf("%s(%d):[%s]连接成功 client=%d\n",
             __FILE__, __LINE__, __FUNCTION__, (int)client);
 #endif
     }
+    return &client;
+}
+
+// ==================== 每线程的共享内存环 ====================
+// 第一次调用时创建，fd随握手数据交给日志服务器；之后写日志不再有系统调用
+// 返回值：可用的环，创建或交付失败返回NULL（只走socket）
+static thread_local CLogFlight* t_flight = NULL;   // 本线程的飞行记录器（交给日志服务器之后才有）
+
+static CLogRing* LogRing() {
+    static thread_local CLogRing ring;
+    static thread_local CLogFlight flight;
+    static thread_local int state = 0;   // 0未创建，1可用，-1失败
+
+    if (state == 0) {
+        CLogFilter::Attach();              // 本进程第一次写日志：换成共享的级别表
+        CLocalSocket* client = LogClient();
+        if (client == NULL) return NULL;   // 服务器还没起来：下次再试
+        state = -1;
+        if (ring.Create(LOG_SHM_RING_SIZE) != 0) return NULL;
+        if (client->SendFD(ring.Fd(), LOG_RING_HELLO, LOG_RING_HELLO_SIZE) != LOG_RING_HELLO_SIZE) {
+            ring.Close();
+            return NULL;
+        }
+        state = 1;
+
+        // 飞行记录器紧跟着交过去（失败了只是没有飞行记录）
+        if (flight.Create(LOG_FLIGHT_SIZE) == 0) {
+            if (client->SendFD(flight.Fd(), LOG_FLIGHT_HELLO, LOG_FLIGHT_HELLO_SIZE) == LOG_FLIGHT_HELLO_SIZE) t_flight = &flight;
+            else flight.Close();
+        }
+    }
+    return state == 1 ? &ring : NULL;
+}
+
+// 环满了：ERROR/FATAL不能丢，走阻塞的socket；其余计数丢弃（不让游戏线程等日志）
+// 返回值：true已处理，false需要走socket
+static bool LogRingFull(CLogRing* ring, int level) {
+    if (level >= LOG_ERROR) return false;
+    ring->AddDropped();
+    return true;
+}
+
+// ==================== CLoggerServer::Trace实现 ====================
+void CLoggerServer::Trace(const LogInfo& info) {
+    CLogRing* ring = LogRing();
+    if (ring != NULL) {
+        if (ring->Publish(info.Level(), LOG_RECORD_TEXT, info.Data(), info.Size()) == 0) return;
+        if (LogRingFull(ring, info.Level())) return;
+    }
+
+    CLocalSocket* client = LogClient();
+    if (client == NULL) return;
+
+    // 第3步：发送日志数据（兜底，少见：拷一份成Buffer）
+    int ret = client->Send(Buffer(std::string(info.Data(), info.Size())));
+#ifdef _DEBUG
+    printf("%s(%d):[%s]发送日志 ret=%d size=%zu\n",
+        __FILE__, __LINE__, __FUNCTION__, ret, info.Size());
+#endif
+    (void)ret;
+}
+
+void CLoggerServer::Trace(const CIOBuf& data) {
+    CLogRing* ring = LogRing();
+    if (ring != NULL) {
+        char* p = ring->Reserve(data.Size());
+        if (p != NULL) {
+            data.CopyTo(p, 0, data.Size());
+            ring->Commit(LOG_INFO, LOG_RECORD_TEXT, data.Size());
+            return;
+        }
+        if (LogRingFull(ring, LOG_INFO)) return;
+    }
+
+    CLocalSocket* client = LogClient();
+    if (client == NULL) return;
 
-    // 第3步：发送日志数据
-    int ret = client.Send(info);
+    // 兜底：阻塞socket，Send内部按TrimStart把短写的剩余部分接着写完
+    int ret = client->Send(data);
 #ifdef _DEBUG
     printf("%s(%d):[%s]发送日志 ret=%d size=%zu\n",
-        __FILE__, __LINE__, __FUNCTION__, ret, ((Buffer)info).size());
+        __FILE__, __LINE__, __FUNCTION__, ret, data.Size());
 #endif
+    (void)ret;
+}
+
+// ==================== 延迟格式化 ====================
+// 格式点登记：每个线程的每个调用点只发一次LOG_RECORD_SITE（日志线程按环记录）
+// 返回值：true已登记，false环满了
+static bool LogRegisterSite(CLogRing* ring, CLogSite& site, const char* func) {
+    static thread_local std::vector<bool> sent;   // 下标 = 格式点ID
+    uint32_t id = site.Id();
+    if (id < sent.size() && sent[id]) return true;
+
+    size_t size = CLogFormatter::SiteSize(site, func);
+    char* p = ring->Reserve(size);
+    if (p == NULL) return false;
+    CLogFormatter::PutSite(p, site, func);
+    ring->Commit(site.level, LOG_RECORD_SITE, size);
+    if (sent.size() <= id) sent.resize(id + 1);
+    sent[id] = true;
+    return true;
+}
+
+char* CLoggerServer::BeginDeferred(CLogRing*& ring, CLogSite& site, const char* func, size_t size) {
+    ring = LogRing();
+    if (ring == NULL || !LogRegisterSite(ring, site, func)) return NULL;
+
+    char* p = ring->Reserve(LOG_BINARY_HEADER + size);
+    if (p == NULL) return NULL;
+    uint32_t id = site.Id();
+    uint64_t tsc = CLogTsc::Now();
+    memcpy(p, &id, 4);
+    memcpy(p + 4, &tsc, 8);
+    return p + LOG_BINARY_HEADER;
+}
+
+void CLoggerServer::TraceDeferredText(CLogRing* ring, CLogSite& site, const char* func,
+    const char* args, size_t size) {
+    if (ring != NULL && LogRingFull(ring, site.level)) return;
+
+    CLocalSocket* client = LogClient();
+    if (client == NULL) return;
+
+    // 本线程格式化（和日志线程的输出一样）
+    LogSiteInfo info = { site.file, site.line, func, site.kind, site.fmt };
+    std::string line;
+    if (CLogFormatter::FormatLine(info, site.level, CClock::Now(), getpid(),
+        (pid_t)syscall(SYS_gettid), args, size, line) != 0) return;
+
+    int ret = client->Send(Buffer(line));
+    (void)ret;
+}
+
+void CLoggerServer::TraceEncoded(CLogSite& site, const char* func, const char* args, size_t size) {
+    CLogRing* ring = NULL;
+    char* p = BeginDeferred(ring, site, func, size);
+    if (p == NULL) {
+        TraceDeferredText(ring, site, func, args, size);
+        return;
+    }
+    memcpy(p, args, size);
+    ring->Commit(site.level, LOG_RECORD_BINARY, LOG_BINARY_HEADER + size);
+}
+
+void CLoggerServer::TraceDump(CLogSite& site, const char* func, const void* data, size_t size) {
+    size_t blob = CLogArgs::BlobSize(size);
+    CLogRing* ring = NULL;
+    char* p = BeginDeferred(ring, site, func, blob);
+    if (p == NULL) {
+        std::string buf(blob, '\0');
+        CLogArgs::PutBlob(&buf[0], data, size);
+        TraceDeferredText(ring, site, func, buf.data(), blob);
+        return;
+    }
+    CLogArgs::PutBlob(p, data, size);
+    ring->Commit(site.level, LOG_RECORD_BINARY, LOG_BINARY_HEADER + blob);
+}
+
+// ==================== 飞行记录器 ====================
+char* CLoggerServer::BeginRecord(CLogFlight*& flight, CLogSite& site, const char* func, size_t size) {
+    // 第一次（还没有记录器）走LogRing()创建；格式点登记走共享内存环，环满了这条就不记
+    CLogRing* ring = LogRing();
+    flight = t_flight;
+    if (ring == NULL || flight == NULL || !LogRegisterSite(ring, site, func)) return NULL;
+
+    char* p = flight->Reserve(LOG_BINARY_HEADER + size);
+    if (p == NULL) return NULL;
+    uint32_t id = site.Id();
+    uint64_t tick = flight->Tick();   // 日志服务器每轮写的粗粒度TSC（不读TSC）
+    memcpy(p, &id, 4);
+    memcpy(p + 4, &tick, 8);
+    return p + LOG_BINARY_HEADER;
+}
+
+void CLoggerServer::RecordEncoded(CLogSite& site, const char* func, const char* args, size_t size) {
+    CLogFlight* flight = NULL;
+    char* p = BeginRecord(flight, site, func, size);
+    if (p == NULL) return;
+    memcpy(p, args, size);
+    flight->Commit(site.level, LOG_RECORD_BINARY, LOG_BINARY_HEADER + size);
+}
+
+void CLoggerServer::RecordDump(CLogSite& site, const char* func, const void* data, size_t size) {
+    size_t blob = CLogArgs::BlobSize(size);
+    CLogFlight* flight = NULL;
+    char* p = BeginRecord(flight, site, func, blob);
+    if (p == NULL) return;
+    CLogArgs::PutBlob(p, data, size);
+    flight->Commit(site.level, LOG_RECORD_BINARY, LOG_BINARY_HEADER + blob);
+}
+
+// 崩溃信号：标记后恢复默认处理再发一次（SA_RESETHAND已经恢复了，SA_NODEFER让它立即生效）
+static void FlightCrashHandler(int signo) {
+    CLogFlight::Signal(signo);
+    raise(signo);
+}
+
+static void FlightUserHandler(int signo) {
+    CLogFlight::Signal(signo);
+}
+
+void CLoggerServer::InstallFlightSignals() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_handler = FlightCrashHandler;
+    action.sa_flags = SA_RESETHAND | SA_NODEFER;
+    int crash[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+    for (size_t i = 0; i < sizeof(crash) / sizeof(crash[0]); i++) sigaction(crash[i], &action, NULL);
+
+    action.sa_handler = FlightUserHandler;
+    action.sa_flags = SA_RESTART;
+    sigaction(LOG_FLIGHT_SIGNAL, &action, NULL);
+}
+
+int CLoggerServer::FlightDump(pid_t pid) {
+    char command[32];
+    snprintf(command, sizeof(command), "dump %d", (int)pid);
+    std::string reply;
+    return CLogFilter::Control(command, reply);
+}
+
+void CLoggerServer::RequestFlight(pid_t pid, const char* reason) {
+    if (m_flightPid == -1) {
+        m_flightPid = pid;
+        m_flightReason = reason;
+    }
+    else if (m_flightPid != pid) {
+        m_flightPid = 0;
+        m_flightReason += std::string(", ") + reason;
+    }
+}
+
+int CLoggerServer::DumpFlight(std::map<int, CLogPeer>& peers, pid_t pid, const char* reason) {
+    // 第1步：先读完这些线程的环（格式点登记），再取出记录器里新的记录
+    struct Entry {
+        uint64_t tsc;
+        CLogPeer* peer;
+        const char* data;   // 记录（LogRecord头部）在拷贝里的位置
+        size_t index;       // 同一个时间按线程里的顺序
+    };
+    std::vector<Entry> entries;
+    std::vector<std::string> bufs(peers.size());
+    std::vector<size_t> offsets;
+    size_t n = 0;
+    for (auto it = peers.begin(); it != peers.end(); it++, n++) {
+        CLogPeer& peer = it->second;
+        if (!peer.flight.IsValid() || (pid != 0 && peer.flight.Pid() != pid)) continue;
+        WriteLog(peer);
+        uint64_t head = peer.flight.Head();
+        peer.flight.Snapshot(bufs[n], offsets, peer.dumped);
+        peer.dumped = head;
+        for (size_t i = 0; i < offsets.size(); i++) {
+            const char* p = bufs[n].data() + offsets[i];
+            LogRecord record;
+            memcpy(&record, p, sizeof(record));
+            if (record.type != LOG_RECORD_BINARY || record.size < LOG_BINARY_HEADER) continue;
+            Entry entry = { 0, &peer, p, entries.size() };
+            memcpy(&entry.tsc, p + sizeof(LogRecord) + 4, 8);
+            entries.push_back(entry);
+        }
+    }
+    if (entries.empty()) return 0;
+
+    // 第2步：所有线程按时间合并（粗粒度的TSC，同一台机器上可以直接比较；同一线程里时间不会倒退）
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.tsc != b.tsc ? a.tsc < b.tsc : a.index < b.index;
+    });
+
+    // 第3步：格式化，写进单独的文件
+    std::string path = "./log/flight-" + std::string((char*)GetTimeStr()) + ".log";
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) return -1;
+    std::string out;
+    char line[256];
+    snprintf(line, sizeof(line), "==== 飞行记录：%s，%zu条 ====\n", reason, entries.size());
+    out += line;
+    for (size_t i = 0; i < entries.size(); i++) {
+        CLogPeer& peer = *entries[i].peer;
+        const char* p = entries[i].data;
+        LogRecord record;
+        memcpy(&record, p, sizeof(record));
+        peer.formatter.Format(LOG_RECORD_BINARY, record.level, p + sizeof(LogRecord), record.size,
+            peer.flight.Pid(), peer.flight.Tid(), m_clock, out);
+        if (out.size() >= 64 * 1024) {
+            if (write(fd, out.data(), out.size()) < 0) break;
+            out.clear();
+        }
+    }
+    out += "==== 结束 ====\n";
+    if (write(fd, out.data(), out.size()) < 0) {}
+    close(fd);
+
+    // 第4步：日志文件里留一行，指向飞行记录的文件
+    char note[512];
+    char time[CLOCK_TIME_STR_SIZE];
+    CClock::Format(time);
+    int len = snprintf(note, sizeof(note), "[%s] 飞行记录（%s）%zu条 → %s\n", time, reason, entries.size(), path.c_str());
+    if (len > 0 && len < (int)sizeof(note)) {
+        if (m_binary.IsOpen()) m_binary.Text(LOG_WARNING, 0, 0, CLogTsc::RealtimeNs(), note, (size_t)len);
+        else if (m_writer.IsOpen()) m_writer.Append(note, (size_t)len, LOG_WARNING);
+    }
+    return (int)entries.size();
 }
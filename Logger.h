@@ -11,6 +11,24 @@
 #include <sys/types.h>   // pid_t
 #include <unistd.h>      // getpid()
 #include <pthread.h>     // pthread_t, pthread_self()
+#include "RingBuffer.h"  // 每个客户端连接的接收缓冲区
+#include "LogRing.h"     // 每个写日志线程的共享内存环
+#include "LogFormat.h"   // 延迟格式化：格式点、参数编码、日志线程的格式化器
+#include "Clock.h"       // 按分钟缓存的时间字符串
+#include "LogWriter.h"   // 日志文件的批量写
+#include "LogFilter.h"   // 按模块的运行时级别（共享内存里的原子变量）
+#include "LogLine.h"     // LogInfo的格式化缓冲（内联，不分配）
+#include "LogHex.h"      // DUMP*的十六进制（SIMD）
+#include "LogBinary.h"   // 结构化的二进制日志文件（可选）
+#include "LogFlight.h"   // 每个线程的飞行记录器（没打开的级别，出事时dump）
+#include <map>
+
+// 每个日志客户端连接的接收环形缓冲区大小
+// 只在连接建立时分配一次，收到的数据按整行写盘
+#define LOG_RING_SIZE (256 * 1024)
+// 客户端交出共享内存环时随fd一起发送的握手数据（服务器收到后丢弃，不写进日志）
+#define LOG_RING_HELLO "\x01LOGRING\n"
+#define LOG_RING_HELLO_SIZE 9
 // ============================================
 // LogInfo类 - 日志信息封装（阶段5实现）
 // ============================================
@@ -21,6 +39,26 @@ enum LogLevel {
     LOG_ERROR,     // 3
     LOG_FATAL      // 4
 };
+
+// 编译期最低级别：低于它的TRACE*/LOG*/DUMP*调用点整个被删掉（按严重度比较，DEBUG最低）
+// 比如发布版本编译时 -DLOG_MIN_LEVEL=LOG_INFO，所有DEBUG日志不进二进制
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_DEBUG
+#endif
+// 这个文件的日志属于哪个模块（#include之前定义，默认0号模块）
+#ifndef LOG_MODULE
+#define LOG_MODULE 0
+#endif
+// 运行期级别没打开的TRACE*/DUMP*/延迟格式化调用点可以写进飞行记录器（见LogFlight.h）
+// 默认不编译进来：打开后TRACE*的格式串必须是字符串字面量（调用点登记成静态CLogSite），
+// TRACEI(msg)这种运行期字符串编译不过，所以由需要的文件自己在 #include 之前 #define LOG_FLIGHT 1
+// 编译进来了也要按模块打开（控制命令 "flight <模块> <级别>"，默认都不记录）：
+// 没打开飞行记录的模块多一次原子读，参数照样不求值
+#ifndef LOG_FLIGHT
+#define LOG_FLIGHT 0
+#endif
+// 让日志服务器dump本进程飞行记录器的信号（InstallFlightSignals）
+#define LOG_FLIGHT_SIGNAL (SIGRTMIN + 2)
 // ==================== 2. LogInfo类声明 ====================
 class LogInfo {
 public:
@@ -47,34 +85,53 @@ public:
     // 析构函数（流式输出风格会在这里自动发送日志）
     ~LogInfo();
 
-    // 类型转换运算符：让LogInfo能转换为Buffer（给Trace()用）
-    operator Buffer() const {
-        return m_buf;
-    }
+    // 格式化好的一行（给Trace()用）：发送时直接用内联缓冲，不拷贝
+    const char* Data() const { return m_line.Data(); }
+    size_t Size() const { return m_line.Size(); }
+
+    int Level() const { return m_level; }
 
     // 流式输出运算符：支持 << 操作（链式调用）
+    // 内置类型直接转换写进缓冲，其他类型走它自己的operator<<（见LogLine.h）
     template<typename T>
     LogInfo& operator<<(const T& data) {
-        std::stringstream stream;
-        stream << data;           // 转换为字符串
-        m_buf += stream.str();    // 追加到缓冲区
+        m_line << data;
         return *this;             // 返回自己（支持链式调用）
     }
 
 private:
     bool bAuto;    // 标志位：false=手动发送（printf/dump）,
     //true = 析构时自动发送（流式输出）
-      Buffer m_buf;  // 日志内容缓冲区
+    CLogLine m_line;   // 日志内容缓冲区（内联，超长才用堆）
+    int m_level;   // LogLevel（随记录一起进共享内存环）
 };
 
 
 
+// 日志文件的格式（CLoggerServer::SetFileFormat）
+enum LogFileFormat {
+    LOG_FILE_TEXT = 0,     // 文本（.log），每条一行
+    LOG_FILE_BINARY = 1,   // 结构化二进制（.blog），用tools/LogDecoder还原成文本，见LogBinary.h
+};
+
+// 交出了共享内存环的客户端：环 + 它登记过的格式点（延迟格式化用）
+struct CLogPeer
+{
+    CLogRing ring;
+    CLogFormatter formatter;
+    std::vector<uint32_t> strings;   // 二进制格式：格式点ID*3 → 文件/函数/格式串在字符串表里的ID（UINT32_MAX = 还没查）
+    CLogFlight flight;               // 这个线程的飞行记录器（没交过来就是无效的）
+    uint64_t dumped = 0;             // 飞行记录器里这个位置之前的已经dump过
+};
+
 // ============================================
 // CLoggerServer类 - 异步日志服务器
 //
 // 设计模式：多生产者-单消费者（MPSC）
-// 通信方式：Unix Domain Socket
-// 并发模型：epoll事件驱动 + 单线程处理
+// 通信方式：每个写日志的线程一个共享内存环（CLogRing，无系统调用）；
+//          Unix Domain Socket只用来交付环的fd、感知线程/进程退出，
+//          以及环不可用（或ERROR/FATAL时环满了）的兜底
+// 并发模型：epoll事件驱动 + 单线程处理（每轮循环把所有环读完）
 // ============================================
 class CLoggerServer
 {
@@ -92,6 +149,9 @@ public:
         // 延迟初始化：构造时不创建Socket
         // 原因：Socket需要文件系统路径，目录可能还不存在
         m_server = NULL;
+        m_control = NULL;
+        m_format = LOG_FILE_TEXT;
+        m_flightPid = -1;
 
         // 动态生成日志文件名：包含时间戳
         // 格式：./log/2025-01-15 14-30-25 123.log
@@ -121,7 +181,7 @@ public:
     // 为什么禁止？
     // 1. m_thread是线程对象，不应该被拷贝（会创建多个线程）
     // 2. m_server是指针，浅拷贝会导致多次delete
-    // 3. m_file是文件句柄，拷贝会导致多次fclose
+    // 3. m_writer持有文件描述符，拷贝会导致多次close
     //
     // C++11方式：= delete（编译期禁止）
     CLoggerServer(const CLoggerServer&) = delete;
@@ -149,6 +209,30 @@ public:
     // 4. 关闭文件
     int Close();
 
+    // 刷盘策略（Start之前设置）：攒够bytes字节、或最早的数据等了ms毫秒才写文件，
+    // ERROR/FATAL所在的那一轮立即写；sync=true每次写出后fdatasync
+    // 默认：64KB / 50ms / 不fdatasync
+    void SetFlushPolicy(size_t bytes, unsigned ms, bool sync) {
+        m_writer.SetPolicy(bytes, ms, sync, LOG_ERROR);
+    }
+
+    // 轮转策略（Start之前设置）：单个文件超过maxBytes、或跨过按本地时间对齐的interval秒边界
+    // （3600 = 每个整点、86400 = 每天零点）就换新文件；旧文件在后台低优先级线程里gzip，
+    // 只保留最近keep个（0不限）。默认：256MB轮转、gzip、不按时间、不删除
+    void SetRotation(size_t maxBytes, unsigned interval, unsigned keep, bool compress) {
+        m_writer.SetRotation("./log", maxBytes, interval, keep, compress);
+    }
+
+    // 文件格式（Start之前设置）：LOG_FILE_TEXT（默认）或LOG_FILE_BINARY
+    // 二进制格式：延迟格式化的记录不在日志线程里格式化，格式点和参数原样写进块里，
+    // 文件名换成.blog；轮转、压缩、保留和文本格式一样
+    void SetFileFormat(int format) {
+        m_format = format == LOG_FILE_BINARY ? LOG_FILE_BINARY : LOG_FILE_TEXT;
+        std::string path = (char*)m_path;
+        path = path.substr(0, path.rfind('.')) + (m_format == LOG_FILE_BINARY ? ".blog" : ".log");
+        m_path = Buffer(path);
+    }
+
     // 静态接口：业务线程调用此方法记录日志
     // 特点：
     // 1. static：可以直接类名调用，无需对象
@@ -156,36 +240,62 @@ public:
     // 3. 异步：发送后立即返回，不等待I/O
     static void Trace(const LogInfo& info);
 
+    // 切片链版本：已经组好的日志行（比如在包数据前面Prepend了日志头）
+    // 一次writev发出，不拼接、不拷贝
+    static void Trace(const CIOBuf& data);
+
+    // 延迟格式化（LOG_TRACE_DEFERRED / 定义了LOG_DEFERRED时的TRACE*）：
+    // 调用方只写 格式点ID + TSC + 参数的字节，格式化、取时间都在日志线程做
+    // 环不可用时在本线程格式化成文本，走socket（和Trace一样的兜底）
+    template<typename... ARGS>
+    static void TraceDeferred(CLogSite& site, const char* func, const ARGS&... args);
+
+    // 参数已经编码好（CLogStream）
+    static void TraceEncoded(CLogSite& site, const char* func, const char* args, size_t size);
+
+    // 二进制块（LOG_DUMP_DEFERRED）：只拷贝数据，十六进制在日志线程里生成
+    static void TraceDump(CLogSite& site, const char* func, const void* data, size_t size);
+
+    // 飞行记录器（宏里运行期级别没打开的分支，见LogFlight.h）：和TraceDeferred一样编码，
+    // 写进本线程的飞行记录器，不进日志文件；没有记录器（日志服务器没起来）就丢掉
+    template<typename... ARGS>
+    static void Record(CLogSite& site, const char* func, const ARGS&... args);
+    static void RecordEncoded(CLogSite& site, const char* func, const char* args, size_t size);
+    static void RecordDump(CLogSite& site, const char* func, const void* data, size_t size);
+
+    // 本进程收到信号时让日志服务器dump飞行记录器：
+    // SIGSEGV/SIGBUS/SIGFPE/SIGILL/SIGABRT标记后按默认处理（进程照样崩溃，记录器在日志服务器那里），
+    // LOG_FLIGHT_SIGNAL只标记（kill -s <SIGRTMIN+2> <pid> 随时dump）。会覆盖这些信号原来的处理函数
+    // 不用SIGUSR2：CThread::Stop用它强制结束线程（Thread.h）
+    static void InstallFlightSignals();
+
+    // 让日志服务器dump飞行记录器（pid=0：所有进程），通过控制socket
+    // 返回值：0成功，<0同CLogFilter::Control
+    static int FlightDump(pid_t pid);
+
     // 工具函数：生成时间字符串
     // 格式：2025-01-15 14-30-25 123
     // 用途：
     // 1. 生成日志文件名
-    // 2. 日志内容的时间戳
+    // 2. 日志内容的时间戳（LogInfo直接用CClock::Format写到栈上，不分配）
+    // 实现：CClock按分钟缓存日期部分，每次只改写秒和毫秒（不再每次localtime_r）
     static Buffer GetTimeStr() {
-        Buffer result(128);                    // [1] 预分配缓冲区
-        timeb tmb;                             // [2] 定义时间结构体
-        ftime(&tmb);                           // [3] 获取当前时间
-        // ✅ 线程安全版本
-        tm local_tm;  // 栈上分配，线程独立
-        localtime_r(&tmb.time, &local_tm);  // POSIX版本
-        int nSize = snprintf(result, result.size(),
-            "%04d-%02d-%02d %02d-%02d-%02d %03d",
-            local_tm.tm_year + 1900,  // ✅ 读取栈上的数据
-            local_tm.tm_mon + 1,
-            local_tm.tm_mday,
-            local_tm.tm_hour,
-            local_tm.tm_min,
-            local_tm.tm_sec,
-            tmb.millitm
-        );
-        //int result = snprintf(buffer, sizeof(buffer), "Hello %s, age=%d", "张三", 25);
-        ////                     ↑        ↑              ↑                   ↑      ↑
-        ////                   目标缓冲   缓冲区大小    格式化字符串        参数1  参数2
-        result.resize(nSize);                  // [6] 调整实际大小
-        return result;                         // [7] 返回
+        char time[CLOCK_TIME_STR_SIZE];
+        return Buffer(std::string(time, CClock::Format(time)));
     }
 
 private:
+    // 延迟格式化：在本线程的环里取一条BINARY记录的空间，写好头部（格式点必要时先登记）
+    // 返回值：参数区的指针；没有环（ring置为NULL）或环满了返回NULL
+    static char* BeginDeferred(CLogRing*& ring, CLogSite& site, const char* func, size_t size);
+
+    // 延迟格式化的兜底：环满了按Trace的规则计数丢弃，否则本线程格式化成文本走socket
+    static void TraceDeferredText(CLogRing* ring, CLogSite& site, const char* func, const char* args, size_t size);
+
+    // 飞行记录器：取一条记录的空间，写好头部（格式点登记走共享内存环）
+    // 返回值：参数区的指针；没有记录器返回NULL
+    static char* BeginRecord(CLogFlight*& flight, CLogSite& site, const char* func, size_t size);
+
     // ========================================
     // 线程函数（下次实现详细逻辑）
     // ========================================
@@ -195,10 +305,37 @@ private:
     // 3. 写入磁盘文件
     int ThreadFunc();
 
-    // 写日志到文件
+    // 写日志到文件（立即写出）
     // 注意：只在日志线程中调用，串行执行，无需加锁
     void WriteLog(const Buffer& data);
 
+    // 从接收环中取出完整的行放进批缓冲（不完整的行留在环里等下次）
+    // socket上来的都是兜底的数据（可能是环满时的ERROR/FATAL），这一轮就写出
+    // bAll=true：全部写出（连接断开或环已满时）
+    void WriteLog(CRingBuffer& ring, bool bAll = false);
+
+    // 读完一个共享内存环里已发布的记录（只放进批缓冲，由调用者按策略统一写出）
+    // 文本记录直接写；延迟格式化的记录用这个客户端的格式化器还原成文本
+    // 返回值：写出的记录数
+    int WriteLog(CLogPeer& peer);
+
+    // 二进制格式：环里的一条记录写进当前块（延迟格式化的记录不格式化）
+    void WriteBinary(CLogPeer& peer, const LogRecord& record, const char* data);
+
+    // 控制连接上收到数据：按行执行命令（CLogFilter::Command），每行回复一行
+    // pending是还没收到换行的半行
+    // 返回值：>0继续，<=0连接断开（调用者释放）
+    int Control(CSocketBase* client, std::string& pending);
+
+    // 记下要dump的进程（这一轮的环都读完之后才做：格式点登记要先处理）
+    // 同一轮里要求了不同的进程就全部dump
+    void RequestFlight(pid_t pid, const char* reason);
+
+    // 把这个进程（pid=0：所有进程）的飞行记录器按时间合并，还原成文本写进./log/flight-时间.log
+    // 只写上次dump之后的记录；先读完这些线程的共享内存环（格式点登记在里面）
+    // 返回值：写出的记录数，0没有新记录，-1文件打开失败
+    int DumpFlight(std::map<int, CLogPeer>& peers, pid_t pid, const char* reason);
+
 private:
     // ========================================
     // 成员变量
@@ -221,16 +358,124 @@ private:
     // - Start()时才创建，Close()时delete
     CSocketBase* m_server;
 
+    // 控制Socket：运行时改日志级别（见LogFilter.h）
+    // 和m_server一样Start()时创建；创建失败不影响写日志
+    CSocketBase* m_control;
+
     // 日志文件路径
     // 类型：Buffer（自动管理内存的字符串类）
     Buffer m_path;
 
-    // 文件句柄
-    // 为什么用FILE*而不是ofstream？
-    // 1. 性能更好（减少C++流的封装开销）
-    // 2. 精确控制：可用fflush()强制刷盘
-    // 3. 简单直接：fwrite比流操作快
-    FILE* m_file;
+    // 日志文件
+    // 为什么不用FILE*？
+    // 1. 一轮循环读到的所有记录攒成一批，一次writev写出（group commit）
+    // 2. 什么时候写、要不要fdatasync完全由刷盘策略决定
+    CLogWriter m_writer;
+
+    // 延迟格式化记录的TSC → 墙上时间（日志线程每轮校准）
+    CLogTsc m_clock;
+
+    // 延迟格式化记录的格式化结果（日志线程复用，不每行分配）
+    std::string m_line;
+
+    // 文件格式（LogFileFormat）；二进制格式时记录先攒成块，整块交给m_writer
+    int m_format;
+    CLogBinaryWriter m_binary;
+
+    // 这一轮结束时要dump飞行记录器的进程（-1没有，0所有进程）和原因
+    pid_t m_flightPid;
+    std::string m_flightReason;
+};
+
+template<typename... ARGS>
+inline void CLoggerServer::TraceDeferred(CLogSite& site, const char* func, const ARGS&... args)
+{
+    // 第1步：直接编码进环里（参数只拷贝，不格式化）
+    size_t size = CLogArgs::Size(args...);
+    CLogRing* ring = NULL;
+    char* p = BeginDeferred(ring, site, func, size);
+    if (p != NULL) {
+        CLogArgs::Put(p, args...);
+        ring->Commit(site.level, LOG_RECORD_BINARY, LOG_BINARY_HEADER + size);
+        return;
+    }
+
+    // 第2步：兜底（少见）：编码到临时缓冲
+    std::string buf(size, '\0');
+    CLogArgs::Put(&buf[0], args...);
+    TraceDeferredText(ring, site, func, buf.data(), size);
+}
+
+template<typename... ARGS>
+inline void CLoggerServer::Record(CLogSite& site, const char* func, const ARGS&... args)
+{
+    // 直接编码进飞行记录器（覆盖写，不会满）
+    size_t size = CLogArgs::Size(args...);
+    CLogFlight* flight = NULL;
+    char* p = BeginRecord(flight, site, func, size);
+    if (p == NULL) return;
+    CLogArgs::Put(p, args...);
+    flight->Commit(site.level, LOG_RECORD_BINARY, LOG_BINARY_HEADER + size);
+}
+
+// ============================================
+// CLogStream类：延迟格式化的流式输出（LOG_STREAM_DEFERRED）
+// 每个 << 只把值编码进内联缓冲（不用stringstream），析构时整条交给TraceEncoded
+// （flight=true：级别没打开，交给RecordEncoded写进飞行记录器）
+// 内置类型和字符串直接编码；业务类型用它自己的operator<<转成字符串
+// ============================================
+#define LOG_STREAM_INLINE 256
+
+class CLogStream
+{
+public:
+    CLogStream(CLogSite& site, const char* func, bool flight = false)
+        : m_site(site), m_func(func), m_size(0), m_spill(false), m_flight(flight) {}
+    ~CLogStream() {
+        if (m_flight) CLoggerServer::RecordEncoded(m_site, m_func, m_spill ? m_heap.data() : m_inline, m_size);
+        else CLoggerServer::TraceEncoded(m_site, m_func, m_spill ? m_heap.data() : m_inline, m_size);
+    }
+    CLogStream(const CLogStream&) = delete;
+    CLogStream& operator=(const CLogStream&) = delete;
+
+    template<typename T>
+    CLogStream& operator<<(const T& value) {
+        Append(value, std::integral_constant<bool, CLogArgs::Native<T>::value>());
+        return *this;
+    }
+
+private:
+    template<typename T>
+    void Append(const T& value, std::true_type) {
+        size_t n = CLogArgs::One(value);
+        CLogArgs::PutOne(Reserve(n), value);
+        m_size += n;
+    }
+    template<typename T>
+    void Append(const T& value, std::false_type) {
+        std::stringstream stream;
+        stream << value;
+        Append(stream.str(), std::true_type());
+    }
+
+    char* Reserve(size_t n) {
+        if (!m_spill && m_size + n <= LOG_STREAM_INLINE) return m_inline + m_size;
+        if (!m_spill) {
+            m_heap.assign(m_inline, m_size);
+            m_spill = true;
+        }
+        m_heap.resize(m_size + n);
+        return &m_heap[m_size];
+    }
+
+private:
+    CLogSite& m_site;
+    const char* m_func;
+    size_t m_size;
+    bool m_spill;                       // 超过内联缓冲，改用m_heap
+    bool m_flight;                      // 写进飞行记录器
+    char m_inline[LOG_STREAM_INLINE];
+    std::string m_heap;
 };
 
 // ============================================
@@ -251,13 +496,18 @@ inline int CLoggerServer::Close() {
         // ⭐ 安全删除技巧：先保存指针，再置空，最后delete
         CSocketBase* p = m_server;  // 保存指针
         m_server = NULL;            // 立即置空（防止重复释放）
-        delete p;                   // 删除对象
+        CSocketBase::Free(p);       // 删除对象（不是slab分配的，Free里delete）
 
         // 为什么这样写？
         // 如果直接 delete m_server; m_server = NULL;
         // 在多线程环境下，delete和赋值之间可能被打断
         // 导致m_server指向已释放的内存（野指针）
     }
+    if (m_control != NULL) {
+        CSocketBase* p = m_control;
+        m_control = NULL;
+        CSocketBase::Free(p);
+    }
 
     // ========================================
     // 步骤2：关闭epoll
@@ -282,10 +532,7 @@ inline int CLoggerServer::Close() {
     // 为什么最后关闭？
     // - 线程已停止，不会再有写入操作
     // - 安全关闭文件，避免数据丢失
-    if (m_file != NULL) {
-        fclose(m_file);   // 关闭文件（自动fflush）
-        m_file = NULL;    // 置空，防止重复关闭
-    }
+    m_writer.Close();   // 写出批缓冲里剩下的数据，关闭文件（重复调用没关系）
 
     return 0;
 }
@@ -294,6 +541,10 @@ inline int CLoggerServer::Close() {
 inline int CLoggerServer::ThreadFunc() {
     EPEvents events;
     std::map<int, CSocketBase*> mapClients;
+    std::map<int, CRingBuffer> mapInput;  // 每个客户端一个接收环（fd → ring）
+    std::map<int, CLogPeer> mapRings;     // 交出了共享内存环的客户端（fd → 映射）
+    std::map<int, std::string> mapControl; // 控制连接（fd → 没收完的半行命令）
+    m_clock.Calibrate();
 
     // 主事件循环：三重保险退出条件
     while (m_thread.isValid() && (m_epoll != -1) && (m_server != NULL)) {
@@ -311,44 +562,114 @@ inline int CLoggerServer::ThreadFunc() {
                 // 处理可读事件
                 else if (events[i].events & EPOLLIN) {
                     // 判断：新连接 vs 数据到达
-                    if (events[i].data.ptr == m_server) {
+                    if (m_control != NULL && events[i].data.ptr == m_control) {
+                        // ========== 控制连接 ==========
+                        CSocketBase* pClient = NULL;
+                        if (m_control->Link(&pClient) < 0) continue;
+                        int fd = (int)(*pClient);
+                        if (m_epoll.Add(*pClient, EpollData(pClient->Handle()), EPOLLIN | EPOLLERR) < 0) {
+                            CSocketBase::Free(pClient);
+                            continue;
+                        }
+                        auto it = mapClients.find(fd);
+                        if (it != mapClients.end()) CSocketBase::Free(it->second);
+                        mapClients[fd] = pClient;
+                        mapInput.erase(fd);
+                        mapControl[fd].clear();
+                    }
+                    else if (events[i].data.ptr == m_server) {
                         // ========== 新连接 ==========
                         CSocketBase* pClient = NULL;
                         int r = m_server->Link(&pClient);
                         if (r < 0) continue;
 
-                        // 添加到epoll（存储pClient指针到data.ptr）
-                        r = m_epoll.Add(*pClient, EpollData((void*)pClient),
+                        // 分配接收环（只在建立连接时分配一次）
+                        int fd = (int)(*pClient);  // ✅ 修复：显式转换
+                        mapInput.erase(fd);
+                        mapControl.erase(fd);
+                        if (mapInput[fd].Create(LOG_RING_SIZE) != 0) {
+                            mapInput.erase(fd);
+                            CSocketBase::Free(pClient);
+                            continue;
+                        }
+
+                        // 添加到epoll（存储pClient的句柄到data.u64，旧事件可识别）
+                        r = m_epoll.Add(*pClient, EpollData(pClient->Handle()),
                             EPOLLIN | EPOLLERR);
                         if (r < 0) {
-                            delete pClient;
+                            mapInput.erase(fd);
+                            CSocketBase::Free(pClient);
                             continue;
                         }
 
                         // 存入客户端容器（检查fd复用）
-                        int fd = (int)(*pClient);  // ✅ 修复：显式转换
                         auto it = mapClients.find(fd);
-                        if (it != mapClients.end() && it->second != NULL) {
-                            delete it->second;  // 删除旧客户端
+                        if (it != mapClients.end()) {
+                            CSocketBase::Free(it->second);  // 删除旧客户端
                         }
                         mapClients[fd] = pClient;
                     }
                     else {
                         // ========== 数据到达 ==========
-                        CSocketBase* pClient = (CSocketBase*)events[i].data.ptr;
+                        // 句柄失效（连接已释放）返回NULL，忽略旧事件
+                        CSocketBase* pClient = CSocketBase::FromHandle(events[i].data.u64);
                         if (pClient != NULL) {
-                            Buffer data(1024 * 1024);  // 1MB缓冲区
-                            int r = pClient->Recv(data);
+                            int fd = (int)(*pClient);  // ✅ 修复：显式转换
+                            auto itControl = mapControl.find(fd);
+                            if (itControl != mapControl.end()) {
+                                if (Control(pClient, itControl->second) <= 0) {
+                                    mapControl.erase(itControl);
+                                    CSocketBase::Free(pClient);
+                                    mapClients.erase(fd);
+                                }
+                                continue;
+                            }
+                            CRingBuffer& ring = mapInput[fd];
+                            int passed = -1;
+                            int r = ((CLocalSocket*)pClient)->Recv(ring, passed);  // 读进环里，顺带取出fd
+
+                            if (passed != -1 && ring.Size() >= LOG_FLIGHT_HELLO_SIZE &&
+                                memcmp(ring.Peek(), LOG_FLIGHT_HELLO, LOG_FLIGHT_HELLO_SIZE) == 0) {
+                                // 紧跟在共享内存环后面交来的飞行记录器
+                                ring.Consume(LOG_FLIGHT_HELLO_SIZE);
+                                auto itRing = mapRings.find(fd);
+                                if (itRing != mapRings.end() && !itRing->second.flight.IsValid()) {
+                                    itRing->second.flight.Attach(passed);
+                                }
+                                close(passed);
+                            }
+                            else if (passed != -1) {
+                                // 客户端交来共享内存环：去掉握手数据，映射
+                                if (ring.Size() >= LOG_RING_HELLO_SIZE &&
+                                    memcmp(ring.Peek(), LOG_RING_HELLO, LOG_RING_HELLO_SIZE) == 0) {
+                                    ring.Consume(LOG_RING_HELLO_SIZE);
+                                }
+                                mapRings.erase(fd);
+                                if (mapRings[fd].ring.Attach(passed) != 0) mapRings.erase(fd);
+                                close(passed);
+                            }
 
                             if (r <= 0) {
-                                // 连接断开
-                                int fd = (int)(*pClient);  // ✅ 修复：显式转换
-                                delete pClient;
-                                mapClients[fd] = NULL;  //标记删除，避免遍历中erase
+                                // 连接断开：先把残留的半行和共享内存环里的记录写出去
+                                WriteLog(ring, true);
+                                mapInput.erase(fd);
+                                auto itRing = mapRings.find(fd);
+                                if (itRing != mapRings.end()) {
+                                    WriteLog(itRing->second);
+                                    // 进程崩溃（信号处理函数做了标记）：连接全断之前把这个进程的记录器都dump出来
+                                    int signo = itRing->second.flight.TakeSignal();
+                                    if (signo != 0) {
+                                        std::string reason = "信号" + std::to_string(signo);
+                                        DumpFlight(mapRings, itRing->second.flight.Pid(), reason.c_str());
+                                    }
+                                    mapRings.erase(itRing);
+                                }
+                                CSocketBase::Free(pClient);
+                                mapClients.erase(fd);  // 不是在遍历mapClients，可以直接删（只置空的话表只增不减）
                             }
                             else {
-                                // 写入日志
-                                WriteLog(data);
+                                // 写入日志（只写完整的行）
+                                WriteLog(ring);
                             }
                         }
                     }
@@ -360,61 +681,179 @@ inline int CLoggerServer::ThreadFunc() {
                 break;
             }
         }
+
+        // 每轮（包括超时）把所有共享内存环读完，按刷盘策略一次writev写出
+        m_clock.Calibrate();
+        uint64_t tick = CLogTsc::Now();
+        for (auto it = mapRings.begin(); it != mapRings.end(); it++) {
+            WriteLog(it->second);
+            it->second.flight.SetTick(tick);              // 飞行记录器的粗粒度时间（生产者不读TSC）
+            int signo = it->second.flight.TakeSignal();   // 进程收到了信号（LOG_FLIGHT_SIGNAL或者正在崩溃）
+            if (signo != 0) RequestFlight(it->second.flight.Pid(), ("信号" + std::to_string(signo)).c_str());
+        }
+        if (m_flightPid != -1) {
+            // FATAL、信号、dump命令：环都读完了（格式点登记过了）再dump
+            pid_t pid = m_flightPid;
+            std::string reason = m_flightReason;
+            m_flightPid = -1;
+            DumpFlight(mapRings, pid, reason.c_str());
+        }
+        m_binary.Poll();   // 二进制格式：块到时候了先交给writer
+        m_writer.Poll();
     }
 
-    // 退出清理：删除所有客户端
+    // 退出清理：写出残留数据，删除所有客户端
+    for (auto it = mapInput.begin(); it != mapInput.end(); it++) {
+        WriteLog(it->second, true);
+    }
+    mapInput.clear();
+    for (auto it = mapRings.begin(); it != mapRings.end(); it++) {
+        WriteLog(it->second);
+    }
+    mapRings.clear();
+    mapControl.clear();
+    m_binary.Flush();
+    m_writer.Flush();
     for (auto it = mapClients.begin(); it != mapClients.end(); it++) {
-        if (it->second) {
-            delete it->second;
-        }
+        CSocketBase::Free(it->second);
     }
     mapClients.clear();
 
     return 0;
 }
 // ==================== 3. 宏定义（用户接口）====================
+// 级别检查：编译期常量部分（LOG_MIN_LEVEL）不成立时整个表达式是常量false，调用点被删掉；
+// 否则是一次原子读 + 一次比较。检查在最前面：没通过时参数不求值、LogInfo不构造
+#define LOG_COMPILED(level) (LOG_SEVERITY(level) >= LOG_SEVERITY(LOG_MIN_LEVEL))
+#define LOG_ENABLED(level) (LOG_COMPILED(level) && CLogFilter::Enabled(LOG_MODULE, LOG_SEVERITY(level)))
+
+// 写成 "cond ? (void)0 : 日志表达式"（不用if/else：宏前面有if、后面有else都不会出错）
+// 函数调用的写法：LOG_IF(level) CLoggerServer::Trace(...)
+#define LOG_IF(level) !LOG_ENABLED(level) ? (void)0 : (void)
+
+// 流式的写法：LOG_STREAM_IF(level) LogInfo(...) << a << b
+// & 的优先级比 << 低、比 ?: 高：整串 << 都在 : 的右边，CLogVoidify再把结果变成void
+struct CLogVoidify
+{
+    template<typename T>
+    void operator&(const T&) {}
+};
+#define LOG_STREAM_IF(level) !LOG_ENABLED(level) ? (void)0 : CLogVoidify() &
+
+// 飞行记录器：编译进来了、运行期没打开的级别，这个模块打开了飞行记录才求值record
+// （只编码参数，写进本线程的记录器）
+// 写法：LOG_FLIGHT_IF(level, 记录的调用) 写日志的调用
+#if LOG_FLIGHT
+#define LOG_RECORDED(level) CLogFilter::Recorded(LOG_MODULE, LOG_SEVERITY(level))
+#define LOG_FLIGHT_IF(level, record) !LOG_COMPILED(level) ? (void)0 : \
+    !CLogFilter::Enabled(LOG_MODULE, LOG_SEVERITY(level)) ? (LOG_RECORDED(level) ? (void)(record) : (void)0) : (void)
+#define LOG_FLIGHT_PRINTF(level, fmt, ...) CLoggerServer::Record( \
+    LOG_SITE(level, LOG_SITE_PRINTF, fmt), __FUNCTION__, ##__VA_ARGS__)
+#define LOG_FLIGHT_DUMP(level, data, size) CLoggerServer::RecordDump( \
+    LOG_SITE(level, LOG_SITE_DUMP, ""), __FUNCTION__, data, size)
+#else
+#define LOG_FLIGHT_IF(level, record) LOG_IF(level)
+#endif
+
 #ifndef TRACE
 
 // -------- TRACE系列：printf风格 --------
 // 用法：TRACEI("User %d login", userId);
-#define TRACEI(...) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_INFO, __VA_ARGS__))
-#define TRACED(...) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_DEBUG, __VA_ARGS__))
-#define TRACEW(...) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_WARNING, __VA_ARGS__))
-#define TRACEE(...) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_ERROR, __VA_ARGS__))
-#define TRACEF(...) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_FATAL, __VA_ARGS__))
+// 定义了LOG_FLIGHT=1时，运行期没打开的级别可以写进飞行记录器：格式串要是字符串字面量，参数要是printf能用的类型
+#define TRACEI(...) LOG_FLIGHT_IF(LOG_INFO, LOG_FLIGHT_PRINTF(LOG_INFO, __VA_ARGS__)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_INFO, __VA_ARGS__))
+#define TRACED(...) LOG_FLIGHT_IF(LOG_DEBUG, LOG_FLIGHT_PRINTF(LOG_DEBUG, __VA_ARGS__)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_DEBUG, __VA_ARGS__))
+#define TRACEW(...) LOG_FLIGHT_IF(LOG_WARNING, LOG_FLIGHT_PRINTF(LOG_WARNING, __VA_ARGS__)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_WARNING, __VA_ARGS__))
+#define TRACEE(...) LOG_FLIGHT_IF(LOG_ERROR, LOG_FLIGHT_PRINTF(LOG_ERROR, __VA_ARGS__)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_ERROR, __VA_ARGS__))
+#define TRACEF(...) LOG_FLIGHT_IF(LOG_FATAL, LOG_FLIGHT_PRINTF(LOG_FATAL, __VA_ARGS__)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_FATAL, __VA_ARGS__))
 
     // -------- LOG系列：流式输出风格 --------
     // 用法：LOGI << "User " << userId << " login";
-#define LOGI LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
+#define LOGI LOG_STREAM_IF(LOG_INFO) LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
     LOG_INFO)
-#define LOGD LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
+#define LOGD LOG_STREAM_IF(LOG_DEBUG) LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
     LOG_DEBUG)
-#define LOGW LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
+#define LOGW LOG_STREAM_IF(LOG_WARNING) LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
     LOG_WARNING)
-#define LOGE LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
+#define LOGE LOG_STREAM_IF(LOG_ERROR) LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
     LOG_ERROR)
-#define LOGF LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
+#define LOGF LOG_STREAM_IF(LOG_FATAL) LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), \
     LOG_FATAL)
 
     // -------- DUMP系列：内存dump风格（已修复bug）--------
     // 用法：DUMPI(buffer, 256);
     // 输出：十六进制 + ASCII可视化
-#define DUMPI(data, size) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_INFO, data, size))
-#define DUMPD(data, size) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_DEBUG, data, size))
-#define DUMPW(data, size) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_WARNING, data, size))
-#define DUMPE(data, size) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_ERROR, data, size))
-#define DUMPF(data, size) CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, \
-    __FUNCTION__, getpid(), pthread_self(), LOG_FATAL, data, size))
+#define DUMPI(data, size) LOG_FLIGHT_IF(LOG_INFO, LOG_FLIGHT_DUMP(LOG_INFO, data, size)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_INFO, data, size))
+#define DUMPD(data, size) LOG_FLIGHT_IF(LOG_DEBUG, LOG_FLIGHT_DUMP(LOG_DEBUG, data, size)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_DEBUG, data, size))
+#define DUMPW(data, size) LOG_FLIGHT_IF(LOG_WARNING, LOG_FLIGHT_DUMP(LOG_WARNING, data, size)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_WARNING, data, size))
+#define DUMPE(data, size) LOG_FLIGHT_IF(LOG_ERROR, LOG_FLIGHT_DUMP(LOG_ERROR, data, size)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_ERROR, data, size))
+#define DUMPF(data, size) LOG_FLIGHT_IF(LOG_FATAL, LOG_FLIGHT_DUMP(LOG_FATAL, data, size)) \
+    CLoggerServer::Trace(LogInfo(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_FATAL, data, size))
 
 #endif
 
+// ==================== 4. 延迟格式化（调用方不格式化）====================
+// 每个调用点一个static CLogSite（常量初始化，没有线程安全检查的开销）
+// 注意：格式串必须是字符串字面量；tid输出的是内核线程ID（来自共享内存环）
+#define LOG_SITE(level, kind, fmt) ([]() -> CLogSite& { \
+    static CLogSite site(__FILE__, __LINE__, level, kind, fmt); return site; }())
+
+// 用法：LOG_TRACE_DEFERRED(LOG_INFO, "User %d login", userId);
+#define LOG_TRACE_DEFERRED(level, fmt, ...) LOG_FLIGHT_IF(level, LOG_FLIGHT_PRINTF(level, fmt, ##__VA_ARGS__)) \
+    CLoggerServer::TraceDeferred(LOG_SITE(level, LOG_SITE_PRINTF, fmt), __FUNCTION__, ##__VA_ARGS__)
+// 用法：LOG_STREAM_DEFERRED(LOG_INFO) << "User " << userId;
+// 飞行记录器：流式的 << 链只能接在一个对象后面，没打开时是同一个CLogStream换个去处
+#if LOG_FLIGHT
+#define LOG_STREAM_DEFERRED(level) !LOG_COMPILED(level) || \
+    (!CLogFilter::Enabled(LOG_MODULE, LOG_SEVERITY(level)) && !LOG_RECORDED(level)) ? (void)0 : CLogVoidify() & \
+    CLogStream(LOG_SITE(level, LOG_SITE_STREAM, ""), __FUNCTION__, !CLogFilter::Enabled(LOG_MODULE, LOG_SEVERITY(level)))
+#else
+#define LOG_STREAM_DEFERRED(level) LOG_STREAM_IF(level) CLogStream(LOG_SITE(level, LOG_SITE_STREAM, ""), __FUNCTION__)
+#endif
+// 用法：LOG_DUMP_DEFERRED(LOG_DEBUG, buffer, 256);
+#define LOG_DUMP_DEFERRED(level, data, size) LOG_FLIGHT_IF(level, LOG_FLIGHT_DUMP(level, data, size)) \
+    CLoggerServer::TraceDump(LOG_SITE(level, LOG_SITE_DUMP, ""), __FUNCTION__, data, size)
+
+// 编译时定义LOG_DEFERRED：TRACE*/LOG*/DUMP*全部改走延迟格式化（调用代码不用改）
+#if defined(LOG_DEFERRED) && !defined(TRACE)
+#undef TRACEI
+#undef TRACED
+#undef TRACEW
+#undef TRACEE
+#undef TRACEF
+#undef LOGI
+#undef LOGD
+#undef LOGW
+#undef LOGE
+#undef LOGF
+#undef DUMPI
+#undef DUMPD
+#undef DUMPW
+#undef DUMPE
+#undef DUMPF
+#define TRACEI(...) LOG_TRACE_DEFERRED(LOG_INFO, __VA_ARGS__)
+#define TRACED(...) LOG_TRACE_DEFERRED(LOG_DEBUG, __VA_ARGS__)
+#define TRACEW(...) LOG_TRACE_DEFERRED(LOG_WARNING, __VA_ARGS__)
+#define TRACEE(...) LOG_TRACE_DEFERRED(LOG_ERROR, __VA_ARGS__)
+#define TRACEF(...) LOG_TRACE_DEFERRED(LOG_FATAL, __VA_ARGS__)
+#define LOGI LOG_STREAM_DEFERRED(LOG_INFO)
+#define LOGD LOG_STREAM_DEFERRED(LOG_DEBUG)
+#define LOGW LOG_STREAM_DEFERRED(LOG_WARNING)
+#define LOGE LOG_STREAM_DEFERRED(LOG_ERROR)
+#define LOGF LOG_STREAM_DEFERRED(LOG_FATAL)
+#define DUMPI(data, size) LOG_DUMP_DEFERRED(LOG_INFO, data, size)
+#define DUMPD(data, size) LOG_DUMP_DEFERRED(LOG_DEBUG, data, size)
+#define DUMPW(data, size) LOG_DUMP_DEFERRED(LOG_WARNING, data, size)
+#define DUMPE(data, size) LOG_DUMP_DEFERRED(LOG_ERROR, data, size)
+#define DUMPF(data, size) LOG_DUMP_DEFERRED(LOG_FATAL, data, size)
+#endif
+
 
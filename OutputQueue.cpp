@@ -0,0 +1,102 @@
+#include "OutputQueue.h"
+#include "Socket.h"      // Buffer
+#include <errno.h>
+#include <string.h>      // memcpy
+
+COutputQueue::COutputQueue()
+{
+    m_high = 0;
+    m_low = 0;
+    m_bHigh = false;
+}
+
+void COutputQueue::Append(const char* data, size_t size)
+{
+    if (size == 0) return;
+
+    // 拷进队尾块的尾部空间（小消息自然合并成一段）
+    // 用Reserve而不是Append：不够时另起的是整页块，后面的小消息接着往里合并
+    char* p = m_chain.Reserve(size);
+    memcpy(p, data, size);
+    m_chain.Commit(size);
+    CheckHigh();
+}
+
+void COutputQueue::Append(const Buffer& data)
+{
+    Append(data.c_str(), data.size());
+}
+
+void COutputQueue::Append(Buffer&& data)
+{
+    if (data.size() < OUTPUT_COALESCE_SIZE) {
+        Append(data.c_str(), data.size());  // 小消息走合并
+        return;
+    }
+    m_chain.Append(std::move((std::string&)data));  // 接管内存，不拷贝
+    CheckHigh();
+}
+
+void COutputQueue::Append(const CIOBuf& data)
+{
+    size_t size = data.Size();
+    if (size == 0) return;
+
+    if (size < OUTPUT_COALESCE_SIZE) {
+        // 小消息拷一次比多占一个iovec划算
+        char* p = m_chain.Reserve(size);
+        data.CopyTo(p, 0, size);
+        m_chain.Commit(size);
+    }
+    else {
+        m_chain.Append(data);  // 共享块
+    }
+    CheckHigh();
+}
+
+ssize_t COutputQueue::Flush(int fd)
+{
+    if (m_chain.Empty()) return 0;
+
+    // 第1步：收集iovec
+    iovec iov[OUTPUT_IOV_MAX];
+    int count = m_chain.Gather(iov, OUTPUT_IOV_MAX);
+
+    // 第2步：一次writev
+    ssize_t ret = writev(fd, iov, count);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+        return -1;
+    }
+
+    // 第3步：去掉已写出的部分（写完的块随之释放）
+    m_chain.TrimStart((size_t)ret);
+
+    // 第4步：回落到低水位时通知
+    if (m_bHigh && m_chain.Size() <= m_low) {
+        m_bHigh = false;
+        if (m_watermark) m_watermark(false);
+    }
+    return ret;
+}
+
+void COutputQueue::SetWatermark(size_t high, size_t low, WatermarkFunc func)
+{
+    m_high = high;
+    m_low = low < high ? low : high;
+    m_watermark = func;
+}
+
+void COutputQueue::Clear()
+{
+    m_chain.Clear();
+    m_bHigh = false;
+}
+
+void COutputQueue::CheckHigh()
+{
+    if (m_high > 0 && !m_bHigh && m_chain.Size() >= m_high) {
+        m_bHigh = true;
+        if (m_watermark) m_watermark(true);
+    }
+}
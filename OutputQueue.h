@@ -0,0 +1,70 @@
+#pragma once
+#include <sys/uio.h>     // iovec, writev
+#include <string>
+#include <functional>
+#include "IOBuf.h"
+
+class Buffer;
+
+// 一次writev最多带多少段（内核上限IOV_MAX=1024，这里取一个不占太多栈的值）
+#define OUTPUT_IOV_MAX 64
+
+// 小于这个长度的消息直接拼到队尾段里，减少iovec数量
+#define OUTPUT_COALESCE_SIZE 512
+
+// ============================================
+// COutputQueue类：每连接的异步发送队列
+//
+// 问题：send()一次一个消息
+//   - 每个消息一次系统调用
+//   - 部分写入 / EAGAIN 要调用者自己处理
+//   - 慢客户端会卡住整个循环
+//
+// 做法：
+//   1. Append()只入队，不发系统调用
+//   2. 每轮事件循环末尾调用一次 Flush()，所有段合并成一次 writev
+//   3. 没写完的留在队列里，下一轮继续（由EPOLLOUT驱动）
+//   4. 积压超过高水位 / 回落到低水位时回调通知业务层
+//
+// 队列结构：一个CIOBuf切片链
+//   m_chain: [切片0][切片1][切片2]...
+//   小消息拷进最后一块的尾部（合并），大消息/CIOBuf直接挂切片（不拷贝），
+//   写出多少就TrimStart多少（部分写入只改第一个切片的偏移）
+// ============================================
+class COutputQueue
+{
+public:
+    // 水位回调：bHigh=true 积压超过高水位；false 回落到低水位
+    using WatermarkFunc = std::function<void(bool bHigh)>;
+
+    COutputQueue();
+    ~COutputQueue() {}
+
+    // 入队（Buffer&&版本直接接管内存，CIOBuf版本共享块，都不拷贝）
+    void Append(const char* data, size_t size);
+    void Append(const Buffer& data);
+    void Append(Buffer&& data);
+    void Append(const CIOBuf& data);
+
+    // 一次writev发出尽可能多的数据
+    // 返回值：>=0 本次写出的字节数（EAGAIN时为0），-1 写失败（errno有效）
+    ssize_t Flush(int fd);
+
+    // 设置水位线（high为0表示不启用）
+    void SetWatermark(size_t high, size_t low, WatermarkFunc func);
+
+    size_t Pending() const { return m_chain.Size(); }
+    bool Empty() const { return m_chain.Empty(); }
+    void Clear();
+
+private:
+    void CheckHigh();
+
+private:
+    CIOBuf m_chain;      // 待发送的数据（切片链）
+
+    size_t m_high;       // 高水位
+    size_t m_low;        // 低水位
+    bool m_bHigh;        // 当前是否处于高水位状态
+    WatermarkFunc m_watermark;
+};
@@ -0,0 +1,291 @@
+#pragma once
+#include "IOBuf.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <tuple>
+#include <type_traits>
+
+// opcode的上限（分发表按opcode直接下标，表长 = 最大opcode + 1）
+#define PROTO_OPCODE_MAX 4096
+// 包头：2字节opcode
+#define PROTO_HEADER_SIZE 2
+
+// 变长字节串：解码时指向包内的数据（不拷贝，包释放前有效）
+struct CProtoBytes
+{
+    const char* data;
+    uint16_t size;
+    CProtoBytes() : data(NULL), size(0) {}
+    CProtoBytes(const char* d, uint16_t n) : data(d), size(n) {}
+};
+
+// 在消息结构体里声明opcode和字段（按顺序编码）：
+//   struct MsgMove {
+//       uint32_t id; float pos[3]; uint8_t dir;
+//       PROTO_MESSAGE(101, id, pos, dir)
+//   };
+#define PROTO_MESSAGE(opcode, ...) \
+    enum { OPCODE = opcode }; \
+    auto Fields() -> decltype(std::tie(__VA_ARGS__)) { return std::tie(__VA_ARGS__); } \
+    auto Fields() const -> decltype(std::tie(__VA_ARGS__)) { return std::tie(__VA_ARGS__); }
+
+// ============================================
+// CProtoField：单个字段的编解码（按类型特化）
+//   FIXED：线上的定长部分（变长字段是2字节长度）
+//   VARIABLE：是否有变长部分
+// 整数、浮点、枚举按主机字节序直接memcpy（x86/ARM都是小端）
+// ============================================
+template<typename T, bool = std::is_arithmetic<T>::value || std::is_enum<T>::value>
+struct CProtoField;
+
+template<typename T>
+struct CProtoField<T, true>
+{
+    enum { FIXED = sizeof(T), VARIABLE = 0 };
+    static size_t Extra(const T&) { return 0; }
+    static char* Put(char* p, const T& v) { memcpy(p, &v, sizeof(T)); return p + sizeof(T); }
+    static const char* Get(const char* p, const char*, size_t, T& v) { memcpy(&v, p, sizeof(T)); return p + sizeof(T); }
+};
+
+// 定长数组（元素也必须是定长的）
+template<typename T, size_t N>
+struct CProtoField<T[N], false>
+{
+    static_assert(!CProtoField<T>::VARIABLE, "数组元素必须是定长类型");
+    enum { FIXED = sizeof(T) * N, VARIABLE = 0 };
+    static size_t Extra(const T(&)[N]) { return 0; }
+    static char* Put(char* p, const T(&v)[N]) { memcpy(p, v, sizeof(v)); return p + sizeof(v); }
+    static const char* Get(const char* p, const char*, size_t, T(&v)[N]) { memcpy(v, p, sizeof(v)); return p + sizeof(v); }
+};
+
+template<>
+struct CProtoField<CProtoBytes, false>
+{
+    enum { FIXED = 2, VARIABLE = 1 };
+    static size_t Extra(const CProtoBytes& v) { return v.size; }
+    static char* Put(char* p, const CProtoBytes& v) {
+        memcpy(p, &v.size, 2);
+        if (v.size > 0) memcpy(p + 2, v.data, v.size);
+        return p + 2 + v.size;
+    }
+    // suffix：后面所有字段的定长部分；一次检查之后，后面的定长字段都不用再查
+    static const char* Get(const char* p, const char* end, size_t suffix, CProtoBytes& v) {
+        memcpy(&v.size, p, 2);
+        p += 2;
+        if ((size_t)(end - p) < v.size + suffix) return NULL;
+        v.data = p;
+        return p + v.size;
+    }
+};
+
+// ============================================
+// 字段列表（std::tie得到的引用tuple）的编译期遍历
+// ============================================
+template<typename Tuple, size_t I = 0, size_t N = std::tuple_size<Tuple>::value>
+struct CProtoFields
+{
+    typedef typename std::remove_reference<typename std::tuple_element<I, Tuple>::type>::type Type;
+    typedef CProtoField<typename std::remove_const<Type>::type> Field;
+    typedef CProtoFields<Tuple, I + 1, N> Next;
+
+    enum {
+        FIXED = (int)Field::FIXED + (int)Next::FIXED,     // 第I个及之后字段的定长部分
+        VARIABLE = Field::VARIABLE || Next::VARIABLE,
+    };
+
+    // T：Fields()返回的tuple（const版本编码，非const版本解码）
+    template<typename T>
+    static size_t Extra(const T& t) { return Field::Extra(std::get<I>(t)) + Next::Extra(t); }
+    template<typename T>
+    static char* Put(char* p, const T& t) { return Next::Put(Field::Put(p, std::get<I>(t)), t); }
+    template<typename T>
+    static const char* Get(const char* p, const char* end, const T& t) {
+        p = Field::Get(p, end, Next::FIXED, std::get<I>(t));
+        return p == NULL ? NULL : Next::Get(p, end, t);
+    }
+};
+
+template<typename Tuple, size_t N>
+struct CProtoFields<Tuple, N, N>
+{
+    enum { FIXED = 0, VARIABLE = 0 };
+    template<typename T>
+    static size_t Extra(const T&) { return 0; }
+    template<typename T>
+    static char* Put(char* p, const T&) { return p; }
+    template<typename T>
+    static const char* Get(const char* p, const char*, const T&) { return p; }
+};
+
+// ============================================
+// CProtocol类：按消息结构体的字段声明编解码（全部在编译期展开）
+//
+// 问题：业务层拿到原始Buffer手工解析：每个字段一次越界检查、偏移自己算，
+//      改一个字段要同时改收发两边；文档里的CProtocol只是草图
+//
+// 做法：
+//   1. 消息 = 普通结构体 + PROTO_MESSAGE(opcode, 字段...)：字段顺序就是线上顺序
+//   2. 模板递归展开成一串memcpy，没有虚函数、没有分配；
+//      定长部分的总长在编译期算好（Message<M>::FIXED）
+//   3. 越界检查按消息提前做：解码前检查一次"剩余 ≥ 全部定长部分"，
+//      只有变长字段（CProtoBytes）再各查一次，定长字段不查
+//   4. 变长字段解码成指向包内的视图，不拷贝
+//
+// 包格式：[opcode 2字节][字段...]（长度分帧由外层负责，见OutputQueue/RingBuffer）
+//
+// 用法：
+//   MsgMove m = { 7, { 1, 2, 3 }, 0 };
+//   char buf[64];  int n = CProtocol::Encode(m, buf, sizeof(buf));
+//   CIOBuf pkt = CProtocol::Pack(m);       // 直接交给SendAsync/CBroadcast
+//   MsgMove r;     CProtocol::Decode(buf, n, r);
+// ============================================
+class CProtocol
+{
+public:
+    template<typename M>
+    struct Message {
+        typedef decltype(std::declval<const M&>().Fields()) Tuple;
+        typedef CProtoFields<Tuple> Fields;
+        enum { OPCODE = M::OPCODE, FIXED = PROTO_HEADER_SIZE + Fields::FIXED };
+        static_assert((int)M::OPCODE >= 0 && (int)M::OPCODE < PROTO_OPCODE_MAX, "opcode超出范围");
+    };
+
+    // 编码后的长度（含包头）
+    template<typename M>
+    static size_t Size(const M& msg) {
+        return Message<M>::FIXED + Message<M>::Fields::Extra(msg.Fields());
+    }
+
+    // 编码到out，返回写入的字节数；-1空间不够
+    template<typename M>
+    static int Encode(const M& msg, char* out, size_t capacity) {
+        size_t size = Size(msg);
+        if (size > capacity) return -1;    // 只检查这一次
+        uint16_t opcode = (uint16_t)M::OPCODE;
+        memcpy(out, &opcode, PROTO_HEADER_SIZE);
+        Message<M>::Fields::Put(out + PROTO_HEADER_SIZE, msg.Fields());
+        return (int)size;
+    }
+
+    // 编码成CIOBuf（前面留了IOBUF_HEADROOM，外层可以直接Prepend长度）
+    template<typename M>
+    static CIOBuf Pack(const M& msg) {
+        size_t size = Size(msg);
+        CIOBuf buf(size);
+        Encode(msg, buf.Reserve(size), size);
+        buf.Commit(size);
+        return buf;
+    }
+
+    // 解码（含包头）；多余的尾部字节忽略（兼容旧版本多加的字段）
+    // 返回值：0成功，-1 opcode不对，-2长度不够
+    template<typename M>
+    static int Decode(const char* data, size_t size, M& msg) {
+        if (size < (size_t)Message<M>::FIXED) return -2;
+        if (Opcode(data) != (uint16_t)M::OPCODE) return -1;
+        return DecodeBody(data + PROTO_HEADER_SIZE, size - PROTO_HEADER_SIZE, msg);
+    }
+
+    // 只解码包体（调用者已检查过size ≥ FIXED - 包头，比如分发表）
+    template<typename M>
+    static int DecodeBody(const char* body, size_t size, M& msg) {
+        const char* end = Message<M>::Fields::Get(body, body + size, msg.Fields());
+        return end == NULL ? -2 : 0;
+    }
+
+    // 包头里的opcode（调用者保证size ≥ PROTO_HEADER_SIZE）
+    static uint16_t Opcode(const char* data) {
+        uint16_t opcode;
+        memcpy(&opcode, data, PROTO_HEADER_SIZE);
+        return opcode;
+    }
+};
+
+// ============================================
+// 编译期检查：opcode不重复、求最大opcode
+// ============================================
+template<int OPCODE, typename... Ms>
+struct CProtoHasOpcode { enum { value = 0 }; };
+template<int OPCODE, typename M, typename... Ms>
+struct CProtoHasOpcode<OPCODE, M, Ms...> { enum { value = (int)M::OPCODE == OPCODE || CProtoHasOpcode<OPCODE, Ms...>::value }; };
+
+template<typename... Ms>
+struct CProtoUnique { enum { value = 1 }; };
+template<typename M, typename... Ms>
+struct CProtoUnique<M, Ms...> { enum { value = !CProtoHasOpcode<M::OPCODE, Ms...>::value && CProtoUnique<Ms...>::value }; };
+
+template<typename... Ms>
+struct CProtoMaxOpcode { enum { value = 0 }; };
+template<typename M, typename... Ms>
+struct CProtoMaxOpcode<M, Ms...> {
+    enum { value = (int)M::OPCODE > (int)CProtoMaxOpcode<Ms...>::value ? (int)M::OPCODE : (int)CProtoMaxOpcode<Ms...>::value };
+};
+
+// ============================================
+// CDispatcher类：opcode → 处理函数，编译期生成的分发表
+//
+// 问题：按opcode找处理函数通常是std::map<int, std::function>或虚函数，
+//      每个包一次树查找 + 一次类型擦除的调用
+//
+// 做法：
+//   1. 消息类型列表在模板参数里给出，重复的opcode编译报错
+//   2. 每种消息实例化一个小函数（检查长度、解码、调用Handler::On(const M&)），
+//      On()是普通成员函数重载，编译器可以直接内联进去
+//   3. 这些函数指针按opcode放进一个定长数组：分发 = 一次边界检查 + 一次下标 + 一次间接调用
+//      数组由constexpr构造函数填好，是常量初始化的静态成员（编译期写进只读数据段），
+//      没有函数内静态变量的初始化检查
+//
+// 用法：
+//   struct GameHandler {
+//       int On(const MsgMove& m) { ... return 0; }
+//       int On(const MsgChat& m) { ... return 0; }
+//   };
+//   typedef CDispatcher<GameHandler, MsgMove, MsgChat> GameDispatcher;
+//   int ret = GameDispatcher::Dispatch(handler, data, size);
+// ============================================
+template<typename Handler, typename... Msgs>
+class CDispatcher
+{
+    static_assert(sizeof...(Msgs) > 0, "至少需要一种消息");
+    static_assert(CProtoUnique<Msgs...>::value, "opcode重复");
+
+public:
+    enum { SIZE = CProtoMaxOpcode<Msgs...>::value + 1 };
+    typedef int (*Entry)(Handler& handler, const char* body, size_t size);
+
+    // 分发一个完整的包（含包头）
+    // 返回值：On()的返回值；-1未知opcode，-2长度不够
+    static int Dispatch(Handler& handler, const char* data, size_t size) {
+        if (size < PROTO_HEADER_SIZE) return -2;
+        uint16_t opcode = CProtocol::Opcode(data);
+        if (opcode >= SIZE) return -1;
+        Entry entry = s_table.entries[opcode];
+        if (entry == NULL) return -1;
+        return entry(handler, data + PROTO_HEADER_SIZE, size - PROTO_HEADER_SIZE);
+    }
+
+    // 这个opcode有没有处理函数
+    static bool Has(uint16_t opcode) { return opcode < SIZE && s_table.entries[opcode] != NULL; }
+
+private:
+    template<typename M>
+    static int Call(Handler& handler, const char* body, size_t size) {
+        if (size < (size_t)CProtocol::Message<M>::FIXED - PROTO_HEADER_SIZE) return -2;
+        M msg;
+        if (CProtocol::DecodeBody(body, size, msg) != 0) return -2;
+        return handler.On((const M&)msg);
+    }
+
+    struct Entries {
+        Entry entries[SIZE];
+        constexpr Entries() : entries() {
+            ((entries[Msgs::OPCODE] = &Call<Msgs>), ...);   // 没有处理函数的opcode保持NULL
+        }
+    };
+
+    static const Entries s_table;   // 定义在类外：类定义完整之后constexpr构造函数才能在常量表达式里用
+};
+
+template<typename Handler, typename... Msgs>
+const typename CDispatcher<Handler, Msgs...>::Entries CDispatcher<Handler, Msgs...>::s_table;
@@ -0,0 +1,748 @@
+#include "ReliableUdp.h"
+#include <time.h>
+#include <stdlib.h>
+
+// 段类型
+#define RUDP_CMD_PUSH 1     // 可靠数据
+#define RUDP_CMD_ACK 2      // 确认（una + SACK区间）
+#define RUDP_CMD_UNREL 3    // 不可靠有序数据
+#define RUDP_CMD_SYN 4      // 建立连接
+#define RUDP_CMD_SYNACK 5   // 建立连接应答
+#define RUDP_CMD_FIN 6      // 关闭
+#define RUDP_CMD_PING 7     // 心跳（对方回ACK）
+
+#define RUDP_RTO_INIT 200   // 初始重传超时（毫秒）
+#define RUDP_RTO_MAX 60000
+#define RUDP_THRESH_MIN 2   // 拥塞控制：慢启动阈值下限
+
+// 序号比较（32位回绕）
+static inline int32_t Diff(uint32_t a, uint32_t b) { return (int32_t)(a - b); }
+
+// 小端编解码
+static inline char* Put8(char* p, uint8_t v) { *p = (char)v; return p + 1; }
+static inline char* Put16(char* p, uint16_t v) {
+    p[0] = (char)(v & 0xFF); p[1] = (char)(v >> 8);
+    return p + 2;
+}
+static inline char* Put32(char* p, uint32_t v) {
+    p[0] = (char)(v & 0xFF); p[1] = (char)((v >> 8) & 0xFF);
+    p[2] = (char)((v >> 16) & 0xFF); p[3] = (char)(v >> 24);
+    return p + 4;
+}
+static inline uint16_t Get16(const char* p) {
+    return (uint16_t)((uint8_t)p[0] | ((uint8_t)p[1] << 8));
+}
+static inline uint32_t Get32(const char* p) {
+    return (uint32_t)(uint8_t)p[0] | ((uint32_t)(uint8_t)p[1] << 8) |
+        ((uint32_t)(uint8_t)p[2] << 16) | ((uint32_t)(uint8_t)p[3] << 24);
+}
+
+// ==================== CRudpSession：构造 ====================
+CRudpSession::CRudpSession(CRudpEndpoint* endpoint, uint32_t conv, const sockaddr_in& addr,
+    const RudpConfig& config, uint32_t now)
+{
+    user = NULL;
+    m_endpoint = endpoint;
+    m_config = config;
+    m_conv = conv;
+    m_state = RUDP_ESTABLISHED;
+    m_addr = addr;
+    m_mss = config.mtu - RUDP_CONV_SIZE - RUDP_HEADER_SIZE;
+
+    m_sndUna = 0;
+    m_sndNxt = 0;
+    m_rmtWnd = config.rcvwnd;
+    m_cwnd = config.congestion ? 1 : config.sndwnd;
+    m_ssthresh = RUDP_THRESH_MIN;
+    m_incr = (uint32_t)m_mss;
+    m_useqSnd = 0;
+
+    m_rcvNxt = 0;
+    m_useqRcv = 0;
+    m_bUseqInit = false;
+
+    m_bAck = false;
+    m_ackTs = 0;
+    m_bSynAck = false;
+    m_synTs = 0;
+    m_tsSyn = now;
+
+    m_srtt = 0;
+    m_rttvar = 0;
+    m_rto = RUDP_RTO_INIT;
+
+    m_tsFlush = now;
+    m_tsRecv = now;
+    m_tsSend = now;
+    m_bDirty = false;
+    m_bTouched = false;
+    m_bReleased = false;
+
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_out.reserve(config.mtu);
+}
+
+// ==================== CRudpSession：发送 ====================
+int CRudpSession::Send(const char* data, size_t size, int channel)
+{
+    return Send(CIOBuf(data, size), channel);  // 只拷贝一次，分片都是它的切片
+}
+
+int CRudpSession::Send(const CIOBuf& data, int channel)
+{
+    if (m_state == RUDP_CLOSED) return -1;
+
+    if (channel == RUDP_SEQUENCED) {
+        if (data.Size() > m_mss) return -2;
+        m_unreliable.push_back(data);
+        m_bDirty = true;
+        return 0;
+    }
+    if (channel != RUDP_RELIABLE) return -3;
+
+    // 分片：frg从count-1倒数到0，接收端看到frg=0就知道消息结束
+    size_t size = data.Size();
+    size_t count = (size <= m_mss) ? 1 : (size + m_mss - 1) / m_mss;
+    if (count > RUDP_FRAGMENT_MAX) return -2;
+
+    for (size_t i = 0; i < count; i++) {
+        Segment seg;
+        seg.cmd = RUDP_CMD_PUSH;
+        seg.frg = (uint8_t)(count - i - 1);
+        seg.sn = 0;
+        seg.ts = 0;
+        seg.resendts = 0;
+        seg.rto = 0;
+        seg.fastack = 0;
+        seg.xmit = 0;
+        seg.data = data.Slice(i * m_mss, m_mss);
+        m_sndQueue.push_back(std::move(seg));
+    }
+    m_bDirty = true;
+    return 0;
+}
+
+void CRudpSession::Close()
+{
+    if (m_state == RUDP_CLOSED) return;
+
+    // 通知对方（不保证送达：丢了对方会在超时后自己关闭）
+    Output(RUDP_CMD_FIN, 0, CRudpEndpoint::Clock(), 0, NULL);
+    OutputFlush();
+    m_state = RUDP_CLOSED;
+    m_endpoint->Release(this);
+}
+
+RudpStats CRudpSession::Stats() const
+{
+    RudpStats stats = m_stats;
+    stats.srtt = (unsigned)m_srtt;
+    stats.rto = m_rto;
+    stats.cwnd = m_cwnd;
+    stats.inflight = m_sndNxt - m_sndUna;
+    return stats;
+}
+
+// ==================== CRudpSession：接收 ====================
+int CRudpSession::Input(const char* data, size_t size, uint32_t now)
+{
+    uint32_t oldUna = m_sndUna;
+    uint32_t maxack = 0;
+    bool bMaxack = false;
+
+    while (size >= RUDP_HEADER_SIZE && m_state != RUDP_CLOSED) {
+        uint8_t cmd = (uint8_t)data[0];
+        uint8_t frg = (uint8_t)data[1];
+        uint16_t wnd = Get16(data + 2);
+        uint32_t ts = Get32(data + 4);
+        uint32_t sn = Get32(data + 8);
+        uint32_t una = Get32(data + 12);
+        uint16_t len = Get16(data + 16);
+        data += RUDP_HEADER_SIZE;
+        size -= RUDP_HEADER_SIZE;
+        if (len > size) return -2;  // 截断的包
+
+        m_tsRecv = now;
+
+        // 客户端：收到服务器的任何应答都说明连接已建立（SYNACK丢了也不影响）
+        if (m_state == RUDP_SYN_SENT && cmd != RUDP_CMD_SYN && cmd != RUDP_CMD_FIN) {
+            m_state = RUDP_ESTABLISHED;
+        }
+
+        switch (cmd) {
+        case RUDP_CMD_SYN:
+            // 服务器：（重复的）SYN，回SYNACK，回显时间戳让客户端算RTT
+            m_bSynAck = true;
+            m_synTs = ts;
+            break;
+        case RUDP_CMD_SYNACK:
+            if (Diff(now, ts) >= 0) UpdateRtt(Diff(now, ts));
+            break;
+        case RUDP_CMD_FIN:
+            m_state = RUDP_CLOSED;
+            m_endpoint->Release(this);
+            return 0;
+        case RUDP_CMD_PING:
+            m_bAck = true;  // 回一个ACK当作心跳应答
+            break;
+        case RUDP_CMD_ACK:
+            m_rmtWnd = wnd;
+            ParseUna(una);
+            if (ts != 0 && Diff(now, ts) >= 0) UpdateRtt(Diff(now, ts));
+            ParseSack(data, len, &maxack, &bMaxack);
+            break;
+        case RUDP_CMD_PUSH:
+            m_rmtWnd = wnd;
+            ParseUna(una);
+            // 窗口内的才收，不管收不收都要回ACK（对方可能没收到上次的ACK）
+            if (Diff(sn, m_rcvNxt + m_config.rcvwnd) < 0) {
+                m_bAck = true;
+                m_ackTs = ts;
+                if (Diff(sn, m_rcvNxt) >= 0) {
+                    Segment seg;
+                    seg.cmd = cmd;
+                    seg.frg = frg;
+                    seg.sn = sn;
+                    seg.ts = ts;
+                    seg.resendts = 0;
+                    seg.rto = 0;
+                    seg.fastack = 0;
+                    seg.xmit = 0;
+                    seg.data = CIOBuf(data, len);
+                    ParseData(seg);
+                }
+            }
+            break;
+        case RUDP_CMD_UNREL:
+            m_rmtWnd = wnd;
+            ParseUna(una);
+            // 只要比已收到的新的，旧的直接丢（不重传、不等待）
+            if (!m_bUseqInit || Diff(sn, m_useqRcv) > 0) {
+                m_bUseqInit = true;
+                m_useqRcv = sn;
+                if (m_endpoint->OnMessage) m_endpoint->OnMessage(this, RUDP_SEQUENCED, data, len);
+            }
+            else {
+                m_stats.dropped++;
+            }
+            break;
+        default:
+            return -3;
+        }
+        data += len;
+        size -= len;
+    }
+
+    // 快速重传计数：比收到的最大序号小、还没确认的段，被"跳过"了一次
+    if (bMaxack) {
+        for (auto& seg : m_sndBuf) {
+            if (Diff(seg.sn, maxack) >= 0) break;
+            seg.fastack++;
+        }
+    }
+
+    // 拥塞控制：有新的确认 → 慢启动 / 拥塞避免
+    if (m_config.congestion && Diff(m_sndUna, oldUna) > 0 && m_cwnd < m_rmtWnd) {
+        uint32_t mss = (uint32_t)m_mss;
+        if (m_cwnd < m_ssthresh) {
+            m_cwnd++;
+            m_incr += mss;
+        }
+        else {
+            if (m_incr < mss) m_incr = mss;
+            m_incr += (mss * mss) / m_incr + mss / 16;
+            if ((m_cwnd + 1) * mss <= m_incr) m_cwnd = (m_incr + mss - 1) / mss;
+        }
+        if (m_cwnd > m_rmtWnd) {
+            m_cwnd = m_rmtWnd;
+            m_incr = m_rmtWnd * mss;
+        }
+    }
+
+    Deliver();
+    return 0;
+}
+
+// 累计确认：una之前的全部收到了
+void CRudpSession::ParseUna(uint32_t una)
+{
+    while (!m_sndBuf.empty() && Diff(m_sndBuf.front().sn, una) < 0) {
+        m_sndBuf.pop_front();
+    }
+    m_sndUna = m_sndBuf.empty() ? m_sndNxt : m_sndBuf.front().sn;
+}
+
+// 选择确认：[start, end) 区间已收到（乱序到达的部分）
+void CRudpSession::ParseSack(const char* data, size_t size, uint32_t* maxack, bool* bMaxack)
+{
+    for (size_t off = 0; off + 8 <= size; off += 8) {
+        uint32_t start = Get32(data + off);
+        uint32_t end = Get32(data + off + 4);
+        for (auto it = m_sndBuf.begin(); it != m_sndBuf.end();) {
+            if (Diff(it->sn, end) >= 0) break;
+            if (Diff(it->sn, start) >= 0) it = m_sndBuf.erase(it);
+            else ++it;
+        }
+        if (!*bMaxack || Diff(end - 1, *maxack) > 0) {
+            *maxack = end - 1;
+            *bMaxack = true;
+        }
+    }
+    m_sndUna = m_sndBuf.empty() ? m_sndNxt : m_sndBuf.front().sn;
+}
+
+// 收到的数据段：按序号插入乱序缓冲，再把连续的部分移到接收队列
+void CRudpSession::ParseData(Segment& seg)
+{
+    auto it = m_rcvBuf.end();
+    while (it != m_rcvBuf.begin()) {
+        auto prev = it - 1;
+        if (prev->sn == seg.sn) return;  // 重复
+        if (Diff(seg.sn, prev->sn) > 0) break;
+        it = prev;
+    }
+    m_rcvBuf.insert(it, std::move(seg));
+
+    while (!m_rcvBuf.empty() && m_rcvBuf.front().sn == m_rcvNxt &&
+        m_rcvQueue.size() < m_config.rcvwnd) {
+        m_rcvQueue.push_back(std::move(m_rcvBuf.front()));
+        m_rcvBuf.pop_front();
+        m_rcvNxt++;
+    }
+}
+
+// 接收队列 → 完整消息 → OnMessage
+void CRudpSession::Deliver()
+{
+    while (!m_rcvQueue.empty() && m_state != RUDP_CLOSED) {
+        size_t count = (size_t)m_rcvQueue.front().frg + 1;
+        if (m_rcvQueue.size() < count) break;  // 分片还没到齐
+
+        CIOBuf message;
+        for (size_t i = 0; i < count; i++) message.Append(m_rcvQueue[i].data);  // 共享，不拷贝
+        for (size_t i = 0; i < count; i++) m_rcvQueue.pop_front();
+
+        const char* p = message.Coalesce();  // 多片时拼成一段（单片不拷贝）
+        if (m_endpoint->OnMessage) m_endpoint->OnMessage(this, RUDP_RELIABLE, p, message.Size());
+    }
+}
+
+unsigned CRudpSession::WndUnused() const
+{
+    if (m_rcvQueue.size() >= m_config.rcvwnd) return 0;
+    return m_config.rcvwnd - (unsigned)m_rcvQueue.size();
+}
+
+// RTT估计（RFC 6298）
+void CRudpSession::UpdateRtt(int32_t rtt)
+{
+    if (m_srtt == 0) {
+        m_srtt = rtt > 0 ? rtt : 1;
+        m_rttvar = rtt / 2;
+    }
+    else {
+        int32_t delta = rtt > m_srtt ? rtt - m_srtt : m_srtt - rtt;
+        m_rttvar = (3 * m_rttvar + delta) / 4;
+        m_srtt = (7 * m_srtt + rtt) / 8;
+        if (m_srtt < 1) m_srtt = 1;
+    }
+    uint32_t var = (uint32_t)(4 * m_rttvar);
+    uint32_t rto = (uint32_t)m_srtt + (var > m_config.interval ? var : m_config.interval);
+    if (rto < m_config.minrto) rto = m_config.minrto;
+    if (rto > RUDP_RTO_MAX) rto = RUDP_RTO_MAX;
+    m_rto = rto;
+}
+
+// ==================== CRudpSession：刷新 ====================
+void CRudpSession::Flush(uint32_t now)
+{
+    if (m_state == RUDP_CLOSED) return;
+    m_tsFlush = now + m_config.interval;
+    m_bDirty = false;
+    size_t sent = m_stats.sentSegments;
+
+    // 第1步：握手
+    if (m_state == RUDP_SYN_SENT) {
+        if (Diff(now, m_tsSyn) >= 0) {
+            Output(RUDP_CMD_SYN, 0, now, 0, NULL);
+            m_tsSyn = now + m_rto;
+            m_tsSend = now;
+        }
+        OutputFlush();
+        return;  // 建立之前数据先排队
+    }
+    if (m_bSynAck) {
+        Output(RUDP_CMD_SYNACK, 0, m_synTs, 0, NULL);
+        m_bSynAck = false;
+    }
+
+    // 第2步：ACK（una + 乱序缓冲里已收到的区间）
+    if (m_bAck) {
+        char sack[RUDP_SACK_MAX * 8];
+        size_t n = 0;
+        for (size_t i = 0; i < m_rcvBuf.size() && n < RUDP_SACK_MAX;) {
+            uint32_t start = m_rcvBuf[i].sn, end = start + 1;
+            for (i++; i < m_rcvBuf.size() && m_rcvBuf[i].sn == end; i++) end++;
+            Put32(Put32(sack + n * 8, start), end);
+            n++;
+        }
+        Output(RUDP_CMD_ACK, 0, m_ackTs, 0, NULL, sack, n * 8);
+        m_bAck = false;
+    }
+
+    // 第3步：发送队列 → 发送窗口（窗口 = min(发送窗口, 对方接收窗口, 拥塞窗口)）
+    uint32_t cwnd = m_config.sndwnd < m_rmtWnd ? m_config.sndwnd : m_rmtWnd;
+    if (m_config.congestion && m_cwnd < cwnd) cwnd = m_cwnd;
+    if (cwnd == 0) cwnd = 1;  // 对方窗口为0时也保留一个段探测
+    while (!m_sndQueue.empty() && Diff(m_sndNxt, m_sndUna + cwnd) < 0) {
+        Segment seg = std::move(m_sndQueue.front());
+        m_sndQueue.pop_front();
+        seg.sn = m_sndNxt++;
+        m_sndBuf.push_back(std::move(seg));
+    }
+
+    // 第4步：首次发送 / 超时重传 / 快速重传
+    bool bLost = false, bChange = false, bDead = false;
+    for (auto& seg : m_sndBuf) {
+        bool bSend = false;
+        if (seg.xmit == 0) {
+            bSend = true;
+            seg.rto = m_rto;
+            seg.resendts = now + seg.rto;
+        }
+        else if (Diff(now, seg.resendts) >= 0) {
+            bSend = true;
+            bLost = true;
+            m_stats.timeouts++;
+            seg.rto += m_config.nodelay ? seg.rto / 2 : seg.rto;  // 退避
+            if (seg.rto > RUDP_RTO_MAX) seg.rto = RUDP_RTO_MAX;
+            seg.resendts = now + seg.rto;
+        }
+        else if (m_config.fastresend > 0 && seg.fastack >= m_config.fastresend) {
+            bSend = true;
+            bChange = true;
+            m_stats.fastResends++;
+            seg.fastack = 0;
+            seg.resendts = now + seg.rto;
+        }
+        if (bSend) {
+            seg.xmit++;
+            seg.ts = now;
+            m_stats.sentSegments++;
+            Output(RUDP_CMD_PUSH, seg.frg, now, seg.sn, &seg.data);
+            if (seg.xmit > m_config.deadlink) bDead = true;
+        }
+    }
+
+    // 第5步：不可靠有序包（发一次就忘）
+    while (!m_unreliable.empty()) {
+        Output(RUDP_CMD_UNREL, 0, now, m_useqSnd++, &m_unreliable.front());
+        m_unreliable.pop_front();
+    }
+
+    // 第6步：空闲心跳
+    if (!m_out.empty() || m_stats.sentSegments != sent) m_tsSend = now;
+    else if (Diff(now, m_tsSend) >= RUDP_PING_INTERVAL) {
+        Output(RUDP_CMD_PING, 0, now, 0, NULL);
+        m_tsSend = now;
+    }
+    OutputFlush();
+
+    // 第7步：拥塞控制（快速重传：窗口减半；超时：回到慢启动）
+    if (m_config.congestion) {
+        uint32_t mss = (uint32_t)m_mss;
+        if (bChange) {
+            uint32_t inflight = m_sndNxt - m_sndUna;
+            m_ssthresh = inflight / 2 < RUDP_THRESH_MIN ? RUDP_THRESH_MIN : inflight / 2;
+            m_cwnd = m_ssthresh + m_config.fastresend;
+            m_incr = m_cwnd * mss;
+        }
+        if (bLost) {
+            m_ssthresh = m_cwnd / 2 < RUDP_THRESH_MIN ? RUDP_THRESH_MIN : m_cwnd / 2;
+            m_cwnd = 1;
+            m_incr = mss;
+        }
+        if (m_cwnd < 1) {
+            m_cwnd = 1;
+            m_incr = mss;
+        }
+    }
+
+    // 重传次数过多：链路已断
+    if (bDead) {
+        m_state = RUDP_CLOSED;
+        m_endpoint->Release(this);
+    }
+}
+
+// 写一个段进当前数据报（放不下就先发出当前数据报）
+void CRudpSession::Output(uint8_t cmd, uint8_t frg, uint32_t ts, uint32_t sn,
+    const CIOBuf* data, const char* raw, size_t rawSize)
+{
+    size_t len = data ? data->Size() : rawSize;
+    if (!m_out.empty() && m_out.size() + RUDP_HEADER_SIZE + len > m_config.mtu) OutputFlush();
+
+    if (m_out.empty()) {
+        m_out.resize(RUDP_CONV_SIZE);
+        Put32(m_out.data(), m_conv);
+    }
+    size_t pos = m_out.size();
+    m_out.resize(pos + RUDP_HEADER_SIZE + len);
+    char* p = m_out.data() + pos;
+    p = Put8(p, cmd);
+    p = Put8(p, frg);
+    p = Put16(p, (uint16_t)WndUnused());
+    p = Put32(p, ts);
+    p = Put32(p, sn);
+    p = Put32(p, m_rcvNxt);
+    p = Put16(p, (uint16_t)len);
+    if (data) data->CopyTo(p, 0, len);
+    else if (len > 0) memcpy(p, raw, len);
+}
+
+void CRudpSession::OutputFlush()
+{
+    if (m_out.size() > RUDP_CONV_SIZE) m_endpoint->Output(m_out.data(), m_out.size(), m_addr);
+    m_out.clear();
+}
+
+// ==================== CRudpEndpoint ====================
+uint32_t CRudpEndpoint::Clock()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+CRudpEndpoint::CRudpEndpoint()
+{
+    m_injector = NULL;
+    m_bServer = false;
+    m_seed = Clock() ^ ((uint32_t)getpid() << 16) ^ 0x5A5A5A5Au;
+    if (m_seed == 0) m_seed = 1;
+}
+
+CRudpEndpoint::~CRudpEndpoint()
+{
+    Close();
+}
+
+int CRudpEndpoint::Init(const CSockParam& param, const RudpConfig& config)
+{
+    if (m_socket != -1) return -1;
+
+    m_config = config;
+    if (m_config.mtu > UDP_SLOT_SIZE) m_config.mtu = UDP_SLOT_SIZE;
+    if (m_config.mtu < RUDP_CONV_SIZE + RUDP_HEADER_SIZE + RUDP_SACK_MAX * 8) {
+        m_config.mtu = RUDP_CONV_SIZE + RUDP_HEADER_SIZE + RUDP_SACK_MAX * 8;
+    }
+    if (m_config.rcvwnd < RUDP_FRAGMENT_MAX) m_config.rcvwnd = RUDP_FRAGMENT_MAX;  // 最大消息要能收齐
+    if (m_config.interval == 0) m_config.interval = 1;
+
+    // 服务器（SOCK_ISSERVER）绑定端口并接受SYN；客户端不绑定，第一次发送时内核自动分配端口
+    // SOCK_ISBLOCK：本仓库的Init里这个标志是设置O_NONBLOCK，事件循环需要非阻塞
+    CSockParam p = param;
+    p.attr |= SOCK_ISBLOCK;
+    if (m_socket.Init(p) != 0) return -2;
+    if (m_socket.Link() != 0) return -2;
+    m_bServer = (param.attr & SOCK_ISSERVER) != 0;
+
+    if (m_recvBatch.Create(UDP_BATCH_SIZE, UDP_SLOT_SIZE) != 0) return -3;
+    if (m_sendBatch.Create(UDP_BATCH_SIZE, UDP_SLOT_SIZE) != 0) return -3;
+    return 0;
+}
+
+void CRudpEndpoint::Close()
+{
+    if (m_socket == -1) return;
+
+    m_sessions.ForEach([](uint32_t, CRudpSession* session) { session->Close(); });  // 通知对方
+    SendPending();
+    ReleaseDead();
+    m_sessions.ForEach([](uint32_t, CRudpSession* session) { delete session; });  // 正常不会剩下
+    m_sessions.Clear();   // 退休的会话也在这里释放：关闭时其他线程不能再Find
+    m_delayed.clear();
+    m_socket.Close();
+}
+
+int CRudpEndpoint::Attach(CEpoll& epoll)
+{
+    if (m_socket == -1) return -1;
+    return epoll.Add(m_socket, EpollData((void*)this), EPOLLIN);
+}
+
+uint32_t CRudpEndpoint::NewConv()
+{
+    while (true) {
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        if (m_seed != 0 && m_sessions.Find(m_seed) == NULL) return m_seed;
+    }
+}
+
+CRudpSession* CRudpEndpoint::Connect(const sockaddr_in& to)
+{
+    if (m_socket == -1) return NULL;
+
+    uint32_t now = Clock();
+    CRudpSession* session = new CRudpSession(this, NewConv(), to, m_config, now);
+    session->m_state = RUDP_SYN_SENT;
+    session->m_bDirty = true;
+    m_sessions.Insert(session->m_conv, to, session);
+    return session;
+}
+
+void CRudpEndpoint::OnReadable()
+{
+    uint32_t now = Clock();
+    std::vector<CRudpSession*> touched;
+
+    while (true) {
+        int n = m_socket.RecvBatch(m_recvBatch);
+        if (n <= 0) break;
+
+        for (int i = 0; i < n; i++) {
+            const char* data = m_recvBatch.Data(i);
+            size_t size = m_recvBatch.Size(i);
+            if (size < RUDP_CONV_SIZE + RUDP_HEADER_SIZE) continue;
+            uint32_t conv = Get32(data);
+
+            // 按连接ID找会话（不看地址）
+            const sockaddr_in& from = m_recvBatch.Addr(i);
+            CRudpSession* session = m_sessions.Find(conv);
+            if (session == NULL) {
+                // 新连接：只有服务器接受，且第一个段必须是SYN
+                if (!m_bServer || conv == 0 || (uint8_t)data[RUDP_CONV_SIZE] != RUDP_CMD_SYN) continue;
+
+                // 按地址兜底：同一个地址上还有旧会话，说明客户端重启后换了连接ID重连，
+                // 旧会话不用再等超时了
+                CRudpSession* old = m_sessions.FindAddr(from);
+                if (old != NULL && old->m_state != RUDP_CLOSED) {
+                    old->m_state = RUDP_CLOSED;
+                    Release(old);
+                }
+
+                session = new CRudpSession(this, conv, from, m_config, now);
+                m_sessions.Insert(conv, from, session);
+                if (OnConnect) OnConnect(session);
+            }
+            if (session->m_state == RUDP_CLOSED) continue;
+
+            int state = session->m_state;
+            if (session->Input(data + RUDP_CONV_SIZE, size - RUDP_CONV_SIZE, now) != 0) continue;
+
+            // 合法的包：地址变了说明NAT重新映射了端口，之后发往新地址
+            if (session->m_addr.sin_addr.s_addr != from.sin_addr.s_addr ||
+                session->m_addr.sin_port != from.sin_port) {
+                m_sessions.Rebind(conv, session->m_addr, from);
+                session->m_addr = from;
+            }
+            if (state == RUDP_SYN_SENT && session->m_state == RUDP_ESTABLISHED && OnConnect) {
+                OnConnect(session);
+            }
+            if (!session->m_bTouched) {
+                session->m_bTouched = true;
+                touched.push_back(session);
+            }
+        }
+        if ((unsigned)n < m_recvBatch.Capacity()) break;  // 没收满，socket里已经没有了
+    }
+
+    // 收完一批立即回ACK（不等下一个定时刷新，降低对方的RTT）
+    for (auto session : touched) {
+        session->m_bTouched = false;
+        session->Flush(now);
+    }
+    SendPending();
+    ReleaseDead();
+}
+
+void CRudpEndpoint::Update()
+{
+    uint32_t now = Clock();
+
+    // 第1步：延迟注入的包到期
+    while (!m_delayed.empty() && Diff(now, m_delayed.begin()->first) >= 0) {
+        Delayed& d = m_delayed.begin()->second;
+        if (m_sendBatch.Add(d.data.data(), d.data.size(), d.to) == -1) {
+            SendPending();
+            m_sendBatch.Add(d.data.data(), d.data.size(), d.to);
+        }
+        m_delayed.erase(m_delayed.begin());
+    }
+
+    // 第2步：各会话的定时器
+    m_sessions.ForEach([this, now](uint32_t, CRudpSession* session) {
+        if (session->m_state == RUDP_CLOSED) return;
+        if (Diff(now, session->m_tsRecv) >= (int32_t)m_config.timeout) {
+            session->m_state = RUDP_CLOSED;  // 太久没有收到任何包
+            Release(session);
+            return;
+        }
+        if (session->m_bDirty || Diff(now, session->m_tsFlush) >= 0) session->Flush(now);
+    });
+
+    SendPending();
+    ReleaseDead();
+}
+
+int CRudpEndpoint::NextTimeout() const
+{
+    int timeout = (int)m_config.interval;
+    if (!m_delayed.empty()) {
+        int32_t wait = Diff(m_delayed.begin()->first, Clock());
+        if (wait < timeout) timeout = wait < 0 ? 0 : wait;
+    }
+    return timeout;
+}
+
+void CRudpEndpoint::Output(const char* data, size_t size, const sockaddr_in& to)
+{
+    // 丢包/延迟注入
+    if (m_injector != NULL) {
+        if (m_injector->Drop()) return;
+        unsigned delay = m_injector->Delay();
+        if (delay > 0) {
+            Delayed d;
+            d.data.assign(data, size);
+            d.to = to;
+            m_delayed.insert(std::make_pair(Clock() + delay, std::move(d)));
+            return;
+        }
+    }
+
+    // 攒进批量发送缓冲，满了先发一批
+    if (m_sendBatch.Add(data, size, to) == -1) {
+        SendPending();
+        m_sendBatch.Add(data, size, to);
+    }
+}
+
+void CRudpEndpoint::SendPending()
+{
+    if (m_sendBatch.Count() == 0) return;
+    m_socket.SendBatch(m_sendBatch);  // 发不出去的当作丢包，由重传处理
+    m_sendBatch.Clear();
+}
+
+void CRudpEndpoint::Release(CRudpSession* session)
+{
+    if (session->m_bReleased) return;
+    session->m_bReleased = true;
+    m_dead.push_back(session);
+}
+
+void CRudpEndpoint::ReleaseDead()
+{
+    // 遍历m_sessions时不能erase，所以关闭的会话集中到这里摘掉
+    // 其他线程可能刚Find到它：不直接delete，退休给CConnEpoch，读线程的guard都离开后才释放
+    for (size_t i = 0; i < m_dead.size(); i++) {
+        CRudpSession* session = m_dead[i];
+        m_sessions.Erase(session->m_conv, session->m_addr);
+        if (OnDisconnect) OnDisconnect(session);
+        m_sessions.Retire(session, DeleteSession);
+    }
+    m_dead.clear();
+    m_sessions.Reclaim();
+}
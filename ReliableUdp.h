@@ -0,0 +1,347 @@
+#pragma once
+#include "Socket.h"
+#include "Epoll.h"
+#include "IOBuf.h"
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "ConnTable.h"
+#include <map>
+#include <functional>
+
+// ============================================
+// 可靠UDP（KCP风格的ARQ）
+//
+// 问题：TCP一个包丢了，后面所有包都要等它重传（队头阻塞），
+//      丢包链路上战斗延迟抖动很大；CUdpSocket只是裸数据报，没有会话
+//
+// 做法：
+//   1. 一个服务器只用一个UDP socket（CRudpEndpoint），会话按连接ID区分，
+//      而不是按地址（NAT重绑定后地址变了，连接ID不变，会话继续）
+//      分派用CConnTable：连接ID表 + 地址表，其他线程可以不加锁地Find
+//   2. 两种通道：
+//      RUDP_RELIABLE  可靠有序：序号 + 累计确认(una) + 选择确认(SACK) + 超时/快速重传
+//      RUDP_SEQUENCED 不可靠有序：不重传，过期的包（序号比已收到的旧）直接丢弃
+//                     适合位置同步这类"只要最新的"数据
+//   3. 拥塞控制可配置：关闭时只受收发窗口限制（低延迟），打开时慢启动 + AIMD
+//   4. 挂在CEpoll上：socket可读时OnReadable()，每轮循环调用Update()
+//   5. CLossInjector在发送端模拟丢包/延迟/抖动，回环上就能测试
+//
+// 数据报格式（小端）：
+//   ┌──────────┬──────────┬──────────┬─────┐
+//   │ conv(4)  │  段1     │  段2     │ ... │   conv：连接ID，一个数据报可以带多个段
+//   └──────────┴──────────┴──────────┴─────┘
+// 段头（18字节）：
+//   cmd(1) frg(1) wnd(2) ts(4) sn(4) una(4) len(2) + 数据(len)
+//   cmd：段类型；frg：分片倒数（0=消息最后一片）；wnd：接收窗口剩余
+//   ts：发送时间（ACK里是回显的时间，用来算RTT）；sn：序号；una：对方下一个期望的序号
+// ============================================
+
+// 通道
+enum RudpChannel {
+    RUDP_RELIABLE = 0,    // 可靠有序
+    RUDP_SEQUENCED = 1,   // 不可靠有序
+};
+
+// 会话状态
+enum RudpState {
+    RUDP_SYN_SENT = 0,    // 客户端已发SYN，等SYNACK
+    RUDP_ESTABLISHED = 1, // 已建立
+    RUDP_CLOSED = 2,      // 已关闭（对方FIN、超时、重传次数过多）
+};
+
+#define RUDP_HEADER_SIZE 18      // 段头
+#define RUDP_CONV_SIZE 4         // 数据报头（连接ID）
+#define RUDP_SACK_MAX 8          // 一个ACK最多带几个SACK区间
+#define RUDP_FRAGMENT_MAX 128    // 一条可靠消息最多分几片
+#define RUDP_PING_INTERVAL 1000  // 空闲多久发一次心跳（毫秒）
+
+// 会话参数
+struct RudpConfig {
+    unsigned interval;     // 定时刷新间隔（毫秒）
+    unsigned mtu;          // 数据报最大长度（不含IP/UDP头）
+    unsigned sndwnd;       // 发送窗口（段数）
+    unsigned rcvwnd;       // 接收窗口（段数）
+    unsigned fastresend;   // 被跳过几次ACK就快速重传（0=关闭）
+    unsigned minrto;       // 最小重传超时（毫秒）
+    unsigned deadlink;     // 一个段重传多少次判定断线
+    unsigned timeout;      // 多久没收到任何包判定断线（毫秒）
+    bool nodelay;          // 超时后RTO×1.5而不是×2
+    bool congestion;       // 是否启用拥塞控制
+
+    // 默认：低延迟配置（类似KCP的极速模式）
+    RudpConfig() {
+        interval = 10;
+        mtu = 1200;
+        sndwnd = 256;
+        rcvwnd = 256;
+        fastresend = 2;
+        minrto = 30;
+        deadlink = 20;
+        timeout = 10000;
+        nodelay = true;
+        congestion = false;
+    }
+};
+
+// 会话统计
+struct RudpStats {
+    uint64_t sentSegments;   // 发出的数据段（含重传）
+    uint64_t timeouts;       // 超时重传次数
+    uint64_t fastResends;    // 快速重传次数
+    uint64_t dropped;        // 丢弃的不可靠有序包（过期）
+    unsigned srtt;           // 平滑RTT（毫秒）
+    unsigned rto;            // 当前重传超时（毫秒）
+    unsigned cwnd;           // 拥塞窗口（段数）
+    unsigned inflight;       // 已发未确认的段数
+};
+
+class CRudpEndpoint;
+
+// ============================================
+// CLossInjector类：丢包/延迟注入（测试用）
+// 挂在CRudpEndpoint的发送出口上：按概率丢弃，其余延迟 latency±jitter 毫秒后发出
+// ============================================
+class CLossInjector
+{
+public:
+    CLossInjector() { m_loss = 0; m_latency = 0; m_jitter = 0; m_seed = 0x9E3779B9u; }
+
+    // loss：丢包率（0~1）；latency/jitter：单向延迟和抖动（毫秒）
+    void Set(double loss, unsigned latency, unsigned jitter) {
+        m_loss = loss;
+        m_latency = latency;
+        m_jitter = jitter;
+    }
+
+    bool Drop() { return m_loss > 0 && (Random() % 10000) < (uint32_t)(m_loss * 10000); }
+    unsigned Delay() {
+        if (m_jitter == 0) return m_latency;
+        return m_latency + Random() % (2 * m_jitter + 1) - m_jitter;
+    }
+
+private:
+    uint32_t Random() {  // xorshift32
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+private:
+    double m_loss;
+    unsigned m_latency;
+    unsigned m_jitter;
+    uint32_t m_seed;
+};
+
+// ============================================
+// CRudpSession类：一个可靠UDP会话（ARQ状态机）
+// 由CRudpEndpoint创建和释放，业务层只调用Send/Close/查询
+// ============================================
+class CRudpSession
+{
+public:
+    // 发送一条消息
+    // RUDP_RELIABLE：自动分片（最多RUDP_FRAGMENT_MAX片）
+    // RUDP_SEQUENCED：必须能放进一个段（Mss()字节以内）
+    // 返回值：0成功，-1会话已关闭，-2消息太大，-3通道错误
+    int Send(const char* data, size_t size, int channel = RUDP_RELIABLE);
+    int Send(const CIOBuf& data, int channel = RUDP_RELIABLE);
+
+    // 主动关闭（通知对方，之后由endpoint回调OnDisconnect并释放）
+    void Close();
+
+    uint32_t Conv() const { return m_conv; }
+    int State() const { return m_state; }
+    const sockaddr_in& Addr() const { return m_addr; }   // 对端当前地址（NAT重绑定后会更新）
+    size_t Mss() const { return m_mss; }                  // 一个段最多带多少数据
+    size_t WaitSend() const { return m_sndQueue.size() + m_sndBuf.size(); }  // 待确认的段数
+    RudpStats Stats() const;
+
+    void* user;   // 业务层自己的数据
+
+private:
+    friend class CRudpEndpoint;
+
+    CRudpSession(CRudpEndpoint* endpoint, uint32_t conv, const sockaddr_in& addr,
+        const RudpConfig& config, uint32_t now);
+    ~CRudpSession() {}
+
+    // 一个段（发送队列/接收缓冲里的元素）
+    struct Segment {
+        uint8_t cmd;
+        uint8_t frg;
+        uint32_t sn;
+        uint32_t ts;
+        uint32_t resendts;   // 下次超时重传的时间
+        uint32_t rto;
+        uint32_t fastack;    // 被后面的段的ACK跳过的次数
+        uint32_t xmit;       // 已发送次数
+        CIOBuf data;
+    };
+
+    // 收到一个数据报（已去掉conv），返回0成功，负数格式错误
+    int Input(const char* data, size_t size, uint32_t now);
+    // 发出ACK、新数据、重传、不可靠包
+    void Flush(uint32_t now);
+
+    void ParseUna(uint32_t una);
+    void ParseSack(const char* data, size_t size, uint32_t* maxack, bool* bMaxack);
+    void ParseData(Segment& seg);
+    void UpdateRtt(int32_t rtt);
+    void Deliver();
+    unsigned WndUnused() const;
+
+    // 把段写进当前数据报，满了就交给endpoint发出
+    void Output(uint8_t cmd, uint8_t frg, uint32_t ts, uint32_t sn, const CIOBuf* data,
+        const char* raw = NULL, size_t rawSize = 0);
+    void OutputFlush();
+
+private:
+    CRudpEndpoint* m_endpoint;
+    RudpConfig m_config;
+    uint32_t m_conv;
+    int m_state;
+    sockaddr_in m_addr;
+    size_t m_mss;
+
+    // 发送端
+    uint32_t m_sndUna;     // 最早未确认的序号
+    uint32_t m_sndNxt;     // 下一个要发的序号
+    uint32_t m_rmtWnd;     // 对方接收窗口
+    uint32_t m_cwnd;       // 拥塞窗口
+    uint32_t m_ssthresh;
+    uint32_t m_incr;       // 拥塞避免阶段的字节计数
+    std::deque<Segment> m_sndQueue;  // 还没进窗口的段
+    std::deque<Segment> m_sndBuf;    // 已发未确认的段（按序号排列）
+    std::deque<CIOBuf> m_unreliable; // 待发的不可靠有序包
+    uint32_t m_useqSnd;    // 不可靠有序通道的发送序号
+
+    // 接收端
+    uint32_t m_rcvNxt;     // 下一个期望的序号
+    std::deque<Segment> m_rcvBuf;    // 乱序到达的段（按序号排列）
+    std::deque<Segment> m_rcvQueue;  // 已按序、等待重组的段
+    uint32_t m_useqRcv;    // 不可靠有序通道已收到的最大序号
+    bool m_bUseqInit;
+
+    // ACK
+    bool m_bAck;           // 有待发的ACK
+    uint32_t m_ackTs;      // 回显给对方的时间戳
+
+    // 握手
+    bool m_bSynAck;        // 服务器：有待发的SYNACK
+    uint32_t m_synTs;      // 服务器：回显SYN的时间戳
+    uint32_t m_tsSyn;      // 客户端：下次重发SYN的时间
+
+    // RTT
+    int32_t m_srtt;
+    int32_t m_rttvar;
+    uint32_t m_rto;
+
+    // 时间
+    uint32_t m_tsFlush;    // 下次定时刷新
+    uint32_t m_tsRecv;     // 最后一次收到包
+    uint32_t m_tsSend;     // 最后一次发包（心跳用）
+    bool m_bDirty;         // 有新数据要发（下一次Update立即刷新）
+    bool m_bTouched;       // 本批收到过包（OnReadable结束时立即刷新ACK）
+    bool m_bReleased;      // 已交给endpoint释放
+
+    RudpStats m_stats;
+    std::vector<char> m_out;   // 正在拼的数据报
+};
+
+// ============================================
+// CRudpEndpoint类：一个UDP socket + 它上面的所有会话
+//
+// 用法（服务器）：
+//   CRudpEndpoint server;
+//   server.Init(CSockParam("0.0.0.0", 7000, SOCK_ISSERVER));
+//   server.OnMessage = [](CRudpSession* s, int channel, const char* data, size_t size) {...};
+//   server.Attach(epoll);
+//   while (...) {
+//       int n = epoll.WaitEvents(events, server.NextTimeout());
+//       for (...) if (events[i].data.ptr == &server) server.OnReadable();
+//       server.Update();
+//   }
+// 客户端：Init(CSockParam("0.0.0.0", 0, 0)) 后 Connect(服务器地址)
+//   不带SOCK_ISSERVER的endpoint不绑定端口（第一次发送时内核分配），也不接受新的SYN
+// ============================================
+class CRudpEndpoint
+{
+public:
+    CRudpEndpoint();
+    ~CRudpEndpoint();
+    CRudpEndpoint(const CRudpEndpoint&) = delete;
+    CRudpEndpoint& operator=(const CRudpEndpoint&) = delete;
+
+    // 创建socket（总是非阻塞）
+    // 返回值：0成功，-1已初始化，-2socket初始化失败，-3批量缓冲区分配失败
+    int Init(const CSockParam& param, const RudpConfig& config = RudpConfig());
+    void Close();
+
+    // 注册到epoll（data.ptr = this）
+    int Attach(CEpoll& epoll);
+
+    // 客户端：发起连接（连接ID随机生成），返回会话，失败返回NULL
+    // 连接建立后回调OnConnect；在此之前Send的数据会排队
+    CRudpSession* Connect(const sockaddr_in& to);
+
+    // socket可读：批量收包并分发给会话
+    void OnReadable();
+
+    // 驱动定时器：超时重传、心跳、断线检测、延迟注入的包到期发出
+    // 每轮事件循环调用一次
+    void Update();
+
+    // 距离下一次需要Update的毫秒数（给WaitEvents当超时）
+    int NextTimeout() const;
+
+    // 丢包/延迟注入（NULL关闭）
+    void SetInjector(CLossInjector* injector) { m_injector = injector; }
+
+    size_t Count() const { return m_sessions.Count(); }
+
+    // 按连接ID查会话（可以在其他线程调用，不加锁）
+    // 其他线程必须先持有CConnGuard：guard期间返回的指针不会被释放（会话可能已关闭，State()可查）
+    //   { CConnGuard guard; CRudpSession* s = endpoint.Find(conv); ... }
+    CRudpSession* Find(uint32_t conv) const { return m_sessions.Find(conv); }
+    operator int() const { return (int)m_socket; }
+
+    // 事件回调
+    std::function<void(CRudpSession*)> OnConnect;      // 会话建立（服务器：新客户端）
+    std::function<void(CRudpSession*)> OnDisconnect;   // 会话关闭（回调后会话退休，不能再用）
+    std::function<void(CRudpSession*, int channel, const char* data, size_t size)> OnMessage;
+
+    // 毫秒时钟（单调）
+    static uint32_t Clock();
+
+private:
+    friend class CRudpSession;
+
+    // 会话发出一个数据报（经过注入器）
+    void Output(const char* data, size_t size, const sockaddr_in& to);
+    void SendPending();
+    void Release(CRudpSession* session);
+    void ReleaseDead();
+    static void DeleteSession(void* session) { delete (CRudpSession*)session; }
+    uint32_t NewConv();
+
+    // 延迟发送的包
+    struct Delayed {
+        std::string data;
+        sockaddr_in to;
+    };
+
+private:
+    CUdpSocket m_socket;
+    RudpConfig m_config;
+    CUdpBatch m_recvBatch;
+    CUdpBatch m_sendBatch;
+    CConnTable<CRudpSession> m_sessions;   // 连接ID/地址 → 会话
+    std::vector<CRudpSession*> m_dead;     // 本轮关闭的会话（遍历结束后退休）
+    CLossInjector* m_injector;
+    std::multimap<uint32_t, Delayed> m_delayed;  // 到期时间 → 包
+    uint32_t m_seed;
+    bool m_bServer;      // 是否接受新连接
+};
@@ -0,0 +1,149 @@
+#include "RingBuffer.h"
+#include <sys/mman.h>    // mmap, munmap, memfd_create
+#include "BufferPool.h"  // 退化模式的内存从缓冲区池取
+#include <string.h>      // memcpy
+
+CRingBuffer::CRingBuffer()
+{
+    m_data = NULL;
+    m_capacity = 0;
+    m_read = 0;
+    m_write = 0;
+    m_mirrored = false;
+}
+
+// 镜像映射：先占住 2*cap 的地址空间，再把同一个memfd映射到前后两半
+// 成功返回基地址，失败返回NULL
+static char* MapMirror(size_t cap)
+{
+    int fd = memfd_create("ringbuffer", MFD_CLOEXEC);
+    if (fd == -1) return NULL;
+    if (ftruncate(fd, (off_t)cap) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    // 第1步：预留连续的虚拟地址
+    void* base = mmap(NULL, cap * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    // 第2步：前后两半映射同一段物理内存
+    void* lo = mmap(base, cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void* hi = mmap((char*)base + cap, cap, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd);  // 映射建立后fd可以关闭
+    if (lo != base || hi != (char*)base + cap) {
+        munmap(base, cap * 2);
+        return NULL;
+    }
+    return (char*)base;
+}
+
+int CRingBuffer::Create(size_t capacity)
+{
+    if (m_data != NULL) return -1;
+
+    // 向上取整到2的幂（保证取模可以用 & 运算），且不小于一页（镜像映射要求）
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t cap = page;
+    while (cap < capacity) cap <<= 1;
+
+    m_data = MapMirror(cap);
+    m_mirrored = (m_data != NULL);
+    if (m_data == NULL) {
+        // 退化：普通内存（从缓冲区池取，不清零，不碰页）
+        m_data = (char*)CBufferPool::Instance().Alloc(cap);
+        if (m_data == NULL) return -2;
+    }
+    m_capacity = cap;
+    m_read = m_write = 0;
+    return 0;
+}
+
+void CRingBuffer::Close()
+{
+    if (m_data != NULL) {
+        char* p = m_data;
+        m_data = NULL;
+        if (m_mirrored) munmap(p, m_capacity * 2);
+        else CBufferPool::Instance().Free(p, m_capacity);
+    }
+    m_capacity = 0;
+    m_read = m_write = 0;
+    m_mirrored = false;
+}
+
+char* CRingBuffer::Reserve(size_t n)
+{
+    if (m_data == NULL || n > Free()) return NULL;
+
+    size_t pos = m_write & (m_capacity - 1);
+    if (!m_mirrored && pos + n > m_capacity) return NULL;  // 尾部不连续
+    return m_data + pos;
+}
+
+int CRingBuffer::Append(const void* data, size_t n)
+{
+    if (m_data == NULL || n > Free()) return -1;
+    iovec iov[2];
+    int count = WritableVec(iov);
+    const char* src = (const char*)data;
+    for (int i = 0; i < count && n > 0; i++) {
+        size_t len = iov[i].iov_len < n ? iov[i].iov_len : n;
+        memcpy(iov[i].iov_base, src, len);
+        src += len;
+        n -= len;
+        Commit(len);
+    }
+    return 0;
+}
+
+size_t CRingBuffer::PeekSize() const
+{
+    if (m_mirrored) return Size();
+    size_t pos = m_read & (m_capacity - 1);
+    size_t tail = m_capacity - pos;
+    return Size() < tail ? Size() : tail;
+}
+
+void CRingBuffer::Consume(size_t n)
+{
+    if (n > Size()) n = Size();
+    m_read += n;
+    if (m_read == m_write) m_read = m_write = 0;  // 空了就归零
+}
+
+int CRingBuffer::ReadableVec(iovec* iov) const
+{
+    size_t size = Size();
+    if (size == 0) return 0;
+
+    iov[0].iov_base = (void*)Peek();
+    iov[0].iov_len = PeekSize();
+    if (iov[0].iov_len == size) return 1;
+
+    // 普通模式且数据跨尾部：第二段从头开始
+    iov[1].iov_base = m_data;
+    iov[1].iov_len = size - iov[0].iov_len;
+    return 2;
+}
+
+int CRingBuffer::WritableVec(iovec* iov) const
+{
+    size_t free = Free();
+    if (m_data == NULL || free == 0) return 0;
+
+    size_t pos = m_write & (m_capacity - 1);
+    iov[0].iov_base = m_data + pos;
+    if (m_mirrored || pos + free <= m_capacity) {
+        iov[0].iov_len = free;
+        return 1;
+    }
+    iov[0].iov_len = m_capacity - pos;
+    iov[1].iov_base = m_data;
+    iov[1].iov_len = free - iov[0].iov_len;
+    return 2;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <unistd.h>
+#include <sys/uio.h>     // iovec, readv, writev
+#include <sys/types.h>
+#include <stddef.h>
+
+// ============================================
+// CRingBuffer类：每连接的收发环形缓冲区
+//
+// 为什么不用Buffer？
+// 1. Buffer(N)会把N字节全部清零（std::string::resize）
+// 2. 扩容需要realloc + 拷贝
+// 3. 消费头部数据需要erase（整体搬移）
+//
+// 本类的特点：
+// 1. 容量固定（2的幂，页对齐），创建时分配一次，不清零
+// 2. 镜像映射：同一块物理内存映射两次，首尾相接
+//    ┌──────────── cap ────────────┬──────────── cap ────────────┐
+//    │ 物理页 0..N                  │ 同样的物理页 0..N（镜像）    │
+//    └─────────────────────────────┴─────────────────────────────┘
+//    所以任意位置开始的 cap 字节都是连续的，Peek()/Reserve()无需拼接
+// 3. 镜像映射失败时退化为普通内存，这时读写区域可能分成两段，
+//    通过 ReadableVec()/WritableVec() 得到 iovec 交给 readv/writev
+//
+// 用法（reserve/commit/consume）：
+//   CRingBuffer ring;
+//   ring.Create(64 * 1024);
+//   char* p = ring.Reserve(n);   // 取得可写区域
+//   memcpy(p, data, n);
+//   ring.Commit(n);              // 提交写入
+//   write(fd, ring.Peek(), ring.Size());
+//   ring.Consume(ring.Size());   // 消费已处理的数据
+// ============================================
+class CRingBuffer
+{
+public:
+    CRingBuffer();
+    ~CRingBuffer() { Close(); }
+
+    // 禁止拷贝（持有映射内存）
+    CRingBuffer(const CRingBuffer&) = delete;
+    CRingBuffer& operator=(const CRingBuffer&) = delete;
+
+    // 创建缓冲区
+    // capacity：期望容量，会向上取整到 2 的幂且不小于一页
+    // 返回值：0成功，-1已创建，-2内存分配失败
+    int Create(size_t capacity);
+
+    // 释放缓冲区
+    void Close();
+
+    // -------------------- 容量查询 --------------------
+    size_t Capacity() const { return m_capacity; }
+    size_t Size() const { return m_write - m_read; }       // 可读字节数
+    size_t Free() const { return m_capacity - Size(); }    // 可写字节数
+    bool Empty() const { return m_write == m_read; }
+    bool IsMirrored() const { return m_mirrored; }
+    bool IsValid() const { return m_data != NULL; }
+
+    // -------------------- 写入端 --------------------
+
+    // 取得至少 n 字节的连续可写区域
+    // 返回值：可写指针；空间不足（或非镜像模式下尾部不连续）返回NULL
+    char* Reserve(size_t n);
+
+    // 提交 n 字节（必须 <= Free()）
+    void Commit(size_t n) { m_write += n; }
+
+    // 追加数据（内部 Reserve + memcpy + Commit，支持跨尾部）
+    // 返回值：0成功，-1空间不足
+    int Append(const void* data, size_t n);
+
+    // -------------------- 读取端 --------------------
+
+    // 可读数据起始地址
+    // 镜像模式：Size()字节全部连续
+    // 普通模式：只保证第一段连续，长度见 PeekSize()
+    const char* Peek() const { return m_data + (m_read & (m_capacity - 1)); }
+    size_t PeekSize() const;
+
+    // 消费 n 字节（必须 <= Size()）
+    void Consume(size_t n);
+
+    // -------------------- iovec接口（给readv/writev用） --------------------
+
+    // 可读区域 → iov[0..1]，返回段数（0表示空）
+    int ReadableVec(iovec* iov) const;
+
+    // 可写区域 → iov[0..1]，返回段数（0表示满）
+    int WritableVec(iovec* iov) const;
+
+private:
+    char* m_data;         // 数据区（镜像模式下长度为 2 * m_capacity 的映射）
+    size_t m_capacity;    // 容量（2的幂）
+    size_t m_read;        // 读位置（单调递增，用时取模）
+    size_t m_write;       // 写位置（单调递增，用时取模）
+    bool m_mirrored;      // 是否镜像映射
+};
@@ -0,0 +1,201 @@
+#include "SessionManager.h"
+#include <time.h>
+
+// ==================== 构造/析构 ====================
+CSessionManager::CSessionManager()
+{
+    m_mask = 0;
+    m_cursor = 0;
+    m_start = 0;
+    m_now = 0;
+    m_tick = 0;
+    m_idleTimeout = 0;
+    m_heartbeat = 0;
+    m_count = 0;
+}
+
+CSessionManager::~CSessionManager()
+{
+    Close();
+}
+
+uint64_t CSessionManager::Clock()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);  // 不进内核，精度几毫秒，够超时用
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int CSessionManager::Init(unsigned idleTimeout, unsigned heartbeat, unsigned tick)
+{
+    if (!m_wheel.empty()) return -1;
+    if (idleTimeout == 0 || tick == 0) return -2;
+
+    // 槽数：跨度覆盖最长的超时（+2：向上取整的刻度和当前刻度），取2的幂
+    unsigned longest = idleTimeout > heartbeat ? idleTimeout : heartbeat;
+    uint64_t span = longest / tick + 2;
+    uint64_t slots = 16;
+    while (slots < span) slots <<= 1;
+
+    m_wheel.assign(slots, NULL);
+    m_mask = slots - 1;
+    m_tick = tick;
+    m_idleTimeout = idleTimeout;
+    m_heartbeat = heartbeat;
+    m_start = Clock();
+    m_now = m_start;
+    m_cursor = 0;
+    return 0;
+}
+
+void CSessionManager::Close()
+{
+    CSessionSlab& slab = CSessionSlab::Instance();
+    for (size_t i = 0; i < m_wheel.size(); i++) {
+        CSession* s = m_wheel[i];
+        while (s != NULL) {
+            CSession* next = s->next;
+            slab.Destroy(s);
+            s = next;
+        }
+    }
+    m_wheel.clear();
+    m_count = 0;
+}
+
+// ==================== 会话 ====================
+CSession* CSessionManager::Add(CSocketBase* socket, void* user)
+{
+    if (m_wheel.empty()) return NULL;
+
+    CSessionSlab& slab = CSessionSlab::Instance();
+    CSession* s = slab.Create();
+    if (s == NULL) return NULL;
+
+    m_now = Clock();
+    s->handle = slab.Handle(s);
+    s->socket = socket;
+    s->user = user;
+    s->lastRecv = m_now;
+    s->lastSend = m_now;
+    s->prev = NULL;
+    s->next = NULL;
+    s->deadline = 0;
+    s->linked = false;
+    Schedule(s);
+    m_count++;
+    return s;
+}
+
+void CSessionManager::Remove(CSession* session)
+{
+    if (session == NULL) return;
+    Unlink(session);
+    m_count--;
+    CSessionSlab::Instance().Destroy(session);
+}
+
+// ==================== 时间轮 ====================
+// 下次检查的时间 = min(空闲超时, 心跳)，换算成刻度（向上取整）
+void CSessionManager::Schedule(CSession* session)
+{
+    uint64_t deadline = session->lastRecv + m_idleTimeout;
+    if (m_heartbeat > 0 && session->lastSend + m_heartbeat < deadline) {
+        deadline = session->lastSend + m_heartbeat;
+    }
+    uint64_t tick = deadline > m_start ? (deadline - m_start + m_tick - 1) / m_tick : 0;
+    Link(session, tick);
+}
+
+void CSessionManager::Link(CSession* session, uint64_t tick)
+{
+    // 已经过去的刻度放到下一格；超出跨度的放到最后一格（到时候重新挂，正常不会发生）
+    if (tick <= m_cursor) tick = m_cursor + 1;
+    if (tick > m_cursor + m_mask) tick = m_cursor + m_mask;
+
+    CSession*& head = m_wheel[tick & m_mask];
+    session->deadline = tick;
+    session->prev = NULL;
+    session->next = head;
+    if (head != NULL) head->prev = session;
+    head = session;
+    session->linked = true;
+}
+
+void CSessionManager::Unlink(CSession* session)
+{
+    if (!session->linked) return;
+    if (session->prev != NULL) session->prev->next = session->next;
+    else m_wheel[session->deadline & m_mask] = session->next;
+    if (session->next != NULL) session->next->prev = session->prev;
+    session->prev = NULL;
+    session->next = NULL;
+    session->linked = false;
+}
+
+// 定时器到期：超时 / 心跳 / 只是活动过（重新挂）
+void CSessionManager::Expire(CSession* session, std::vector<uint64_t>& expired)
+{
+    if (m_now >= session->lastRecv + m_idleTimeout) {
+        expired.push_back(session->handle);
+        return;
+    }
+    if (m_heartbeat > 0 && m_now >= session->lastSend + m_heartbeat) {
+        m_beats.push_back(session);
+        session->lastSend = m_now;
+    }
+    Schedule(session);
+}
+
+int CSessionManager::Tick()
+{
+    if (m_wheel.empty()) return 0;
+    m_now = Clock();
+
+    // 第1步：走过到期的槽（落后超过一圈时每个槽只走一次）
+    uint64_t target = (m_now - m_start) / m_tick;
+    if (target - m_cursor > m_mask + 1) m_cursor = target - (m_mask + 1);
+
+    m_expired.clear();
+    while (m_cursor < target) {
+        m_cursor++;
+        CSession*& head = m_wheel[m_cursor & m_mask];
+        CSession* s = head;
+        head = NULL;  // 整个链表摘下来，重新挂的不会落回这个槽
+        while (s != NULL) {
+            CSession* next = s->next;
+            s->prev = NULL;
+            s->next = NULL;
+            s->linked = false;
+            Expire(s, m_expired);
+            s = next;
+        }
+    }
+
+    // 第2步：本轮的心跳一批发出
+    if (!m_beats.empty()) {
+        if (OnHeartbeat) {
+            OnHeartbeat(m_beats);
+        }
+        else if (!m_ping.Empty()) {
+            for (size_t i = 0; i < m_beats.size(); i++) {
+                CSocketBase* socket = m_beats[i]->socket;
+                if (socket != NULL && socket->SendAsync(m_ping) == 1) socket->Flush();
+            }
+        }
+        m_beats.clear();
+    }
+
+    // 第3步：超时的会话（回调里可能移除别的会话，所以按句柄再确认一次）
+    int count = 0;
+    for (size_t i = 0; i < m_expired.size(); i++) {
+        CSession* s = Get(m_expired[i]);
+        if (s == NULL) continue;
+        if (OnTimeout) OnTimeout(s);
+        s = Get(m_expired[i]);  // 回调里可能已经Remove
+        if (s != NULL) Remove(s);
+        count++;
+    }
+    m_expired.clear();
+    return count;
+}
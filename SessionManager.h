@@ -0,0 +1,126 @@
+#pragma once
+#include "Socket.h"
+#include "Slab.h"
+#include "IOBuf.h"
+#include <stdint.h>
+#include <vector>
+#include <functional>
+
+// 会话的slab类型编号（句柄高8位，和SocketSlabType不重复）
+#define SESSION_SLAB_TYPE 3
+
+// ============================================
+// CSession：一个连接的存活状态
+// 由CSessionManager分配在slab里，业务层用句柄引用（旧句柄Get()返回NULL）
+// ============================================
+struct CSession
+{
+    uint64_t handle;         // 自己的句柄
+    CSocketBase* socket;     // 连接（管理器不负责释放）
+    void* user;              // 业务层数据
+    uint64_t lastRecv;       // 最后一次收到数据（毫秒）
+    uint64_t lastSend;       // 最后一次发出数据（毫秒）
+
+    // 时间轮链表（管理器内部使用）
+    CSession* prev;
+    CSession* next;
+    uint64_t deadline;       // 下次检查的时间轮刻度
+    bool linked;
+};
+
+typedef CSlab<CSession, SESSION_SLAB_TYPE> CSessionSlab;
+
+// ============================================
+// CSessionManager类：会话表 + 时间轮超时 + 批量心跳
+//
+// 问题：没有任何地方跟踪连接是否还活着；日志服务器的客户端表只置空不删除
+//      10万个大多空闲的连接，每次都遍历一遍检查超时是O(连接数)
+//
+// 做法：
+//   1. 会话放在slab里（连续、句柄带代数），按句柄查找O(1)
+//   2. 每个会话在时间轮上只挂一个定时器：下次需要检查的时间
+//      = min(最后收包 + 空闲超时, 最后发包 + 心跳间隔)
+//   3. 收发数据时只更新时间戳（Touch/Sent），不动时间轮（O(1)，不加锁，不搬链表）
+//      定时器到期时再看时间戳：真的超时 → 回调OnTimeout并移除；
+//      需要心跳 → 放进本轮的心跳批次；都不是 → 按新的时间重新挂上
+//   4. 时间轮的跨度 ≥ 最长的超时，所以一个槽里的会话全部到期，
+//      Tick()只访问到期的会话：O(到期数)，和连接总数无关
+//   5. 心跳每轮一批：有OnHeartbeat回调就整批交给它（比如UDP一次sendmmsg），
+//      没有就把SetPing()的包（共享的CIOBuf，只编码一次）挂到每个连接的发送队列
+//
+// 用法：
+//   CSessionManager sessions;
+//   sessions.Init(30000, 10000);              // 30秒空闲断开，10秒没发过数据就发心跳
+//   sessions.OnTimeout = [](CSession* s) { CSocketBase::Free(s->socket); };
+//   CSession* s = sessions.Add(pClient);
+//   epoll.Add(*pClient, EpollData(s->handle), EPOLLIN);
+//   ...收到数据：sessions.Touch(sessions.Get(ev.data.u64));
+//   ...每轮循环：sessions.Tick();
+// ============================================
+class CSessionManager
+{
+public:
+    CSessionManager();
+    ~CSessionManager();
+    CSessionManager(const CSessionManager&) = delete;
+    CSessionManager& operator=(const CSessionManager&) = delete;
+
+    // idleTimeout：多久没收到数据判定断线；heartbeat：多久没发过数据就发心跳（0=不发）
+    // tick：时间轮刻度（毫秒，超时精度）
+    // 返回值：0成功，-1已初始化，-2参数错误
+    int Init(unsigned idleTimeout = 30000, unsigned heartbeat = 10000, unsigned tick = 100);
+
+    // 关闭：移除全部会话（不回调OnTimeout）
+    void Close();
+
+    // 添加会话，返回NULL表示slab已满
+    CSession* Add(CSocketBase* socket, void* user = NULL);
+
+    // 移除会话（不释放socket）
+    void Remove(CSession* session);
+
+    // 句柄 → 会话（已移除或不是会话句柄返回NULL）
+    CSession* Get(uint64_t handle) const { return CSessionSlab::Instance().Get(handle); }
+
+    // 收到/发出数据（只更新时间戳，O(1)）
+    void Touch(CSession* session) { if (session) session->lastRecv = m_now; }
+    void Sent(CSession* session) { if (session) session->lastSend = m_now; }
+
+    // 推进时间轮：处理到期的会话，发出本轮的心跳批次
+    // 返回值：本轮超时移除的会话数
+    int Tick();
+
+    // 心跳包内容（OnHeartbeat为空时使用）
+    void SetPing(const CIOBuf& ping) { m_ping = ping; }
+
+    size_t Count() const { return m_count; }
+    uint64_t Now() const { return m_now; }   // 最近一次Tick/Add的时间（毫秒）
+
+    // 超时回调：回调返回后会话被移除（在回调里释放socket）
+    std::function<void(CSession*)> OnTimeout;
+    // 心跳回调：本轮需要心跳的全部会话（已记为发送过；回调里不要Remove）
+    std::function<void(std::vector<CSession*>&)> OnHeartbeat;
+
+    // 毫秒时钟（单调，粗粒度）
+    static uint64_t Clock();
+
+private:
+    void Schedule(CSession* session);
+    void Link(CSession* session, uint64_t tick);
+    void Unlink(CSession* session);
+    void Expire(CSession* session, std::vector<uint64_t>& expired);
+
+private:
+    std::vector<CSession*> m_wheel;   // 每个槽一个双向链表
+    uint64_t m_mask;                  // 槽数 - 1
+    uint64_t m_cursor;                // 已处理到的刻度
+    uint64_t m_start;                 // 刻度0对应的时间
+    uint64_t m_now;
+    unsigned m_tick;
+    unsigned m_idleTimeout;
+    unsigned m_heartbeat;
+    size_t m_count;
+    CIOBuf m_ping;
+    std::vector<CSession*> m_beats;   // 本轮的心跳批次（复用，不每轮分配）
+    std::vector<uint64_t> m_expired;  // 本轮超时的会话句柄
+};
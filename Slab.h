@@ -0,0 +1,230 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>      // aligned_alloc, free
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <new>           // placement new
+#include <utility>       // std::forward
+
+// 每个chunk的槽位数（2^8 = 256）
+#define SLAB_CHUNK_SHIFT 8
+#define SLAB_CHUNK_SIZE (1u << SLAB_CHUNK_SHIFT)
+// 最多多少个chunk（256 * 4096 = 100万个对象）
+#define SLAB_MAX_CHUNKS 4096
+// 每线程缓存的空闲槽位数
+#define SLAB_CACHE_SIZE 64
+
+// ============================================
+// 句柄格式（64位，可以直接放进 epoll_data.u64）
+//
+//   63      56 55            32 31                0
+//   ┌─────────┬────────────────┬──────────────────┐
+//   │ 类型(8) │  代数(24)      │   槽位下标(32)    │
+//   └─────────┴────────────────┴──────────────────┘
+//
+// 类型：区分是哪个slab（高8位非0，所以句柄不可能和用户态指针相等）
+// 代数：槽位每分配/释放一次加1，奇数=使用中，偶数=空闲
+//       旧事件里的句柄代数对不上 → Get()返回NULL，不会访问已释放/已复用的对象
+//       Get()只检查查的那一刻：拿到指针之后别的线程Destroy了照样失效，
+//       多线程使用时要保证同一个对象同时只归一个线程（比如EPOLLONESHOT，见CSocketBase::FromHandle）
+// ============================================
+#define SLAB_HANDLE_TYPE(h) ((unsigned)((h) >> 56))
+#define SLAB_HANDLE_GEN(h) ((uint32_t)(((h) >> 32) & 0xFFFFFF))
+#define SLAB_HANDLE_INDEX(h) ((uint32_t)((h) & 0xFFFFFFFF))
+
+// ============================================
+// CSlab模板：按类型分配的对象池
+//
+// 为什么不用new/delete？
+// 1. 连接频繁建立/断开，堆上留下大量碎片
+// 2. 对象分散在堆的各处，遍历连接时缓存命中率低
+// 3. epoll_data里存裸指针：对象释放后fd被复用，
+//    旧事件里的指针会指向已释放的内存
+//
+// 做法：
+// 1. 对象放在按chunk分配的连续槽位里（每chunk 256个）
+// 2. 空闲槽位：每线程一个小缓存 + 全局空闲表（加锁）
+//    本线程释放的槽位优先给本线程复用，大多数情况下不加锁，O(1)
+// 3. 对外用带代数的句柄，而不是指针
+//
+// 用法：
+//   CTcpSocket* p = CSlab<CTcpSocket, 2>::Instance().Create(fd);
+//   uint64_t h = CSlab<CTcpSocket, 2>::Instance().Handle(p);
+//   CTcpSocket* q = CSlab<CTcpSocket, 2>::Instance().Get(h);  // 已释放则为NULL
+//   CSlab<CTcpSocket, 2>::Instance().Destroy(p);
+// ============================================
+template<typename T, unsigned TYPE>
+class CSlab
+{
+public:
+    // 每个类型一个slab（函数内静态变量：第一次使用时构造，线程安全）
+    static CSlab& Instance() {
+        static CSlab slab;
+        return slab;
+    }
+
+    // 分配槽位并构造对象
+    // 返回值：对象指针，槽位耗尽返回NULL
+    template<typename... Args>
+    T* Create(Args&&... args) {
+        uint32_t index = 0;
+        if (!Pop(index)) return NULL;
+
+        Slot* slot = At(index);
+        T* p = new (slot->storage) T(std::forward<Args>(args)...);
+        slot->gen.fetch_add(1, std::memory_order_release);  // 偶→奇：使用中
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        return p;
+    }
+
+    // 析构对象并归还槽位
+    void Destroy(T* p) {
+        if (p == NULL) return;
+        Slot* slot = (Slot*)p;  // storage是第一个成员，地址相同
+        slot->gen.fetch_add(1, std::memory_order_release);  // 奇→偶：先作废句柄
+        p->~T();
+        m_count.fetch_sub(1, std::memory_order_relaxed);
+        Push(slot->index);
+    }
+
+    // 对象 → 句柄
+    uint64_t Handle(const T* p) const {
+        const Slot* slot = (const Slot*)p;
+        uint64_t gen = slot->gen.load(std::memory_order_acquire) & 0xFFFFFF;
+        return ((uint64_t)TYPE << 56) | (gen << 32) | slot->index;
+    }
+
+    // 句柄 → 对象（类型不符、槽位已释放或已被复用都返回NULL）
+    T* Get(uint64_t handle) const {
+        if (SLAB_HANDLE_TYPE(handle) != TYPE) return NULL;
+        uint32_t index = SLAB_HANDLE_INDEX(handle);
+        if ((index >> SLAB_CHUNK_SHIFT) >= SLAB_MAX_CHUNKS) return NULL;
+
+        Slot* chunk = m_chunks[index >> SLAB_CHUNK_SHIFT].load(std::memory_order_acquire);
+        if (chunk == NULL) return NULL;
+        Slot* slot = &chunk[index & (SLAB_CHUNK_SIZE - 1)];
+        uint32_t gen = slot->gen.load(std::memory_order_acquire);
+        if ((gen & 1) == 0) return NULL;                      // 空闲
+        if ((gen & 0xFFFFFF) != SLAB_HANDLE_GEN(handle)) return NULL;  // 已被复用
+        return (T*)slot->storage;
+    }
+
+    // 按内存顺序遍历所有存活对象（同一chunk内连续，缓存友好）
+    // 注意：只能在不会并发Create/Destroy的线程里调用
+    template<typename F>
+    void ForEach(F func) {
+        uint32_t total = m_next.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < total; i++) {
+            Slot* slot = At(i);
+            if (slot->gen.load(std::memory_order_acquire) & 1) {
+                func((T*)slot->storage);
+            }
+        }
+    }
+
+    // 存活对象个数
+    size_t Count() const { return m_count.load(std::memory_order_relaxed); }
+
+    CSlab(const CSlab&) = delete;
+    CSlab& operator=(const CSlab&) = delete;
+
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];  // 对象本体（必须是第一个成员）
+        std::atomic<uint32_t> gen;   // 代数：奇数=使用中
+        uint32_t index;              // 自己的下标
+    };
+
+    // 每线程空闲缓存；线程退出时把剩余槽位还给全局空闲表
+    struct Cache {
+        uint32_t items[SLAB_CACHE_SIZE];
+        unsigned count = 0;
+        ~Cache() {
+            if (count > 0) Instance().PushGlobal(items, count);
+        }
+    };
+
+    CSlab() : m_next(0), m_count(0) {
+        for (unsigned i = 0; i < SLAB_MAX_CHUNKS; i++) m_chunks[i] = NULL;
+    }
+
+    ~CSlab() {
+        // 进程退出：只释放内存，不再析构残留对象（它们的拥有者负责）
+        for (unsigned i = 0; i < SLAB_MAX_CHUNKS; i++) {
+            Slot* chunk = m_chunks[i].load();
+            if (chunk != NULL) free(chunk);
+        }
+    }
+
+    Slot* At(uint32_t index) const {
+        return &m_chunks[index >> SLAB_CHUNK_SHIFT].load(std::memory_order_acquire)
+            [index & (SLAB_CHUNK_SIZE - 1)];
+    }
+
+    static Cache& LocalCache() {
+        static thread_local Cache cache;
+        return cache;
+    }
+
+    // 取一个空闲槽位：本线程缓存 → 全局空闲表（一次取半个缓存） → 新槽位
+    bool Pop(uint32_t& index) {
+        Cache& cache = LocalCache();
+        if (cache.count == 0) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (cache.count < SLAB_CACHE_SIZE / 2 && !m_free.empty()) {
+                cache.items[cache.count++] = m_free.back();
+                m_free.pop_back();
+            }
+            if (cache.count == 0) return Grow(index);
+        }
+        index = cache.items[--cache.count];
+        return true;
+    }
+
+    // 归还槽位：放进本线程缓存，满了就把一半还给全局
+    void Push(uint32_t index) {
+        Cache& cache = LocalCache();
+        if (cache.count == SLAB_CACHE_SIZE) {
+            unsigned half = SLAB_CACHE_SIZE / 2;
+            PushGlobal(&cache.items[half], half);
+            cache.count = half;
+        }
+        cache.items[cache.count++] = index;
+    }
+
+    void PushGlobal(const uint32_t* items, unsigned count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.insert(m_free.end(), items, items + count);
+    }
+
+    // 分配一个全新槽位（调用者持有m_mutex），需要时分配新chunk
+    bool Grow(uint32_t& index) {
+        uint32_t next = m_next.load(std::memory_order_relaxed);
+        uint32_t chunk = next >> SLAB_CHUNK_SHIFT;
+        if (chunk >= SLAB_MAX_CHUNKS) return false;
+
+        if (m_chunks[chunk].load(std::memory_order_relaxed) == NULL) {
+            size_t bytes = sizeof(Slot) * SLAB_CHUNK_SIZE;
+            size_t align = alignof(Slot) < 64 ? 64 : alignof(Slot);  // 按缓存行对齐
+            bytes = (bytes + align - 1) / align * align;
+            Slot* slots = (Slot*)aligned_alloc(align, bytes);
+            if (slots == NULL) return false;
+            for (uint32_t i = 0; i < SLAB_CHUNK_SIZE; i++) {
+                new (&slots[i].gen) std::atomic<uint32_t>(0);
+                slots[i].index = (chunk << SLAB_CHUNK_SHIFT) | i;
+            }
+            m_chunks[chunk].store(slots, std::memory_order_release);
+        }
+        index = next;
+        m_next.store(next + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::atomic<Slot*> m_chunks[SLAB_MAX_CHUNKS];  // chunk表（固定大小，扩容时不搬移）
+    std::atomic<uint32_t> m_next;   // 下一个从未使用过的槽位
+    std::atomic<size_t> m_count;    // 存活对象数
+    std::mutex m_mutex;             // 保护m_free和Grow
+    std::vector<uint32_t> m_free;   // 全局空闲表
+};
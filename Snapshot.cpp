@@ -0,0 +1,207 @@
+#include "Snapshot.h"
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#define SNAPSHOT_SSE2
+#endif
+
+CSnapshotRing::CSnapshotRing()
+{
+    m_entities = 0;
+    m_fields = 0;
+    m_stride = 0;
+    m_words = 0;
+    m_mask = 0;
+    m_current = 0;
+    m_slot = 0;
+}
+
+int CSnapshotRing::Init(uint32_t entities, unsigned fields, unsigned history)
+{
+    if (!m_ticks.empty()) return -1;
+    if (entities == 0 || fields == 0 || fields > SNAPSHOT_FIELDS_MAX || history < 2) return -2;
+
+    unsigned slots = 2;
+    while (slots < history) slots <<= 1;
+
+    m_entities = entities;
+    m_fields = fields;
+    m_stride = ((size_t)entities + 63) & ~(size_t)63;
+    m_words = m_stride / 64;
+    m_mask = slots - 1;
+    // 多一个槽给Decode解码用（校验通过才复制进环，坏包不破坏环里的帧）
+    m_data.assign((size_t)(slots + 1) * fields * m_stride, 0);
+    m_alive.assign((size_t)(slots + 1) * m_words, 0);
+    m_ticks.assign(slots, 0);
+    m_zero.assign(m_stride, 0);
+    m_changed.resize(m_words);
+    return 0;
+}
+
+void CSnapshotRing::CopySlot(size_t dst, long src)
+{
+    size_t columns = (size_t)m_fields * m_stride;
+    if (src < 0) {
+        memset(&m_data[dst * columns], 0, columns * sizeof(uint32_t));
+        memset(Bitmap(dst), 0, m_words * sizeof(uint64_t));
+    }
+    else if ((size_t)src != dst) {
+        memcpy(&m_data[dst * columns], &m_data[(size_t)src * columns], columns * sizeof(uint32_t));
+        memcpy(Bitmap(dst), Bitmap((size_t)src), m_words * sizeof(uint64_t));
+    }
+}
+
+int CSnapshotRing::Begin(uint32_t tick)
+{
+    if (m_ticks.empty()) return -1;
+    if (tick <= m_current) return -2;
+
+    size_t slot = tick & m_mask;
+    CopySlot(slot, m_current != 0 ? (long)m_slot : -1);
+    m_ticks[slot] = tick;
+    m_slot = slot;
+    m_current = tick;
+    m_cache.clear();
+    return 0;
+}
+
+void CSnapshotRing::SetAlive(size_t slot, uint32_t id, bool alive)
+{
+    uint64_t bit = 1ull << (id & 63);
+    if (alive) {
+        Bitmap(slot)[id >> 6] |= bit;
+        return;
+    }
+    Bitmap(slot)[id >> 6] &= ~bit;
+    for (unsigned f = 0; f < m_fields; f++) Column(slot, f)[id] = 0;
+}
+
+// ==================== 编码 ====================
+void CSnapshotRing::Diff(const uint32_t* cur, const uint32_t* base, size_t count, uint64_t* changed)
+{
+    // count是64的倍数：每次处理64个实体，拼成位图的一个字
+    for (size_t w = 0; w < count / 64; w++) {
+        const uint32_t* a = cur + w * 64;
+        const uint32_t* b = base + w * 64;
+        uint64_t bits = 0;
+#ifdef SNAPSHOT_SSE2
+        for (unsigned i = 0; i < 64; i += 4) {
+            __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+            unsigned same = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(eq));   // 每个实体1位
+            bits |= (uint64_t)(~same & 0xF) << i;
+        }
+#else
+        for (unsigned i = 0; i < 64; i++) bits |= (uint64_t)(a[i] != b[i]) << i;
+#endif
+        changed[w] |= bits;
+    }
+}
+
+CIOBuf CSnapshotRing::Encode(uint32_t base)
+{
+    if (m_current == 0) return CIOBuf();
+    if (!Has(base) || base >= m_current) base = 0;   // 全量
+    for (size_t i = 0; i < m_cache.size(); i++) {
+        if (m_cache[i].first == base) return m_cache[i].second;
+    }
+
+    // 第1步：存活位变了的 + 任何一列有差别的实体
+    size_t baseSlot = base & m_mask;
+    const uint64_t* alive = Bitmap(m_slot);
+    for (size_t w = 0; w < m_words; w++) {
+        m_changed[w] = alive[w] ^ (base != 0 ? Bitmap(baseSlot)[w] : 0);
+    }
+    for (unsigned f = 0; f < m_fields; f++) {
+        Diff(Column(m_slot, f), base != 0 ? Column(baseSlot, f) : m_zero.data(), m_stride, m_changed.data());
+    }
+    uint32_t count = 0;
+    for (size_t w = 0; w < m_words; w++) count += (uint32_t)__builtin_popcountll(m_changed[w]);
+
+    // 第2步：逐个编码有变化的实体
+    std::string out;
+    out.reserve(12 + (size_t)count * (2 + m_fields * 2));
+    CBitWriter writer(out);
+    writer.Write(m_current, 32);
+    writer.Write(base, 32);
+    writer.WriteVar(count);
+
+    uint32_t next = 0;   // 上一个实体id + 1
+    for (size_t w = 0; w < m_words; w++) {
+        uint64_t bits = m_changed[w];
+        while (bits != 0) {
+            uint32_t id = (uint32_t)(w * 64 + __builtin_ctzll(bits));
+            bits &= bits - 1;
+            writer.WriteVar(id - next);
+            next = id + 1;
+
+            bool live = (alive[id >> 6] >> (id & 63)) & 1;
+            writer.Write(live ? 1 : 0, 1);
+            if (!live) continue;   // 死亡：解码时清零
+
+            uint32_t mask = 0;
+            for (unsigned f = 0; f < m_fields; f++) {
+                uint32_t old = base != 0 ? Column(baseSlot, f)[id] : 0;
+                if (Column(m_slot, f)[id] != old) mask |= 1u << f;
+            }
+            writer.Write(mask, m_fields);
+            for (unsigned f = 0; f < m_fields; f++) {
+                if ((mask & (1u << f)) == 0) continue;
+                uint32_t old = base != 0 ? Column(baseSlot, f)[id] : 0;
+                uint32_t delta = Column(m_slot, f)[id] - old;
+                writer.WriteVar((delta << 1) ^ (uint32_t)((int32_t)delta >> 31));   // zigzag：小的负数也短
+            }
+        }
+    }
+    writer.Flush();
+
+    CIOBuf result(std::move(out));
+    m_cache.push_back(std::make_pair(base, result));
+    return result;
+}
+
+// ==================== 解码 ====================
+int CSnapshotRing::Decode(const char* data, size_t size)
+{
+    if (m_ticks.empty()) return -4;
+    CBitReader reader(data, size);
+    uint32_t tick = reader.Read(32);
+    uint32_t base = reader.Read(32);
+    uint32_t count = reader.ReadVar();
+    if (reader.Error() || tick == 0 || count > m_entities) return -1;
+    if (tick <= m_current) return -3;
+    if (base != 0 && !Has(base)) return -2;
+
+    // 第1步：基准帧复制到解码槽（环外的最后一个槽；新的一帧的槽可能就是当前帧，先不动）
+    size_t slot = (size_t)m_mask + 1;
+    CopySlot(slot, base != 0 ? (long)(base & m_mask) : -1);
+
+    // 第2步：应用差值（读越界只记标志，最后检查一次）
+    uint32_t next = 0;
+    for (uint32_t k = 0; k < count && !reader.Error(); k++) {
+        uint32_t id = next + reader.ReadVar();
+        if (id < next || id >= m_entities) return -1;
+        next = id + 1;
+
+        if (reader.Read(1) == 0) {
+            SetAlive(slot, id, false);
+            continue;
+        }
+        SetAlive(slot, id, true);
+        uint32_t mask = reader.Read(m_fields);
+        for (unsigned f = 0; f < m_fields; f++) {
+            if ((mask & (1u << f)) == 0) continue;
+            uint32_t zigzag = reader.ReadVar();
+            Column(slot, f)[id] += (zigzag >> 1) ^ (0u - (zigzag & 1));
+        }
+    }
+    if (reader.Error()) return -1;
+
+    // 第3步：整包合法，才写进环
+    slot = tick & m_mask;
+    CopySlot(slot, (long)m_mask + 1);
+    m_ticks[slot] = tick;
+    m_slot = slot;
+    m_current = tick;
+    m_cache.clear();
+    return 0;
+}
@@ -0,0 +1,210 @@
+#pragma once
+#include "IOBuf.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+// 环里默认保留的快照数（2的幂）：客户端确认落后超过这么多帧就只能发全量
+#define SNAPSHOT_HISTORY 32
+// 每个实体最多的字段数（字段掩码用一个uint32_t）
+#define SNAPSHOT_FIELDS_MAX 32
+
+// ============================================
+// CBitWriter / CBitReader：按位读写（低位在前，小端）
+// 64位累加器，满32位才写一次内存；读的时候一次补满
+// ============================================
+class CBitWriter
+{
+public:
+    explicit CBitWriter(std::string& out) : m_out(out), m_acc(0), m_bits(0) {}
+
+    // 写value的低bits位（bits <= 32）
+    void Write(uint32_t value, unsigned bits) {
+        m_acc |= (uint64_t)(value & (uint32_t)((1ull << bits) - 1)) << m_bits;
+        m_bits += bits;
+        if (m_bits >= 32) {
+            char bytes[4] = { (char)m_acc, (char)(m_acc >> 8), (char)(m_acc >> 16), (char)(m_acc >> 24) };
+            m_out.append(bytes, 4);
+            m_acc >>= 32;
+            m_bits -= 32;
+        }
+    }
+
+    // 变长整数：<64 → 7位，<16384 → 16位，否则34位
+    void WriteVar(uint32_t value) {
+        if (value < (1u << 6)) Write(value << 1, 7);
+        else if (value < (1u << 14)) Write((value << 2) | 1, 16);
+        else {
+            Write(3, 2);
+            Write(value, 32);
+        }
+    }
+
+    // 剩下不满32位的部分按字节写出
+    void Flush() {
+        while (m_bits > 0) {
+            m_out.push_back((char)m_acc);
+            m_acc >>= 8;
+            m_bits = m_bits > 8 ? m_bits - 8 : 0;
+        }
+        m_acc = 0;
+    }
+
+private:
+    std::string& m_out;
+    uint64_t m_acc;
+    unsigned m_bits;
+};
+
+class CBitReader
+{
+public:
+    CBitReader(const char* data, size_t size)
+        : m_data((const uint8_t*)data), m_size(size), m_pos(0), m_acc(0), m_bits(0), m_error(false) {}
+
+    // 读bits位（bits <= 32）；数据不够时返回0并记下错误（调用者最后统一检查Error()）
+    uint32_t Read(unsigned bits) {
+        if (m_bits < bits) {
+            while (m_bits <= 56 && m_pos < m_size) {
+                m_acc |= (uint64_t)m_data[m_pos++] << m_bits;
+                m_bits += 8;
+            }
+            if (m_bits < bits) {
+                m_error = true;
+                return 0;
+            }
+        }
+        uint32_t value = (uint32_t)(m_acc & ((1ull << bits) - 1));
+        m_acc >>= bits;
+        m_bits -= bits;
+        return value;
+    }
+
+    uint32_t ReadVar() {
+        if (Read(1) == 0) return Read(6);
+        if (Read(1) == 0) return Read(14);
+        return Read(32);
+    }
+
+    bool Error() const { return m_error; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos;
+    uint64_t m_acc;
+    unsigned m_bits;
+    bool m_error;
+};
+
+// 每个客户端已确认的快照（0 = 还没有，发全量）
+struct CSnapshotClient
+{
+    uint32_t acked;
+    CSnapshotClient() : acked(0) {}
+};
+
+// ============================================
+// CSnapshotRing类：实体状态快照 + 增量编码
+//
+// 问题：没有快照机制，每帧都发全部实体的全部状态；
+//      实测全量是增量的5~10倍（大部分实体、大部分字段这一帧没变）
+//
+// 做法：
+//   1. 字段都是32位（坐标、朝向等由业务层量化成整数），按列存（SoA）：
+//      每个快照 = fields列 × 实体数，加一个存活位图；环里保留最近history帧
+//   2. Begin()开新的一帧时复制上一帧，业务层只写变了的字段
+//   3. 每个客户端记一个"已确认的帧"；编码时和那一帧比较：
+//      a. 按列比较（SSE2一次4个实体），得到"有变化的实体"位图
+//      b. 只编码有变化的实体：id间隔、存活位、字段掩码、每个字段的差值
+//         （zigzag + 变长：小的移动7位，中等16位，其余34位）
+//      确认的帧已经不在环里（或从没确认过）→ 和全0比较，即全量
+//   4. 同一帧、同一基准的编码结果缓存下来：确认到同一帧的客户端共享一个CIOBuf
+//      （配合CBroadcast只编码一次）
+//   5. 客户端用同一个类解码：找到基准帧、复制、应用差值，写成新的一帧
+//
+// 包格式（按位，低位在前）：帧号32 基准帧32 实体数Var {间隔Var 存活1 [掩码F 差值Var...]}...
+//
+// 用法（服务器）：
+//   CSnapshotRing snap;  snap.Init(10000, 8);
+//   每帧：snap.Begin(tick);  snap.Set(id, FIELD_X, x);  snap.SetAlive(id, false); ...
+//         CIOBuf msg = snap.Encode(client.acked);  → 发给客户端
+//   收到确认：snap.Ack(client, tick);
+// 用法（客户端）：
+//   CSnapshotRing view;  view.Init(10000, 8);
+//   收到包：if (view.Decode(data, size) == 0) 回复确认view.Current()
+// ============================================
+class CSnapshotRing
+{
+public:
+    CSnapshotRing();
+    ~CSnapshotRing() {}
+    CSnapshotRing(const CSnapshotRing&) = delete;
+    CSnapshotRing& operator=(const CSnapshotRing&) = delete;
+
+    // entities：实体id的上限；fields：每个实体的字段数；history：保留的帧数（向上取2的幂）
+    // 返回值：0成功，-1已初始化，-2参数错误
+    int Init(uint32_t entities, unsigned fields, unsigned history = SNAPSHOT_HISTORY);
+
+    // 开始新的一帧（复制上一帧）；tick从1开始且必须递增
+    // 返回值：0成功，-1未初始化，-2帧号不递增
+    int Begin(uint32_t tick);
+
+    // 写当前帧（id、field不检查范围）
+    void Set(uint32_t id, unsigned field, uint32_t value) { Column(m_slot, field)[id] = value; }
+    uint32_t* Field(unsigned field) { return Column(m_slot, field); }   // 整列批量写
+    // 死亡的实体字段清零（重生时相对0编码）
+    void SetAlive(uint32_t id, bool alive) { SetAlive(m_slot, id, alive); }
+
+    // 读取当前帧
+    uint32_t Get(uint32_t id, unsigned field) const { return Column(m_slot, field)[id]; }
+    bool Alive(uint32_t id) const { return (Bitmap(m_slot)[id >> 6] >> (id & 63)) & 1; }
+
+    // 历史帧是否还在环里 / 取历史帧的一列（不在返回NULL）
+    bool Has(uint32_t tick) const { return tick != 0 && m_ticks[tick & m_mask] == tick; }
+    const uint32_t* Field(uint32_t tick, unsigned field) const { return Has(tick) ? Column(tick & m_mask, field) : NULL; }
+    uint32_t Current() const { return m_current; }
+
+    // 当前帧相对base帧的增量（base不在环里 → 全量）；本帧写完之后再调用
+    CIOBuf Encode(uint32_t base);
+    CIOBuf Encode(const CSnapshotClient& client) { return Encode(client.acked); }
+
+    // 客户端确认了tick（只前进；已经不在环里的忽略）
+    void Ack(CSnapshotClient& client, uint32_t tick) const {
+        if (tick > client.acked && Has(tick)) client.acked = tick;
+    }
+
+    // 解码一个增量包，写成新的一帧
+    // 返回值：0成功，-1数据错误，-2基准帧不在环里，-3帧号不递增，-4未初始化
+    int Decode(const char* data, size_t size);
+
+private:
+    uint32_t* Column(size_t slot, unsigned field) { return &m_data[(slot * m_fields + field) * m_stride]; }
+    const uint32_t* Column(size_t slot, unsigned field) const { return &m_data[(slot * m_fields + field) * m_stride]; }
+    uint64_t* Bitmap(size_t slot) { return &m_alive[slot * m_words]; }
+    const uint64_t* Bitmap(size_t slot) const { return &m_alive[slot * m_words]; }
+    void SetAlive(size_t slot, uint32_t id, bool alive);
+
+    // 新的一帧：从src复制（src < 0 则清零）
+    void CopySlot(size_t dst, long src);
+
+    // 按列比较cur和base，有差别的实体在changed里置位（或运算）
+    static void Diff(const uint32_t* cur, const uint32_t* base, size_t count, uint64_t* changed);
+
+private:
+    uint32_t m_entities;
+    unsigned m_fields;
+    size_t m_stride;                 // 每列的长度（实体数向上取64的倍数）
+    size_t m_words;                  // 存活位图的uint64_t个数
+    uint32_t m_mask;                 // 帧数 - 1
+    std::vector<uint32_t> m_data;    // [帧][字段][实体]
+    std::vector<uint64_t> m_alive;   // [帧][位图]
+    std::vector<uint32_t> m_ticks;   // 每个槽里的帧号（0=空）
+    std::vector<uint32_t> m_zero;    // 全量编码的基准（一列0）
+    std::vector<uint64_t> m_changed; // 编码时的变化位图（复用）
+    uint32_t m_current;
+    size_t m_slot;
+    std::vector<std::pair<uint32_t, CIOBuf>> m_cache;   // 本帧已编码的 {基准帧, 结果}
+};
@@ -1,4 +1,217 @@
 ﻿#include "Socket.h"
+#include <netinet/udp.h>   // UDP_SEGMENT, UDP_GRO
+#include <stdlib.h>
+#include <sys/sendfile.h>   // sendfile
+#include <linux/errqueue.h> // sock_extended_err（零拷贝完成通知）
+#include <poll.h>           // poll（关闭前等零拷贝完成通知）
+#include <time.h>           // clock_gettime
+
+// 老版本头文件里没有零拷贝相关的定义
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+// ==================== CSocketBase：环形缓冲区收发 ====================
+// 流式socket（Unix域/TCP）共用：readv/writev直接操作ring的内存，没有中间Buffer
+int CSocketBase::Send(CRingBuffer& ring) {
+    if (m_status != 2) return -1;
+
+    iovec iov[2];
+    int count = ring.ReadableVec(iov);
+    if (count == 0) return 0;  // 没有待发数据
+
+    ssize_t ret = writev(m_socket, iov, count);
+    if (ret > 0) ring.Consume((size_t)ret);
+    return (int)ret;
+}
+
+int CSocketBase::Recv(CRingBuffer& ring) {
+    if (m_status != 2) return -1;
+
+    iovec iov[2];
+    int count = ring.WritableVec(iov);
+    if (count == 0) return -2;  // ring已满，调用者应先消费
+
+    ssize_t ret = readv(m_socket, iov, count);
+    if (ret > 0) ring.Commit((size_t)ret);
+    return (int)ret;  // >0:接收字节数, 0:连接关闭, -1:失败
+}
+
+// ==================== CSocketBase：切片链收发 ====================
+int CSocketBase::Send(const CIOBuf& data) {
+    if (m_status != 2) return -1;
+
+    // 第1步：队列里还有积压，直接写会乱序：整条入队，顺手推一把
+    if (!m_output.Empty()) {
+        m_output.Append(data);
+        if (Flush() == -2) return -1;
+        return (int)data.Size();
+    }
+
+    // 第2步：循环writev，短写就TrimStart接着写（切片超过IOBUF_IOV_MAX时也靠这里分批）
+    CIOBuf rest(data);   // 共享块，不拷贝负载
+    while (!rest.Empty()) {
+        iovec iov[IOBUF_IOV_MAX];
+        int count = rest.Gather(iov, IOBUF_IOV_MAX);
+        ssize_t n = writev(m_socket, iov, count);
+        if (n > 0) {
+            rest.TrimStart((size_t)n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // 第3步：写满了：剩下的进发送队列，可写时由Flush接着发
+            m_output.Append(rest);
+            UpdateWriting();
+            break;
+        }
+        return -1;
+    }
+    return (int)data.Size();
+}
+
+int CSocketBase::Recv(CIOBuf& data, size_t max) {
+    if (m_status != 2) return -1;
+
+    char* p = data.Reserve(max);
+    ssize_t ret = read(m_socket, p, max);
+    if (ret > 0) data.Commit((size_t)ret);
+    return (int)ret;  // >0:接收字节数, 0:连接关闭, -1:失败
+}
+
+// ==================== CSocketBase：句柄 ====================
+CSocketBase* CSocketBase::FromHandle(uint64_t handle) {
+    switch (SLAB_HANDLE_TYPE(handle)) {
+    case SOCKET_SLAB_LOCAL: return CLocalSocketSlab::Instance().Get(handle);
+    case SOCKET_SLAB_TCP: return CTcpSocketSlab::Instance().Get(handle);
+    }
+    return NULL;
+}
+
+void CSocketBase::Free(CSocketBase* pSocket) {
+    if (pSocket == NULL) return;
+    switch (SLAB_HANDLE_TYPE(pSocket->m_handle)) {
+    case SOCKET_SLAB_LOCAL:
+        CLocalSocketSlab::Instance().Destroy((CLocalSocket*)pSocket);
+        break;
+    case SOCKET_SLAB_TCP:
+        CTcpSocketSlab::Instance().Destroy((CTcpSocket*)pSocket);
+        break;
+    default:
+        delete pSocket;  // 不是slab分配的
+        break;
+    }
+}
+
+// ==================== CSocketBase：批量设置选项 ====================
+int CSocketBase::SetOptions(const CSockParam& param, bool bTcp) {
+    int on = 1;
+
+    // 第1步：地址/端口复用（bind之前）
+    if (param.attr & SOCK_ISREUSE) {
+        if (setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) == -1) return -1;
+    }
+    if (param.attr & SOCK_ISREUSEPORT) {
+        if (setsockopt(m_socket, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1) return -2;
+    }
+
+    // 第2步：缓冲区（listen之前设置，窗口扩大因子才会按新大小协商）
+    if (param.rcvbuf > 0) {
+        if (setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &param.rcvbuf, sizeof(int)) == -1) return -3;
+    }
+    if (param.sndbuf > 0) {
+        if (setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, &param.sndbuf, sizeof(int)) == -1) return -4;
+    }
+    if (!bTcp) return 0;
+
+    // 第3步：TCP层选项
+    if (param.attr & SOCK_ISNODELAY) {
+        if (setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) == -1) return -5;
+    }
+    if (param.attr & SOCK_ISKEEPALIVE) {
+        if (setsockopt(m_socket, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on)) == -1) return -6;
+        if (param.keepidle > 0)
+            setsockopt(m_socket, IPPROTO_TCP, TCP_KEEPIDLE, &param.keepidle, sizeof(int));
+        if (param.keepintvl > 0)
+            setsockopt(m_socket, IPPROTO_TCP, TCP_KEEPINTVL, &param.keepintvl, sizeof(int));
+        if (param.keepcnt > 0)
+            setsockopt(m_socket, IPPROTO_TCP, TCP_KEEPCNT, &param.keepcnt, sizeof(int));
+    }
+    if ((param.attr & SOCK_ISSERVER) && param.defer_accept > 0) {
+        if (setsockopt(m_socket, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+            &param.defer_accept, sizeof(int)) == -1) return -7;
+    }
+    return 0;
+}
+
+// ==================== CSocketBase：异步发送 ====================
+void CSocketBase::BindEpoll(CEpoll* epoll, const EpollData& data, uint32_t events) {
+    m_pEpoll = epoll;
+    m_epollData = data;
+    m_events = events & ~EPOLLOUT;
+    m_bWriting = (events & EPOLLOUT) != 0;
+}
+
+int CSocketBase::SendAsync(const Buffer& data) {
+    if (m_status != 2) return -1;
+    bool bEmpty = m_output.Empty();
+    m_output.Append(data);
+    return (bEmpty && !m_output.Empty()) ? 1 : 0;
+}
+
+int CSocketBase::SendAsync(Buffer&& data) {
+    if (m_status != 2) return -1;
+    bool bEmpty = m_output.Empty();
+    m_output.Append(std::move(data));
+    return (bEmpty && !m_output.Empty()) ? 1 : 0;
+}
+
+int CSocketBase::SendAsync(const CIOBuf& data) {
+    if (m_status != 2) return -1;
+    bool bEmpty = m_output.Empty();
+    m_output.Append(data);
+    return (bEmpty && !m_output.Empty()) ? 1 : 0;
+}
+
+int CSocketBase::SendAsync(const char* header, size_t headerSize, const CIOBuf& body) {
+    if (m_status != 2) return -1;
+    bool bEmpty = m_output.Empty();
+    m_output.Append(header, headerSize);
+    m_output.Append(body);
+    return (bEmpty && !m_output.Empty()) ? 1 : 0;
+}
+
+int CSocketBase::Flush() {
+    if (m_status != 2) return -1;
+
+    ssize_t ret = m_output.Flush(m_socket);
+    if (ret < 0) return -2;
+
+    // 没写完：打开EPOLLOUT等待可写；写完了：关闭EPOLLOUT，避免空转
+    UpdateWriting();
+    return (int)ret;
+}
+
+void CSocketBase::UpdateWriting() {
+    if (m_pEpoll == NULL) return;
+
+    bool bNeed = !m_output.Empty();
+    if (bNeed == m_bWriting) return;  // 状态没变，不调epoll_ctl
+
+    uint32_t events = bNeed ? (m_events | EPOLLOUT) : m_events;
+    if (m_pEpoll->Modify(m_socket, events, m_epollData) == 0) {
+        m_bWriting = bNeed;
+    }
+}
 
 int CLocalSocket::Init(const CSockParam& param)
 {
@@ -21,7 +234,7 @@ int CLocalSocket::Init(const CSockParam& param)
         if (bind(m_socket, param.addrun(), sizeof(sockaddr_un)) == -1) {
             return -3;
         }
-        if (listen(m_socket, 10) == -1) {
+        if (listen(m_socket, param.backlog) == -1) {
             return -4;
         }
     }
@@ -62,14 +275,21 @@ int CLocalSocket::Link(CSocketBase** pClient) {
         // accept等待客户端连接
         sockaddr_un client_addr;
         socklen_t len = sizeof(client_addr);
-        int client_fd = accept(m_socket, (sockaddr*)&client_addr, &len);
+        // accept4：顺带设置close-on-exec，子进程不会继承客户端连接
+        int client_fd = accept4(m_socket, (sockaddr*)&client_addr, &len, SOCK_CLOEXEC);
 
         if (client_fd == -1) {
             return -3;  // accept失败
         }
 
-        // 创建客户端socket对象（用特殊构造函数）
-        CLocalSocket* new_client = new CLocalSocket(client_fd);
+        // 从对象池取客户端socket对象（用特殊构造函数）
+        CLocalSocketSlab& slab = CLocalSocketSlab::Instance();
+        CLocalSocket* new_client = slab.Create(client_fd);
+        if (new_client == NULL) {
+            close(client_fd);
+            return -3;  // 对象池耗尽
+        }
+        new_client->m_handle = slab.Handle(new_client);
         new_client->m_status = 2;  // 设置为已连接状态
 
         // ✅ 通过双重指针返回客户端对象
@@ -122,6 +342,57 @@ int CLocalSocket::Recv(Buffer& data) {
     // 第3步：返回结果
     return ret;  // >0:接收字节数, 0:连接关闭, -1:失败
 }
+int CLocalSocket::SendFD(int fd, const char* data, size_t size) {
+    if (m_status != 2 || size == 0) return -1;
+
+    // 控制消息里放fd，普通数据至少1字节（否则对方recvmsg分不清是关闭还是传fd）
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+    iovec iov;
+    iov.iov_base = (void*)data;
+    iov.iov_len = size;
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    return (int)sendmsg(m_socket, &msg, MSG_NOSIGNAL);
+}
+
+int CLocalSocket::Recv(CRingBuffer& ring, int& fd) {
+    fd = -1;
+    if (m_status != 2) return -1;
+
+    iovec iov[2];
+    int count = ring.WritableVec(iov);
+    if (count == 0) return -2;
+
+    char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t ret = recvmsg(m_socket, &msg, MSG_CMSG_CLOEXEC);
+    if (ret > 0) {
+        ring.Commit((size_t)ret);
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+            }
+        }
+    }
+    return (int)ret;
+}
+
 int CLocalSocket::Close() {
     // 第1步：状态检查
     if (m_status == 0 || m_status == 3) {
@@ -149,12 +420,15 @@ int CTcpSocket::Init(const CSockParam& param) {
     m_param = param;
 
     // 第3步：选择类型（不变）
-    int type = SOCK_STREAM;
+    int type = SOCK_STREAM | SOCK_CLOEXEC;
 
     // ========== 修改1：地址族改为AF_INET ==========
     m_socket = socket(AF_INET, type, 0);  // ← AF_UNIX → AF_INET
     if (m_socket == -1) return -2;
 
+    // 第4步：一次性设置socket选项（必须在bind/listen之前）
+    if (SetOptions(param, true) != 0) return -5;
+
     // 第5步：服务器绑定+监听
     if (param.attr & SOCK_ISSERVER) {
         // ========== 修改2：不需要unlink ==========
@@ -167,9 +441,14 @@ int CTcpSocket::Init(const CSockParam& param) {
             return -3;
         }
 
-        if (listen(m_socket, 10) == -1) {
+        // backlog可配置：登录高峰时内核队列满了，新的SYN会被丢弃
+        if (listen(m_socket, param.backlog) == -1) {
             return -4;
         }
+
+        // 预留一个空闲fd：fd耗尽时先关掉它腾出位置，accept后立即关闭，
+        // 避免连接一直堆在队列里让epoll反复触发
+        m_idlefd = open("/dev/null", O_RDONLY | O_CLOEXEC);
     }
 
     // 第6步：设置非阻塞（不变）
@@ -193,17 +472,21 @@ int CTcpSocket::Link(CSocketBase * *pClient) {
         // ========== 服务器逻辑 ==========
         if (pClient == NULL) return -2;
 
-        // ========== 修改：使用sockaddr_in ==========
-        sockaddr_in client_addr;  // ← sockaddr_un → sockaddr_in
-        socklen_t len = sizeof(client_addr);
-        int client_fd = accept(m_socket, (sockaddr*)&client_addr, &len);
+        // ========== 修改：accept4，新连接直接是非阻塞的 ==========
+        int client_fd = AcceptOne();
 
         if (client_fd == -1) return -3;
 
-        // ========== 修改：创建CTcpSocket对象 ==========
-        CTcpSocket* new_client = new CTcpSocket(client_fd);
+        // ========== 修改：从CTcpSocket的对象池取对象 ==========
+        CTcpSocketSlab& slab = CTcpSocketSlab::Instance();
+        CTcpSocket* new_client = slab.Create(client_fd);
         //          ↑↑↑↑↑↑↑↑↑
         // CLocalSocket → CTcpSocket
+        if (new_client == NULL) {
+            close(client_fd);
+            return -3;
+        }
+        new_client->m_handle = slab.Handle(new_client);
         new_client->m_status = 2;
 
         *pClient = new_client;
@@ -239,8 +522,263 @@ int CTcpSocket::Recv(Buffer& data) {
     return recv(m_socket, (char*)data.c_str(), data.size(), 0);
 }
 
+// ========== AcceptOne：accept4一个连接 ==========
+int CTcpSocket::AcceptOne() {
+    sockaddr_in client_addr;
+    socklen_t len = sizeof(client_addr);
+    int client_fd = accept4(m_socket, (sockaddr*)&client_addr, &len,
+        SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (client_fd == -1 && (errno == EMFILE || errno == ENFILE) && m_idlefd != -1) {
+        // fd耗尽：用预留fd腾位置，接受后立即关闭（客户端会看到断开并重试）
+        close(m_idlefd);
+        int fd = accept(m_socket, NULL, NULL);
+        if (fd != -1) close(fd);
+        m_idlefd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        errno = EMFILE;
+    }
+    return client_fd;
+}
+
+// ========== LinkBatch：一次事件accept全部积压连接 ==========
+int CTcpSocket::LinkBatch(std::vector<CSocketBase*>& clients, unsigned max) {
+    if (m_status != 1) return -1;
+    if ((m_param.attr & SOCK_ISSERVER) == 0) return -2;
+
+    // 阻塞的监听socket只能accept一次
+    bool bNonBlock = (m_param.attr & SOCK_ISBLOCK) != 0;
+    if (!bNonBlock) max = 1;
+
+    CTcpSocketSlab& slab = CTcpSocketSlab::Instance();
+    unsigned count = 0;
+    while (max == 0 || count < max) {
+        int client_fd = AcceptOne();
+        if (client_fd == -1) {
+            if (errno == EINTR) continue;
+            if (errno == ECONNABORTED) continue;  // 对端已放弃，继续取下一个
+            break;  // EAGAIN：队列已空；其他错误：下次事件再试
+        }
+
+        CTcpSocket* new_client = slab.Create(client_fd);
+        if (new_client == NULL) {
+            close(client_fd);  // 对象池耗尽
+            break;
+        }
+        new_client->m_handle = slab.Handle(new_client);
+        new_client->m_status = 2;
+        clients.push_back(new_client);
+        count++;
+    }
+    return (int)count;
+}
+
+// ========== SendFile：文件 → socket ==========
+int CTcpSocket::SendFile(int fd, off_t& offset, size_t count) {
+    if (m_status != 2) return -1;
+    if (count == 0) return 0;
+
+    ssize_t ret = sendfile(m_socket, fd, &offset, count);  // 内核自动前移offset
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+        return -2;
+    }
+    return (int)ret;
+}
+
+// ========== Splice：任意fd → 管道 → socket ==========
+int CTcpSocket::Splice(int fd, size_t count) {
+    if (m_status != 2) return -1;
+
+    // 第1步：第一次使用时创建管道（非阻塞，两端都不会卡住事件循环）
+    if (m_pipe[0] == -1) {
+        if (pipe2(m_pipe, O_NONBLOCK | O_CLOEXEC) == -1) return -2;
+    }
+
+    size_t taken = 0;
+    while (true) {
+        // 第2步：管道空了才从fd取（先把上次残留的发出去，保证顺序）
+        if (m_pipeBytes == 0) {
+            if (taken >= count) break;
+            ssize_t in = splice(fd, NULL, m_pipe[1], NULL, count - taken,
+                SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (in == 0) break;  // fd已到结尾
+            if (in < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+                return -2;
+            }
+            m_pipeBytes += (size_t)in;
+            taken += (size_t)in;
+        }
+
+        // 第3步：管道 → socket
+        ssize_t out = splice(m_pipe[0], NULL, m_socket, NULL, m_pipeBytes,
+            SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (out < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+            return -2;
+        }
+        m_pipeBytes -= (size_t)out;
+    }
+    return (int)taken;
+}
+
+// ========== 零拷贝发送 ==========
+int CTcpSocket::EnableZeroCopy() {
+    if (m_socket == -1) return -1;
+    int on = 1;
+    if (setsockopt(m_socket, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) == -1) return -2;
+    m_bZeroCopy = true;
+    return 0;
+}
+
+int CTcpSocket::SendZeroCopy(const CIOBuf& data) {
+    if (m_status != 2) return -1;
+    if (data.Empty()) return 0;
+
+    iovec iov[IOBUF_IOV_MAX];
+    int count = data.Gather(iov, IOBUF_IOV_MAX);
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+
+    // 小数据：拷贝反而更便宜
+    bool bZeroCopy = m_bZeroCopy && data.Size() >= ZEROCOPY_MIN_SIZE;
+    ssize_t ret = sendmsg(m_socket, &msg, bZeroCopy ? MSG_ZEROCOPY : 0);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+        if (errno == ENOBUFS && bZeroCopy) return 0;  // 锁定页超过限额：等完成通知后再试
+        return -2;
+    }
+
+    // 成功的零拷贝调用占一个编号；发出的部分要保持到完成通知到达
+    if (bZeroCopy) {
+        ZeroCopySend zc;
+        zc.id = m_zcNext++;
+        zc.data = data.Slice(0, (size_t)ret);
+        m_zcPending.push_back(std::move(zc));
+    }
+    return (int)ret;
+}
+
+int CTcpSocket::ReapZeroCopy() {
+    if (m_socket == -1) return -1;
+    return ReapErrQueue(m_socket, m_zcPending, m_zcCopied);
+}
+
+int CTcpSocket::ReapErrQueue(int fd, std::deque<ZeroCopySend>& pending, uint64_t& copied) {
+    int done = 0;
+    while (true) {
+        char control[128];
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE) == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;  // 错误队列已空
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) continue;
+
+            sock_extended_err* err = (sock_extended_err*)CMSG_DATA(cm);
+            if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+
+            // [lo, hi]这些编号的发送已经完成（编号会回绕，用差值比较）
+            uint32_t lo = err->ee_info, hi = err->ee_data;
+            uint32_t n = hi - lo + 1;
+            if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) copied += n;
+            done += (int)n;
+
+            for (auto it = pending.begin(); it != pending.end();) {
+                if ((int32_t)(it->id - lo) >= 0 && (int32_t)(hi - it->id) >= 0) {
+                    it = pending.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+    }
+    return done;
+}
+
+// ========== 关闭后的零拷贝收尾 ==========
+std::mutex CTcpSocket::s_lingerLock;
+std::vector<CTcpSocket::ZeroCopyLinger> CTcpSocket::s_lingering;
+
+size_t CTcpSocket::ReapLingering() {
+    std::lock_guard<std::mutex> lock(s_lingerLock);
+    for (size_t i = 0; i < s_lingering.size();) {
+        ZeroCopyLinger& linger = s_lingering[i];
+        ReapErrQueue(linger.fd, linger.pending, linger.copied);
+
+        // 连接已彻底断开：发送队列已清空（发完或被丢弃），内核不再引用这些页
+        tcp_info info;
+        socklen_t len = sizeof(info);
+        bool bGone = getsockopt(linger.fd, IPPROTO_TCP, TCP_INFO, &info, &len) == 0 &&
+            info.tcpi_state == TCP_CLOSE;
+        if (linger.pending.empty() || bGone) {
+            close(linger.fd);   // socket到这里才真正释放
+            s_lingering[i] = std::move(s_lingering.back());
+            s_lingering.pop_back();
+            continue;
+        }
+        i++;
+    }
+    return s_lingering.size();
+}
+
 // ========== Close函数（和CLocalSocket完全一样） ==========
 int CTcpSocket::Close() {
+    if (m_idlefd != -1) {
+        close(m_idlefd);
+        m_idlefd = -1;
+    }
+    if (m_pipe[0] != -1) {
+        close(m_pipe[0]);
+        close(m_pipe[1]);
+        m_pipe[0] = m_pipe[1] = -1;
+        m_pipeBytes = 0;
+    }
+    // 还有零拷贝发送没完成：内核可能还在从这些块DMA，不能直接释放（释放了池会重用，发出去的就是脏数据）
+    // 第1步：等一小会儿完成通知（错误队列非空时poll报POLLERR）
+    if (!m_zcPending.empty() && m_socket != -1) {
+        timespec begin, now;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        int waited = 0;
+        while (!m_zcPending.empty() && waited < ZEROCOPY_CLOSE_WAIT) {
+            pollfd pfd = { m_socket, 0, 0 };
+            if (poll(&pfd, 1, ZEROCOPY_CLOSE_WAIT - waited) <= 0) break;
+            if (ReapZeroCopy() <= 0 && !(pfd.revents & POLLERR)) break;   // 只有POLLHUP：不会再有通知
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            waited = (int)((now.tv_sec - begin.tv_sec) * 1000 + (now.tv_nsec - begin.tv_nsec) / 1000000);
+        }
+    }
+    // 第2步：还没等到：fd连同缓冲区一起转交ReapLingering（错误队列还要靠这个fd读）
+    //        shutdown照常发FIN；从绑定的epoll里摘掉，免得旧的EpollData再报事件
+    bool bLinger = false;
+    if (!m_zcPending.empty() && m_socket != -1) {
+        if (m_pEpoll != NULL) m_pEpoll->Del(m_socket);
+        shutdown(m_socket, SHUT_RDWR);
+        std::lock_guard<std::mutex> lock(s_lingerLock);
+        ZeroCopyLinger linger;
+        linger.fd = m_socket;
+        linger.copied = 0;
+        linger.pending.swap(m_zcPending);
+        s_lingering.push_back(std::move(linger));
+        m_socket = -1;
+        bLinger = true;
+    }
+    ReapLingering();
+    if (bLinger) {
+        m_status = 3;
+        return 0;
+    }
     if (m_status == 0 || m_status == 3) return -1;
 
     if (m_socket != -1) {
@@ -265,6 +803,9 @@ int CUdpSocket::Init(const CSockParam& param) {
     m_socket = socket(AF_INET, type, 0);
     if (m_socket == -1) return -2;
 
+    // 地址复用、收发缓冲区（UDP高包率时缓冲区太小会丢包）
+    if (SetOptions(param, false) != 0) return -4;
+
     // ========== UDP服务器也需要bind ==========
     if (param.attr & SOCK_ISSERVER) {
         if (bind(m_socket, param.addrin(), sizeof(sockaddr_in)) == -1) {
@@ -357,4 +898,299 @@ int CUdpSocket::Close() {
 
     m_status = 3;
     return 0;
-}
\ No newline at end of file
+}
+
+// ==================== CUdpSocket：环形缓冲区收发 ====================
+// 一次只收一个数据报，数据报边界由调用者自己记录（返回值就是长度）
+int CUdpSocket::Recv(CRingBuffer& ring) {
+    if (m_status != 2) return -1;
+
+    iovec iov[2];
+    int count = ring.WritableVec(iov);
+    if (count == 0) return -2;
+
+    sockaddr_in from_addr;
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &from_addr;
+    msg.msg_namelen = sizeof(from_addr);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+
+    ssize_t ret = recvmsg(m_socket, &msg, 0);
+    if (ret > 0) ring.Commit((size_t)ret);
+    return (int)ret;
+}
+
+int CUdpSocket::Send(CRingBuffer& ring) {
+    if (m_status != 2) return -1;
+
+    iovec iov[2];
+    int count = ring.ReadableVec(iov);
+    if (count == 0) return 0;
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = m_param.addrin();
+    msg.msg_namelen = sizeof(sockaddr_in);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+
+    ssize_t ret = sendmsg(m_socket, &msg, 0);
+    if (ret > 0) ring.Consume(ring.Size());  // 数据报要么全发要么不发
+    return (int)ret;
+}
+
+// 切片链：所有切片作为一个数据报发出
+int CUdpSocket::Send(const CIOBuf& data) {
+    return Send(data, m_param.addr_in);
+}
+
+// ==================== CUdpSocket：指定对端收发 ====================
+int CUdpSocket::Send(const Buffer& data, const sockaddr_in& to) {
+    if (m_status != 2) return -1;
+    return sendto(m_socket, data.c_str(), data.size(), 0,
+        (const sockaddr*)&to, sizeof(sockaddr_in));
+}
+
+int CUdpSocket::Recv(Buffer& data, sockaddr_in& from) {
+    if (m_status != 2) return -1;
+    if (data.size() == 0) data.resize(UDP_SLOT_SIZE);
+
+    socklen_t len = sizeof(from);
+    int ret = recvfrom(m_socket, (char*)data.c_str(), data.size(), 0,
+        (sockaddr*)&from, &len);
+    if (ret >= 0) data.resize(ret);  // 调整为实际长度
+    return ret;
+}
+
+int CUdpSocket::Send(const CIOBuf& data, const sockaddr_in& to) {
+    if (m_status != 2) return -1;
+
+    iovec iov[IOBUF_IOV_MAX];
+    int count = data.Gather(iov, IOBUF_IOV_MAX);
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = (void*)&to;
+    msg.msg_namelen = sizeof(sockaddr_in);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    return (int)sendmsg(m_socket, &msg, 0);
+}
+
+// ==================== CUdpBatch ====================
+// 控制消息空间：容纳一个 uint16_t（gso_size）即可
+#define UDP_CONTROL_SIZE CMSG_SPACE(sizeof(uint16_t))
+
+CUdpBatch::CUdpBatch() {
+    m_slab = NULL;
+    m_slot = 0;
+    m_capacity = 0;
+}
+
+CUdpBatch::~CUdpBatch() {
+    if (m_slab != NULL) {
+        free(m_slab);
+        m_slab = NULL;
+    }
+}
+
+int CUdpBatch::Create(unsigned count, size_t slot) {
+    if (m_slab != NULL) return -1;
+    if (count == 0 || slot == 0) return -2;
+
+    // malloc不清零：槽位内容总是先写后读
+    m_slab = (char*)malloc(count * slot);
+    if (m_slab == NULL) return -3;
+
+    m_slot = slot;
+    m_capacity = count;
+    m_msgs.resize(count);
+    m_iovs.resize(count);
+    m_addrs.resize(count);
+    m_control.resize(count * UDP_CONTROL_SIZE);
+    m_packets.reserve(count);
+    m_counts.reserve(count);
+    return 0;
+}
+
+int CUdpBatch::Add(const char* data, size_t size, const sockaddr_in& to) {
+    if (m_packets.size() >= m_capacity) return -1;
+    if (size > m_slot) return -2;
+
+    unsigned slot = (unsigned)m_packets.size();
+    memcpy(m_slab + slot * m_slot, data, size);
+    m_addrs[slot] = to;
+    m_packets.push_back({ slot * m_slot, size, slot });
+    return 0;
+}
+
+// ==================== CUdpSocket：GSO/GRO开关 ====================
+int CUdpSocket::SetGso(bool bOn) {
+    if (!bOn) {
+        m_bGso = false;
+        return 0;
+    }
+#ifdef UDP_SEGMENT
+    // 探测内核是否支持：能读到这个选项就说明支持
+    int val = 0;
+    socklen_t len = sizeof(val);
+    if (getsockopt(m_socket, SOL_UDP, UDP_SEGMENT, &val, &len) == 0) {
+        m_bGso = true;
+        return 0;
+    }
+#endif
+    return -2;
+}
+
+int CUdpSocket::SetGro(bool bOn) {
+#ifdef UDP_GRO
+    int val = bOn ? 1 : 0;
+    if (setsockopt(m_socket, SOL_UDP, UDP_GRO, &val, sizeof(val)) == 0) {
+        m_bGro = bOn;
+        return 0;
+    }
+#endif
+    return bOn ? -2 : 0;
+}
+
+// ==================== CUdpSocket：批量接收 ====================
+int CUdpSocket::RecvBatch(CUdpBatch& batch) {
+    if (m_status != 2) return -1;
+    if (batch.m_slab == NULL) return -2;
+    if (m_bGro && batch.m_slot < UDP_GRO_SLOT_SIZE) return -3;  // 会被截断
+
+    // 第1步：每次调用前重置消息头（内核会改写长度字段）
+    for (unsigned i = 0; i < batch.m_capacity; i++) {
+        batch.m_iovs[i].iov_base = batch.m_slab + i * batch.m_slot;
+        batch.m_iovs[i].iov_len = batch.m_slot;
+
+        msghdr& hdr = batch.m_msgs[i].msg_hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = &batch.m_addrs[i];
+        hdr.msg_namelen = sizeof(sockaddr_in);
+        hdr.msg_iov = &batch.m_iovs[i];
+        hdr.msg_iovlen = 1;
+        if (m_bGro) {
+            hdr.msg_control = &batch.m_control[i * UDP_CONTROL_SIZE];
+            hdr.msg_controllen = UDP_CONTROL_SIZE;
+        }
+    }
+
+    // 第2步：一次系统调用收多个数据报（MSG_WAITFORONE：收到一个就可以返回）
+    batch.m_packets.clear();
+    int ret = recvmmsg(m_socket, batch.m_msgs.data(), batch.m_capacity,
+        MSG_WAITFORONE, NULL);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+        return -4;
+    }
+
+    // 第3步：整理成逻辑数据报；GRO合并的超大包按gso_size拆开
+    for (int i = 0; i < ret; i++) {
+        size_t len = batch.m_msgs[i].msg_len;
+        size_t base = (size_t)i * batch.m_slot;
+        size_t seg = len;
+#ifdef UDP_GRO
+        if (m_bGro) {
+            msghdr& hdr = batch.m_msgs[i].msg_hdr;
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != NULL;
+                cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+                if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                    uint16_t gso = 0;
+                    memcpy(&gso, CMSG_DATA(cmsg), sizeof(gso));
+                    if (gso > 0) seg = gso;
+                }
+            }
+        }
+#endif
+        for (size_t off = 0; off < len; off += seg) {
+            size_t n = (len - off) < seg ? (len - off) : seg;
+            batch.m_packets.push_back({ base + off, n, (unsigned)i });
+        }
+        if (len == 0) batch.m_packets.push_back({ base, 0, (unsigned)i });  // 空数据报
+    }
+    return (int)batch.m_packets.size();
+}
+
+// ==================== CUdpSocket：批量发送 ====================
+int CUdpSocket::SendBatch(CUdpBatch& batch) {
+    if (m_status != 2) return -1;
+    if (batch.m_slab == NULL) return -2;
+
+    unsigned total = batch.Count();
+    if (total == 0) return 0;
+
+    // 第1步：把数据报组装成消息
+    // 不开GSO：一个数据报一个消息
+    // 开GSO：同一对端、等长（最后一个可以更短）的连续数据报合成一个消息，
+    //       用UDP_SEGMENT告诉内核按多大切分
+    std::vector<unsigned>& counts = batch.m_counts;  // 每个消息包含几个数据报
+    counts.clear();
+    unsigned nmsg = 0;
+    for (unsigned i = 0; i < total; ) {
+        const CUdpBatch::Packet& first = batch.m_packets[i];
+        unsigned n = 1;
+        size_t bytes = first.size;
+#ifdef UDP_SEGMENT
+        if (m_bGso) {
+            while (i + n < total && n < 64) {
+                const CUdpBatch::Packet& next = batch.m_packets[i + n];
+                const sockaddr_in& a = batch.m_addrs[first.slot];
+                const sockaddr_in& b = batch.m_addrs[next.slot];
+                if (a.sin_addr.s_addr != b.sin_addr.s_addr || a.sin_port != b.sin_port) break;
+                if (next.size > first.size || bytes + next.size > 65000) break;
+                if (batch.m_packets[i + n - 1].size != first.size) break;  // 短包只能在最后
+                bytes += next.size;
+                n++;
+            }
+        }
+#endif
+        msghdr& hdr = batch.m_msgs[nmsg].msg_hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = &batch.m_addrs[first.slot];
+        hdr.msg_namelen = sizeof(sockaddr_in);
+        hdr.msg_iov = &batch.m_iovs[i];   // 第i个数据报起的n个iovec
+        hdr.msg_iovlen = n;
+        for (unsigned k = 0; k < n; k++) {
+            const CUdpBatch::Packet& p = batch.m_packets[i + k];
+            batch.m_iovs[i + k].iov_base = batch.m_slab + p.offset;
+            batch.m_iovs[i + k].iov_len = p.size;
+        }
+#ifdef UDP_SEGMENT
+        if (n > 1) {
+            char* ctrl = &batch.m_control[nmsg * UDP_CONTROL_SIZE];
+            memset(ctrl, 0, UDP_CONTROL_SIZE);
+            hdr.msg_control = ctrl;
+            hdr.msg_controllen = UDP_CONTROL_SIZE;
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t gso = (uint16_t)first.size;
+            memcpy(CMSG_DATA(cmsg), &gso, sizeof(gso));
+        }
+#endif
+        counts.push_back(n);
+        nmsg++;
+        i += n;
+    }
+
+    // 第2步：一次系统调用发出全部消息
+    int ret = sendmmsg(m_socket, batch.m_msgs.data(), nmsg, 0);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return 0;
+        if (errno == EIO && m_bGso) {
+            // 网卡不支持分段卸载：关闭GSO，按普通方式重发
+            m_bGso = false;
+            return SendBatch(batch);
+        }
+        return -3;
+    }
+
+    // 第3步：换算成已发出的数据报个数
+    unsigned sent = 0;
+    for (int i = 0; i < ret; i++) sent += counts[i];
+    return (int)sent;
+}
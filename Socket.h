@@ -7,6 +7,15 @@
 #include <string>
 #include <cstring>
 #include <fcntl.h>  
+#include <netinet/tcp.h>  // TCP_NODELAY, TCP_DEFER_ACCEPT, TCP_KEEPIDLE
+#include "RingBuffer.h"
+#include "OutputQueue.h"
+#include "IOBuf.h"
+#include "Epoll.h"
+#include "Slab.h"
+#include <vector>
+#include <deque>
+#include <mutex>
 
 class Buffer : public std::string
 {
@@ -29,9 +38,10 @@ public:
 enum SockAttr {
     SOCK_ISSERVER = 1,  // 0001：是否是服务器（1=服务器，0=客户端）
     SOCK_ISBLOCK = 2,   // 0010：是否阻塞（1=阻塞，0=非阻塞）
-    // 未来可扩展：
-    // SOCK_ISREUSE = 4,   // 0100：是否复用地址
-    // SOCK_ISKEEPALIVE = 8 // 1000：是否保持连接
+    SOCK_ISREUSE = 4,       // 0100：SO_REUSEADDR，重启后立即重新绑定端口
+    SOCK_ISKEEPALIVE = 8,   // 1000：SO_KEEPALIVE（参数见keepidle/keepintvl/keepcnt）
+    SOCK_ISNODELAY = 16,    // TCP_NODELAY：关闭Nagle，小包立即发出
+    SOCK_ISREUSEPORT = 32,  // SO_REUSEPORT：多个进程/线程各自监听同一端口，内核做负载均衡
 };
 
 // ============================================
@@ -48,6 +58,7 @@ public:
         bzero(&addr_un, sizeof(addr_un));  // 清零Unix域地址
         port = -1;   // -1表示无效端口
         attr = 0;    // 无属性
+        InitOptions();
     }
     //使用场景
 
@@ -65,6 +76,9 @@ public:
     //      port - 端口号（1-65535）
     //      attr - 属性标志（SOCK_ISSERVER | SOCK_ISBLOCK）
     CSockParam(const Buffer& ip, short port, int attr) {
+        bzero(&addr_in, sizeof(addr_in));
+        bzero(&addr_un, sizeof(addr_un));
+        InitOptions();
         this->ip = ip;
         this->port = port;
         this->attr = attr;
@@ -80,6 +94,10 @@ public:
     // 参数：path - Unix域socket文件路径（如"/tmp/server.sock"）
     //      attr - 属性标志
     CSockParam(const Buffer& path, int attr) {
+        bzero(&addr_in, sizeof(addr_in));
+        bzero(&addr_un, sizeof(addr_un));
+        InitOptions();
+        port = -1;
         ip = path;  // 复用ip字段存储路径
 
         // 初始化Unix域地址结构体
@@ -104,6 +122,7 @@ public:
         attr = param.attr;
         memcpy(&addr_in, &param.addr_in, sizeof(addr_in));
         memcpy(&addr_un, &param.addr_un, sizeof(addr_un));
+        CopyOptions(param);
     }
 
     // 赋值运算符：p2 = p1;
@@ -114,6 +133,7 @@ public:
             attr = param.attr;
             memcpy(&addr_in, &param.addr_in, sizeof(addr_in));
             memcpy(&addr_un, &param.addr_un, sizeof(addr_un));
+            CopyOptions(param);
         }
         return *this;
     }
@@ -128,6 +148,27 @@ public:
     // 用途：bind(fd, param.addrun(), sizeof(sockaddr_un))
     sockaddr* addrun() const { return (sockaddr*)&addr_un; }
 
+private:
+    // 选项默认值：0表示"使用系统默认"
+    void InitOptions() {
+        backlog = SOMAXCONN;
+        rcvbuf = 0;
+        sndbuf = 0;
+        keepidle = 0;
+        keepintvl = 0;
+        keepcnt = 0;
+        defer_accept = 0;
+    }
+    void CopyOptions(const CSockParam& param) {
+        backlog = param.backlog;
+        rcvbuf = param.rcvbuf;
+        sndbuf = param.sndbuf;
+        keepidle = param.keepidle;
+        keepintvl = param.keepintvl;
+        keepcnt = param.keepcnt;
+        defer_accept = param.defer_accept;
+    }
+
     // -------------------- 成员变量 --------------------
 public:
     sockaddr_in addr_in;   // TCP/UDP地址结构体
@@ -135,6 +176,16 @@ public:
     Buffer ip;             // IP地址或Unix路径
     short port;            // 端口号（-1表示无效）
     int attr;              // 属性标志（SockAttr枚举的组合）
+
+    // -------------------- Socket选项（Init时一次性设置） --------------------
+    // 监听socket上设置的选项会被accept出来的连接继承，不需要每个连接再设一遍
+    int backlog;        // listen队列长度（默认SOMAXCONN；登录高峰时队列太短会丢连接）
+    int rcvbuf;         // SO_RCVBUF（字节，0=系统默认）
+    int sndbuf;         // SO_SNDBUF（字节，0=系统默认）
+    int keepidle;       // TCP_KEEPIDLE：空闲多少秒开始探测（需SOCK_ISKEEPALIVE）
+    int keepintvl;      // TCP_KEEPINTVL：探测间隔秒数
+    int keepcnt;        // TCP_KEEPCNT：探测失败几次判定断开
+    int defer_accept;   // TCP_DEFER_ACCEPT：连接有数据到达后才唤醒accept（秒，0=关闭）
 };
 
 // ============================================
@@ -148,21 +199,12 @@ public:
     CSocketBase() {
         m_socket = -1;  // 初始化为无效描述符
         m_status = 0;   // 初始化为未初始化状态
+        m_pEpoll = NULL;
+        m_events = 0;
+        m_bWriting = false;
+        m_handle = 0;   // 0：不是从slab分配的（用new创建或在栈上）
     }
 
-    // -------------------- 虚析构函数 --------------------
-
-    // 虚析构函数：确保子类对象通过基类指针删除时正确析构
-    virtual ~CSocketBase() {
-        m_status = 3;  // 标记为已关闭
-
-        // 关闭socket文件描述符
-        if (m_socket != -1) {
-            int fd = m_socket;
-            m_socket = -1;      // 先设置-1，防止重复关闭
-            close(fd);          // 再关闭fd
-        }
-    }
     virtual operator int() { return m_socket; }
     virtual operator int() const { return m_socket; }
     // -------------------- 纯虚函数（子类必须实现） --------------------
@@ -192,10 +234,100 @@ public:
     // 返回值：接收的字节数，0表示连接关闭，负数失败
     virtual int Recv(Buffer& data) = 0;
 
+    // 环形缓冲区版本（流式socket通用实现，见Socket.cpp）
+    // Send：把ring中可读的数据用writev发出，发出多少就Consume多少
+    // Recv：用readv直接读进ring的空闲区，读到多少就Commit多少
+    // 返回值：同上；Recv时ring已满返回-2
+    virtual int Send(CRingBuffer& ring);
+    virtual int Recv(CRingBuffer& ring);
+
+    // 切片链版本（零拷贝，见IOBuf.h）
+    // Send：切片用writev发出，短写就接着写剩下的；不修改data
+    //       写到EAGAIN时剩余部分进发送队列（等Flush/EPOLLOUT），发送队列已有积压时整条入队保证顺序
+    //       返回值：data.Size()（全部写出或已入队），-1 未连接或写失败
+    // Recv：直接读进data的尾部空间（最多max字节），读到多少就Commit多少
+    // 返回值：同上
+    virtual int Send(const CIOBuf& data);
+    virtual int Recv(CIOBuf& data, size_t max = IOBUF_BLOCK_SIZE);
+
     // 关闭连接
     // 返回值：0成功，负数失败
     virtual int Close() = 0;
 
+    // -------------------- 异步发送（流式socket） --------------------
+    // 用法：
+    //   client->BindEpoll(&epoll, EpollData((void*)client), EPOLLIN);
+    //   client->SendAsync(msg1);   // 只入队
+    //   client->SendAsync(msg2);
+    //   ...
+    //   client->Flush();           // 本轮循环末尾：一次writev
+    //   收到EPOLLOUT时再调用Flush()继续发送积压数据
+
+    // 绑定所在的epoll：有积压时自动加上EPOLLOUT，发完自动去掉
+    // data/events：与epoll.Add()时传入的一致
+    void BindEpoll(CEpoll* epoll, const EpollData& data, uint32_t events);
+
+    // 入队待发送数据
+    // 返回值：1 队列由空变为非空（调用者应把本连接记入本轮待Flush列表）
+    //        0 已在队列中排队，-1 未连接
+    int SendAsync(const Buffer& data);
+    int SendAsync(Buffer&& data);
+    int SendAsync(const CIOBuf& data);   // 共享块入队，不拷贝负载
+    // 头部 + 共享消息体：头部（每个接收者不同）拷进队尾，消息体只挂引用（广播用，见Broadcast.h）
+    int SendAsync(const char* header, size_t headerSize, const CIOBuf& body);
+
+    // 发送积压数据（一次writev）
+    // 返回值：>=0 本次写出的字节数，-1 未连接，-2 写失败（应关闭连接）
+    int Flush();
+
+    // 发送队列（设置水位回调、查询积压）
+    COutputQueue& Output() { return m_output; }
+
+    // -------------------- 句柄（连接对象池） --------------------
+    // 服务器Link/LinkBatch返回的客户端对象来自按类型划分的slab（见Slab.h），
+    // 而不是new出来的：
+    //   epoll注册：epoll.Add(*pClient, EpollData(pClient->Handle()), EPOLLIN);
+    //   事件到达：CSocketBase* pClient = CSocketBase::FromHandle(ev.data.u64);
+    //             （对象已释放/fd已被复用 → 返回NULL，直接忽略这个旧事件）
+    //   释放连接：CSocketBase::Free(pClient);   ← 不能用delete（基类析构函数是protected的，
+    //             delete CSocketBase*编译不过）
+
+    // 本对象的句柄（0表示不是slab分配的）
+    uint64_t Handle() const { return m_handle; }
+
+    // 句柄 → 对象，失效返回NULL
+    // 注意：代数只保证查的那一刻对象还在，不保证之后不被别的线程Free（槽位随即被复用）。
+    // 多个线程等同一个epoll时，连接必须用EPOLLONESHOT注册：一个事件只交给一个线程，
+    // 在它重新打开（EPOLL_CTL_MOD）之前，这个连接只属于这个线程，只有它能Free；
+    // 处理完不释放就重新打开（见CThreadPool::TaskDispatch）
+    static CSocketBase* FromHandle(uint64_t handle);
+
+    // 释放对象：slab分配的归还槽位，其他的delete
+    static void Free(CSocketBase* pSocket);
+
+protected:
+    // 虚析构函数：子类对象通过基类指针释放时正确析构
+    // protected：CSocketBase*只能交给Free()（slab里的对象delete是未定义行为）；
+    // 子类的析构函数是public的，栈上的对象、new出来的子类指针照常使用
+    virtual ~CSocketBase() {
+        m_status = 3;  // 标记为已关闭
+
+        // 关闭socket文件描述符
+        if (m_socket != -1) {
+            int fd = m_socket;
+            m_socket = -1;      // 先设置-1，防止重复关闭
+            close(fd);          // 再关闭fd
+        }
+    }
+
+    // 根据是否有积压打开/关闭EPOLLOUT
+    void UpdateWriting();
+
+    // 按param一次性设置socket选项（在bind/listen/connect之前调用）
+    // bTcp=true：额外设置TCP层选项（NODELAY、keepalive参数、DEFER_ACCEPT）
+    // 返回值：0成功，负数表示哪一类选项设置失败
+    int SetOptions(const CSockParam& param, bool bTcp);
+
 protected:
     // -------------------- 成员变量 --------------------
 
@@ -208,6 +340,21 @@ protected:
     // 2 - 已连接（已调用Link）
     // 3 - 已关闭（已调用Close或析构）
     int m_status;
+
+    // 异步发送相关
+    COutputQueue m_output;   // 发送队列
+    CEpoll* m_pEpoll;        // 所在的epoll（NULL表示未绑定，不自动管理EPOLLOUT）
+    EpollData m_epollData;   // 注册到epoll时的数据
+    uint32_t m_events;       // 注册到epoll时的事件（不含EPOLLOUT）
+    bool m_bWriting;         // 当前是否已打开EPOLLOUT
+
+    uint64_t m_handle;       // slab句柄（0=非slab对象）
+};
+
+// slab类型编号（句柄的高8位）
+enum SocketSlabType {
+    SOCKET_SLAB_LOCAL = 1,   // CLocalSocket
+    SOCKET_SLAB_TCP = 2,     // CTcpSocket
 };
 
   //二、为什么需要抽象基类？
@@ -257,16 +404,33 @@ public:
 
     // 关闭socket
     virtual int Close() override;
+
+    // 环形缓冲区版本沿用基类实现（避免被上面的重载隐藏）
+    using CSocketBase::Send;
+    using CSocketBase::Recv;
+
+    // 发送数据并附带一个文件描述符（SCM_RIGHTS，对方收到自己的一份fd）
+    // 返回值：发送的字节数，-1失败
+    int SendFD(int fd, const char* data, size_t size);
+
+    // 收进环形缓冲区，同时取出附带的文件描述符（没有则fd=-1）
+    // 返回值：同Recv(CRingBuffer&)
+    int Recv(CRingBuffer& ring, int& fd);
 private:
     CSockParam m_param;
 };
 
 
+// 小于这个长度的数据用MSG_ZEROCOPY不划算（固定页、完成通知的开销比拷贝大）
+#define ZEROCOPY_MIN_SIZE (16 * 1024)
+// Close时最多等多久零拷贝完成通知（毫秒），超时的转交ReapLingering继续等
+#define ZEROCOPY_CLOSE_WAIT 20
+
 class CTcpSocket : public CSocketBase {
 public:
     // ========== 构造函数（和CLocalSocket一样） ==========
-    CTcpSocket() : CSocketBase() {}
-    CTcpSocket(int sock) : CSocketBase() { m_socket = sock; }
+    CTcpSocket() : CSocketBase() { m_idlefd = -1; InitBulk(); }
+    CTcpSocket(int sock) : CSocketBase() { m_socket = sock; m_idlefd = -1; InitBulk(); }
     virtual ~CTcpSocket() { Close(); }
 
     // ========== 纯虚函数实现 ==========
@@ -275,14 +439,174 @@ public:
     virtual int Send(const Buffer& data) override;
     virtual int Recv(Buffer& data) override;
     virtual int Close() override;
+    using CSocketBase::Send;
+    using CSocketBase::Recv;
+
+    // 服务器：一次就绪事件里把积压的连接全部accept出来（直到EAGAIN）
+    // 新连接是非阻塞 + close-on-exec（accept4一步完成，不用再fcntl）
+    // clients：新连接追加到末尾；max：最多accept几个（0=不限）
+    // 返回值：本次accept的个数，-1状态错误，-2不是服务器
+    // 注意：监听socket是阻塞的时候只accept一个（否则会阻塞在第二次accept上）
+    int LinkBatch(std::vector<CSocketBase*>& clients, unsigned max = 0);
+
+    // -------------------- 大块传输（地图分块下载、回放上传、补丁文件） --------------------
+    // 这几个接口都不经过Buffer，数据不在用户态拷贝
+    // 返回值：>=0 本次的字节数（socket缓冲区满时为0，等EPOLLOUT再调用），
+    //        -1 未连接，-2 失败（应关闭连接）
+
+    // 文件 → socket：sendfile，页缓存直接进socket
+    // offset：文件偏移，发出多少自动前移多少
+    int SendFile(int fd, off_t& offset, size_t count);
+
+    // 任意fd（管道、另一个socket）→ socket：经内部管道splice
+    // 返回值是本次从fd取走的字节数（调用者据此推进进度）；
+    // 进了管道还没进socket的部分下次调用时先发，SplicePending()查询
+    int Splice(int fd, size_t count);
+    size_t SplicePending() const { return m_pipeBytes; }
+
+    // 开启SO_ZEROCOPY（内核4.14+）
+    // 返回值：0成功，-1未初始化，-2内核不支持
+    int EnableZeroCopy();
+
+    // 大块内存：MSG_ZEROCOPY，内核直接引用data所在的页
+    // 发出的部分由本对象共享持有，直到内核的完成通知（ReapZeroCopy）到达，
+    // 调用者可以立即释放自己的引用；但在完成之前块里的数据不能被改写
+    // 小于ZEROCOPY_MIN_SIZE或没有开启零拷贝时走普通writev
+    int SendZeroCopy(const CIOBuf& data);
+
+    // 读错误队列里的完成通知，释放已完成的缓冲区
+    // 完成通知到达时epoll会报EPOLLERR（不需要注册），收到后调用本函数
+    // 返回值：本次完成的发送次数，-1失败
+    int ReapZeroCopy();
+
+    // 还在等完成通知的发送次数（Close会先等一小会儿，见下面的ReapLingering）
+    size_t ZeroCopyPending() const { return m_zcPending.size(); }
+
+    // 已关闭但零拷贝发送还没完成的连接：Close时fd（shutdown之后）和缓冲区一起挂在这里，
+    // 直到完成通知全部到达或连接彻底断开（TCP_CLOSE）才释放，期间块不会被池重用
+    // 每次Close都会顺便调用；没有新连接关闭时，可以在定时器里调用
+    // 返回值：还在等待的连接数
+    static size_t ReapLingering();
+    // 被内核退化成拷贝的发送次数（回环、网卡不支持分散聚集时）
+    uint64_t ZeroCopyCopied() const { return m_zcCopied; }
+
+protected:
+    // accept一个连接，失败返回-1（errno有效）
+    int AcceptOne();
+
+    void InitBulk() {
+        m_pipe[0] = m_pipe[1] = -1;
+        m_pipeBytes = 0;
+        m_bZeroCopy = false;
+        m_zcNext = 0;
+        m_zcCopied = 0;
+    }
+
+    // 一次MSG_ZEROCOPY发送：内核按调用次数编号（从0开始），完成通知给出编号区间
+    struct ZeroCopySend {
+        uint32_t id;
+        CIOBuf data;   // 发出的部分，完成前不能释放
+    };
+
+    // 关闭后还在等完成通知的连接（fd已shutdown，只用来读错误队列）
+    struct ZeroCopyLinger {
+        int fd;
+        uint64_t copied;
+        std::deque<ZeroCopySend> pending;
+    };
+
+    // 读fd错误队列里的完成通知，从pending里去掉已完成的发送
+    // 返回值：完成的发送次数，-1失败
+    static int ReapErrQueue(int fd, std::deque<ZeroCopySend>& pending, uint64_t& copied);
 
 protected:
     CSockParam m_param;  // 保存参数
+    int m_idlefd;        // 预留的空闲fd：fd耗尽(EMFILE)时用来接受并立即关闭连接
+
+    int m_pipe[2];       // splice用的管道（第一次Splice时创建）
+    size_t m_pipeBytes;  // 管道里还没进socket的字节数
+    bool m_bZeroCopy;    // 是否已开启SO_ZEROCOPY
+    uint32_t m_zcNext;   // 下一次零拷贝发送的编号
+    uint64_t m_zcCopied; // 被退化为拷贝的次数
+    std::deque<ZeroCopySend> m_zcPending;  // 等待完成通知的发送
+
+    static std::mutex s_lingerLock;
+    static std::vector<ZeroCopyLinger> s_lingering;  // 见ReapLingering
+};
+
+// 一次recvmmsg/sendmmsg最多处理的数据报个数
+#define UDP_BATCH_SIZE 64
+// 每个数据报槽位的大小（普通模式：大于以太网MTU即可）
+#define UDP_SLOT_SIZE 2048
+// 开启UDP_GRO时槽位必须能装下内核合并后的超大包
+#define UDP_GRO_SLOT_SIZE 65536
+
+// ============================================
+// CUdpBatch类：UDP批量收发的数据报数组
+//
+// 内存布局：一整块 count * slot 字节的连续内存，每个数据报占一个槽位
+//   ┌──────┬──────┬──────┬─────┐
+//   │槽位0 │槽位1 │槽位2 │ ... │   + 每个槽位对应的 mmsghdr/iovec/地址
+//   └──────┴──────┴──────┴─────┘
+// 对象可以反复使用：创建一次，每轮循环 RecvBatch / Clear+Add+SendBatch
+//
+// 接收：RecvBatch() 之后用 Count()/Data(i)/Size(i)/Addr(i) 遍历，
+//       每个数据报都带着发送方地址，可以直接回复
+// 发送：Clear() → Add(data, to) ... → SendBatch()
+// ============================================
+class CUdpBatch
+{
+public:
+    CUdpBatch();
+    ~CUdpBatch();
+    CUdpBatch(const CUdpBatch&) = delete;
+    CUdpBatch& operator=(const CUdpBatch&) = delete;
+
+    // 分配槽位
+    // 返回值：0成功，-1已创建，-2参数错误，-3内存不足
+    int Create(unsigned count = UDP_BATCH_SIZE, size_t slot = UDP_SLOT_SIZE);
+
+    // 数据报个数（GRO合并的包拆开后按逻辑数据报计数）
+    unsigned Count() const { return (unsigned)m_packets.size(); }
+    const char* Data(unsigned i) const { return m_slab + m_packets[i].offset; }
+    size_t Size(unsigned i) const { return m_packets[i].size; }
+    const sockaddr_in& Addr(unsigned i) const { return m_addrs[m_packets[i].slot]; }
+
+    // 清空（准备下一轮发送）
+    void Clear() { m_packets.clear(); }
+
+    // 添加一个待发送的数据报（拷贝进槽位）
+    // 返回值：0成功，-1已满，-2数据报超过槽位大小
+    int Add(const char* data, size_t size, const sockaddr_in& to);
+    int Add(const Buffer& data, const sockaddr_in& to) { return Add(data.c_str(), data.size(), to); }
+
+    size_t SlotSize() const { return m_slot; }
+    unsigned Capacity() const { return m_capacity; }
+
+private:
+    friend class CUdpSocket;
+
+    // 一个逻辑数据报：在m_slab中的位置和长度，slot是地址所在的槽位
+    struct Packet {
+        size_t offset;
+        size_t size;
+        unsigned slot;
+    };
+
+    char* m_slab;                    // 所有槽位的连续内存
+    size_t m_slot;                   // 槽位大小
+    unsigned m_capacity;             // 槽位个数
+    std::vector<mmsghdr> m_msgs;     // recvmmsg/sendmmsg用的消息头
+    std::vector<iovec> m_iovs;       // 每个消息的iovec（发送时GSO一个消息可带多段）
+    std::vector<sockaddr_in> m_addrs;  // 每个槽位的对端地址
+    std::vector<char> m_control;     // 每个槽位的控制消息空间（UDP_GRO/UDP_SEGMENT）
+    std::vector<Packet> m_packets;   // 逻辑数据报列表
+    std::vector<unsigned> m_counts;  // 发送时每个消息包含的数据报个数
 };
 
 class CUdpSocket : public CSocketBase {
 public:
-    CUdpSocket() : CSocketBase() {}
+    CUdpSocket() : CSocketBase() { m_bGso = false; m_bGro = false; }
     virtual ~CUdpSocket() { Close(); }
 
     virtual int Init(const CSockParam& param) override;
@@ -291,10 +615,44 @@ public:
     virtual int Recv(Buffer& data) override;
     virtual int Close() override;
 
+    // UDP按数据报收发：一次Recv读一个数据报，一次Send把ring中全部数据作为一个数据报
+    virtual int Send(CRingBuffer& ring) override;
+    virtual int Recv(CRingBuffer& ring) override;
+
+    // 切片链作为一个数据报发出（sendmsg，不用先拼成连续内存）
+    virtual int Send(const CIOBuf& data) override;
+    using CSocketBase::Recv;
+
+    // 指定对端的单个数据报收发（服务器用：回复给发送方）
+    // Recv会把data调整为实际收到的长度，from返回发送方地址
+    int Send(const Buffer& data, const sockaddr_in& to);
+    int Recv(Buffer& data, sockaddr_in& from);
+    int Send(const CIOBuf& data, const sockaddr_in& to);
+
+    // 批量收发
+    // RecvBatch：一次recvmmsg最多收batch.Capacity()个数据报，返回逻辑数据报个数
+    //            （0表示没有数据，负数失败）
+    // SendBatch：一次sendmmsg发出batch中的全部数据报，返回已发出的数据报个数
+    //            开启GSO时，同一对端、等长的连续数据报合并成一个超大包交给内核切分
+    int RecvBatch(CUdpBatch& batch);
+    int SendBatch(CUdpBatch& batch);
+
+    // UDP_SEGMENT（发送端分段卸载）/ UDP_GRO（接收端合并）
+    // 内核不支持时返回-2，保持关闭
+    // 注意：开启GRO后，RecvBatch用的batch槽位必须 >= UDP_GRO_SLOT_SIZE
+    int SetGso(bool bOn);
+    int SetGro(bool bOn);
+
 protected:
     CSockParam m_param;
+    bool m_bGso;   // 是否使用UDP_SEGMENT
+    bool m_bGro;   // 是否开启UDP_GRO
 };
 
+// 各类连接的对象池
+typedef CSlab<CLocalSocket, SOCKET_SLAB_LOCAL> CLocalSocketSlab;
+typedef CSlab<CTcpSocket, SOCKET_SLAB_TCP> CTcpSocketSlab;
+
 class Socket
 {
 };
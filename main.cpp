@@ -8,13 +8,31 @@
 #include <stdlib.h>
 #include <sys/socket.h>  // ← 新增
 #include <cstring>       // ← 新增
+#include <climits>       // INT_MIN等（日志格式化核对）
 #include <fcntl.h>       // ← 新增
 #include <sys/stat.h>    // ← 新增
 #include "Epoll.h"
 #include "Thread.h"      // ← 新增：线程封装
 #include "CThreadPool.h" // ← 新增：线程池
+#define LOG_FLIGHT 1      // 飞行记录器的测试要用（格式串都是字面量）
 #include"Logger.h"
 #include <iostream>
+#include <atomic>
+#include <vector>
+#include <sys/resource.h> // ← 新增：setrlimit（压测需要较多fd）
+#include <thread>
+#include "BufferPool.h"
+#include <poll.h>         // poll（大块传输压测等待可写）
+#include "ReliableUdp.h"
+#include "SessionManager.h"
+#include "Broadcast.h"
+#include "Aoi.h"
+#include "Snapshot.h"
+#include "Protocol.h"
+#include <map>
+#include <dirent.h>      // opendir（核对日志文件）
+#include <algorithm>
+#include <unordered_map>
 class CProcess
 {
 public:
@@ -810,57 +828,2771 @@ int TestThreadPool_Stress() {
     sleep(3);
     printf("✓ 混合任务执行完成\n\n");
 
+    // 测试3：同一个线程连续提交4个任务，4个要同时在跑（等齐了才结束，2秒等不齐就是被串行化了）
+    printf("【测试3】同一个线程提交的任务并行执行...\n");
+    std::atomic<int> running(0), together(0), finished(0);
+    for (int i = 0; i < 4; i++) {
+        pool.AddTask([&running, &together, &finished]() {
+            running.fetch_add(1);
+            timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            do {
+                if (running.load() == 4) {
+                    together.fetch_add(1);
+                    break;
+                }
+                usleep(1000);
+                clock_gettime(CLOCK_MONOTONIC, &t1);
+            } while (t1.tv_sec - t0.tv_sec < 2);
+            finished.fetch_add(1);
+        });
+    }
+    while (finished.load() < 4) usleep(10000);
+    if (together.load() != 4) {
+        printf("❌ 只有%d个任务等到了其他任务（同一个生产者的任务被串行化）\n", together.load());
+        pool.Close();
+        return -2;
+    }
+    printf("✓ 4个任务同时在执行\n\n");
+
     pool.Close();
     printf("✓ 线程池已关闭\n\n");
 
-    printf("========================================\n");
-    printf("  ✅ 阶段3测试通过！\n");
+    printf("========================================\n");
+    printf("  ✅ 阶段3测试通过！\n");
+    printf("========================================\n\n");
+
+    return 0;
+}
+
+// 完整测试套件
+int TestThreadPool_All() {
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║     线程池完整测试套件                  ║\n");
+    printf("╚════════════════════════════════════════╝\n");
+
+    int ret = 0;
+
+    // 阶段1
+    ret = TestThreadPool_Basic();
+    if (ret != 0) {
+        printf("\n❌ 阶段1测试失败\n");
+        return -1;
+    }
+    printf("按回车继续阶段2测试...\n");
+    getchar();
+
+    // 阶段2
+    ret = TestThreadPool_Advanced();
+    if (ret != 0) {
+        printf("\n❌ 阶段2测试失败\n");
+        return -2;
+    }
+    printf("按回车继续阶段3测试...\n");
+    getchar();
+
+    // 阶段3
+    ret = TestThreadPool_Stress();
+    if (ret != 0) {
+        printf("\n❌ 阶段3测试失败\n");
+        return -3;
+    }
+
+    printf("\n");
+    printf("╔════════════════════════════════════════╗\n");
+    printf("║     🎉 所有测试通过！                   ║\n");
+    printf("╚════════════════════════════════════════╝\n");
+    printf("\n");
+
+    return 0;
+}
+
+// ==================== 环形缓冲区测试 ====================
+// 镜像映射的CRingBuffer：读写位置反复绕过容量边界，核对
+//   1. 容量取整、镜像模式下任意位置的Reserve/Peek都是连续的一整段（跨边界也是）
+//   2. 字节序列不错、不丢：写入变长的块，每次消费一部分（不读空，位置一直往前走）
+//   3. iovec接口：镜像模式只有一段，长度等于Size()/Free()；writev/readv经过管道原样往返
+//   4. 满了Append失败、Reserve返回NULL
+#define RING_TEST_ROUNDS 200000
+
+int TestRingBuffer() {
+    printf("\n========================================\n");
+    printf("  环形缓冲区测试\n");
+    printf("========================================\n\n");
+
+    int errors = 0;
+    CRingBuffer ring;
+    int ret = ring.Create(5000);
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t expect = page;
+    while (expect < 5000) expect <<= 1;
+    printf("  Create(5000) → %d，容量%zu（应为%zu），镜像%s\n", ret, ring.Capacity(), expect,
+        ring.IsMirrored() ? "是" : "否（退化为普通内存）");
+    if (ret != 0 || ring.Capacity() != expect || ring.Create(100) != -1) errors++;
+    size_t cap = ring.Capacity();
+
+    // 第1步：写入序号字节（i & 0xFF），读的时候核对；一直留一些不读，让位置绕过边界
+    unsigned int seed = 12345;
+    size_t written = 0, readPos = 0, crossed = 0, mismatch = 0;
+    for (int round = 0; round < RING_TEST_ROUNDS; round++) {
+        size_t n = rand_r(&seed) % (cap / 3) + 1;
+        if (n <= ring.Free()) {
+            // 镜像模式：直接Reserve一整段（跨尾部也连续）；普通模式用Append
+            char* p = ring.IsMirrored() ? ring.Reserve(n) : NULL;
+            if (p != NULL) {
+                size_t pos = (size_t)(p - ring.Peek()) + readPos;   // 写位置对应的序号
+                if ((pos & (cap - 1)) + n > cap) crossed++;
+                for (size_t i = 0; i < n; i++) p[i] = (char)(written + i);
+                ring.Commit(n);
+            }
+            else {
+                std::string data(n, '\0');
+                for (size_t i = 0; i < n; i++) data[i] = (char)(written + i);
+                if (ring.Append(data.data(), n) != 0) errors++;
+            }
+            written += n;
+        }
+        // 消费一部分，至少留1字节（读空时位置归零，就测不到绕边界了）
+        size_t size = ring.Size();
+        if (size <= 1) continue;
+        size_t m = rand_r(&seed) % (size - 1) + 1;
+        const char* q = ring.Peek();
+        size_t first = ring.PeekSize();
+        for (size_t i = 0; i < m && i < first; i++) {
+            if ((unsigned char)q[i] != (unsigned char)(readPos + i)) mismatch++;
+        }
+        ring.Consume(m);
+        readPos += m;
+    }
+    printf("  %d轮：写入%zu字节，跨边界的连续写%zu次，读出不一致%zu字节\n",
+        RING_TEST_ROUNDS, written, crossed, mismatch);
+    if (mismatch != 0 || (ring.IsMirrored() && crossed == 0)) errors++;
+
+    // 第2步：iovec接口经过管道往返（writev出去，readv回来）
+    iovec iov[2];
+    int segs = ring.ReadableVec(iov);
+    size_t total = 0;
+    for (int i = 0; i < segs; i++) total += iov[i].iov_len;
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    std::string expectData(ring.Size(), '\0');
+    for (size_t i = 0; i < ring.Size(); i++) expectData[i] = (char)(readPos + i);
+    ssize_t out = writev(fds[1], iov, segs);
+    size_t pending = ring.Size();
+    ring.Consume((size_t)(out > 0 ? out : 0));
+    readPos += (size_t)(out > 0 ? out : 0);
+    segs = ring.WritableVec(iov);
+    size_t freeTotal = 0;
+    for (int i = 0; i < segs; i++) freeTotal += iov[i].iov_len;
+    ssize_t in = readv(fds[0], iov, segs);
+    if (in > 0) ring.Commit((size_t)in);
+    close(fds[0]);
+    close(fds[1]);
+    bool same = ring.Size() == pending;
+    std::string back;
+    iovec rd[2];
+    int rsegs = ring.ReadableVec(rd);
+    for (int i = 0; i < rsegs; i++) back.append((const char*)rd[i].iov_base, rd[i].iov_len);
+    same = same && back == expectData;
+    printf("  writev %zd/%zu字节 → readv %zd字节（可写%zu），内容%s\n", out, total, in, freeTotal,
+        same ? "一致" : "不一致");
+    if (out != (ssize_t)total || total != pending || in != out || !same) errors++;
+    if (ring.IsMirrored() && (rsegs != 1 || segs != 1)) errors++;
+
+    // 第3步：写满
+    size_t room = ring.Free();
+    std::string fill(room, 'x');
+    int full = ring.Append(fill.data(), room);
+    bool over = ring.Append("y", 1) == -1 && ring.Reserve(1) == NULL;
+    printf("  写满：Append(%zu) → %d，再写1字节%s\n\n", room, full, over ? "失败（正确）" : "成功（错误）");
+    if (full != 0 || !over || ring.Free() != 0) errors++;
+
+    ring.Close();
+    return errors == 0 ? 0 : -2;
+}
+
+// ==================== 发送队列测试 ====================
+// COutputQueue经过非阻塞的socketpair，核对
+//   1. 合并：1000条小消息（多于一次writev的OUTPUT_IOV_MAX段）一次Flush全部写出
+//   2. 大消息（Buffer&&、CIOBuf）挂切片不拷贝，和小消息交错时顺序不乱
+//   3. 部分写入：发送缓冲很小，Flush每次只写出一部分，剩下的留在队列里，对端收到的字节完全一致
+//   4. 对端不读：Flush返回0（EAGAIN）；水位回调：超过高水位一次，回落到低水位一次
+#define OUTQ_TEST_SMALL 1000
+
+// 消息内容：序号字节（从start开始）
+static void OutqFill(char* p, size_t n, size_t start) {
+    for (size_t i = 0; i < n; i++) p[i] = (char)((start + i) * 7 + 3);
+}
+
+// 读走对端现有的全部数据，核对序号
+static size_t OutqDrain(int fd, size_t& received, size_t& mismatch) {
+    char buf[65536];
+    size_t total = 0;
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            if (buf[i] != (char)((received + i) * 7 + 3)) mismatch++;
+        }
+        received += (size_t)n;
+        total += (size_t)n;
+    }
+    return total;
+}
+
+int TestOutputQueue() {
+    printf("\n========================================\n");
+    printf("  发送队列测试\n");
+    printf("========================================\n\n");
+
+    int errors = 0;
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) != 0) return -1;
+
+    // 第1步：小消息合并（20~100字节）
+    COutputQueue queue;
+    size_t sent = 0, received = 0, mismatch = 0;
+    for (int i = 0; i < OUTQ_TEST_SMALL; i++) {
+        char msg[100];
+        size_t n = 20 + i % 81;
+        OutqFill(msg, n, sent);
+        queue.Append(msg, n);
+        sent += n;
+    }
+    size_t pending = queue.Pending();
+    ssize_t ret = queue.Flush(sv[0]);
+    OutqDrain(sv[1], received, mismatch);
+    printf("  %d条小消息 %zu字节：一次Flush写出%zd字节，剩%zu\n", OUTQ_TEST_SMALL, pending, ret, queue.Pending());
+    if (pending != sent || ret != (ssize_t)sent || !queue.Empty()) errors++;
+
+    // 第2步：大小消息交错，把发送缓冲调小，一次只能写出一部分
+    int small = 4096;
+    setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    unsigned int seed = 7;
+    for (int i = 0; i < 300; i++) {
+        size_t n = (i % 3 == 0) ? 600 + rand_r(&seed) % 20000 : 1 + rand_r(&seed) % 300;
+        if (i % 3 == 0 && i % 2 == 0) {
+            Buffer big(n);
+            OutqFill(&big[0], n, sent);
+            queue.Append(std::move(big));            // 接管内存
+        }
+        else if (i % 3 == 0) {
+            CIOBuf chain;
+            char* p = chain.Reserve(n);
+            OutqFill(p, n, sent);
+            chain.Commit(n);
+            queue.Append(chain);                     // 共享块
+        }
+        else {
+            Buffer msg(n);
+            OutqFill(&msg[0], n, sent);
+            queue.Append(msg);                       // 拷贝合并
+        }
+        sent += n;
+    }
+    int flushes = 0, partial = 0;
+    while (!queue.Empty() && flushes < 100000) {
+        size_t before = queue.Pending();
+        ret = queue.Flush(sv[0]);
+        flushes++;
+        if (ret < 0) break;
+        if ((size_t)ret < before) partial++;
+        if (queue.Pending() != before - (size_t)ret) errors++;
+        OutqDrain(sv[1], received, mismatch);
+    }
+    OutqDrain(sv[1], received, mismatch);
+    printf("  大小交错：%d次Flush（%d次部分写入），对端收到%zu/%zu字节，不一致%zu\n",
+        flushes, partial, received, sent, mismatch);
+    if (!queue.Empty() || received != sent || mismatch != 0 || partial == 0) errors++;
+
+    // 第3步：对端不读 → 写满后Flush返回0；水位回调
+    int highs = 0, lows = 0;
+    queue.SetWatermark(256 * 1024, 64 * 1024, [&](bool bHigh) { bHigh ? highs++ : lows++; });
+    char block[1024];
+    size_t base = sent;
+    while (queue.Pending() < 512 * 1024) {
+        OutqFill(block, sizeof(block), sent);
+        queue.Append(block, sizeof(block));
+        sent += sizeof(block);
+    }
+    while (queue.Flush(sv[0]) > 0) {}
+    ret = queue.Flush(sv[0]);
+    printf("  对端不读：Flush → %zd（应为0），积压%zu字节，高水位回调%d次\n", ret, queue.Pending(), highs);
+    if (ret != 0 || highs != 1 || lows != 0) errors++;
+    while (!queue.Empty()) {
+        if (queue.Flush(sv[0]) < 0) break;
+        OutqDrain(sv[1], received, mismatch);
+    }
+    OutqDrain(sv[1], received, mismatch);
+    printf("  读完：低水位回调%d次，收到%zu/%zu字节，不一致%zu\n\n", lows, received - base, sent - base, mismatch);
+    if (lows != 1 || received != sent || mismatch != 0) errors++;
+
+    close(sv[0]);
+    close(sv[1]);
+    return errors == 0 ? 0 : -2;
+}
+
+// ==================== UDP批量收发测试 ====================
+// 本机回环上的两个CUdpSocket，核对
+//   1. SendBatch/RecvBatch：变长数据报内容不错，每个数据报带着发送方地址，按地址原样回复
+//   2. GSO（UDP_SEGMENT）：等长的连续数据报合成一个消息，对端收到的还是一个个独立的数据报
+//   3. GRO（UDP_GRO）：内核合并的超大包按gso_size拆开，逻辑数据报个数、内容不变
+//   4. 边界：超过槽位的数据报、槽位满、开GRO时槽位太小
+// 内核不支持GSO/GRO时对应的一项跳过
+#define UDPB_TEST_PORT 19710
+
+// 数据报i的内容：第一个字节是i，其余按i和位置填
+static void UdpbFill(char* p, size_t n, unsigned i) {
+    for (size_t k = 0; k < n; k++) p[k] = (char)(k == 0 ? i : i * 31 + k);
+}
+
+static bool UdpbCheck(const char* p, size_t n, size_t expectSize) {
+    if (n != expectSize || n == 0) return false;
+    unsigned i = (unsigned char)p[0];
+    for (size_t k = 1; k < n; k++) {
+        if (p[k] != (char)(i * 31 + k)) return false;
+    }
+    return true;
+}
+
+// 收够count个数据报（最多等1秒），逐个核对长度（sizes按数据报的第一个字节找）和内容
+static int UdpbReceive(CUdpSocket& sock, CUdpBatch& batch, unsigned count, const size_t* sizes,
+    unsigned& bad, unsigned short& fromPort) {
+    unsigned got = 0;
+    for (int wait = 0; got < count && wait < 1000; ) {
+        int n = sock.RecvBatch(batch);
+        if (n < 0) return n;
+        if (n == 0) {
+            usleep(1000);
+            wait++;
+            continue;
+        }
+        for (unsigned i = 0; i < batch.Count(); i++) {
+            unsigned id = batch.Size(i) > 0 ? (unsigned char)batch.Data(i)[0] : 0;
+            if (id >= count || !UdpbCheck(batch.Data(i), batch.Size(i), sizes[id])) bad++;
+            fromPort = ntohs(batch.Addr(i).sin_port);
+        }
+        got += batch.Count();
+    }
+    return (int)got;
+}
+
+int TestUdpBatch() {
+    printf("\n========================================\n");
+    printf("  UDP批量收发测试\n");
+    printf("========================================\n\n");
+
+    int errors = 0;
+    CUdpSocket server, client;
+    if (server.Init(CSockParam("127.0.0.1", UDPB_TEST_PORT, SOCK_ISSERVER | SOCK_ISBLOCK)) != 0 ||
+        client.Init(CSockParam("127.0.0.1", UDPB_TEST_PORT + 1, SOCK_ISSERVER | SOCK_ISBLOCK)) != 0) {
+        printf("  ❌ 初始化失败 errno=%d\n", errno);
+        return -1;
+    }
+    server.Link(NULL);
+    client.Link(NULL);
+    sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(UDPB_TEST_PORT);
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // 第1步：变长数据报一来一回
+    CUdpBatch out, in;
+    out.Create(UDP_BATCH_SIZE, UDP_SLOT_SIZE);
+    in.Create(UDP_BATCH_SIZE, UDP_SLOT_SIZE);
+    size_t sizes[UDP_BATCH_SIZE];
+    char data[UDP_GRO_SLOT_SIZE];
+    for (unsigned i = 0; i < UDP_BATCH_SIZE; i++) {
+        sizes[i] = 1 + (i * 97) % 1400;
+        UdpbFill(data, sizes[i], i);
+        if (out.Add(data, sizes[i], to) != 0) errors++;
+    }
+    int sent = client.SendBatch(out);
+    unsigned bad = 0;
+    unsigned short fromPort = 0;
+    int got = UdpbReceive(server, in, UDP_BATCH_SIZE, sizes, bad, fromPort);
+    printf("  SendBatch %d个 → RecvBatch %d个，内容错误%u，发送方端口%u（应为%d）\n",
+        sent, got, bad, fromPort, UDPB_TEST_PORT + 1);
+    if (sent != UDP_BATCH_SIZE || got != UDP_BATCH_SIZE || bad != 0 || fromPort != UDPB_TEST_PORT + 1) errors++;
+
+    // 按收到的地址原样回复（最后一次RecvBatch收到的那些）
+    out.Clear();
+    unsigned replies = in.Count();
+    for (unsigned i = 0; i < in.Count(); i++) out.Add(in.Data(i), in.Size(i), in.Addr(i));
+    int echoed = server.SendBatch(out);
+    unsigned bad2 = 0;
+    got = UdpbReceive(client, in, replies, sizes, bad2, fromPort);
+    printf("  回复 %d个 → 客户端收到%d个，内容错误%u，来自端口%u\n", echoed, got, bad2, fromPort);
+    if (echoed != (int)replies || got != (int)replies || bad2 != 0 || fromPort != UDPB_TEST_PORT) errors++;
+
+    // 第2步：GSO：1200字节 × 40 + 最后一个短的，一个消息发出
+    const unsigned gsoCount = 41;
+    size_t gsoSizes[gsoCount];
+    out.Clear();
+    for (unsigned i = 0; i < gsoCount; i++) {
+        gsoSizes[i] = i + 1 < gsoCount ? 1200 : 300;
+        UdpbFill(data, gsoSizes[i], i);
+        out.Add(data, gsoSizes[i], to);
+    }
+    if (client.SetGso(true) == 0) {
+        sent = client.SendBatch(out);
+        bad = 0;
+        got = UdpbReceive(server, in, gsoCount, gsoSizes, bad, fromPort);
+        printf("  GSO：发出%d个 → 收到%d个独立的数据报，内容错误%u\n", sent, got, bad);
+        if (sent != (int)gsoCount || got != (int)gsoCount || bad != 0) errors++;
+    }
+    else {
+        printf("  GSO：内核不支持，跳过\n");
+    }
+
+    // 第3步：GRO：槽位太小时拒绝；换大槽位收GSO发来的包
+    CUdpBatch big;
+    big.Create(8, UDP_GRO_SLOT_SIZE);
+    if (server.SetGro(true) == 0) {
+        int small = server.RecvBatch(in);
+        sent = client.SendBatch(out);
+        bad = 0;
+        got = UdpbReceive(server, big, gsoCount, gsoSizes, bad, fromPort);
+        printf("  GRO：小槽位RecvBatch → %d（应为-3）；发出%d个 → 拆出%d个，内容错误%u\n", small, sent, got, bad);
+        if (small != -3 || got != (int)gsoCount || bad != 0) errors++;
+        server.SetGro(false);
+    }
+    else {
+        printf("  GRO：内核不支持，跳过\n");
+    }
+
+    // 第4步：边界
+    out.Clear();
+    int tooBig = out.Add(data, UDP_SLOT_SIZE + 1, to);
+    for (unsigned i = 0; i < UDP_BATCH_SIZE; i++) out.Add(data, 10, to);
+    int full = out.Add(data, 10, to);
+    printf("  超过槽位的Add → %d（应为-2），满了再Add → %d（应为-1）\n\n", tooBig, full);
+    if (tooBig != -2 || full != -1) errors++;
+
+    return errors == 0 ? 0 : -2;
+}
+
+// ==========================================
+// CIOBuf测试：切片/前插/引用计数、块大小、短写
+// ==========================================
+#define IOBUF_TEST_PORT 19750
+#define IOBUF_TEST_SEND (2 * 1024 * 1024)   // 远大于发送缓冲，必然短写
+
+static char IobufByte(size_t pos) { return (char)(pos * 7 + pos / 251); }
+
+// 检查buf的内容是否等于pattern[begin, begin+buf.Size())
+static bool IobufCheck(const CIOBuf& buf, size_t begin) {
+    std::string s = buf.ToString();
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] != IobufByte(begin + i)) return false;
+    }
+    return true;
+}
+
+int TestIOBuf() {
+    printf("\n========================================\n");
+    printf("  CIOBuf测试\n");
+    printf("========================================\n\n");
+
+    int errors = 0;
+    char data[1000];
+
+    // 第1步：切片共享块，原链继续追加不影响切片
+    CIOBuf chain;
+    for (size_t base = 0; base < 10000; base += sizeof(data)) {
+        for (size_t i = 0; i < sizeof(data); i++) data[i] = IobufByte(base + i);
+        chain.Append(data, sizeof(data));
+    }
+    CIOBuf slice = chain.Slice(2500, 5000);
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = IobufByte(10000 + i);
+    chain.Append(data, sizeof(data));
+    bool bSlice = slice.Size() == 5000 && IobufCheck(slice, 2500) && chain.Size() == 11000 && IobufCheck(chain, 0);
+    printf("  切片[2500,7500)：%zu字节 %u段，原链追加后%s\n", slice.Size(), slice.Count(), bSlice ? "内容不变" : "内容错误");
+    if (!bSlice) errors++;
+
+    // 第2步：共享块不能原地前插 → 另起一块，原链头部不被覆盖
+    char header[8];
+    for (size_t i = 0; i < sizeof(header); i++) header[i] = IobufByte(2492 + i);
+    unsigned before = slice.Count();
+    slice.Prepend(header, sizeof(header));
+    bool bPrepend = slice.Count() == before + 1 && IobufCheck(slice, 2492) && IobufCheck(chain, 0);
+    printf("  共享块前插8字节：%u段 → %u段，%s\n", before, slice.Count(), bPrepend ? "原链不变" : "内容错误");
+    if (!bPrepend) errors++;
+
+    // 第3步：独占块有头部空间 → 原地前插，不多一段
+    CIOBuf packet(64);
+    for (size_t i = 0; i < 64; i++) data[i] = IobufByte(100 + i);
+    packet.Append(data, 64);
+    for (size_t i = 0; i < sizeof(header); i++) header[i] = IobufByte(92 + i);
+    packet.Prepend(header, sizeof(header));
+    bool bHead = packet.Count() == 1 && packet.Size() == 72 && IobufCheck(packet, 92);
+    printf("  独占块前插8字节：%u段，%s\n", packet.Count(), bHead ? "原地写入" : "错误");
+    if (!bHead) errors++;
+
+    // 第4步：TrimStart/TrimEnd跨块，Coalesce合并成一段
+    slice.TrimStart(1008);   // 去掉头部8字节 + 1000字节
+    slice.TrimEnd(1500);
+    bool bTrim = slice.Size() == 2500 && IobufCheck(slice, 3500);
+    const char* flat = slice.Coalesce();
+    bool bFlat = slice.Count() == 1 && flat != NULL && IobufCheck(slice, 3500);
+    printf("  裁剪后%zu字节，Coalesce后%u段：%s\n", slice.Size(), slice.Count(), (bTrim && bFlat) ? "正确" : "错误");
+    if (!bTrim || !bFlat) errors++;
+
+    // 第5步：引用计数：原链释放后切片仍然有效
+    chain.Clear();
+    CIOBuf keep = chain.Slice(0, 1);   // 空链切片
+    CIOBuf copy(slice);
+    slice.Clear();
+    bool bRef = keep.Empty() && copy.Size() == 2500 && IobufCheck(copy, 3500);
+    printf("  原链/切片释放后副本%zu字节：%s\n", copy.Size(), bRef ? "仍然有效" : "错误");
+    if (!bRef) errors++;
+
+    // 第6步：块大小：小消息按请求大小分配（不占整页），Reserve给流式累积留整页
+    CIOBuf small(data, 30);
+    small.Append(data, 300);
+    CIOBuf stream;
+    memcpy(stream.Reserve(30), data, 30);
+    stream.Commit(30);
+    memcpy(stream.Reserve(300), data, 300);
+    stream.Commit(300);
+    printf("  30字节 + 300字节：Append %u段（小块放不下），Reserve %u段（整页里接着写）\n",
+        small.Count(), stream.Count());
+    if (small.Count() != 2 || stream.Count() != 1) errors++;
+
+    // 第7步：Send短写：剩余部分进发送队列，Flush写完，对端收到的字节完整有序
+    CTcpSocket server;
+    if (server.Init(CSockParam("127.0.0.1", IOBUF_TEST_PORT, SOCK_ISSERVER | SOCK_ISBLOCK | SOCK_ISREUSE)) != 0) return -1;
+    sockaddr_in addr = CSockParam("127.0.0.1", IOBUF_TEST_PORT, 0).addr_in;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) return -2;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    std::vector<CSocketBase*> peers;
+    while (peers.empty()) server.LinkBatch(peers);
+    CSocketBase* peer = peers[0];
+    int sndbuf = 16 * 1024;
+    setsockopt((int)*peer, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    CIOBuf message;   // 200多段，超过IOBUF_IOV_MAX
+    for (size_t base = 0; base < IOBUF_TEST_SEND; base += 9000) {
+        size_t n = IOBUF_TEST_SEND - base < 9000 ? IOBUF_TEST_SEND - base : 9000;
+        char* p = message.Reserve(n);
+        for (size_t i = 0; i < n; i++) p[i] = IobufByte(base + i);
+        message.Commit(n);
+    }
+    int ret = peer->Send(message);
+    size_t queued = peer->Output().Pending();
+    size_t received = 0, mismatch = 0;
+    char buf[65536];
+    pollfd pfd[2] = { { fd, POLLIN, 0 }, { (int)*peer, POLLOUT, 0 } };   // 对端可读 / 本端可写
+    while (received < IOBUF_TEST_SEND && poll(pfd, 2, 1000) > 0) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        for (ssize_t i = 0; i < n; i++) {
+            if (buf[i] != IobufByte(received + i)) mismatch++;
+        }
+        if (n > 0) received += (size_t)n;
+        if (peer->Flush() == -2) break;
+    }
+    printf("  Send %zu字节（%u段）：返回%d，入队%zu字节，对端收到%zu字节，不一致%zu\n\n",
+        message.Size(), message.Count(), ret, queued, received, mismatch);
+    if (ret != IOBUF_TEST_SEND || queued == 0 || received != IOBUF_TEST_SEND || mismatch != 0) errors++;
+
+    close(fd);
+    CSocketBase::Free(peer);
+    return errors == 0 ? 0 : -3;
+}
+
+// ==========================================
+// 登录风暴压测：accept路径
+// 模拟服务器重启后大量客户端同时重连
+// ==========================================
+
+// 压测客户端线程：连接count次，连接保持到服务器统计结束
+static void StormClient(int port, int count, std::atomic<int>* connected,
+    std::atomic<int>* failed, std::atomic<bool>* done) {
+    std::vector<CTcpSocket*> socks;
+    for (int i = 0; i < count; i++) {
+        CTcpSocket* sock = new CTcpSocket();
+        if ((sock->Init(CSockParam("127.0.0.1", port, 0)) != 0) || (sock->Link() != 0)) {
+            (*failed)++;
+            delete sock;
+            continue;
+        }
+        (*connected)++;
+        socks.push_back(sock);
+    }
+    while (!*done) usleep(1000);
+    for (auto sock : socks) delete sock;
+}
+
+// 一轮压测
+// bBatch：true=LinkBatch一次取完，false=每个事件只Link一个（旧做法）
+static int LoginStormRound(bool bBatch, int backlog, int port, int total, int threads) {
+    CSockParam param("127.0.0.1", port,
+        SOCK_ISSERVER | SOCK_ISBLOCK | SOCK_ISREUSE | SOCK_ISNODELAY);
+    param.backlog = backlog;
+
+    CTcpSocket server;
+    int ret = server.Init(param);
+    if (ret != 0) {
+        printf("❌ 服务器初始化失败: %d errno:%d\n", ret, errno);
+        return -1;
+    }
+    CEpoll epoll;
+    epoll.Create(1);
+    epoll.Add(server, EpollData((void*)&server), EPOLLIN);
+
+    std::atomic<int> connected(0), failed(0);
+    std::atomic<bool> done(false);
+    std::vector<CThread*> clients;
+
+    timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int i = 0; i < threads; i++) {
+        clients.push_back(new CThread(StormClient, port, total / threads,
+            &connected, &failed, &done));
+        clients.back()->Start();
+    }
+
+    // 服务器事件循环：直到全部accept
+    std::vector<CSocketBase*> accepted;
+    int wakeups = 0;
+    EPEvents events;
+    while ((int)accepted.size() + failed < total) {
+        ssize_t n = epoll.WaitEvents(events, 10);
+        if (n <= 0) continue;
+        wakeups++;
+        if (bBatch) {
+            server.LinkBatch(accepted);
+        }
+        else {
+            CSocketBase* pClient = NULL;
+            if (server.Link(&pClient) == 0) accepted.push_back(pClient);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ms = (end.tv_sec - begin.tv_sec) * 1000.0 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+    printf("  %-10s backlog=%-5d 接受=%-6zu 失败=%-4d 唤醒=%-6d 耗时=%.1fms (%.0f 连接/秒)\n",
+        bBatch ? "LinkBatch" : "Link", backlog, accepted.size(), (int)failed, wakeups,
+        ms, accepted.size() * 1000.0 / ms);
+
+    done = true;
+    usleep(200 * 1000);  // 等客户端线程关闭连接
+    for (auto pClient : accepted) CSocketBase::Free(pClient);
+    for (auto thread : clients) delete thread;
+    return 0;
+}
+
+int TestLoginStorm() {
+    printf("\n========================================\n");
+    printf("  登录风暴压测（accept路径）\n");
+    printf("========================================\n\n");
+
+    // 每个连接两端各占一个fd，先把fd上限提到最大
+    rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    int total = (int)((rl.rlim_cur - 64) / 2);
+    if (total > 4000) total = 4000;
+    int threads = 8;
+    total = total / threads * threads;
+    printf("客户端：%d 个连接，%d 个线程并发发起\n\n", total, threads);
+
+    // 旧做法：backlog=10，一次一个（队列溢出的SYN要等1秒以上重传，太慢，只测十分之一）
+    LoginStormRound(false, 10, 19700, total / 10, threads);
+    LoginStormRound(false, SOMAXCONN, 19701, total, threads);  // 只调大backlog
+    LoginStormRound(true, SOMAXCONN, 19702, total, threads);   // accept4循环取空队列
+
+    printf("\n");
+    return 0;
+}
+
+// ============================================
+// 缓冲区池压测：每线程反复分配/释放不同大小的缓冲区
+// ============================================
+static const size_t g_poolSizes[] = { 8, 64, 200, 1500, 4096, 16384, 65536 };
+
+void PoolWorker(bool bPool, int rounds, std::atomic<size_t>* checksum) {
+    size_t sum = 0;
+    for (int i = 0; i < rounds; i++) {
+        size_t size = g_poolSizes[i % 7];
+        if (bPool) {
+            char* p = (char*)CBufferPool::Instance().Alloc(size);
+            p[0] = (char)i;
+            sum += (unsigned char)p[0];
+            CBufferPool::Instance().Free(p, size);
+        }
+        else {
+            Buffer data(size);  // 旧做法：malloc + 清零
+            data[0] = (char)i;
+            sum += (unsigned char)data[0];
+        }
+    }
+    *checksum += sum;
+}
+
+int TestBufferPool() {
+    printf("\n========================================\n");
+    printf("  缓冲区池压测\n");
+    printf("========================================\n\n");
+
+    const int threads = 4, rounds = 2000000;
+    std::atomic<size_t> checksum(0);
+    for (int mode = 0; mode < 2; mode++) {
+        timespec begin, end;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        std::vector<std::thread> workers;
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back(PoolWorker, mode == 1, rounds, &checksum);
+        }
+        for (auto& t : workers) t.join();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double ms = (end.tv_sec - begin.tv_sec) * 1000.0 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+        printf("  %-16s %d线程 x %d次 耗时=%.1fms (%.1f ns/次)\n",
+            mode ? "CBufferPool" : "Buffer(size)", threads, rounds, ms,
+            ms * 1e6 / ((double)threads * rounds));
+    }
+
+    PoolStats stats = CBufferPool::Instance().Stats();
+    printf("\n  命中=%llu 批量取回=%llu 新分配=%llu 归还=%llu 超大块=%llu\n",
+        (unsigned long long)stats.hits, (unsigned long long)stats.refills,
+        (unsigned long long)stats.misses, (unsigned long long)stats.frees,
+        (unsigned long long)stats.oversize);
+    printf("  (checksum=%zu)\n\n", (size_t)checksum);
+    return 0;
+}
+
+// ============================================
+// 大块传输压测：同一份数据分别用 read+send / sendfile / MSG_ZEROCOPY 发出
+// 关注发送线程的CPU时间（大块传输不能挤占游戏逻辑的CPU和内存带宽）
+// ============================================
+#define BULK_SIZE (128 * 1024 * 1024)
+#define BULK_CHUNK (1024 * 1024)
+
+void BulkReceiver(int port, std::atomic<size_t>* received) {
+    CTcpSocket client;
+    if (client.Init(CSockParam("127.0.0.1", port, 0)) != 0) return;
+    if (client.Link() != 0) return;
+    Buffer data(256 * 1024);
+    int ret = 0;
+    while ((ret = client.Recv(data)) > 0) *received += ret;
+}
+
+static void WaitSocket(int fd, short events) {
+    pollfd pfd = { fd, events, 0 };
+    poll(&pfd, 1, 100);
+}
+
+void BulkRound(CTcpSocket& server, int port, int mode, int file, const CIOBuf& memory) {
+    const char* names[] = { "read+send", "SendFile", "SendZeroCopy" };
+    std::atomic<size_t> received(0);
+    std::thread receiver(BulkReceiver, port, &received);
+
+    CSocketBase* pClient = NULL;
+    while (server.Link(&pClient) != 0) usleep(1000);
+    CTcpSocket* conn = (CTcpSocket*)pClient;
+    int fd = (int)*conn;
+
+    rusage ru0, ru1;
+    timespec begin, end;
+    getrusage(RUSAGE_THREAD, &ru0);
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+
+    if (mode == 0) {
+        // 旧做法：读进Buffer再send（两次拷贝）
+        Buffer chunk(BULK_CHUNK);
+        for (off_t offset = 0; offset < BULK_SIZE;) {
+            ssize_t n = pread(file, (char*)chunk, chunk.size(), offset);
+            if (n <= 0) break;
+            for (ssize_t done = 0; done < n;) {
+                ssize_t r = send(fd, (char*)chunk + done, n - done, 0);
+                if (r > 0) done += r;
+                else WaitSocket(fd, POLLOUT);
+            }
+            offset += n;
+        }
+    }
+    else if (mode == 1) {
+        off_t offset = 0;
+        while (offset < BULK_SIZE) {
+            int r = conn->SendFile(file, offset, BULK_SIZE - offset);
+            if (r < 0) break;
+            if (r == 0) WaitSocket(fd, POLLOUT);
+        }
+    }
+    else {
+        conn->EnableZeroCopy();
+        size_t offset = 0;
+        while (offset < memory.Size()) {
+            size_t len = memory.Size() - offset;
+            if (len > BULK_CHUNK) len = BULK_CHUNK;
+            int r = conn->SendZeroCopy(memory.Slice(offset, len));
+            if (r < 0) break;
+            if (r == 0) WaitSocket(fd, POLLOUT);
+            offset += r;
+            conn->ReapZeroCopy();
+        }
+        while (conn->ZeroCopyPending() > 0) {  // 等全部完成通知
+            WaitSocket(fd, 0);  // 只等POLLERR（错误队列）
+            conn->ReapZeroCopy();
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getrusage(RUSAGE_THREAD, &ru1);
+    uint64_t copied = (mode == 2) ? conn->ZeroCopyCopied() : 0;
+    CSocketBase::Free(pClient);  // 关闭连接，接收端读到结尾退出
+    receiver.join();
+
+    double ms = (end.tv_sec - begin.tv_sec) * 1000.0 + (end.tv_nsec - begin.tv_nsec) / 1e6;
+    double cpu = (ru1.ru_utime.tv_sec - ru0.ru_utime.tv_sec) * 1000.0 +
+        (ru1.ru_utime.tv_usec - ru0.ru_utime.tv_usec) / 1000.0 +
+        (ru1.ru_stime.tv_sec - ru0.ru_stime.tv_sec) * 1000.0 +
+        (ru1.ru_stime.tv_usec - ru0.ru_stime.tv_usec) / 1000.0;
+    printf("  %-13s 接收=%zuMB 耗时=%.1fms (%.0f MB/s) 发送线程CPU=%.1fms",
+        names[mode], (size_t)received >> 20, ms, (BULK_SIZE >> 20) * 1000.0 / ms, cpu);
+    if (mode == 2) printf(" 退化为拷贝=%llu次", (unsigned long long)copied);
+    printf("\n");
+}
+
+int TestBulkTransfer() {
+    printf("\n========================================\n");
+    printf("  大块传输压测（%dMB）\n", BULK_SIZE >> 20);
+    printf("========================================\n\n");
+
+    // 准备一个临时文件（打开后立即删除，进程退出自动回收）
+    char path[] = "/tmp/bulkXXXXXX";
+    int file = mkstemp(path);
+    if (file == -1) return -1;
+    unlink(path);
+    CIOBuf memory(BULK_SIZE, 0);  // 同样的数据在内存里也放一份（零拷贝发送用）
+    char* p = memory.Reserve(BULK_SIZE);
+    for (size_t i = 0; i < BULK_SIZE; i++) p[i] = (char)(i * 131);
+    memory.Commit(BULK_SIZE);
+    if (write(file, p, BULK_SIZE) != BULK_SIZE) return -2;
+
+    int port = 19710;
+    CTcpSocket server;
+    CSockParam param("127.0.0.1", port, SOCK_ISSERVER | SOCK_ISREUSE);
+    if (server.Init(param) != 0) return -3;
+
+    for (int mode = 0; mode < 3; mode++) {
+        BulkRound(server, port, mode, file, memory);
+    }
+    printf("  （回环上内核会把零拷贝退化成拷贝，真实网卡上才有收益）\n\n");
+    close(file);
+    return 0;
+}
+
+// ==================== 可靠UDP回环测试 ====================
+// 服务器和客户端两个endpoint挂在同一个epoll上，双向都注入丢包和延迟：
+// 客户端发可靠消息（有的超过MSS需要分片），服务器原样回显，客户端检查顺序和内容；
+// 同时每轮发一个不可靠有序的"位置"，服务器检查序号只增不减
+#define RUDP_TEST_COUNT 2000
+
+static size_t RudpTestSize(uint32_t i) { return 8 + (i * 7919) % 3000; }
+
+static bool RudpTestCheck(const char* data, size_t size, uint32_t i) {
+    if (size != RudpTestSize(i)) return false;
+    uint32_t index = 0;
+    memcpy(&index, data, sizeof(index));
+    if (index != i) return false;
+    for (size_t k = sizeof(index); k < size; k++) {
+        if (data[k] != (char)(i + k)) return false;
+    }
+    return true;
+}
+
+int TestReliableUdp() {
+    printf("\n========================================\n");
+    printf("  可靠UDP回环测试（丢包10%%，单向延迟20±5ms）\n");
+    printf("========================================\n\n");
+
+    int port = 19720;
+    CRudpEndpoint server, client;
+    if (server.Init(CSockParam("127.0.0.1", port, SOCK_ISSERVER | SOCK_ISREUSE)) != 0) return -1;
+    if (client.Init(CSockParam("0.0.0.0", 0, 0)) != 0) return -2;
+
+    CLossInjector serverLoss, clientLoss;
+    serverLoss.Set(0.1, 20, 5);
+    clientLoss.Set(0.1, 20, 5);
+    server.SetInjector(&serverLoss);
+    client.SetInjector(&clientLoss);
+
+    // 服务器：可靠消息回显，不可靠有序只检查序号
+    int lastPos = -1, positions = 0, reversed = 0;
+    server.OnMessage = [&](CRudpSession* session, int channel, const char* data, size_t size) {
+        if (channel == RUDP_RELIABLE) {
+            session->Send(data, size, RUDP_RELIABLE);
+            return;
+        }
+        int pos = 0;
+        memcpy(&pos, data, sizeof(pos));
+        if (pos <= lastPos) reversed++;
+        lastPos = pos;
+        positions++;
+    };
+
+    // 客户端：回显必须按发送顺序、内容不变
+    uint32_t echoed = 0;
+    int errors = 0;
+    client.OnMessage = [&](CRudpSession*, int channel, const char* data, size_t size) {
+        if (channel != RUDP_RELIABLE) return;
+        if (!RudpTestCheck(data, size, echoed)) errors++;
+        echoed++;
+    };
+    bool bConnected = false;
+    client.OnConnect = [&](CRudpSession*) { bConnected = true; };
+
+    CEpoll epoll;
+    if (epoll.Create(16) != 0) return -3;
+    server.Attach(epoll);
+    client.Attach(epoll);
+
+    sockaddr_in to = CSockParam("127.0.0.1", port, 0).addr_in;
+    CRudpSession* session = client.Connect(to);
+    if (session == NULL) return -4;
+
+    uint32_t begin = CRudpEndpoint::Clock();
+    uint32_t sent = 0;
+    int pos = 0;
+    std::string message;
+    EPEvents events;
+    while (echoed < RUDP_TEST_COUNT && CRudpEndpoint::Clock() - begin < 60000) {
+        // 发送端：待确认的段不超过窗口的一半时继续塞（模拟持续的业务流量）
+        while (bConnected && sent < RUDP_TEST_COUNT && session->WaitSend() < 128) {
+            message.resize(RudpTestSize(sent));
+            memcpy(&message[0], &sent, sizeof(sent));
+            for (size_t k = sizeof(sent); k < message.size(); k++) message[k] = (char)(sent + k);
+            session->Send(message.data(), message.size(), RUDP_RELIABLE);
+            sent++;
+        }
+        if (bConnected) {
+            session->Send((const char*)&pos, sizeof(pos), RUDP_SEQUENCED);
+            pos++;
+        }
+
+        int timeout = server.NextTimeout() < client.NextTimeout() ? server.NextTimeout() : client.NextTimeout();
+        ssize_t n = epoll.WaitEvents(events, timeout);
+        for (ssize_t i = 0; i < n; i++) {
+            ((CRudpEndpoint*)events[i].data.ptr)->OnReadable();
+        }
+        server.Update();
+        client.Update();
+    }
+    uint32_t elapsed = CRudpEndpoint::Clock() - begin;
+
+    RudpStats stats = session->Stats();
+    printf("  可靠消息：回显 %u/%u 条，内容/顺序错误 %d，耗时 %ums\n",
+        echoed, RUDP_TEST_COUNT, errors, elapsed);
+    printf("  客户端：发出段=%llu 超时重传=%llu 快速重传=%llu srtt=%ums rto=%ums\n",
+        (unsigned long long)stats.sentSegments, (unsigned long long)stats.timeouts,
+        (unsigned long long)stats.fastResends, stats.srtt, stats.rto);
+    printf("  不可靠有序：发出 %d，服务器收到 %d（丢失/过期 %d），乱序交付 %d\n\n",
+        pos, positions, pos - positions, reversed);
+
+    session->Close();
+    client.Close();
+    server.Close();
+    return (echoed == RUDP_TEST_COUNT && errors == 0 && reversed == 0) ? 0 : -5;
+}
+
+// ==================== 连接分派表压测 ====================
+// 1万个会话，按连接ID随机查找：std::unordered_map vs CConnTable
+// 再开3个读线程并发查找，写线程同时不断删除/插入/重绑定，被替换的值退休后释放
+#define CONN_TEST_SESSIONS 10000
+#define CONN_TEST_LOOKUPS 10000000
+
+// 释放前先写成-1：读线程如果在guard期间读到-1，说明被提前释放了
+static void ConnTestFree(void* p) {
+    *(volatile int*)p = -1;
+    delete (int*)p;
+}
+
+int TestConnTable() {
+    printf("\n========================================\n");
+    printf("  连接分派表压测（%d个会话）\n", CONN_TEST_SESSIONS);
+    printf("========================================\n\n");
+
+    std::vector<uint32_t> convs(CONN_TEST_SESSIONS);
+    std::vector<int> values(CONN_TEST_SESSIONS);
+    std::vector<sockaddr_in> addrs(CONN_TEST_SESSIONS);
+    uint32_t seed = 12345;
+    for (int i = 0; i < CONN_TEST_SESSIONS; i++) {
+        seed = seed * 1664525 + 1013904223;
+        convs[i] = seed | 1;
+        values[i] = i;
+        addrs[i] = CSockParam("10.0.0.1", 1024 + i, 0).addr_in;
+    }
+
+    std::unordered_map<uint32_t, int*> map;
+    CConnTable<int> table;
+    for (int i = 0; i < CONN_TEST_SESSIONS; i++) {
+        map[convs[i]] = &values[i];
+        table.Insert(convs[i], addrs[i], &values[i]);
+    }
+
+    // 第1步：单线程查找（第3轮每次查找都带CConnGuard，看宣告的开销）
+    const char* names[] = { "unordered_map", "CConnTable", "CConnTable+guard" };
+    for (int round = 0; round < 3; round++) {
+        timespec begin, end;
+        size_t found = 0;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (int i = 0; i < CONN_TEST_LOOKUPS; i++) {
+            uint32_t conv = convs[((size_t)i * 7919) % CONN_TEST_SESSIONS];
+            if (round == 0) found += map.find(conv) != map.end();
+            else if (round == 1) found += table.Find(conv) != NULL;
+            else {
+                CConnGuard guard;
+                found += table.Find(conv) != NULL;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double ns = ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / CONN_TEST_LOOKUPS;
+        printf("  %-16s 每次查找 %.1fns（命中 %zu）\n", names[round], ns, found);
+    }
+
+    // 第2步：3个读线程 + 1个写线程（前一半会话反复删除/插入/重绑定，后一半不动）
+    //        前一半每次插入新分配的值，旧值退休：读线程在guard期间读到的值必须还没被释放
+    std::atomic<bool> bStop(false);
+    std::atomic<size_t> lookups(0), errors(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; t++) {
+        readers.emplace_back([&, t]() {
+            size_t n = 0;
+            for (int i = t; !bStop; i++) {
+                CConnGuard guard;
+                int k = CONN_TEST_SESSIONS / 2 + i % (CONN_TEST_SESSIONS / 2);
+                int* p = table.Find(convs[k]);  // 不动的那一半必须一直查得到
+                if (p == NULL || *p != k) errors++;
+                int* q = table.Find(convs[i % (CONN_TEST_SESSIONS / 2)]);  // 变动的那一半：查到就必须是对的
+                if (q != NULL && *q != i % (CONN_TEST_SESSIONS / 2)) errors++;
+                n += 2;
+            }
+            lookups += n;
+        });
+    }
+    uint32_t begin = CRudpEndpoint::Clock();
+    size_t writes = 0;
+    while (CRudpEndpoint::Clock() - begin < 1000) {
+        for (int i = 0; i < CONN_TEST_SESSIONS / 2; i++, writes++) {
+            sockaddr_in moved = addrs[i];
+            moved.sin_port = htons(40000 + i % 20000);
+            int* old = table.Find(convs[i]);
+            table.Erase(convs[i], addrs[i]);
+            table.Insert(convs[i], addrs[i], new int(i));
+            table.Rebind(convs[i], addrs[i], moved);
+            table.Rebind(convs[i], moved, addrs[i]);
+            if (old != &values[i]) table.Retire(old, ConnTestFree);
+        }
+        table.Reclaim();
+    }
+    bStop = true;
+    for (auto& t : readers) t.join();
+    size_t pending = table.Reclaim();   // 读线程都退出了：应该全部释放
+    printf("  并发：读 %zu 次，写 %zu 轮，错误 %zu，容量 %zu，退休未释放 %zu\n\n",
+        (size_t)lookups, writes, (size_t)errors, table.Capacity(), pending);
+    for (int i = 0; i < CONN_TEST_SESSIONS / 2; i++) delete table.Find(convs[i]);
+    return (errors == 0 && pending == 0) ? 0 : -1;
+}
+
+// ==================== 会话超时压测 ====================
+// 10万个会话：一半每秒都有数据（保持活跃），另一半从头到尾空闲
+// 空闲2秒断开，0.5秒没发过数据就发心跳，时间轮刻度10ms
+// 对比：每个刻度遍历全部会话检查时间戳
+#define SESSION_TEST_COUNT 100000
+
+int TestSessionManager() {
+    printf("\n========================================\n");
+    printf("  会话超时压测（%d个会话）\n", SESSION_TEST_COUNT);
+    printf("========================================\n\n");
+
+    CSessionManager sessions;
+    if (sessions.Init(2000, 500, 10) != 0) return -1;
+    size_t beats = 0, batches = 0, expired = 0;
+    sessions.OnHeartbeat = [&](std::vector<CSession*>& batch) { beats += batch.size(); batches++; };
+    sessions.OnTimeout = [&](CSession*) { expired++; };
+
+    std::vector<uint64_t> handles(SESSION_TEST_COUNT);
+    for (int i = 0; i < SESSION_TEST_COUNT; i++) handles[i] = sessions.Add(NULL)->handle;
+
+    // 第1步：时间轮
+    size_t ticks = 0, cursor = 0;
+    uint64_t cost = 0, worst = 0;
+    uint64_t begin = CSessionManager::Clock();
+    while (CSessionManager::Clock() - begin < 3000) {
+        // 活跃的一半：每10ms摸500个，每个会话1秒内至少收到一次数据
+        for (int k = 0; k < SESSION_TEST_COUNT / 200; k++) {
+            sessions.Touch(sessions.Get(handles[cursor]));
+            cursor = (cursor + 1) % (SESSION_TEST_COUNT / 2);
+        }
+        timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        sessions.Tick();
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        uint64_t ns = (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+        cost += ns;
+        if (ns > worst) worst = ns;
+        ticks++;
+        usleep(10000);
+    }
+    printf("  时间轮：%zu轮，平均每轮 %.1fus，最慢 %.1fus\n", ticks, cost / 1000.0 / ticks, worst / 1000.0);
+    printf("          心跳 %zu 个（%zu批），超时 %zu 个，剩余 %zu 个\n",
+        beats, batches, expired, sessions.Count());
+
+    // 第2步：对比——每轮遍历全部会话（只检查，不做任何处理）
+    std::vector<CSession*> all(SESSION_TEST_COUNT);
+    for (int i = 0; i < SESSION_TEST_COUNT; i++) {
+        all[i] = CSessionSlab::Instance().Create();
+        all[i]->lastRecv = all[i]->lastSend = CSessionManager::Clock();
+    }
+    timespec t0, t1;
+    size_t due = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int round = 0; round < 100; round++) {
+        uint64_t now = CSessionManager::Clock();
+        for (int i = 0; i < SESSION_TEST_COUNT; i++) {
+            if (now >= all[i]->lastRecv + 2000 || now >= all[i]->lastSend + 500) due++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("  全表遍历：平均每轮 %.1fus（到期 %zu）\n\n",
+        ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1000.0 / 100, due);
+    for (int i = 0; i < SESSION_TEST_COUNT; i++) CSessionSlab::Instance().Destroy(all[i]);
+
+    sessions.Close();
+    return expired == SESSION_TEST_COUNT / 2 ? 0 : -2;
+}
+
+// ==================== 广播压测 ====================
+// 房间里500个连接，每轮广播一条1KB的状态（8字节头部里写每个连接自己的序号）
+// 旧做法：每个连接构造一个Buffer（分配 + 拷贝头部和消息体）
+// CBroadcast：消息体编码一次，每个连接只拷8字节头部 + 挂消息体引用
+// （writev的耗时两者差不多：回环上主要是系统调用本身）
+#define BROADCAST_TEST_CONNS 500
+#define BROADCAST_TEST_ROUNDS 200
+#define BROADCAST_TEST_BODY 1024
+
+static void DrainClients(const std::vector<int>& fds, size_t* bytes) {
+    char buf[65536];
+    for (size_t i = 0; i < fds.size(); i++) {
+        ssize_t n = 0;
+        while ((n = read(fds[i], buf, sizeof(buf))) > 0) *bytes += n;
+    }
+}
+
+int TestBroadcast() {
+    printf("\n========================================\n");
+    printf("  广播压测（%d个连接，%d字节消息体）\n", BROADCAST_TEST_CONNS, BROADCAST_TEST_BODY);
+    printf("========================================\n\n");
+
+    rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+
+    int port = 19730;
+    CTcpSocket server;
+    if (server.Init(CSockParam("127.0.0.1", port, SOCK_ISSERVER | SOCK_ISBLOCK | SOCK_ISREUSE)) != 0) return -1;
+
+    // 第1步：建立连接（客户端用裸fd，非阻塞读）
+    std::vector<int> clients;
+    std::vector<CSocketBase*> players;
+    sockaddr_in addr = CSockParam("127.0.0.1", port, 0).addr_in;
+    for (int i = 0; i < BROADCAST_TEST_CONNS; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == -1 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) return -2;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        clients.push_back(fd);
+        server.LinkBatch(players);
+    }
+    while (players.size() < clients.size()) server.LinkBatch(players);
+
+    CIOBuf body(BROADCAST_TEST_BODY, 0);
+    char* p = body.Reserve(BROADCAST_TEST_BODY);
+    for (int i = 0; i < BROADCAST_TEST_BODY; i++) p[i] = (char)i;
+    body.Commit(BROADCAST_TEST_BODY);
+    std::vector<uint32_t> seqs(players.size(), 0);
+
+    // 第2步：两种做法各跑一遍
+    for (int mode = 0; mode < 2; mode++) {
+        size_t received = 0;
+        uint64_t cost = 0, flushCost = 0;
+        std::vector<CSocketBase*> dirty;
+        CBroadcast msg;
+        uint32_t header[2] = { BROADCAST_TEST_BODY, 0 };  // 长度 + 序号
+        msg.Set(body, (const char*)header, sizeof(header));
+        msg.Patch = [&](size_t i, CSocketBase*, char* h, size_t) {
+            uint32_t seq = seqs[i]++;
+            memcpy(h + 4, &seq, sizeof(seq));
+        };
+
+        for (int round = 0; round < BROADCAST_TEST_ROUNDS; round++) {
+            timespec t0, t1, t2;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            if (mode == 0) {
+                for (size_t i = 0; i < players.size(); i++) {
+                    Buffer data(sizeof(header) + BROADCAST_TEST_BODY);
+                    header[1] = seqs[i]++;
+                    memcpy((char*)data, header, sizeof(header));
+                    body.CopyTo((char*)data + sizeof(header), 0, BROADCAST_TEST_BODY);
+                    if (players[i]->SendAsync(std::move(data)) == 1) dirty.push_back(players[i]);
+                }
+            }
+            else {
+                msg.Send(players, &dirty);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            CBroadcast::FlushAll(dirty);
+            clock_gettime(CLOCK_MONOTONIC, &t2);
+            cost += (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+            flushCost += (t2.tv_sec - t1.tv_sec) * 1000000000ull + (t2.tv_nsec - t1.tv_nsec);
+            DrainClients(clients, &received);
+        }
+        // 剩余的（套接字缓冲区满时留在队列里的）
+        for (int k = 0; k < 100 && received < (size_t)BROADCAST_TEST_ROUNDS * players.size() *
+            (sizeof(header) + BROADCAST_TEST_BODY); k++) {
+            for (auto player : players) player->Flush();
+            DrainClients(clients, &received);
+        }
+        size_t copied = players.size() * (mode == 0 ? sizeof(header) + BROADCAST_TEST_BODY : sizeof(header));
+        printf("  %-10s 每次广播：入队 %.1fus，拷贝 %zuKB；writev %.1fus；收到 %zuKB\n",
+            mode == 0 ? "Buffer" : "CBroadcast", cost / 1000.0 / BROADCAST_TEST_ROUNDS, copied >> 10,
+            flushCost / 1000.0 / BROADCAST_TEST_ROUNDS, received >> 10);
+    }
+    PoolStats stats = CBufferPool::Instance().Stats();
+    printf("  缓冲区池：命中 %llu，新分配 %llu\n\n",
+        (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+
+    for (auto player : players) CSocketBase::Free(player);
+    for (auto fd : clients) close(fd);
+    return 0;
+}
+
+// ==================== 视野管理压测 ====================
+// 2万个实体在2000×2000的地图上随机走动（每帧一半在动），视野半径50
+// 串行更新 vs 线程池按区域并行；最后和暴力O(N²)的结果核对
+#define AOI_TEST_ENTITIES 20000
+#define AOI_TEST_TICKS 100
+
+static float AoiRandom(uint32_t& seed) {
+    seed = seed * 1664525 + 1013904223;
+    return (seed >> 8) / 16777216.0f;
+}
+
+int TestAoi() {
+    printf("\n========================================\n");
+    printf("  视野管理压测（%d个实体）\n", AOI_TEST_ENTITIES);
+    printf("========================================\n\n");
+
+    CThreadPool pool;
+    if (pool.Start(4) != 0) return -1;
+
+    uint64_t costs[2] = { 0, 0 };
+    int ret = 0;
+    for (int mode = 0; mode < 2; mode++) {
+        CAoiGrid aoi;
+        if (aoi.Init(2000, 2000, 50, AOI_TEST_ENTITIES) != 0) return -2;
+        std::vector<float> xs(AOI_TEST_ENTITIES), ys(AOI_TEST_ENTITIES);
+        uint32_t seed = 2024;
+        for (uint32_t i = 0; i < AOI_TEST_ENTITIES; i++) {
+            xs[i] = AoiRandom(seed) * 2000;
+            ys[i] = AoiRandom(seed) * 2000;
+            aoi.Add(i, xs[i], ys[i]);
+        }
+        aoi.Update(mode == 0 ? NULL : &pool);
+
+        uint64_t cost = 0;
+        size_t events = 0, aoiMessages = 0, allMessages = 0;
+        for (int tick = 0; tick < AOI_TEST_TICKS; tick++) {
+            for (uint32_t i = 0; i < AOI_TEST_ENTITIES; i++) {
+                if (AoiRandom(seed) < 0.5f) continue;
+                xs[i] += (AoiRandom(seed) - 0.5f) * 10;
+                ys[i] += (AoiRandom(seed) - 0.5f) * 10;
+                aoi.Move(i, xs[i], ys[i]);
+            }
+            timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            aoi.Update(mode == 0 ? NULL : &pool);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            cost += (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+
+            // 位置广播：只发给视野内的 vs 发给所有人
+            events += aoi.Events().size();
+            for (auto id : aoi.Moved()) aoiMessages += aoi.View(id).size();
+            allMessages += aoi.Moved().size() * (AOI_TEST_ENTITIES - 1);
+        }
+
+        // 核对：抽200个实体，暴力计算视野（Move会截断到地图内，这里同样截断）
+        int errors = 0;
+        for (uint32_t k = 0; k < 200; k++) {
+            uint32_t id = k * (AOI_TEST_ENTITIES / 200);
+            std::vector<uint32_t> expect;
+            float x = std::min(std::max(xs[id], 0.0f), 2000.0f), y = std::min(std::max(ys[id], 0.0f), 2000.0f);
+            for (uint32_t j = 0; j < AOI_TEST_ENTITIES; j++) {
+                float ox = std::min(std::max(xs[j], 0.0f), 2000.0f), oy = std::min(std::max(ys[j], 0.0f), 2000.0f);
+                if (j != id && (ox - x) * (ox - x) + (oy - y) * (oy - y) <= 50.0f * 50.0f) expect.push_back(j);
+            }
+            if (expect != aoi.View(id)) errors++;
+        }
+        printf("  %-6s 每帧 %.2fms，事件 %zu/帧，位置消息 %zu/帧（全发：%zu/帧），核对错误 %d\n",
+            mode == 0 ? "串行" : "4线程", cost / 1e6 / AOI_TEST_TICKS, events / AOI_TEST_TICKS,
+            aoiMessages / AOI_TEST_TICKS, allMessages / AOI_TEST_TICKS, errors);
+        costs[mode] = cost;
+        if (errors > 0) ret = -3;
+    }
+
+    // 并行要真的快：4核以上至少快20%（第1阶段占大头；核不够时线程只是轮流跑，不比）
+    unsigned cores = std::thread::hardware_concurrency();
+    printf("  加速比 %.2f（%u核）\n", costs[1] > 0 ? (double)costs[0] / costs[1] : 0.0, cores);
+    if (cores >= 4 && costs[1] * 10 > costs[0] * 8) {
+        printf("  ❌ 4线程没有比串行快（区域任务没有分到多个线程上）\n");
+        if (ret == 0) ret = -4;
+    }
+    printf("\n");
+    pool.Close();
+    return ret;
+}
+
+// ==================== 快照增量压测 ====================
+// 5000个实体、8个字段（量化后的坐标、朝向、血量、状态…），每帧20%的实体移动、2%掉血、偶尔出生/死亡
+// 三个客户端：每帧确认 / 丢10%的包、确认晚5帧 / 从不确认（每次全量）
+// 客户端解码后逐帧和服务器核对
+#define SNAP_TEST_ENTITIES 5000
+#define SNAP_TEST_FIELDS 8
+#define SNAP_TEST_TICKS 300
+
+int TestSnapshot() {
+    printf("\n========================================\n");
+    printf("  快照增量压测（%d个实体 × %d个字段）\n", SNAP_TEST_ENTITIES, SNAP_TEST_FIELDS);
+    printf("========================================\n\n");
+
+    CSnapshotRing server;
+    if (server.Init(SNAP_TEST_ENTITIES, SNAP_TEST_FIELDS) != 0) return -1;
+
+    const int CLIENTS = 3;
+    const char* names[CLIENTS] = { "每帧确认", "丢包+确认晚5帧", "从不确认" };
+    CSnapshotRing views[CLIENTS];
+    CSnapshotClient acks[CLIENTS];
+    std::vector<std::pair<int, uint32_t>> pending;   // {客户端, 帧号}：晚到的确认
+    size_t bytes[CLIENTS] = { 0 }, packets[CLIENTS] = { 0 };
+    int errors = 0, rejected = 0;
+    for (int c = 0; c < CLIENTS; c++) views[c].Init(SNAP_TEST_ENTITIES, SNAP_TEST_FIELDS);
+
+    uint32_t seed = 7;
+    auto rnd = [&seed](uint32_t n) { seed = seed * 1664525 + 1013904223; return (seed >> 8) % n; };
+    uint64_t encodeCost = 0;
+    size_t fullBytes = 0;
+
+    for (uint32_t tick = 1; tick <= SNAP_TEST_TICKS; tick++) {
+        server.Begin(tick);
+        if (tick == 1) {
+            for (uint32_t id = 0; id < SNAP_TEST_ENTITIES; id++) {
+                server.SetAlive(id, true);
+                for (unsigned f = 0; f < SNAP_TEST_FIELDS; f++) server.Set(id, f, rnd(100000));
+            }
+        }
+        for (uint32_t id = 0; id < SNAP_TEST_ENTITIES; id++) {
+            uint32_t r = rnd(1000);
+            if (!server.Alive(id) && r != 220) continue;   // 死亡的实体只能重生
+            if (r < 200) {                 // 移动：x/y/z/朝向
+                for (unsigned f = 0; f < 4; f++) server.Set(id, f, server.Get(id, f) + rnd(61) - 30);
+            }
+            else if (r < 220) {            // 掉血
+                server.Set(id, 4, server.Get(id, 4) - rnd(500));
+            }
+            else if (r == 220) {           // 死亡 / 重生
+                if (server.Alive(id)) server.SetAlive(id, false);
+                else {
+                    server.SetAlive(id, true);
+                    for (unsigned f = 0; f < SNAP_TEST_FIELDS; f++) server.Set(id, f, rnd(100000));
+                }
+            }
+        }
+
+        // 全量的大小：每个活着的实体 id + 全部字段
+        size_t alive = 0;
+        for (uint32_t id = 0; id < SNAP_TEST_ENTITIES; id++) alive += server.Alive(id);
+        fullBytes += alive * (4 + SNAP_TEST_FIELDS * 4);
+
+        for (int c = 0; c < CLIENTS; c++) {
+            timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            CIOBuf msg = server.Encode(acks[c]);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            encodeCost += (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+            bytes[c] += msg.Size();
+            packets[c]++;
+
+            if (c == 1 && rnd(10) == 0) continue;   // 丢包
+            const char* data = msg.Coalesce();
+            int ret = views[c].Decode(data, msg.Size());
+            if (ret != 0) {
+                rejected++;
+                continue;
+            }
+            if (c == 0) server.Ack(acks[c], tick);
+            else if (c == 1) pending.push_back(std::make_pair(c, tick));
+        }
+        for (size_t i = 0; i < pending.size();) {    // 晚5帧的确认到达
+            if (pending[i].second + 5 <= tick) {
+                server.Ack(acks[pending[i].first], pending[i].second);
+                pending.erase(pending.begin() + i);
+            }
+            else i++;
+        }
+
+        // 核对：收到这一帧的客户端，状态和服务器一致
+        for (int c = 0; c < CLIENTS; c++) {
+            if (views[c].Current() != tick) continue;
+            for (uint32_t id = 0; id < SNAP_TEST_ENTITIES; id++) {
+                bool same = views[c].Alive(id) == server.Alive(id);
+                for (unsigned f = 0; f < SNAP_TEST_FIELDS && same; f++) same = views[c].Get(id, f) == server.Get(id, f);
+                if (!same) errors++;
+            }
+        }
+    }
+
+    // 坏包：帧号落在当前帧的槽上、全量、截掉一半。要被拒绝，当前帧不能被破坏
+    CIOBuf full = server.Encode(0u);
+    std::string bad(full.Coalesce(), full.Size() / 2);
+    uint32_t badTick = views[0].Current() + SNAPSHOT_HISTORY;
+    memcpy(&bad[0], &badTick, 4);   // 包的开头：帧号32位，低位在前
+    int badRet = views[0].Decode(bad.data(), bad.size());
+    bool intact = views[0].Has(views[0].Current());
+    for (uint32_t id = 0; id < SNAP_TEST_ENTITIES && intact; id++) {
+        for (unsigned f = 0; f < SNAP_TEST_FIELDS && intact; f++) intact = views[0].Get(id, f) == server.Get(id, f);
+    }
+    printf("  截断的坏包：Decode=%d（应为-1），当前帧%s\n", badRet, intact ? "完好" : "被破坏");
+    if (badRet != -1 || !intact) errors++;
+
+    printf("  全量（id + 全部字段）：%zu 字节/帧\n", fullBytes / SNAP_TEST_TICKS);
+    for (int c = 0; c < CLIENTS; c++) {
+        printf("  %-20s %7zu 字节/帧（全量的 %.1f%%）\n", names[c], bytes[c] / packets[c],
+            100.0 * bytes[c] / fullBytes);
+    }
+    printf("  编码耗时 %.1fus/次（同帧同基准的客户端共享结果），解码被拒 %d，核对错误 %d\n\n",
+        encodeCost / 1000.0 / (SNAP_TEST_TICKS * CLIENTS), rejected, errors);
+    return errors == 0 ? 0 : -2;
+}
+
+// ==================== 协议分发压测 ====================
+// 三种消息混合编码100万个（2字节长度分帧），然后：
+//   a. CDispatcher：编译期分发表 + 按字段声明解码
+//   b. 对照：std::map<opcode, std::function> + 手工逐字段检查解析
+#define PROTO_TEST_COUNT 1000000
+
+struct MsgMove {
+    uint32_t id;
+    float pos[3];
+    uint8_t dir;
+    PROTO_MESSAGE(101, id, pos, dir)
+};
+
+struct MsgChat {
+    uint32_t from;
+    uint8_t channel;
+    CProtoBytes text;
+    PROTO_MESSAGE(102, from, channel, text)
+};
+
+struct MsgSkill {
+    uint32_t caster;
+    uint32_t target;
+    uint16_t skill;
+    int32_t damage;
+    PROTO_MESSAGE(103, caster, target, skill, damage)
+};
+
+struct ProtoTestHandler {
+    uint64_t sum = 0;
+    int On(const MsgMove& m) { sum += m.id + (uint32_t)m.pos[0] + m.dir; return 0; }
+    int On(const MsgChat& m) { sum += m.from + m.channel + m.text.size; return 0; }
+    int On(const MsgSkill& m) { sum += m.caster + m.target + m.skill + (uint32_t)m.damage; return 0; }
+};
+
+typedef CDispatcher<ProtoTestHandler, MsgMove, MsgChat, MsgSkill> ProtoTestDispatcher;
+
+// 对照组的手工解析：每个字段一次越界检查
+static bool ProtoTestRead(const char*& p, const char* end, void* out, size_t n) {
+    if ((size_t)(end - p) < n) return false;
+    memcpy(out, p, n);
+    p += n;
+    return true;
+}
+
+int TestProtocol() {
+    printf("\n========================================\n");
+    printf("  协议分发压测（%d个消息）\n", PROTO_TEST_COUNT);
+    printf("========================================\n\n");
+
+    // 第1步：编码
+    const char* words = "hello world, this is a chat message";
+    std::vector<char> stream((size_t)PROTO_TEST_COUNT * 64);
+    size_t used = 0;
+    timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t i = 0; i < PROTO_TEST_COUNT; i++) {
+        char* frame = &stream[used];
+        int n = -1;
+        if (i % 10 < 6) {
+            MsgMove m = { i, { (float)i, 2.0f, 3.0f }, (uint8_t)(i & 7) };
+            n = CProtocol::Encode(m, frame + 2, stream.size() - used - 2);
+        }
+        else if (i % 10 < 9) {
+            MsgSkill m = { i, i + 1, (uint16_t)(i % 300), (int32_t)(i % 1000) - 500 };
+            n = CProtocol::Encode(m, frame + 2, stream.size() - used - 2);
+        }
+        else {
+            MsgChat m = { i, 1, CProtoBytes(words, (uint16_t)(5 + i % 30)) };
+            n = CProtocol::Encode(m, frame + 2, stream.size() - used - 2);
+        }
+        if (n < 0) return -1;
+        uint16_t len = (uint16_t)n;
+        memcpy(frame, &len, 2);
+        used += 2 + n;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    uint64_t encodeCost = (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+
+    // 第2步：编译期分发表
+    ProtoTestHandler handler;
+    int errors = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (size_t pos = 0; pos < used;) {
+        uint16_t len;
+        memcpy(&len, &stream[pos], 2);
+        if (ProtoTestDispatcher::Dispatch(handler, &stream[pos + 2], len) != 0) errors++;
+        pos += 2 + len;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    uint64_t dispatchCost = (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+
+    // 第3步：对照组
+    uint64_t baseSum = 0;
+    std::map<uint16_t, std::function<int(const char*, size_t)>> handlers;
+    handlers[101] = [&baseSum](const char* p, size_t n) {
+        const char* end = p + n;
+        uint32_t id; float pos[3]; uint8_t dir;
+        if (!ProtoTestRead(p, end, &id, 4) || !ProtoTestRead(p, end, &pos[0], 4) || !ProtoTestRead(p, end, &pos[1], 4) ||
+            !ProtoTestRead(p, end, &pos[2], 4) || !ProtoTestRead(p, end, &dir, 1)) return -2;
+        baseSum += id + (uint32_t)pos[0] + dir;
+        return 0;
+    };
+    handlers[102] = [&baseSum](const char* p, size_t n) {
+        const char* end = p + n;
+        uint32_t from; uint8_t channel; uint16_t size;
+        if (!ProtoTestRead(p, end, &from, 4) || !ProtoTestRead(p, end, &channel, 1) || !ProtoTestRead(p, end, &size, 2)) return -2;
+        if ((size_t)(end - p) < size) return -2;
+        baseSum += from + channel + size;
+        return 0;
+    };
+    handlers[103] = [&baseSum](const char* p, size_t n) {
+        const char* end = p + n;
+        uint32_t caster, target; uint16_t skill; int32_t damage;
+        if (!ProtoTestRead(p, end, &caster, 4) || !ProtoTestRead(p, end, &target, 4) ||
+            !ProtoTestRead(p, end, &skill, 2) || !ProtoTestRead(p, end, &damage, 4)) return -2;
+        baseSum += caster + target + skill + (uint32_t)damage;
+        return 0;
+    };
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (size_t pos = 0; pos < used;) {
+        uint16_t len, opcode;
+        memcpy(&len, &stream[pos], 2);
+        memcpy(&opcode, &stream[pos + 2], 2);
+        auto it = handlers.find(opcode);
+        if (it == handlers.end() || it->second(&stream[pos + 4], len - 2) != 0) errors++;
+        pos += 2 + len;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    uint64_t baseCost = (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+
+    // 第4步：截断的包必须被拒绝
+    MsgChat chat = { 1, 2, CProtoBytes(words, 10) };
+    char one[64];
+    int n = CProtocol::Encode(chat, one, sizeof(one));
+    for (int cut = 0; cut < n; cut++) {
+        if (ProtoTestDispatcher::Dispatch(handler, one, cut) == 0) errors++;
+    }
+    uint16_t unknown = 999;
+    if (ProtoTestDispatcher::Dispatch(handler, (const char*)&unknown, 2) != -1) errors++;
+    uint64_t sum = handler.sum;   // 截断的包都被拒绝，不会加进来
+
+    printf("  编码：%.1fns/个（%.1fMB）\n", (double)encodeCost / PROTO_TEST_COUNT, used / 1048576.0);
+    printf("  编译期分发表 + 声明式解码：%.1fns/个\n", (double)dispatchCost / PROTO_TEST_COUNT);
+    printf("  map + function + 手工解析：%.1fns/个\n", (double)baseCost / PROTO_TEST_COUNT);
+    printf("  校验和 %s，错误 %d\n\n", sum == baseSum ? "一致" : "不一致", errors);
+    return (errors == 0 && sum == baseSum) ? 0 : -2;
+}
+
+// ==================== 日志环压测 ====================
+// 日志服务器在子进程里（和CreateLogServer一样跨进程），4个线程写日志：
+//   a. 旧的传输方式：每行一次send()
+//   b. 共享内存环：每行一次memcpy + release store
+// 只计传输的耗时（同一条预先格式化好的LogInfo反复发），另外给出TRACEI完整一行的耗时
+// 每个线程分批写（一批5000行，批间歇20ms），最后到日志文件里数行数核对
+#define LOGRING_TEST_THREADS 4
+#define LOGRING_TEST_BATCHES 20
+#define LOGRING_TEST_BATCH 5000
+
+static size_t CountLogLines(const char* tag) {
+    size_t count = 0;
+    DIR* dir = opendir("log");
+    if (dir == NULL) return 0;
+    dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len < 4 || strcmp(entry->d_name + len - 4, ".log") != 0) continue;
+        if (strncmp(entry->d_name, "flight-", 7) == 0) continue;   // 飞行记录（CountFlightLines）
+        std::string path = std::string("log/") + entry->d_name;
+        FILE* file = fopen(path.c_str(), "r");
+        if (file == NULL) continue;
+        char line[1024];
+        while (fgets(line, sizeof(line), file) != NULL) {
+            if (strstr(line, tag) != NULL) count++;
+        }
+        fclose(file);
+    }
+    closedir(dir);
+    return count;
+}
+
+// 子进程里启动日志服务器，父进程关闭quit（管道写端）时退出；等300ms让服务器准备好
+// 返回值：子进程pid，-1失败
+static pid_t StartLogServer(int format, int& quit) {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[1]);
+        CLoggerServer server;
+        server.SetFileFormat(format);
+        if (server.Start() != 0) _exit(1);
+        char c;
+        while (read(fds[0], &c, 1) > 0) {}
+        server.Close();
+        _exit(0);
+    }
+    close(fds[0]);
+    quit = fds[1];
+    usleep(300 * 1000);
+    return pid;
+}
+
+int TestLogRing() {
+    printf("\n========================================\n");
+    printf("  日志环压测（%d线程 × %d行）\n", LOGRING_TEST_THREADS, LOGRING_TEST_BATCHES * LOGRING_TEST_BATCH);
+    printf("========================================\n\n");
+
+    // 第1步：启动日志服务器
+    int quit;
+    pid_t pid = StartLogServer(LOG_FILE_TEXT, quit);
+    if (pid < 0) return -1;
+
+    char tag[64];
+    snprintf(tag, sizeof(tag), "logring-%d-%ld", getpid(), (long)time(NULL));
+    const size_t total = (size_t)LOGRING_TEST_THREADS * LOGRING_TEST_BATCHES * LOGRING_TEST_BATCH;
+
+    // 第2步：三种方式各跑一遍
+    const char* names[3] = { "send()每行一次", "共享内存环", "TRACEI完整一行" };
+    for (int mode = 0; mode < 3; mode++) {
+        std::atomic<uint64_t> cost(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < LOGRING_TEST_THREADS; t++) {
+            threads.emplace_back([mode, t, &tag, &cost]() {
+                LogInfo info(__FILE__, __LINE__, __FUNCTION__, getpid(), pthread_self(), LOG_INFO,
+                    "%s mode=%d thread=%d 玩家移动 x=%d y=%d", tag, mode, t, 100, 200);
+                Buffer line(std::string(info.Data(), info.Size()));
+                CLocalSocket client;
+                if (mode == 0) {
+                    client.Init(CSockParam("./log/server.sock", 0));
+                    client.Link();
+                }
+                uint64_t ns = 0;
+                for (int b = 0; b < LOGRING_TEST_BATCHES; b++) {
+                    timespec t0, t1;
+                    clock_gettime(CLOCK_MONOTONIC, &t0);
+                    for (int i = 0; i < LOGRING_TEST_BATCH; i++) {
+                        if (mode == 0) client.Send(line);
+                        else if (mode == 1) CLoggerServer::Trace(info);
+                        else TRACEI("%s mode=%d thread=%d 玩家移动 x=%d y=%d", tag, mode, t, 100, 200);
+                    }
+                    clock_gettime(CLOCK_MONOTONIC, &t1);
+                    ns += (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+                    usleep(20 * 1000);
+                }
+                cost += ns;
+            });
+        }
+        for (auto& th : threads) th.join();
+        printf("  %-24s %8.1fns/行\n", names[mode], (double)cost.load() / total);
+    }
+
+    // 第3步：关掉日志服务器（退出前会把环里剩下的写完），核对行数
+    close(quit);
+    waitpid(pid, NULL, 0);
+    size_t lines = CountLogLines(tag);
+    printf("\n  日志文件中 %zu 行（应为 %zu）\n\n", lines, total * 3);
+    return lines == total * 3 ? 0 : -2;
+}
+
+// ==================== 延迟格式化压测 ====================
+// 同样的内容，调用方线程的耗时：
+//   a. TRACEI / LOGI：本线程格式化（asprintf + 取时间 + stringstream）再写进环
+//   b. LOG_TRACE_DEFERRED / LOG_STREAM_DEFERRED：只写格式点ID + TSC + 参数的字节
+// 最后核对：行数对得上，同一条日志两种方式格式化出来的内容完全一样
+#define DEFERRED_TEST_THREADS 4
+#define DEFERRED_TEST_BATCHES 20
+#define DEFERRED_TEST_BATCH 2000
+
+// 日志文件里含tag和key的行（whole=false时只取从tag开始的部分，跳过行头）
+static std::vector<std::string> FindLogLines(const char* tag, const char* key, bool whole = false) {
+    std::vector<std::string> result;
+    DIR* dir = opendir("log");
+    if (dir == NULL) return result;
+    dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len < 4 || strcmp(entry->d_name + len - 4, ".log") != 0) continue;
+        std::string path = std::string("log/") + entry->d_name;
+        FILE* file = fopen(path.c_str(), "r");
+        if (file == NULL) continue;
+        char line[1024];
+        while (fgets(line, sizeof(line), file) != NULL) {
+            const char* p = strstr(line, tag);
+            if (p != NULL && strstr(whole ? line : p, key) != NULL) result.push_back(whole ? line : p);
+        }
+        fclose(file);
+    }
+    closedir(dir);
+    return result;
+}
+
+int TestLogDeferred() {
+    printf("\n========================================\n");
+    printf("  延迟格式化压测（%d线程 × %d行）\n", DEFERRED_TEST_THREADS, DEFERRED_TEST_BATCHES * DEFERRED_TEST_BATCH);
+    printf("========================================\n\n");
+
+    // 第1步：启动日志服务器
+    int quit;
+    pid_t pid = StartLogServer(LOG_FILE_TEXT, quit);
+    if (pid < 0) return -1;
+
+    char tag[64];
+    snprintf(tag, sizeof(tag), "deferred-%d-%ld", getpid(), (long)time(NULL));
+    const size_t total = (size_t)DEFERRED_TEST_THREADS * DEFERRED_TEST_BATCHES * DEFERRED_TEST_BATCH;
+
+    // 第2步：四种方式各跑一遍（只计调用方线程的耗时）
+    const char* names[4] = { "TRACEI", "LOG_TRACE_DEFERRED", "LOGI", "LOG_STREAM_DEFERRED" };
+    for (int mode = 0; mode < 4; mode++) {
+        std::atomic<uint64_t> cost(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < DEFERRED_TEST_THREADS; t++) {
+            threads.emplace_back([mode, t, &tag, &cost]() {
+                uint64_t ns = 0;
+                for (int b = 0; b < DEFERRED_TEST_BATCHES; b++) {
+                    timespec t0, t1;
+                    clock_gettime(CLOCK_MONOTONIC, &t0);
+                    for (int i = 0; i < DEFERRED_TEST_BATCH; i++) {
+                        if (mode == 0) TRACEI("%s mode=%d thread=%d 玩家移动 x=%d y=%d hp=%.2f", tag, mode, t, i, b, 87.5);
+                        else if (mode == 1) LOG_TRACE_DEFERRED(LOG_INFO, "%s mode=%d thread=%d 玩家移动 x=%d y=%d hp=%.2f", tag, mode, t, i, b, 87.5);
+                        else if (mode == 2) LOGI << tag << " mode=" << mode << " thread=" << t << " 玩家移动 x=" << i << " hp=" << 87.5;
+                        else LOG_STREAM_DEFERRED(LOG_INFO) << tag << " mode=" << mode << " thread=" << t << " 玩家移动 x=" << i << " hp=" << 87.5;
+                    }
+                    clock_gettime(CLOCK_MONOTONIC, &t1);
+                    ns += (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+                    usleep(20 * 1000);
+                }
+                cost += ns;
+            });
+        }
+        for (auto& th : threads) th.join();
+        printf("  %-24s %8.1fns/行\n", names[mode], (double)cost.load() / total);
+    }
+
+    // 第3步：同一条日志两种方式各写一次（各种格式说明符、流式的各种类型）
+    unsigned char level = 7;
+    std::string name = "王万鑫";
+    TRACEI("%s check-printf %5d|%-4x|%08.3f|%c|%lu|%p|%%|%.3s|%*d|%e", tag, -7, 255u, 3.14159, 'Z',
+        (unsigned long)123456789, (void*)0x1234, "abcdef", 6, 42, 1e-9);
+    LOG_TRACE_DEFERRED(LOG_INFO, "%s check-printf %5d|%-4x|%08.3f|%c|%lu|%p|%%|%.3s|%*d|%e", tag, -7, 255u, 3.14159, 'Z',
+        (unsigned long)123456789, (void*)0x1234, "abcdef", 6, 42, 1e-9);
+    LOGW << tag << " check-stream " << -1 << ' ' << 0.12345f << ' ' << 1.23456789 << ' ' << level << ' '
+        << true << ' ' << name << ' ' << 18446744073709551615ull;
+    LOG_STREAM_DEFERRED(LOG_WARNING) << tag << " check-stream " << -1 << ' ' << 0.12345f << ' ' << 1.23456789 << ' '
+        << level << ' ' << true << ' ' << name << ' ' << 18446744073709551615ull;
+    char dump[40];
+    for (int i = 0; i < (int)sizeof(dump); i++) dump[i] = (char)(i * 7 + 30);
+    char marker[20];
+    snprintf(marker, sizeof(marker), "dump%012d", (int)getpid());   // 正好16字节：dump第一行的ASCII部分
+    memcpy(dump, marker, 16);
+    DUMPI((void*)dump, (size_t)sizeof(dump));
+    LOG_DUMP_DEFERRED(LOG_INFO, dump, sizeof(dump));
+
+    // 第4步：等日志服务器接收本线程的新连接，再关掉（退出前会把环里剩下的写完），核对
+    usleep(300 * 1000);
+    close(quit);
+    waitpid(pid, NULL, 0);
+    size_t lines = CountLogLines(tag);
+    size_t expect = total * 4 + 4;
+    printf("\n  日志文件中 %zu 行（应为 %zu）\n", lines, expect);
+    int errors = 0;
+    const char* keys[3] = { "check-printf", "check-stream", "\t; " };
+    for (int k = 0; k < 3; k++) {
+        std::vector<std::string> found = k < 2 ? FindLogLines(tag, keys[k]) : FindLogLines(marker, keys[k], true);
+        bool same = found.size() == 2 && found[0] == found[1];
+        if (!same) errors++;
+        printf("  %-14s %s  %s", keys[k], same ? "一致" : "不一致", found.empty() ? "\n" : found[0].c_str());
+    }
+    printf("\n");
+    return (lines == expect && errors == 0) ? 0 : -2;
+}
+
+// ==================== 时间格式化压测 ====================
+// 旧的GetTimeStr（每次取时间 + localtime_r + snprintf）和CClock::Format（按分钟缓存）
+// 先核对：随机时间点（跨分钟、跨天、跨年）两种方式结果一致；再4个线程比耗时
+#define CLOCK_TEST_THREADS 4
+#define CLOCK_TEST_COUNT 500000
+
+static size_t OldTimeStr(uint64_t ns, char* out) {
+    time_t sec = (time_t)(ns / 1000000000ull);
+    tm local_tm;
+    localtime_r(&sec, &local_tm);
+    return (size_t)snprintf(out, CLOCK_TIME_STR_SIZE, "%04d-%02d-%02d %02d-%02d-%02d %03d",
+        local_tm.tm_year + 1900, local_tm.tm_mon + 1, local_tm.tm_mday,
+        local_tm.tm_hour, local_tm.tm_min, local_tm.tm_sec, (int)(ns / 1000000ull % 1000));
+}
+
+int TestClock() {
+    printf("\n========================================\n");
+    printf("  时间格式化压测（%d线程 × %d次）\n", CLOCK_TEST_THREADS, CLOCK_TEST_COUNT);
+    printf("========================================\n\n");
+
+    // 第1步：核对（递增的时间：大多数在同一分钟里，偶尔跳很远）
+    int errors = 0;
+    uint64_t ns = CClock::NowPrecise();
+    srand(7);
+    for (int i = 0; i < 1000000; i++) {
+        ns += (i % 1000 == 0) ? (uint64_t)rand() * 1000000000ull : (uint64_t)(rand() % 5000) * 1000000ull;
+        if (i % 77 == 0) ns -= 3000000000ull;   // 偶尔往回走
+        char a[CLOCK_TIME_STR_SIZE], b[CLOCK_TIME_STR_SIZE];
+        size_t na = CClock::Format(ns, a);
+        size_t nb = OldTimeStr(ns, b);
+        if (na != nb || memcmp(a, b, na + 1) != 0) {
+            if (errors++ < 3) printf("  不一致：%s / %s\n", a, b);
+        }
+    }
+    printf("  核对100万个时间点，错误 %d\n\n", errors);
+
+    // 第2步：多线程耗时
+    const char* names[3] = { "clock_gettime+localtime_r", "CClock::Format", "GetTimeStr" };
+    for (int mode = 0; mode < 3; mode++) {
+        std::atomic<uint64_t> cost(0);
+        std::atomic<uint64_t> sink(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < CLOCK_TEST_THREADS; t++) {
+            threads.emplace_back([mode, &cost, &sink]() {
+                char out[CLOCK_TIME_STR_SIZE];
+                uint64_t sum = 0;
+                timespec t0, t1;
+                clock_gettime(CLOCK_MONOTONIC, &t0);
+                for (int i = 0; i < CLOCK_TEST_COUNT; i++) {
+                    if (mode == 0) {
+                        timespec now;
+                        clock_gettime(CLOCK_REALTIME, &now);
+                        sum += OldTimeStr((uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec, out);
+                    }
+                    else if (mode == 1) sum += CClock::Format(out);
+                    else sum += CLoggerServer::GetTimeStr().size();
+                    sum += (unsigned char)out[22];
+                }
+                clock_gettime(CLOCK_MONOTONIC, &t1);
+                cost += (t1.tv_sec - t0.tv_sec) * 1000000000ull + (t1.tv_nsec - t0.tv_nsec);
+                sink += sum;
+            });
+        }
+        for (auto& th : threads) th.join();
+        printf("  %-26s %8.1fns/次\n", names[mode], (double)cost.load() / ((double)CLOCK_TEST_THREADS * CLOCK_TEST_COUNT));
+    }
+    printf("\n");
+    return errors == 0 ? 0 : -2;
+}
+
+// ==================== 批量写日志压测 ====================
+// 模拟日志线程：每轮读到一批行（每轮64行，共20万行），写进文件
+//   a. 旧方式：每行 fwrite + fflush（一行一次write）
+//   b. CLogWriter：每轮末尾Poll，按策略一次writev
+//   c. CLogWriter：每轮都有一条ERROR（每轮都立即写）
+// 核对三个文件内容完全一样
+#define WRITER_TEST_LINES 200000
+#define WRITER_TEST_ROUND 64
+
+int TestLogWriter() {
+    printf("\n========================================\n");
+    printf("  批量写日志压测（%d行，每轮%d行）\n", WRITER_TEST_LINES, WRITER_TEST_ROUND);
     printf("========================================\n\n");
 
+    const char* paths[3] = { "/tmp/logwriter-a.log", "/tmp/logwriter-b.log", "/tmp/logwriter-c.log" };
+    const char* names[3] = { "fwrite+fflush每行", "CLogWriter", "CLogWriter+每轮ERROR" };
+    for (int mode = 0; mode < 3; mode++) {
+        FILE* file = NULL;
+        CLogWriter writer;
+        if (mode == 0) file = fopen(paths[mode], "w+");
+        else writer.Open(paths[mode]);
+        if (file == NULL && !writer.IsOpen()) return -1;
+
+        char line[160];
+        timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        uint64_t writes = 0;
+        for (int i = 0; i < WRITER_TEST_LINES; i++) {
+            int level = (mode == 2 && i % WRITER_TEST_ROUND == 0) ? LOG_ERROR : LOG_DEBUG;
+            int n = snprintf(line, sizeof(line), "main.cpp(%d):[DEBUG][2025-01-15 14-30-25 123]<100-200>(Tick) "
+                "玩家移动 id=%d x=%d y=%d\n", i % 1000, i, i * 3, i * 7);
+            if (mode == 0) {
+                fwrite(line, 1, (size_t)n, file);
+                fflush(file);
+                writes++;
+            }
+            else writer.Append(line, (size_t)n, level);
+            if (mode != 0 && i % WRITER_TEST_ROUND == WRITER_TEST_ROUND - 1) writer.Poll();   // 一轮结束
+        }
+        if (mode == 0) fclose(file);
+        else {
+            writer.Close();
+            writes = writer.Writes();
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+        printf("  %-24s %8.1fns/行  write次数 %llu\n", names[mode], ns / WRITER_TEST_LINES, (unsigned long long)writes);
+    }
+
+    // 核对内容
+    int errors = 0;
+    std::string data[3];
+    for (int mode = 0; mode < 3; mode++) {
+        FILE* file = fopen(paths[mode], "r");
+        if (file == NULL) return -1;
+        char buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), file)) > 0) data[mode].append(buf, n);
+        fclose(file);
+        unlink(paths[mode]);
+        if (data[mode] != data[0]) errors++;
+    }
+    printf("\n  文件大小 %zu 字节，内容%s\n\n", data[0].size(), errors == 0 ? "一致" : "不一致");
+    return errors == 0 ? 0 : -2;
+}
+
+// ==================== 日志轮转压测 ====================
+// CLogWriter按1MB轮转，写40MB带序号的行（每轮64行），后台gzip：
+//   a. 不删旧文件：把所有文件（.gz用gzip -dc）按名字顺序接起来，序号必须连续（不丢不重）
+//   b. 只保留3个：目录里最后剩 3个归档 + 1个正在写的
+// 同时记录单次Flush的最大耗时（压缩在后台，不应该卡住写）
+#define ROTATE_TEST_LINES 400000
+
+static int RotateTestRun(const std::string& dir, unsigned keep, double& maxFlushMs, std::vector<std::string>& names) {
+    mkdir(dir.c_str(), 0755);
+    CLogWriter writer;
+    writer.SetRotation(dir.c_str(), 1024 * 1024, 0, keep, true);
+    char time[CLOCK_TIME_STR_SIZE];
+    CClock::Format(time);
+    if (writer.Open((dir + "/" + time + ".log").c_str()) != 0) return -1;
+
+    char line[128];
+    maxFlushMs = 0;
+    for (int i = 0; i < ROTATE_TEST_LINES; i++) {
+        int n = snprintf(line, sizeof(line), "seq=%08d 玩家移动 x=%d y=%d 这是一行用来填充的日志内容\n", i, i * 3, i * 7);
+        writer.Append(line, (size_t)n, LOG_DEBUG);
+        if (i % 64 == 63) {
+            timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            writer.Flush();
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+            if (ms > maxFlushMs) maxFlushMs = ms;
+        }
+    }
+    writer.Flush();
+    writer.Archiver().Wait();
+    writer.Close();
+
+    names.clear();
+    DIR* d = opendir(dir.c_str());
+    if (d == NULL) return -1;
+    dirent* entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (CLogArchiver::IsLogName(entry->d_name)) names.push_back(entry->d_name);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
     return 0;
 }
 
-// 完整测试套件
-int TestThreadPool_All() {
+int TestLogRotate() {
+    printf("\n========================================\n");
+    printf("  日志轮转压测（%d行，1MB轮转）\n", ROTATE_TEST_LINES);
+    printf("========================================\n\n");
+
+    char dir[64];
+    snprintf(dir, sizeof(dir), "/tmp/logrotate-%d", (int)getpid());
+    int errors = 0;
+
+    // 第1步：不删旧文件，核对序号
+    std::vector<std::string> names;
+    double maxFlushMs = 0;
+    if (RotateTestRun(std::string(dir) + "-a", 0, maxFlushMs, names) != 0) return -1;
+    int next = 0, gz = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        std::string path = std::string(dir) + "-a/" + names[i];
+        bool zipped = names[i].size() > 3 && names[i].compare(names[i].size() - 3, 3, ".gz") == 0;
+        gz += zipped ? 1 : 0;
+        FILE* file = zipped ? popen(("gzip -dc '" + path + "'").c_str(), "r") : fopen(path.c_str(), "r");
+        if (file == NULL) return -1;
+        char line[256];
+        while (fgets(line, sizeof(line), file) != NULL) {
+            int seq = -1;
+            if (sscanf(line, "seq=%d", &seq) != 1 || seq != next) errors++;
+            next = seq + 1;
+        }
+        if (zipped) pclose(file);
+        else fclose(file);
+        unlink(path.c_str());
+    }
+    rmdir((std::string(dir) + "-a").c_str());
+    printf("  不删旧文件：%zu个文件（%d个已压缩），读回%d行，序号错误%d，Flush最长%.2fms\n",
+        names.size(), gz, next, errors, maxFlushMs);
+    if (next != ROTATE_TEST_LINES) errors++;
+
+    // 第2步：只保留3个归档
+    if (RotateTestRun(std::string(dir) + "-b", 3, maxFlushMs, names) != 0) return -1;
+    printf("  保留3个：剩%zu个文件（应为4）\n", names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        printf("    %s\n", names[i].c_str());
+        unlink((std::string(dir) + "-b/" + names[i]).c_str());
+    }
+    rmdir((std::string(dir) + "-b").c_str());
+    if (names.size() != 4) errors++;
+
+    // 第3步：交来就Stop：队列里的文件都要压缩完才退出；Stop之后Wait不能卡住
+    std::string dirC = std::string(dir) + "-c";
+    mkdir(dirC.c_str(), 0755);
+    CLogArchiver archiver;
+    archiver.Start(dirC, 0, true);
+    for (int i = 0; i < 5; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "2025-01-15 14-30-%02d 000.log", i);
+        FILE* file = fopen((dirC + "/" + name).c_str(), "w");
+        if (file == NULL) return -1;
+        fprintf(file, "seq=%d\n", i);
+        fclose(file);
+        archiver.Submit(dirC + "/" + name, "");
+    }
+    archiver.Stop();
+    archiver.Wait();
+    int zipped = 0;
+    DIR* d = opendir(dirC.c_str());
+    dirent* entry;
+    while (d != NULL && (entry = readdir(d)) != NULL) {
+        std::string name = entry->d_name;
+        if (!CLogArchiver::IsLogName(name)) continue;
+        if (name.compare(name.size() - 3, 3, ".gz") == 0) zipped++;
+        unlink((dirC + "/" + name).c_str());
+    }
+    if (d != NULL) closedir(d);
+    rmdir(dirC.c_str());
+    printf("  交来5个立即Stop：压缩了%d个（应为5）\n", zipped);
+    if (zipped != 5) errors++;
     printf("\n");
-    printf("╔════════════════════════════════════════╗\n");
-    printf("║     线程池完整测试套件                  ║\n");
-    printf("╚════════════════════════════════════════╝\n");
+    return errors == 0 ? 0 : -2;
+}
 
-    int ret = 0;
+// ==================== 日志级别过滤压测 ====================
+// 日志服务器在子进程里，父进程通过控制socket改级别：
+//   a. 关掉DEBUG：热循环里的TRACED/LOGD/DUMPD每次只剩一次原子读 + 一次比较，参数不求值
+//   b. 打开DEBUG：同样的调用真正写日志（对比耗时），日志文件里的行数核对
+//   c. 编译期：LOG_MIN_LEVEL=LOG_INFO编译的函数里，DEBUG调用点整个不存在
+//   d. 打开了飞行记录的模块：关掉的TRACED/DUMPD求值参数写进飞行记录器（LOGD不记），关掉飞行记录又不求值
+// 级别表在 ./log/levels.shm（所有进程共享，重启也保留），测试结束改回全部DEBUG
+#define FILTER_TEST_OFF 10000000
+#define FILTER_TEST_ON 20000
+
+static int g_filterEval = 0;   // 参数被求值的次数
+static int FilterArg(int v) {
+    g_filterEval++;
+    return v;
+}
 
-    // 阶段1
-    ret = TestThreadPool_Basic();
-    if (ret != 0) {
-        printf("\n❌ 阶段1测试失败\n");
-        return -1;
+#pragma push_macro("LOG_MIN_LEVEL")
+#undef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_INFO
+static void FilterCompiledOut(const char* tag, int i) {
+    TRACED("%s compiled-out %d", tag, FilterArg(i));
+    LOGD << tag << " compiled-out " << FilterArg(i);
+}
+#pragma pop_macro("LOG_MIN_LEVEL")
+
+static double FilterLoop(const char* tag, int count, int mode) {
+    char data[64] = { 0 };
+    timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < count; i++) {
+        if (mode == 0) TRACED("%s filter %d", tag, FilterArg(i));
+        else if (mode == 1) LOGD << tag << " filter " << FilterArg(i);
+        else DUMPD((void*)data, (size_t)FilterArg(sizeof(data)));
     }
-    printf("按回车继续阶段2测试...\n");
-    getchar();
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / count;
+}
 
-    // 阶段2
-    ret = TestThreadPool_Advanced();
-    if (ret != 0) {
-        printf("\n❌ 阶段2测试失败\n");
-        return -2;
+int TestLogFilter() {
+    printf("\n========================================\n");
+    printf("  日志级别过滤压测\n");
+    printf("========================================\n\n");
+
+    // 第1步：启动日志服务器
+    int quit;
+    pid_t pid = StartLogServer(LOG_FILE_TEXT, quit);
+    if (pid < 0) return -1;
+    if (CLogFilter::Attach() != 0) return -1;
+
+    char tag[64];
+    snprintf(tag, sizeof(tag), "filter-%d-%ld", getpid(), (long)time(NULL));
+    int errors = 0;
+    std::string reply;
+
+    // 第2步：关掉0号模块的DEBUG（通过日志服务器的控制socket），飞行记录也不开
+    int ret = CLogFilter::Control("level default info", reply);
+    printf("  level default info → %d %s", ret, reply.c_str());
+    CLogFilter::Control("flight * off", reply);
+    if (ret != 0 || CLogFilter::Level(0) != LOG_SEVERITY(LOG_INFO)) errors++;
+    const char* names[3] = { "TRACED", "LOGD", "DUMPD" };
+    for (int mode = 0; mode < 3; mode++) {
+        g_filterEval = 0;
+        double ns = FilterLoop(tag, FILTER_TEST_OFF, mode);
+        printf("  关闭 %-6s %6.2fns/次，参数求值%d次\n", names[mode], ns, g_filterEval);
+        if (g_filterEval != 0) errors++;
     }
-    printf("按回车继续阶段3测试...\n");
-    getchar();
 
-    // 阶段3
-    ret = TestThreadPool_Stress();
-    if (ret != 0) {
-        printf("\n❌ 阶段3测试失败\n");
-        return -3;
+    // 第3步：打开这个模块的飞行记录：TRACED/DUMPD每次求值一次（写进记录器），LOGD照样不求值
+    ret = CLogFilter::Control("flight default debug", reply);
+    printf("\n  flight default debug → %d %s", ret, reply.c_str());
+    if (ret != 0 || CLogFilter::Flight(0) != LOG_SEVERITY(LOG_DEBUG)) errors++;
+    for (int mode = 0; mode < 3; mode++) {
+        g_filterEval = 0;
+        double ns = FilterLoop(tag, FILTER_TEST_ON, mode);
+        int expect = mode == 1 ? 0 : FILTER_TEST_ON;
+        printf("  飞行记录 %-6s %6.2fns/次，参数求值%d次（应为%d）\n", names[mode], ns, g_filterEval, expect);
+        if (g_filterEval != expect) errors++;
+    }
+    CLogFilter::Control("flight default off", reply);
+    g_filterEval = 0;
+    FilterLoop(tag, FILTER_TEST_ON, 0);
+    printf("  flight default off：参数求值%d次\n", g_filterEval);
+    if (g_filterEval != 0 || CLogFilter::Flight(0) != LOG_SEVERITY_OFF) errors++;
+
+    // 第4步：打开DEBUG，同样的调用真正写日志
+    ret = CLogFilter::Control("level default debug", reply);
+    printf("\n  level default debug → %d %s", ret, reply.c_str());
+    for (int mode = 0; mode < 3; mode++) {
+        g_filterEval = 0;
+        double ns = FilterLoop(tag, FILTER_TEST_ON, mode);
+        printf("  打开 %-6s %6.0fns/次，参数求值%d次\n", names[mode], ns, g_filterEval);
+        if (g_filterEval != FILTER_TEST_ON) errors++;
+        usleep(100 * 1000);   // 让日志线程读完（环满了会丢DEBUG）
+    }
+
+    // 第5步：编译期去掉的调用点（运行期是DEBUG也不存在）
+    g_filterEval = 0;
+    for (int i = 0; i < 1000; i++) FilterCompiledOut(tag, i);
+    printf("\n  LOG_MIN_LEVEL=LOG_INFO编译的DEBUG调用点：参数求值%d次\n", g_filterEval);
+    if (g_filterEval != 0) errors++;
+
+    // 第6步：其他命令
+    CLogFilter::SetName(5, "filtertest");
+    CLogFilter::Control("level filtertest error", reply);
+    CLogFilter::Control("get", reply);
+    printf("  get → %s", reply.c_str());
+    if (CLogFilter::Level(5) != LOG_SEVERITY(LOG_ERROR)) errors++;
+    CLogFilter::Control("level nosuch debug", reply);
+    printf("  level nosuch debug → %s", reply.c_str());
+    if (reply.compare(0, 3, "ERR") != 0) errors++;
+    CLogFilter::Control("level * debug", reply);
+    if (CLogFilter::Level(5) != LOG_SEVERITY(LOG_DEBUG)) errors++;
+
+    // 第7步：等日志服务器写完，核对行数（只有打开时的那些）
+    usleep(300 * 1000);
+    close(quit);
+    waitpid(pid, NULL, 0);
+    size_t lines = CountLogLines(tag);
+    // DUMPD的行里没有tag：只数TRACED和LOGD
+    printf("\n  日志文件中 %zu 行（应为 %d），错误 %d\n\n", lines, FILTER_TEST_ON * 2, errors);
+    if (lines != (size_t)FILTER_TEST_ON * 2) errors++;
+    return errors == 0 ? 0 : -2;
+}
+
+// ==================== 日志行格式化压测 ====================
+// 以前的LogInfo::operator<<（每个值一个stringstream，str()再追加）和CLogLine：
+//   1. 核对：各种类型（整数边界、浮点特殊值、字符、字符串、业务类型、enum、指针、std::hex）
+//      两种方式逐字节一致
+//   2. 比耗时：一行 "头部 + 6个值"，单线程
+#define LOGLINE_TEST_COUNT 1000000
+
+struct LineTestPos {
+    int x, y;
+};
+static std::ostream& operator<<(std::ostream& os, const LineTestPos& pos) {
+    return os << '(' << pos.x << ',' << pos.y << ')';
+}
+enum LineTestEnum { LINE_TEST_A = 3 };
+
+// 以前的写法
+struct OldLogLine {
+    std::string buf;
+    template<typename T>
+    OldLogLine& operator<<(const T& data) {
+        std::stringstream stream;
+        stream << data;
+        buf += stream.str();
+        return *this;
+    }
+};
+
+int TestLogLine() {
+    printf("\n========================================\n");
+    printf("  日志行格式化压测（%d行）\n", LOGLINE_TEST_COUNT);
+    printf("========================================\n\n");
+
+    // 第1步：核对
+    int errors = 0, checked = 0;
+    auto check = [&](const std::string& a, const char* data, size_t size, const char* what) {
+        checked++;
+        if (a.size() == size && memcmp(a.data(), data, size) == 0) return;
+        errors++;
+        printf("  不一致 %-10s 以前[%s] 现在[%.*s]\n", what, a.c_str(), (int)size, data);
+    };
+    double doubles[] = { 0.0, -0.0, 1.0, 0.1, -2.5, 87.5, 1.23456789, 123456.7, 1234567.0, 1e-5, 1e-300,
+        1e300, 3.14159265358979, 1.0 / 0.0, -1.0 / 0.0, 0.0 / 0.0, 4.9e-324, 1.7976931348623157e308 };
+    for (double d : doubles) {
+        OldLogLine a; CLogLine b;
+        a << d << ' ' << (float)d; b << d << ' ' << (float)d;
+        check(a.buf, b.Data(), b.Size(), "double");
+    }
+    uint32_t seed = 12345;
+    for (int i = 0; i < 100000; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint64_t bits = ((uint64_t)seed << 32) ^ (seed * 2654435761u);
+        double d;
+        memcpy(&d, &bits, 8);
+        OldLogLine a; CLogLine b;
+        a << d << (float)(seed / 7.0) << (int)seed << (long long)bits << (unsigned long long)bits;
+        b << d << (float)(seed / 7.0) << (int)seed << (long long)bits << (unsigned long long)bits;
+        if (i < 20 || a.buf.size() != b.Size() || memcmp(a.buf.data(), b.Data(), b.Size()) != 0)
+            check(a.buf, b.Data(), b.Size(), "random");
+    }
+    {
+        OldLogLine a; CLogLine b;
+        LineTestPos pos = { 10, -20 };
+        const char* null = NULL;
+        std::string name = "王万鑫";
+        std::string_view view = "view";
+        void* ptr = (void*)0x1234;
+        long double ld = 1.5L;
+        a << INT_MIN << ' ' << INT_MAX << ' ' << LLONG_MIN << ' ' << ULLONG_MAX << ' ' << (short)-5 << ' '
+            << (unsigned short)65535 << ' ' << 'A' << ' ' << (unsigned char)66 << ' ' << (signed char)67 << ' '
+            << true << false << ' ' << "literal" << ' ' << null << ' ' << name << ' ' << view << ' ' << pos << ' '
+            << LINE_TEST_A << ' ' << ptr << ' ' << ld << ' ' << std::hex << 255 << ' ' << 0u;
+        b << INT_MIN << ' ' << INT_MAX << ' ' << LLONG_MIN << ' ' << ULLONG_MAX << ' ' << (short)-5 << ' '
+            << (unsigned short)65535 << ' ' << 'A' << ' ' << (unsigned char)66 << ' ' << (signed char)67 << ' '
+            << true << false << ' ' << "literal" << ' ' << null << ' ' << name << ' ' << view << ' ' << pos << ' '
+            << LINE_TEST_A << ' ' << ptr << ' ' << ld << ' ' << std::hex << 255 << ' ' << 0u;
+        check(a.buf, b.Data(), b.Size(), "types");
+        printf("  各种类型：%.*s\n", (int)b.Size(), b.Data());
+    }
+    {
+        // 超长行：搬到堆上，内容不变
+        OldLogLine a; CLogLine b;
+        std::string longText(3000, 'x');
+        a << "head " << longText << ' ' << 42; b << "head " << longText << ' ' << 42;
+        b.Printf(" %s|%d", longText.c_str(), 7);
+        a.buf += " " + longText + "|7";
+        check(a.buf, b.Data(), b.Size(), "long");
+        if (!b.Spilled()) errors++;
+    }
+    printf("  核对 %d 项，不一致 %d\n\n", checked, errors);
+
+    // 第2步：比耗时（同样的一行：头部 + 6个值）
+    LineTestPos pos = { 100, 200 };
+    size_t total[2] = { 0, 0 };
+    double ns[2];
+    for (int mode = 0; mode < 2; mode++) {
+        timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int i = 0; i < LOGLINE_TEST_COUNT; i++) {
+            if (mode == 0) {
+                char* buf = NULL;
+                int n = asprintf(&buf, "%s(%d):[%s][%s]<%d-%d>(%s) ", "main.cpp", 100, "INFO",
+                    "2025-01-15 14-30-25 123", 1234, 5678, "TestLogLine");
+                OldLogLine a;
+                if (n > 0) {
+                    a.buf = buf;
+                    free(buf);
+                }
+                a << "玩家移动 id=" << i << " x=" << i * 3 << " hp=" << 87.5 << " pos=" << pos;
+                a.buf += "\n";
+                total[mode] += a.buf.size();
+            }
+            else {
+                CLogLine b;
+                b.Printf("%s(%d):[%s][%s]<%d-%d>(%s) ", "main.cpp", 100, "INFO",
+                    "2025-01-15 14-30-25 123", 1234, 5678, "TestLogLine");
+                b << "玩家移动 id=" << i << " x=" << i * 3 << " hp=" << 87.5 << " pos=" << pos;
+                b.Append('\n');
+                total[mode] += b.Size();
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        ns[mode] = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / LOGLINE_TEST_COUNT;
+    }
+    printf("  stringstream + asprintf  %7.1fns/行\n", ns[0]);
+    printf("  CLogLine                 %7.1fns/行（%.1f倍）\n", ns[1], ns[0] / ns[1]);
+    printf("  输出字节数 %s\n\n", total[0] == total[1] ? "一致" : "不一致");
+    if (total[0] != total[1]) errors++;
+    return errors == 0 ? 0 : -2;
+}
+
+// ==================== 十六进制dump压测 ====================
+// 最早的DUMP*（每字节snprintf("%02X ")、ASCII列逐字符+=）和CLogHex的三种实现：
+//   1. 核对：0~600字节的随机数据，所有实现逐字节一致
+//   2. 比耗时：64B / 1KB / 16KB 的包
+#define HEXDUMP_TEST_BYTES (64 * 1024 * 1024)   // 每种大小、每种实现一共dump这么多字节
+
+static void OldHexDump(const char* Data, size_t nSize, std::string& m_buf) {
+    for (size_t i = 0; i < nSize; i++) {
+        char buf[16] = "";
+        snprintf(buf, sizeof(buf), "%02X ", Data[i] & 0xFF);
+        m_buf += buf;
+        if (0 == ((i + 1) % 16)) {
+            m_buf += "\t; ";
+            for (size_t j = i - 15; j <= i; j++) {
+                if ((Data[j] & 0xFF) > 31 && (Data[j] & 0xFF) < 0x7F) m_buf += Data[j];
+                else m_buf += '.';
+            }
+            m_buf += "\n";
+        }
     }
+    size_t k = nSize % 16;
+    if (k != 0) {
+        for (size_t j = 0; j < 16 - k; j++) m_buf += "   ";
+        m_buf += "\t; ";
+        for (size_t j = nSize - k; j < nSize; j++) {
+            if ((Data[j] & 0xFF) > 31 && (Data[j] & 0xFF) < 0x7F) m_buf += Data[j];
+            else m_buf += '.';
+        }
+        m_buf += "\n";
+    }
+}
+
+int TestHexDump() {
+    printf("\n========================================\n");
+    printf("  十六进制dump压测（自动选择：%s）\n", CLogHex::Best() == LOG_HEX_AVX2 ? "AVX2" :
+        CLogHex::Best() == LOG_HEX_SSSE3 ? "SSSE3" : "逐字节");
+    printf("========================================\n\n");
 
+    // 第1步：核对
+    const char* names[4] = { "snprintf(最早)", "逐字节查表", "SSSE3", "AVX2" };
+    std::vector<char> data(16 * 1024 + 16);   // 压测时起点错开0~15字节
+    uint32_t seed = 2024;
+    for (size_t i = 0; i < data.size(); i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (char)(seed >> 16);
+    }
+    int errors = 0;
+    for (size_t size = 0; size <= 600; size++) {
+        std::string expect;
+        OldHexDump(&data[size], size, expect);   // 起点也错开（不对齐）
+        if (CLogHex::Size(size) != expect.size()) errors++;
+        for (int kernel = LOG_HEX_SCALAR; kernel <= LOG_HEX_AVX2; kernel++) {
+            if (!CLogHex::Supported(kernel)) continue;
+            std::string out(CLogHex::Size(size), '\0');
+            size_t n = CLogHex::Dump(&data[size], size, &out[0], kernel);
+            if (n != expect.size() || out != expect) {
+                if (errors < 5) printf("  不一致：%s %zu字节\n", names[kernel], size);
+                errors++;
+            }
+        }
+    }
+    printf("  核对 0~600字节：不一致 %d\n\n", errors);
+
+    // 第2步：比耗时（每次dump写进同一块预先留好的输出，最早的写法每次新建string）
+    size_t sizes[3] = { 64, 1024, 16 * 1024 };
+    std::string out(CLogHex::Size(sizes[2]), '\0');
+    printf("  %10s %10s %10s\n", "64B", "1KB", "16KB");
+    for (int kernel = 0; kernel <= LOG_HEX_AVX2; kernel++) {
+        if (kernel > 0 && !CLogHex::Supported(kernel)) continue;
+        printf(" ");
+        for (int s = 0; s < 3; s++) {
+            size_t count = HEXDUMP_TEST_BYTES / sizes[s] / (kernel == 0 ? 16 : 1);
+            size_t sum = 0;
+            timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            for (size_t i = 0; i < count; i++) {
+                if (kernel == 0) {
+                    std::string text;
+                    OldHexDump(&data[i % 16], sizes[s], text);
+                    sum += text.size();
+                }
+                else sum += CLogHex::Dump(&data[i % 16], sizes[s], &out[0], kernel);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / count;
+            if (sum != count * CLogHex::Size(sizes[s])) errors++;
+            if (ns >= 10000) printf(" %8.1fus", ns / 1000);
+            else printf(" %8.0fns", ns);
+        }
+        printf("  %s\n", names[kernel]);
+    }
     printf("\n");
-    printf("╔════════════════════════════════════════╗\n");
-    printf("║     🎉 所有测试通过！                   ║\n");
-    printf("╚════════════════════════════════════════╝\n");
+    return errors == 0 ? 0 : -2;
+}
+
+// ==================== 二进制日志压测 ====================
+// 同样的日志分别用文本格式和二进制格式写一遍（日志服务器在子进程里）：
+//   1. 核对：二进制文件解码出来的行和文本文件里的行一致（去掉时间后逐行比较）
+//   2. 比文件大小
+//   3. 定位：合成一个多块的文件（时间均匀分布），取中间1秒，按块头二分 vs 从头扫
+#define LOGBIN_TEST_LINES 20000
+#define LOGBIN_TEST_EVENTS 2000000    // 合成文件的记录数（每条间隔1ms）
+
+// log目录里最新的某种格式的日志文件（文件名就是时间，按名字比较）
+static std::string NewestLog(const char* suffix) {
+    std::string newest;
+    DIR* dir = opendir("log");
+    if (dir == NULL) return newest;
+    dirent* entry;
+    size_t n = strlen(suffix);
+    while ((entry = readdir(dir)) != NULL) {
+        std::string name = entry->d_name;
+        if (!CLogArchiver::IsLogName(name) || name.size() < n || name.compare(name.size() - n, n, suffix) != 0) continue;
+        if (name > newest) newest = name;
+    }
+    closedir(dir);
+    return newest.empty() ? newest : "log/" + newest;
+}
+
+// 去掉头部的时间和线程（"[2025-01-15 14-30-25 123]<pid-tid>"），两次运行的其余部分应该一样
+static std::string StripTime(const std::string& line) {
+    size_t begin = line.find("][");
+    size_t end = begin == std::string::npos ? begin : line.find('>', begin);
+    return end == std::string::npos ? line : line.substr(0, begin + 1) + line.substr(end + 1);
+}
+
+static void WriteBinaryTestLogs(const char* tag) {
+    for (int i = 0; i < LOGBIN_TEST_LINES; i++) {
+        LOG_TRACE_DEFERRED(LOG_INFO, "%s deferred %d %.3f %s", tag, i, i / 7.0, "player");
+        if (i % 4 == 0) LOG_STREAM_DEFERRED(LOG_WARNING) << tag << " stream " << i << ' ' << (i * 3ull);
+        if (i % 16 == 0) TRACEI("%s text %d", tag, i);
+        if (i % 1000 == 0) usleep(10 * 1000);   // 别把环写满
+    }
+    char packet[40];
+    for (int i = 0; i < (int)sizeof(packet); i++) packet[i] = (char)(i * 7);
+    LOG_DUMP_DEFERRED(LOG_INFO, packet, sizeof(packet));
+}
+
+int TestLogBinary() {
+    printf("\n========================================\n");
+    printf("  二进制日志压测\n");
+    printf("========================================\n\n");
+
+    // 第1步：同样的日志，文本和二进制各写一遍
+    char tag[64];
+    snprintf(tag, sizeof(tag), "binary-%d-%ld", getpid(), (long)time(NULL));
+    std::string files[2];
+    for (int format = LOG_FILE_TEXT; format <= LOG_FILE_BINARY; format++) {
+        int quit;
+        pid_t pid = StartLogServer(format, quit);
+        if (pid < 0) return -1;
+        // 每次一个新线程写（线程的共享内存环只交给第一次连上的服务器）
+        std::thread writer(WriteBinaryTestLogs, tag);
+        writer.join();
+        usleep(300 * 1000);
+        close(quit);
+        waitpid(pid, NULL, 0);
+        files[format] = NewestLog(format == LOG_FILE_TEXT ? ".log" : ".blog");
+    }
+
+    // 第2步：核对（文本文件按行读，二进制文件解码）
+    std::vector<std::string> text, decoded;
+    FILE* file = fopen(files[0].c_str(), "r");
+    if (file != NULL) {
+        char line[4096];
+        while (fgets(line, sizeof(line), file) != NULL) text.push_back(StripTime(line));
+        fclose(file);
+    }
+    CLogBinaryReader reader;
+    LogBinaryRecord record;
+    std::string line;
+    if (reader.Open(files[1].c_str()) == 0) {
+        while (reader.Next(record) == 1) {
+            line.clear();
+            CLogBinaryReader::Format(record, line);
+            // 一条记录可能是多行（DUMP），按行拆开
+            for (size_t start = 0; start < line.size();) {
+                size_t end = line.find('\n', start);
+                end = end == std::string::npos ? line.size() : end + 1;
+                decoded.push_back(StripTime(line.substr(start, end - start)));
+                start = end;
+            }
+        }
+    }
+    // 只比较这次测试写的（文件里还有服务器自己的行）
+    auto mine = [&tag](std::vector<std::string>& lines) {
+        std::vector<std::string> out;
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (lines[i].find(tag) != std::string::npos || lines[i].find("\t; ") != std::string::npos) out.push_back(lines[i]);
+        }
+        lines.swap(out);
+    };
+    mine(text);
+    mine(decoded);
+    int errors = 0;
+    for (size_t i = 0; i < text.size() || i < decoded.size(); i++) {
+        if (i < text.size() && i < decoded.size() && text[i] == decoded[i]) continue;
+        if (errors++ < 3) {
+            printf("  第%zu行不一致\n    文本  %s    解码  %s", i, i < text.size() ? text[i].c_str() : "(无)\n",
+                i < decoded.size() ? decoded[i].c_str() : "(无)\n");
+        }
+    }
+    size_t expect = LOGBIN_TEST_LINES + LOGBIN_TEST_LINES / 4 + LOGBIN_TEST_LINES / 16 + 3;
+    printf("  %s\n  %s\n", files[0].c_str(), files[1].c_str());
+    printf("  文本 %zu 行，解码 %zu 行（应为 %zu），不一致 %d，坏块 %llu\n", text.size(), decoded.size(), expect,
+        errors, (unsigned long long)reader.Corrupt());
+    if (text.size() != expect || reader.Corrupt() != 0) errors++;
+
+    // 第3步：文件大小
+    struct stat st[2];
+    if (stat(files[0].c_str(), &st[0]) == 0 && stat(files[1].c_str(), &st[1]) == 0) {
+        printf("  文件大小：文本 %lld 字节，二进制 %lld 字节（%.0f%%），%llu块\n\n", (long long)st[0].st_size,
+            (long long)st[1].st_size, 100.0 * st[1].st_size / st[0].st_size, (unsigned long long)reader.Blocks());
+    }
+    reader.Close();
+
+    // 第4步：合成一个多块的文件（直接用CLogBinaryWriter，时间间隔1ms）
+    const char* path = "log/binary-seek.tmp";
+    uint64_t base = CLogTsc::RealtimeNs();
+    {
+        CLogWriter writer;
+        if (writer.Open(path) != 0) return -1;
+        CLogBinaryWriter binary;
+        binary.Open(&writer);
+        LogSiteInfo site = { __FILE__, __LINE__, __FUNCTION__, LOG_SITE_PRINTF, "seek %d %s" };
+        char args[64];
+        for (int i = 0; i < LOGBIN_TEST_EVENTS; i++) {
+            size_t size = CLogArgs::Put(args, i, "synthetic") - args;
+            binary.Event(LOG_INFO, 1, 2, base + (uint64_t)i * 1000000, site, args, size);
+        }
+        binary.Flush();
+        writer.Close();
+    }
+
+    // 第5步：取中间1秒，二分定位 vs 从头扫
+    uint64_t from = base + (uint64_t)LOGBIN_TEST_EVENTS / 2 * 1000000, to = from + 1000000000ull;
+    for (int seek = 1; seek >= 0; seek--) {
+        timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        CLogBinaryReader range;
+        range.Open(path);
+        if (seek) range.Seek(from);
+        size_t found = 0;
+        while (range.Next(record) == 1) {
+            if (record.ns >= to) break;   // 合成的时间是单调的
+            if (record.ns < from) continue;
+            line.clear();
+            CLogBinaryReader::Format(record, line);
+            found++;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+        printf("  %s：%zu条（应为1000），读%llu块 %.1fMB，%.2fms\n", seek ? "二分定位" : "从头扫  ", found,
+            (unsigned long long)range.Blocks(), range.BytesRead() / 1048576.0, ms);
+        if (found != 1000) errors++;
+    }
+    unlink(path);
+
+    // 第6步：块的时间不单调（中间一块是更早的记录，比如飞行记录转储），定位不能跳过前面的块
+    // A：100条（第1000~1099毫秒）  B：1000条（第0~999毫秒）  C：1000条（第2000~2999毫秒）
+    const char* quoted = "log/binary-seek'$(x).tmp";   // 第7步压缩它：文件名原样交给gzip
+    {
+        CLogWriter writer;
+        if (writer.Open(quoted) != 0) return -1;
+        CLogBinaryWriter binary;
+        binary.Open(&writer);
+        LogSiteInfo site = { __FILE__, __LINE__, __FUNCTION__, LOG_SITE_PRINTF, "seek %d %s" };
+        char args[64];
+        const int starts[3] = { 1000, 0, 2000 }, counts[3] = { 100, 1000, 1000 };
+        for (int b = 0; b < 3; b++) {
+            for (int i = 0; i < counts[b]; i++) {
+                size_t size = CLogArgs::Put(args, starts[b] + i, "unordered") - args;
+                binary.Event(LOG_INFO, 1, 2, base + (uint64_t)(starts[b] + i) * 1000000, site, args, size);
+            }
+            binary.Flush();
+        }
+        writer.Close();
+    }
+    auto countFrom = [&record](CLogBinaryReader& range, uint64_t ns) {
+        size_t found = 0;
+        while (range.Next(record) == 1) found += record.ns >= ns;
+        return found;
+    };
+    uint64_t middle = base + 1050 * 1000000ull;
+    CLogBinaryReader unordered;
+    size_t found = 0;
+    if (unordered.Open(quoted) == 0 && unordered.Seek(middle) == 0) found = countFrom(unordered, middle);
+    unordered.Close();
+    printf("  时间不单调的块：定位后 >= 第1050毫秒的 %zu条（应为1050）\n", found);
+    if (found != 1050) errors++;
+
+    // 第7步：.gz顺序读（同样的定位）；不存在的.gz打开失败
+    std::string gz = std::string(quoted) + ".gz";
+    found = 0;
+    pid_t gzip = fork();
+    if (gzip == 0) {
+        execlp("gzip", "gzip", "-f", "--", quoted, (char*)NULL);
+        _exit(127);
+    }
+    int status = -1;
+    if (gzip > 0) waitpid(gzip, &status, 0);
+    if (status == 0 && unordered.Open(gz.c_str()) == 0 && unordered.Seek(middle) == 0) {
+        found = countFrom(unordered, middle);
+    }
+    unordered.Close();
+    int missing = unordered.Open("log/binary-none.blog.gz");
+    printf("  .gz：%zu条（应为1050），不存在的文件 Open=%d\n", found, missing);
+    if (found != 1050 || missing != -1) errors++;
+    unlink(quoted);
+    unlink(gz.c_str());
     printf("\n");
+    return errors == 0 ? 0 : -2;
+}
 
-    return 0;
+// ==================== 飞行记录器压测 ====================
+// 日志服务器在子进程里，默认模块的级别设成INFO（DEBUG不写文件）、打开飞行记录：
+//   1. 另一个进程写DEBUG后崩溃（SIGSEGV）：日志服务器从它的记录器里dump出最后的DEBUG
+//   2. 本进程写DEBUG：比较记录的耗时；TRACEF之后flight文件里有最后的那些DEBUG、日志文件里没有
+//   3. 再写一些，dump命令（CLoggerServer::FlightDump）只dump新的记录
+#define FLIGHT_TEST_COUNT 1000000
+
+// log目录里所有飞行记录文件中包含tag的行数；last非空时同时检查最后一条包含tag的行里有last
+static size_t CountFlightLines(const char* tag, const char* last = NULL, bool* lastOk = NULL) {
+    size_t count = 0;
+    DIR* dir = opendir("log");
+    if (dir == NULL) return 0;
+    dirent* entry;
+    std::string lastLine;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "flight-", 7) != 0) continue;
+        std::string path = std::string("log/") + entry->d_name;
+        FILE* file = fopen(path.c_str(), "r");
+        if (file == NULL) continue;
+        char line[1024];
+        while (fgets(line, sizeof(line), file) != NULL) {
+            if (strstr(line, tag) == NULL) continue;
+            count++;
+            lastLine = line;
+        }
+        fclose(file);
+    }
+    closedir(dir);
+    if (lastOk != NULL) *lastOk = last != NULL && lastLine.find(last) != std::string::npos;
+    return count;
+}
+
+int TestLogFlight() {
+    printf("\n========================================\n");
+    printf("  飞行记录器压测\n");
+    printf("========================================\n\n");
+
+    // 第1步：日志服务器，DEBUG不写文件
+    int quit;
+    pid_t server = StartLogServer(LOG_FILE_TEXT, quit);
+    if (server < 0 || CLogFilter::Attach() != 0) return -1;
+    std::string reply;
+    CLogFilter::Control("level default info", reply);
+    CLogFilter::Control("flight default debug", reply);   // 0号模块没打开的级别写进飞行记录器
+    int errors = 0;
+    char tag[64];
+    snprintf(tag, sizeof(tag), "flight-%d-%ld", getpid(), (long)time(NULL));
+
+    // 第2步：崩溃的进程（在本进程写日志之前fork：线程的环和记录器都是它自己的）
+    pid_t child = fork();
+    if (child == 0) {
+        CLoggerServer::InstallFlightSignals();
+        for (int i = 0; i < 1000; i++) TRACED("%s crash %d", tag, i);
+        LOG_STREAM_DEFERRED(LOG_DEBUG) << tag << " crash last";
+        *(volatile int*)NULL = 0;   // SIGSEGV
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    usleep(300 * 1000);
+    char crashTag[80];
+    snprintf(crashTag, sizeof(crashTag), "%s crash", tag);
+    bool lastOk = false;
+    size_t crashLines = CountFlightLines(crashTag, "crash last", &lastOk);
+    printf("  崩溃的进程：%s，飞行记录 %zu 行（应为1001），最后一条%s\n",
+        WIFSIGNALED(status) ? strsignal(WTERMSIG(status)) : "没有崩溃", crashLines, lastOk ? "在" : "不在");
+    if (!WIFSIGNALED(status) || crashLines != 1001 || !lastOk) errors++;
+
+    // 第3步：本进程写DEBUG（不进文件，只进记录器），计时
+    timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < FLIGHT_TEST_COUNT; i++) TRACED("%s debug %d", tag, i);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / FLIGHT_TEST_COUNT;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < FLIGHT_TEST_COUNT; i++) LOG_TRACE_DEFERRED(LOG_INFO, "%s info %d", tag, i);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double infoNs = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / FLIGHT_TEST_COUNT;
+    printf("  记进飞行记录器的TRACED %.1fns/条，写日志的延迟格式化TRACEI %.1fns/条\n", ns, infoNs);
+    usleep(300 * 1000);   // 让日志线程读完环（INFO可能因为环满丢掉一些，不核对）
+
+    // 第4步：写几条DEBUG，然后FATAL：飞行记录里有最后的DEBUG
+    for (int i = 0; i < 10; i++) TRACED("%s before-fatal %d", tag, i);
+    TRACEF("%s fatal", tag);
+    usleep(300 * 1000);
+    char fatalTag[80];
+    snprintf(fatalTag, sizeof(fatalTag), "%s before-fatal", tag);
+    size_t fatalLines = CountFlightLines(fatalTag, "before-fatal 9", &lastOk);
+    char debugTag[80];
+    snprintf(debugTag, sizeof(debugTag), "%s debug", tag);
+    size_t debugLines = CountFlightLines(debugTag);
+    printf("  FATAL之后：之前的10条DEBUG %zu 行，最后一条%s；之前的%d条里留下 %zu 条（记录器%dKB）\n",
+        fatalLines, lastOk ? "在" : "不在", FLIGHT_TEST_COUNT, debugLines, LOG_FLIGHT_SIZE / 1024);
+    if (fatalLines != 10 || !lastOk || debugLines == 0) errors++;
+
+    // 第5步：dump命令只dump上次之后的记录
+    for (int i = 0; i < 5; i++) TRACED("%s on-demand %d", tag, i);
+    int ret = CLoggerServer::FlightDump(getpid());
+    usleep(300 * 1000);
+    char demandTag[80];
+    snprintf(demandTag, sizeof(demandTag), "%s on-demand", tag);
+    size_t demandLines = CountFlightLines(demandTag);
+    size_t fatalAgain = CountFlightLines(fatalTag);
+    printf("  dump命令 → %d：新的 %zu 行（应为5），FATAL前的 %zu 行（应为10，不重复）\n", ret, demandLines, fatalAgain);
+    if (ret != 0 || demandLines != 5 || fatalAgain != 10) errors++;
+
+    // 第6步：DEBUG一条都没进日志文件
+    size_t logged = CountLogLines(debugTag) + CountLogLines(fatalTag) + CountLogLines(crashTag);
+    printf("  日志文件里的DEBUG %zu 行（应为0）\n\n", logged);
+    if (logged != 0) errors++;
+
+    CLogFilter::Control("flight default off", reply);
+    CLogFilter::Control("level default debug", reply);
+    close(quit);
+    waitpid(server, NULL, 0);
+    return errors == 0 ? 0 : -2;
 }
 
 int main()
@@ -1060,6 +3792,102 @@ int main()
     return TestThreadPool_All();
 #pragma endregion
 
+#pragma region 环形缓冲区测试
+    // return TestRingBuffer();
+#pragma endregion
+
+#pragma region 发送队列测试
+    // return TestOutputQueue();
+#pragma endregion
+
+#pragma region UDP批量收发测试
+    // return TestUdpBatch();
+#pragma endregion
+
+#pragma region CIOBuf测试
+    // return TestIOBuf();
+#pragma endregion
+
+#pragma region 登录风暴压测
+    // return TestLoginStorm();
+#pragma endregion
+
+#pragma region 缓冲区池压测
+    // return TestBufferPool();
+#pragma endregion
+
+#pragma region 大块传输压测
+    // return TestBulkTransfer();
+#pragma endregion
+
+#pragma region 可靠UDP回环测试
+    // return TestReliableUdp();
+#pragma endregion
+
+#pragma region 连接分派表压测
+    // return TestConnTable();
+#pragma endregion
+
+#pragma region 会话超时压测
+    // return TestSessionManager();
+#pragma endregion
+
+#pragma region 广播压测
+    // return TestBroadcast();
+#pragma endregion
+
+#pragma region 视野管理压测
+    // return TestAoi();
+#pragma endregion
+
+#pragma region 快照增量压测
+    // return TestSnapshot();
+#pragma endregion
+
+#pragma region 协议分发压测
+    // return TestProtocol();
+#pragma endregion
+
+#pragma region 日志环压测
+    // return TestLogRing();
+#pragma endregion
+
+#pragma region 延迟格式化压测
+    // return TestLogDeferred();
+#pragma endregion
+
+#pragma region 时间格式化压测
+    // return TestClock();
+#pragma endregion
+
+#pragma region 批量写日志压测
+    // return TestLogWriter();
+#pragma endregion
+
+#pragma region 日志轮转压测
+    // return TestLogRotate();
+#pragma endregion
+
+#pragma region 日志级别过滤压测
+    // return TestLogFilter();
+#pragma endregion
+
+#pragma region 日志行格式化压测
+    // return TestLogLine();
+#pragma endregion
+
+#pragma region 十六进制dump压测
+    // return TestHexDump();
+#pragma endregion
+
+#pragma region 二进制日志压测
+    // return TestLogBinary();
+#pragma endregion
+
+#pragma region 飞行记录器压测
+    // return TestLogFlight();
+#pragma endregion
+
 std::cout << "hello" << std::endl;
 CProcess proclog;
 